@@ -0,0 +1,465 @@
+/*
+ * libsstv - Header-only C++17 layer over the encoder and decoder C APIs
+ *
+ * Copyright (C) 2026 (library port)
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef SSTV_HPP
+#define SSTV_HPP
+
+#if __cplusplus < 201703L && !(defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#error "sstv.hpp requires C++17"
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "sstv_encoder.h"
+#include "sstv_decoder.h"
+
+namespace sstv {
+
+/*
+ * Handles are move-only and free their C object on destruction. Nothing
+ * throws: factories return an empty object (test with operator bool) and
+ * calls return the C API's status codes. Sample and pixel buffers are
+ * passed as span views, so no call copies caller data; non-float sample
+ * types go through a small stack buffer.
+ */
+
+/* Non-owning view of contiguous elements (std::span is C++20) */
+template <class T>
+class span {
+public:
+    constexpr span() noexcept : data_(nullptr), size_(0) {}
+    constexpr span(T *data, size_t size) noexcept : data_(data), size_(size) {}
+    template <size_t N>
+    constexpr span(T (&arr)[N]) noexcept : data_(arr), size_(N) {}
+    /* Any container with data() and size(): std::vector, std::array, span */
+    template <class C, class = std::enable_if_t<
+        std::is_convertible_v<decltype(std::declval<C&>().data()), T*>>>
+    constexpr span(C &c) noexcept : data_(c.data()), size_(c.size()) {}
+
+    constexpr T* data() const noexcept { return data_; }
+    constexpr size_t size() const noexcept { return size_; }
+    constexpr bool empty() const noexcept { return size_ == 0; }
+    constexpr T& operator[](size_t i) const noexcept { return data_[i]; }
+    constexpr T* begin() const noexcept { return data_; }
+    constexpr T* end() const noexcept { return data_ + size_; }
+    constexpr span first(size_t n) const noexcept { return span(data_, n < size_ ? n : size_); }
+    constexpr span subspan(size_t off) const noexcept {
+        return off < size_ ? span(data_ + off, size_ - off) : span();
+    }
+
+private:
+    T *data_;
+    size_t size_;
+};
+
+template <class Sig> class function_ref;
+
+/* Non-owning reference to a callable: two pointers, never allocates.
+ * The callable must outlive every call made through the reference. */
+template <class R, class... Args>
+class function_ref<R(Args...)> {
+public:
+    function_ref() noexcept : obj_(nullptr), call_(nullptr) {}
+    template <class F, class = std::enable_if_t<
+        !std::is_same_v<std::decay_t<F>, function_ref> &&
+        std::is_invocable_r_v<R, F&, Args...>>>
+    function_ref(F &&f) noexcept
+        : obj_(const_cast<void*>(static_cast<const void*>(std::addressof(f)))),
+          call_([](void *obj, Args... args) -> R {
+              return (*static_cast<std::remove_reference_t<F>*>(obj))(std::forward<Args>(args)...);
+          }) {}
+
+    R operator()(Args... args) const { return call_(obj_, std::forward<Args>(args)...); }
+    explicit operator bool() const noexcept { return call_ != nullptr; }
+
+private:
+    void *obj_;
+    R (*call_)(void*, Args...);
+};
+
+/* Decoder status */
+enum class Status : int {
+    Ok = SSTV_RX_OK,
+    NeedMore = SSTV_RX_NEED_MORE,
+    ImageReady = SSTV_RX_IMAGE_READY,
+    Error = SSTV_RX_ERROR
+};
+
+/* Read-only view of an image owned by someone else */
+struct ImageView {
+    span<const uint8_t> pixels;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t stride = 0;
+    sstv_pixel_format_t format = SSTV_RGB24;
+
+    span<const uint8_t> row(uint32_t y) const {
+        return span<const uint8_t>(pixels.data() + (size_t)y * stride,
+                                   (size_t)width * (format == SSTV_RGB24 ? 3 : 1));
+    }
+};
+
+/* Image that owns its pixels */
+struct Image {
+    std::vector<uint8_t> pixels;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t stride = 0;
+    sstv_pixel_format_t format = SSTV_RGB24;
+
+    Image() = default;
+    explicit Image(const ImageView &v)
+        : pixels(v.pixels.begin(), v.pixels.end()), width(v.width), height(v.height),
+          stride(v.stride), format(v.format) {}
+
+    ImageView view() const { return ImageView{span<const uint8_t>(pixels), width, height, stride, format}; }
+};
+
+namespace detail {
+
+/* Samples converted per stack chunk for non-float types */
+constexpr size_t kChunk = 512;
+
+template <class T>
+constexpr bool is_sample_v = std::is_same_v<T, float> || std::is_same_v<T, double> ||
+                             std::is_same_v<T, int16_t> || std::is_same_v<T, int32_t>;
+
+inline float clamp_pcm(float v, float lo, float hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+} // namespace detail
+
+/*==============================================================================
+ * ENCODER
+ *============================================================================*/
+
+class Encoder {
+public:
+    Encoder() noexcept = default;
+    Encoder(const Encoder&) = delete;
+    Encoder& operator=(const Encoder&) = delete;
+    Encoder(Encoder &&o) noexcept { take(o); }
+    Encoder& operator=(Encoder &&o) noexcept {
+        if (this != &o) {
+            sstv_encoder_free(enc_);
+            take(o);
+        }
+        return *this;
+    }
+    ~Encoder() { sstv_encoder_free(enc_); }
+
+    /**
+     * Create an encoder
+     *
+     * @param mode SSTV mode
+     * @param sample_rate Output sample rate in Hz
+     * @return Encoder, empty on error
+     */
+    static Encoder create(sstv_mode_t mode, double sample_rate) {
+        Encoder e;
+        e.enc_ = sstv_encoder_create(mode, sample_rate);
+        return e;
+    }
+
+    explicit operator bool() const noexcept { return enc_ != nullptr; }
+    sstv_encoder_t* handle() const noexcept { return enc_; }
+
+    /**
+     * Set the image to send
+     *
+     * The pixels are not copied and must stay valid until generation ends;
+     * the view's header is kept inside the Encoder, so temporaries are fine.
+     *
+     * @param image Image matching the mode's size
+     * @return 0 on success, -1 on size mismatch or empty encoder
+     */
+    int set_image(const ImageView &image) {
+        if (!enc_) return -1;
+        image_.pixels = const_cast<uint8_t*>(image.pixels.data());
+        image_.width = image.width;
+        image_.height = image.height;
+        image_.stride = image.stride;
+        image_.format = image.format;
+        has_image_ = sstv_encoder_set_image(enc_, &image_) == 0;
+        return has_image_ ? 0 : -1;
+    }
+
+    void set_vis_enabled(bool enable) {
+        if (enc_) sstv_encoder_set_vis_enabled(enc_, enable ? 1 : 0);
+    }
+
+    bool complete() const { return !enc_ || sstv_encoder_is_complete(enc_); }
+    float progress() const { return enc_ ? sstv_encoder_get_progress(enc_) : 0.0f; }
+    size_t total_samples() const { return enc_ ? sstv_encoder_get_total_samples(enc_) : 0; }
+    void reset() {
+        if (enc_) sstv_encoder_reset(enc_);
+    }
+
+    /**
+     * Generate samples into out
+     *
+     * float is the native format (+-1.0, written in place); double keeps
+     * that range; int16_t and int32_t are full-scale PCM.
+     *
+     * @param out Destination
+     * @return Samples written (0 when complete)
+     */
+    template <class SampleT>
+    size_t generate(span<SampleT> out) {
+        static_assert(detail::is_sample_v<SampleT>,
+                      "sample type must be float, double, int16_t or int32_t");
+        if (!enc_) return 0;
+        if constexpr (std::is_same_v<SampleT, float>) {
+            return sstv_encoder_generate(enc_, out.data(), out.size());
+        } else {
+            float tmp[detail::kChunk];
+            size_t done = 0;
+            while (done < out.size() && !sstv_encoder_is_complete(enc_)) {
+                size_t want = out.size() - done;
+                if (want > detail::kChunk) want = detail::kChunk;
+                size_t n = sstv_encoder_generate(enc_, tmp, want);
+                if (n == 0) break;
+                SampleT *dst = out.data() + done;
+                for (size_t i = 0; i < n; i++) {
+                    if constexpr (std::is_same_v<SampleT, double>) {
+                        dst[i] = (double)tmp[i];
+                    } else if constexpr (std::is_same_v<SampleT, int16_t>) {
+                        dst[i] = (int16_t)std::lrintf(detail::clamp_pcm(tmp[i] * 32767.0f, -32768.0f, 32767.0f));
+                    } else {
+                        dst[i] = (int32_t)std::lrint(detail::clamp_pcm(tmp[i], -1.0f, 1.0f) * 2147483647.0);
+                    }
+                }
+                done += n;
+            }
+            return done;
+        }
+    }
+
+    template <class C>
+    auto generate(C &out) -> decltype(generate(span<typename C::value_type>(out))) {
+        return generate(span<typename C::value_type>(out));
+    }
+
+private:
+    void take(Encoder &o) noexcept {
+        enc_ = o.enc_;
+        image_ = o.image_;
+        has_image_ = o.has_image_;
+        o.enc_ = nullptr;
+        o.has_image_ = false;
+        /* The C encoder points at image_, which just moved */
+        if (enc_ && has_image_) sstv_encoder_set_image(enc_, &image_);
+    }
+
+    sstv_encoder_t *enc_ = nullptr;
+    sstv_image_t image_ = {};
+    bool has_image_ = false;
+};
+
+/*==============================================================================
+ * DECODER
+ *============================================================================*/
+
+/* Line callback: line index, RGB24 row (valid during the call), width, height */
+using LineCallback = function_ref<void(int, span<const uint8_t>, int, int)>;
+
+class Decoder {
+public:
+    Decoder() noexcept = default;
+    Decoder(const Decoder&) = delete;
+    Decoder& operator=(const Decoder&) = delete;
+    Decoder(Decoder &&o) noexcept { take(o); }
+    Decoder& operator=(Decoder &&o) noexcept {
+        if (this != &o) {
+            sstv_decoder_free(dec_);
+            take(o);
+        }
+        return *this;
+    }
+    ~Decoder() { sstv_decoder_free(dec_); }
+
+    /**
+     * Create a decoder
+     *
+     * @param sample_rate Input sample rate in Hz
+     * @param alloc Frame buffer allocator (nullptr = malloc)
+     * @return Decoder, empty on error
+     */
+    static Decoder create(double sample_rate, const sstv_allocator_t *alloc = nullptr) {
+        Decoder d;
+        d.dec_ = alloc ? sstv_decoder_create_with_allocator(sample_rate, alloc)
+                       : sstv_decoder_create(sample_rate);
+        return d;
+    }
+
+    explicit operator bool() const noexcept { return dec_ != nullptr; }
+    sstv_decoder_t* handle() const noexcept { return dec_; }
+
+    /**
+     * Feed samples
+     *
+     * float is the native format (16-bit PCM scale) and is passed through
+     * untouched; int16_t is exact PCM, double is narrowed, and int32_t is
+     * scaled down to 16-bit. The decoder does not depend on chunking, so
+     * every type decodes identically to the same samples as float.
+     *
+     * @param in Samples
+     * @return Decoder status after the last sample
+     */
+    template <class SampleT>
+    Status feed(span<const SampleT> in) {
+        static_assert(detail::is_sample_v<SampleT>,
+                      "sample type must be float, double, int16_t or int32_t");
+        if (!dec_ || in.empty()) return Status::Error;
+        if constexpr (std::is_same_v<SampleT, float>) {
+            return (Status)sstv_decoder_feed(dec_, in.data(), in.size());
+        } else {
+            float tmp[detail::kChunk];
+            sstv_rx_status_t st = SSTV_RX_NEED_MORE;
+            for (size_t pos = 0; pos < in.size(); pos += detail::kChunk) {
+                size_t n = in.size() - pos;
+                if (n > detail::kChunk) n = detail::kChunk;
+                const SampleT *src = in.data() + pos;
+                for (size_t i = 0; i < n; i++) {
+                    if constexpr (std::is_same_v<SampleT, int32_t>) {
+                        tmp[i] = (float)((double)src[i] / 65536.0);
+                    } else {
+                        tmp[i] = (float)src[i];
+                    }
+                }
+                st = sstv_decoder_feed(dec_, tmp, n);
+                if (st == SSTV_RX_ERROR) break;
+            }
+            return (Status)st;
+        }
+    }
+
+    template <class C>
+    auto feed(const C &in) -> decltype(feed(span<const typename C::value_type>(in))) {
+        return feed(span<const typename C::value_type>(in));
+    }
+
+    /**
+     * Borrow the decoded frame
+     *
+     * Valid until the next feed, reset or redecode, or until the Decoder
+     * goes away; use image_copy() to keep it.
+     *
+     * @return View of the frame, or nullopt before VIS lock
+     */
+    std::optional<ImageView> image() const {
+        sstv_image_t img;
+        if (!dec_ || sstv_decoder_get_image(dec_, &img) != 0) return std::nullopt;
+        return ImageView{span<const uint8_t>(img.pixels, (size_t)img.stride * img.height),
+                         img.width, img.height, img.stride, img.format};
+    }
+
+    /**
+     * Copy the decoded frame out
+     *
+     * @return Owning image, or nullopt before VIS lock
+     */
+    std::optional<Image> image_copy() const {
+        std::optional<ImageView> v = image();
+        if (!v) return std::nullopt;
+        return Image(*v);
+    }
+
+    /**
+     * Call cb for each completed line
+     *
+     * Only a reference is stored, so cb must be an lvalue that outlives
+     * the registration (until clear_on_line(), another on_line() or
+     * destruction); temporaries are rejected at compile time. Moving the
+     * Decoder keeps the registration.
+     *
+     * @param cb Callable taking (int line, span<const uint8_t> rgb, int width, int height)
+     */
+    template <class F>
+    void on_line(F &cb) {
+        line_cb_ = LineCallback(cb);
+        bind_line_callback();
+    }
+    template <class F>
+    void on_line(F &&cb) = delete;
+
+    void clear_on_line() {
+        line_cb_ = LineCallback();
+        bind_line_callback();
+    }
+
+    void reset() {
+        if (dec_) sstv_decoder_reset(dec_);
+    }
+    void set_mode_hint(sstv_mode_t mode) {
+        if (dec_) sstv_decoder_set_mode_hint(dec_, mode);
+    }
+    void set_vis_enabled(bool enable) {
+        if (dec_) sstv_decoder_set_vis_enabled(dec_, enable ? 1 : 0);
+    }
+    int set_demod(sstv_demod_t demod) { return dec_ ? sstv_decoder_set_demod(dec_, demod) : -1; }
+
+    std::optional<sstv_decoder_state_t> state() const {
+        sstv_decoder_state_t s;
+        if (!dec_ || sstv_decoder_get_state(dec_, &s) != 0) return std::nullopt;
+        return s;
+    }
+
+    /**
+     * Per-line quality of the current frame
+     *
+     * @param out Filled from line 0
+     * @return Lines written, or -1 on error
+     */
+    int line_quality(span<sstv_line_quality_t> out) const {
+        return dec_ ? sstv_decoder_get_line_quality(dec_, out.data(), (int)out.size()) : -1;
+    }
+
+    uint64_t checksum() const { return dec_ ? sstv_decoder_get_checksum(dec_) : 0; }
+
+private:
+    static void line_trampoline(void *user, int line, const uint8_t *rgb, int width, int height) {
+        const Decoder *self = static_cast<const Decoder*>(user);
+        self->line_cb_(line, span<const uint8_t>(rgb, (size_t)width * 3), width, height);
+    }
+
+    void bind_line_callback() {
+        if (!dec_) return;
+        if (line_cb_) {
+            sstv_decoder_set_line_callback(dec_, line_trampoline, this);
+        } else {
+            sstv_decoder_set_line_callback(dec_, nullptr, nullptr);
+        }
+    }
+
+    void take(Decoder &o) noexcept {
+        dec_ = o.dec_;
+        line_cb_ = o.line_cb_;
+        o.dec_ = nullptr;
+        o.line_cb_ = LineCallback();
+        /* The C decoder's user pointer was the old address */
+        bind_line_callback();
+    }
+
+    sstv_decoder_t *dec_ = nullptr;
+    LineCallback line_cb_;
+};
+
+} // namespace sstv
+
+#endif /* SSTV_HPP */
@@ -0,0 +1,394 @@
+/*
+ * libsstv - Optional C++20 coroutine adapters over sstv.hpp
+ *
+ * Copyright (C) 2026 (library port)
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef SSTV_CORO_HPP
+#define SSTV_CORO_HPP
+
+#if !defined(__cpp_impl_coroutine) && !(defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+#error "sstv_coro.hpp requires C++20 coroutines"
+#endif
+
+#include <coroutine>
+#include <exception>
+
+#include "sstv.hpp"
+
+namespace sstv {
+
+/*
+ * generate_blocks() turns the encoder's generate/is_complete polling into
+ * a lazy range of sample blocks. AsyncDecoder lets a coroutine co_await
+ * the next decoded lines or image while another part of the program feeds
+ * audio, so one thread can serve many sessions without a thread per
+ * stream.
+ *
+ * Nothing here allocates per block or per event. Sample blocks are
+ * written into a buffer the caller owns. Awaiters live in the awaiting
+ * coroutine's frame. Only the generator's own frame comes from the heap,
+ * and a compiler that can see its whole lifetime (a generator used as a
+ * local in one scope) may elide that allocation too.
+ */
+
+/* Lazy single-pass range of values produced by a coroutine */
+template <class T>
+class generator {
+public:
+    struct promise_type {
+        const T *value = nullptr;
+
+        generator get_return_object() noexcept {
+            return generator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        /* The yielded temporary lives until the coroutine resumes */
+        std::suspend_always yield_value(const T &v) noexcept {
+            value = std::addressof(v);
+            return {};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+
+    struct sentinel {};
+
+    class iterator {
+    public:
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() noexcept = default;
+        explicit iterator(std::coroutine_handle<promise_type> h) noexcept : h_(h) {}
+
+        const T& operator*() const noexcept { return *h_.promise().value; }
+        const T* operator->() const noexcept { return h_.promise().value; }
+        iterator& operator++() {
+            h_.resume();
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+        friend bool operator==(const iterator &it, sentinel) noexcept { return !it.h_ || it.h_.done(); }
+
+    private:
+        std::coroutine_handle<promise_type> h_;
+    };
+
+    generator(generator &&o) noexcept : h_(o.h_) { o.h_ = nullptr; }
+    generator& operator=(generator &&o) noexcept {
+        if (this != &o) {
+            if (h_) h_.destroy();
+            h_ = o.h_;
+            o.h_ = nullptr;
+        }
+        return *this;
+    }
+    generator(const generator&) = delete;
+    generator& operator=(const generator&) = delete;
+    ~generator() {
+        if (h_) h_.destroy();
+    }
+
+    /* Runs the coroutine up to its first value */
+    iterator begin() {
+        if (h_) h_.resume();
+        return iterator(h_);
+    }
+    sentinel end() const noexcept { return {}; }
+
+private:
+    explicit generator(std::coroutine_handle<promise_type> h) noexcept : h_(h) {}
+    std::coroutine_handle<promise_type> h_;
+};
+
+/**
+ * Lazily generate the transmission in blocks
+ *
+ * Each block is written into `buffer` and yielded as a view of the
+ * samples just generated (the last one may be shorter). A view is valid
+ * until the range advances. Nothing is generated before the first
+ * iteration. The encoder and buffer must outlive the range.
+ *
+ * @param enc Encoder with its image set
+ * @param buffer Preallocated block buffer (non-empty)
+ * @return Range of sample blocks, ending when the encoder completes
+ */
+inline generator<span<const float>> generate_blocks(Encoder &enc, span<float> buffer) {
+    while (!buffer.empty() && !enc.complete()) {
+        size_t n = enc.generate(buffer);
+        if (n == 0) break;
+        co_yield span<const float>(buffer.data(), n);
+    }
+}
+
+/**
+ * Lazily generate the transmission in blocks of `block` samples
+ *
+ * Like the buffer overload, with the buffer allocated once when the
+ * range starts and owned by the coroutine.
+ *
+ * @param enc Encoder with its image set
+ * @param block Samples per block (non-zero)
+ * @return Range of sample blocks, ending when the encoder completes
+ */
+inline generator<span<const float>> generate_blocks(Encoder &enc, size_t block) {
+    std::vector<float> buffer(block);
+    while (block > 0 && !enc.complete()) {
+        size_t n = enc.generate(buffer);
+        if (n == 0) break;
+        co_yield span<const float>(buffer.data(), n);
+    }
+}
+
+/* Hands a coroutine that is ready to continue to whatever runs it (post
+ * to an event loop, a thread pool, a strand). A null post resumes inline
+ * at the end of AsyncDecoder::feed(). */
+struct Executor {
+    void (*post)(void *ctx, std::coroutine_handle<> h) = nullptr;
+    void *ctx = nullptr;
+};
+
+/* Lines completed since the awaiting coroutine last looked */
+struct LineEvent {
+    bool ok = false;             /* false once the decoder is closed */
+    uint64_t frame = 0;          /* Frame the lines belong to (1 = first) */
+    int first = 0;               /* First new line */
+    int last = -1;               /* Last new line (rows stay in image()) */
+    int width = 0;
+    int height = 0;
+};
+
+/* A finished image */
+struct ImageEvent {
+    bool ok = false;             /* false once the decoder is closed */
+    uint64_t frame = 0;          /* Frames completed so far */
+};
+
+/*
+ * Decoder whose events can be awaited
+ *
+ * feed() runs the decoder; when it returns, a coroutine waiting for lines
+ * or an image whose condition is now met is handed to the executor.
+ * Events are cumulative, so a coroutine that is resumed late misses
+ * nothing: a line event covers every line since the previous one, and
+ * the rows themselves stay in image() until the next VIS lock or reset.
+ *
+ * One coroutine at a time may wait for lines, and one for images; a
+ * second waiter of the same kind gets ok = false immediately. feed(),
+ * close() and the awaiting coroutines must not run concurrently (use one
+ * strand per session). The AsyncDecoder must not move while a coroutine
+ * is waiting on it, and it owns the decoder's line callback, so do not
+ * also register one through decoder().on_line().
+ */
+class AsyncDecoder {
+public:
+    AsyncDecoder() noexcept = default;
+    AsyncDecoder(const AsyncDecoder&) = delete;
+    AsyncDecoder& operator=(const AsyncDecoder&) = delete;
+    AsyncDecoder(AsyncDecoder &&o) noexcept { take(o); }
+    AsyncDecoder& operator=(AsyncDecoder &&o) noexcept {
+        if (this != &o) take(o);
+        return *this;
+    }
+
+    /**
+     * Create an awaitable decoder
+     *
+     * @param sample_rate Input sample rate in Hz
+     * @param ex Executor used to resume waiting coroutines
+     * @param alloc Frame buffer allocator (nullptr = malloc)
+     * @return Decoder, empty on error
+     */
+    static AsyncDecoder create(double sample_rate, Executor ex = {},
+                               const sstv_allocator_t *alloc = nullptr) {
+        AsyncDecoder d;
+        d.dec_ = Decoder::create(sample_rate, alloc);
+        d.ex_ = ex;
+        return d;
+    }
+
+    explicit operator bool() const noexcept { return (bool)dec_; }
+
+    /* The wrapped decoder, for settings and image() */
+    Decoder& decoder() noexcept { return dec_; }
+    const Decoder& decoder() const noexcept { return dec_; }
+
+    /**
+     * Feed samples, then wake waiters whose event arrived
+     *
+     * @param in Samples (see Decoder::feed)
+     * @return Decoder status after the last sample
+     */
+    template <class SampleT>
+    Status feed(span<const SampleT> in) {
+        if (closed_) return Status::Error;
+        bind();
+        Status st = dec_.feed(in);
+        wake();
+        return st;
+    }
+
+    template <class C>
+    auto feed(const C &in) -> decltype(feed(span<const typename C::value_type>(in))) {
+        return feed(span<const typename C::value_type>(in));
+    }
+
+    /**
+     * End of stream: waiting coroutines resume with ok = false, and so
+     * do later awaits once their pending events have been taken
+     */
+    void close() {
+        closed_ = true;
+        wake();
+    }
+
+    class LineAwaiter {
+    public:
+        explicit LineAwaiter(AsyncDecoder &d) noexcept : d_(d) {}
+        bool await_ready() const noexcept { return d_.lines_pending() || d_.closed_; }
+        bool await_suspend(std::coroutine_handle<> h) noexcept {
+            if (d_.line_waiter_) {
+                rejected_ = true;
+                return false;
+            }
+            d_.line_waiter_ = h;
+            return true;
+        }
+        LineEvent await_resume() noexcept {
+            return rejected_ ? LineEvent() : d_.take_lines();
+        }
+
+    private:
+        AsyncDecoder &d_;
+        bool rejected_ = false;
+    };
+
+    class ImageAwaiter {
+    public:
+        explicit ImageAwaiter(AsyncDecoder &d) noexcept : d_(d) {}
+        bool await_ready() const noexcept { return d_.image_pending() || d_.closed_; }
+        bool await_suspend(std::coroutine_handle<> h) noexcept {
+            if (d_.image_waiter_) {
+                rejected_ = true;
+                return false;
+            }
+            d_.image_waiter_ = h;
+            return true;
+        }
+        ImageEvent await_resume() noexcept {
+            return rejected_ ? ImageEvent() : d_.take_image();
+        }
+
+    private:
+        AsyncDecoder &d_;
+        bool rejected_ = false;
+    };
+
+    /* co_await: lines completed since the last line event */
+    LineAwaiter next_line() noexcept { return LineAwaiter(*this); }
+
+    /* co_await: the next finished image (image() holds it) */
+    ImageAwaiter next_image() noexcept { return ImageAwaiter(*this); }
+
+private:
+    static void on_line(void *user, int line, const uint8_t*, int width, int height) {
+        AsyncDecoder *self = static_cast<AsyncDecoder*>(user);
+        if (line == 0 || line < self->line_hi_) {
+            self->frame_++;
+            self->line_seen_ = 0;
+        }
+        self->line_hi_ = line + 1;
+        self->width_ = width;
+        self->height_ = height;
+        if (line + 1 == height) self->images_++;
+    }
+
+    /* The C callback carries this object's address, so bind at each feed */
+    void bind() {
+        if (dec_) sstv_decoder_set_line_callback(dec_.handle(), on_line, this);
+    }
+
+    bool lines_pending() const noexcept { return line_seen_ < line_hi_ || seen_frame_ != frame_; }
+    bool image_pending() const noexcept { return images_seen_ < images_; }
+
+    LineEvent take_lines() noexcept {
+        LineEvent ev;
+        if (!lines_pending()) return ev;              /* Closed */
+        if (seen_frame_ != frame_) {
+            seen_frame_ = frame_;
+            line_seen_ = 0;
+        }
+        ev.ok = true;
+        ev.frame = frame_;
+        ev.first = line_seen_;
+        ev.last = line_hi_ - 1;
+        ev.width = width_;
+        ev.height = height_;
+        line_seen_ = line_hi_;
+        return ev;
+    }
+
+    ImageEvent take_image() noexcept {
+        ImageEvent ev;
+        if (!image_pending()) return ev;              /* Closed */
+        images_seen_ = images_;
+        ev.ok = true;
+        ev.frame = images_;
+        return ev;
+    }
+
+    void wake() {
+        if (line_waiter_ && (lines_pending() || closed_)) resume(line_waiter_);
+        if (image_waiter_ && (image_pending() || closed_)) resume(image_waiter_);
+    }
+
+    void resume(std::coroutine_handle<> &slot) {
+        std::coroutine_handle<> h = slot;
+        slot = nullptr;
+        if (ex_.post) {
+            ex_.post(ex_.ctx, h);
+        } else {
+            h.resume();
+        }
+    }
+
+    void take(AsyncDecoder &o) noexcept {
+        dec_ = std::move(o.dec_);
+        ex_ = o.ex_;
+        closed_ = o.closed_;
+        frame_ = o.frame_;
+        seen_frame_ = o.seen_frame_;
+        line_hi_ = o.line_hi_;
+        line_seen_ = o.line_seen_;
+        width_ = o.width_;
+        height_ = o.height_;
+        images_ = o.images_;
+        images_seen_ = o.images_seen_;
+        line_waiter_ = image_waiter_ = nullptr;
+    }
+
+    Decoder dec_;
+    Executor ex_;
+    bool closed_ = false;
+    uint64_t frame_ = 0;         /* Frames started (line callback) */
+    uint64_t seen_frame_ = 0;
+    int line_hi_ = 0;            /* Lines completed in frame_ */
+    int line_seen_ = 0;          /* Of those, already handed out */
+    int width_ = 0;
+    int height_ = 0;
+    uint64_t images_ = 0;        /* Frames finished */
+    uint64_t images_seen_ = 0;
+    std::coroutine_handle<> line_waiter_;
+    std::coroutine_handle<> image_waiter_;
+};
+
+} // namespace sstv
+
+#endif /* SSTV_CORO_HPP */
@@ -41,7 +41,17 @@ typedef enum {
     SSTV_AGC_AUTO = 5      /* Automatic: select mode based on signal level */
 } sstv_agc_mode_t;
 
-/* Decoder handle (opaque) */
+/* Image demodulator tier */
+typedef enum {
+    SSTV_DEMOD_TONE = 0,   /* Tone detector bank (default) */
+    SSTV_DEMOD_ZC = 1      /* Zero-crossing interval estimator: lowest CPU */
+} sstv_demod_t;
+
+/* Decoder handle (opaque)
+ *
+ * Thread safety: all mutable state lives in the handle, so distinct
+ * handles may be used concurrently from different threads. A single
+ * handle must not be used by two threads at once. */
 typedef struct sstv_decoder_s sstv_decoder_t;
 
 /**
@@ -62,6 +72,108 @@ typedef struct sstv_decoder_s sstv_decoder_t;
  */
 sstv_decoder_t* sstv_decoder_create(double sample_rate);
 
+/**
+ * Memory allocator for decoder buffers (image frames, VIS scratch)
+ *
+ * Blocks need not be zeroed. free receives the size that was passed to
+ * alloc. Both may be called from inside sstv_decoder_feed() (a frame is
+ * allocated at VIS lock), so they must not block for long; an allocator
+ * shared by several decoders on different threads must be thread safe.
+ */
+typedef struct {
+    void* (*alloc)(void *user, size_t size);          /* NULL on failure */
+    void (*free)(void *user, void *ptr, size_t size); /* ptr may be NULL */
+    void *user;                                       /* Passed to both */
+} sstv_allocator_t;
+
+/**
+ * Create a decoder whose buffers come from the given allocator
+ *
+ * The allocator is copied; whatever it draws from (e.g. a slab pool) must
+ * outlive the decoder. Journal frames (sstv_decoder_set_journal()) still
+ * live in their file mapping.
+ *
+ * @param sample_rate Audio sample rate in Hz
+ * @param allocator Allocator, or NULL for malloc/free
+ * @return Decoder handle or NULL on error
+ */
+sstv_decoder_t* sstv_decoder_create_with_allocator(double sample_rate,
+                                                   const sstv_allocator_t *allocator);
+
+/**
+ * Slab pool: a thread-safe allocator shared by many decoders
+ *
+ * Blocks are grouped by exact size, which for image frames is the frame
+ * geometry (width * height * 3). A freed block goes on its size's free
+ * list and is handed to the next decoder that locks a frame of that
+ * geometry, so a multi-channel engine stops calling malloc once every
+ * geometry in use has been seen (or reserved up front). New slabs come
+ * from calloc, whose large blocks are untouched zero pages; recycled
+ * slabs are not cleared, since the decoder only zeroes the part of a
+ * frame it never received, when that frame is read.
+ */
+typedef struct sstv_slab_pool_s sstv_slab_pool_t;
+
+/**
+ * Slab pool counters
+ */
+typedef struct {
+    size_t bytes_total;      /* Memory held by the pool (free + in use) */
+    size_t bytes_in_use;     /* Memory handed out and not yet returned */
+    int size_classes;        /* Distinct block sizes seen */
+    uint64_t allocs;         /* Blocks handed out */
+    uint64_t reused;         /* Of those, served from a free list */
+    uint64_t failed;         /* Refused by the byte limit or out of memory */
+} sstv_slab_stats_t;
+
+/**
+ * Create a slab pool
+ *
+ * @param max_bytes Limit on memory held by the pool, 0 for no limit
+ * @return Pool handle or NULL on error
+ */
+sstv_slab_pool_t* sstv_slab_pool_create(size_t max_bytes);
+
+/**
+ * Free a slab pool and all of its blocks
+ *
+ * Every decoder using the pool must have been freed first.
+ *
+ * @param pool Pool handle (NULL safe)
+ */
+void sstv_slab_pool_free(sstv_slab_pool_t *pool);
+
+/**
+ * Get an allocator that draws from the pool
+ *
+ * @param pool Pool handle
+ * @param out Output: allocator for sstv_decoder_create_with_allocator()
+ * @return 0 on success, -1 on error
+ */
+int sstv_slab_pool_allocator(sstv_slab_pool_t *pool, sstv_allocator_t *out);
+
+/**
+ * Pre-allocate blocks so later allocations of that size never hit malloc
+ *
+ * For decoder frames of a mode, block_size is width * height * 3 from
+ * sstv_get_mode_info(); reserve one per channel that may receive it.
+ *
+ * @param pool Pool handle
+ * @param block_size Block size in bytes
+ * @param count Free blocks of this size to have on hand
+ * @return 0 on success, -1 on error or if the byte limit was reached
+ */
+int sstv_slab_pool_reserve(sstv_slab_pool_t *pool, size_t block_size, int count);
+
+/**
+ * Get pool counters
+ *
+ * @param pool Pool handle
+ * @param stats Output: counters
+ * @return 0 on success, -1 on error
+ */
+int sstv_slab_pool_get_stats(sstv_slab_pool_t *pool, sstv_slab_stats_t *stats);
+
 /**
  * Free decoder resources
  *
@@ -100,6 +212,43 @@ void sstv_decoder_set_vis_enabled(sstv_decoder_t *dec, int enable);
  */
 void sstv_decoder_set_agc_mode(sstv_decoder_t *dec, sstv_agc_mode_t mode);
 
+/**
+ * Select the image demodulator
+ *
+ * SSTV_DEMOD_ZC measures the spacing of zero crossings in the band-passed
+ * signal (interpolated between samples, median of 5 cycles) instead
+ * of running the tone detector bank during image reception. It is meant
+ * for single-channel decoding on small hosts; VIS and sync acquisition are
+ * unchanged. Takes effect immediately.
+ *
+ * @param dec Decoder handle
+ * @param demod SSTV_DEMOD_TONE or SSTV_DEMOD_ZC
+ * @return 0 on success, -1 on error or unknown tier
+ */
+int sstv_decoder_set_demod(sstv_decoder_t *dec, sstv_demod_t demod);
+
+/**
+ * Set the front-end AGC timing
+ *
+ * The band-passed input is normalised by a gain that follows the signal
+ * peak. The signal runs `lookahead_ms` behind the peak detector, so the
+ * gain falls (attack) before a transient reaches the tone detectors and
+ * rises back (release) smoothly afterwards. The lookahead is rounded up
+ * to whole 16-sample blocks and also delays decoding by that much.
+ * Takes effect immediately and restarts the AGC (a lookahead worth of
+ * silence); kept across sstv_decoder_reset().
+ *
+ * Defaults: 5 ms lookahead, 1 ms attack, 100 ms release.
+ *
+ * @param dec Decoder handle
+ * @param lookahead_ms Delay ahead of the gain (> 0, max 20 ms; at most 64 blocks)
+ * @param attack_ms Time constant of falling gain (> 0, max 10000)
+ * @param release_ms Time constant of rising gain (> 0, max 10000)
+ * @return 0 on success, -1 on error
+ */
+int sstv_decoder_set_agc_timing(sstv_decoder_t *dec, double lookahead_ms,
+                                double attack_ms, double release_ms);
+
 /**
  * Get current AGC mode
  *
@@ -117,6 +266,52 @@ sstv_agc_mode_t sstv_decoder_get_agc_mode(sstv_decoder_t *dec);
  */
 void sstv_decoder_set_vis_tones(sstv_decoder_t *dec, double mark_hz, double space_hz);
 
+/**
+ * Set the target false-alarm rate of VIS acquisition
+ *
+ * While idle, the decoder tracks the noise floor (running mean and
+ * deviation) of its 1200 Hz sync and VIS mark/space detectors. A start
+ * bit must rise k deviations above the sync floor to begin acquisition,
+ * and k - 1 to keep it going; VIS bits need k - 1 above the mark/space
+ * floors. Each false start (an acquisition abandoned without a VIS lock)
+ * raises k, and k relaxes slowly while idle, so false starts settle near
+ * the target rate. Levels never go below the fixed MMSSTV thresholds,
+ * so clean signals decode exactly as before.
+ *
+ * Default: 6 per hour. Floors and counters restart on sstv_decoder_reset().
+ *
+ * @param dec Decoder handle
+ * @param per_hour Target false starts per hour (0 = fixed thresholds only, max 3600)
+ * @return 0 on success, -1 on error
+ */
+int sstv_decoder_set_false_alarm_rate(sstv_decoder_t *dec, double per_hour);
+
+/**
+ * Acquisition counters and current detection levels
+ */
+typedef struct {
+    uint64_t triggers;           /* Start bits held long enough to validate */
+    uint64_t vis_attempts;       /* Start bits validated, VIS bits decoded */
+    uint64_t false_starts;       /* Acquisitions abandoned without a VIS lock */
+    uint64_t vis_locks;          /* VIS codes decoded to a mode */
+    double noise_floor;          /* 1200 Hz detector idle mean */
+    double sync_level;           /* 1200 Hz level that starts acquisition */
+    double hold_level;           /* 1200 Hz level that keeps it going */
+    double k;                    /* Trigger deviations above the floor */
+    uint64_t vis_repairs;        /* VIS bits flipped by the soft-decision parity check */
+    double vis_confidence;       /* Mean soft bit margin of the last VIS lock (0-1),
+                                    0 if it fell back to the hard decisions */
+} sstv_sense_stats_t;
+
+/**
+ * Get acquisition counters and detection levels
+ *
+ * @param dec Decoder handle
+ * @param stats Output: counters since create/reset and current levels
+ * @return 0 on success, -1 on error
+ */
+int sstv_decoder_get_sense_stats(const sstv_decoder_t *dec, sstv_sense_stats_t *stats);
+
 /**
  * Feed audio samples into decoder
  *
@@ -150,6 +345,8 @@ typedef struct {
     int image_ready;             /* Image decoding complete */
     int current_line;            /* Current scan line */
     int total_lines;             /* Total lines in image */
+    uint64_t lock_sample;        /* Input sample (since create/reset) where the
+                                    VIS locked and image data starts; 0 before */
 } sstv_decoder_state_t;
 
 /**
@@ -161,6 +358,260 @@ typedef struct {
  */
 int sstv_decoder_get_state(sstv_decoder_t *dec, sstv_decoder_state_t *state);
 
+/**
+ * Journal the image buffer to a memory-mapped file
+ *
+ * When set, each frame's image buffer is placed in a file mapping at
+ * `path` (created/truncated at VIS lock) instead of heap memory. The file
+ * holds a small header (mode, geometry, lines completed) followed by the
+ * RGB24 pixels, and the header is updated as each line finishes. After a
+ * crash, sstv_decoder_recover_journal() returns the partial image. The
+ * file is left in place after decoding; the next frame overwrites it.
+ *
+ * Takes effect at the next VIS lock. POSIX only.
+ *
+ * @param dec Decoder handle
+ * @param path Journal file path, or NULL to go back to heap buffers
+ * @return 0 on success, -1 on error or if unsupported on this platform
+ */
+int sstv_decoder_set_journal(sstv_decoder_t *dec, const char *path);
+
+/**
+ * Recover an image from a journal file
+ *
+ * Does not need a decoder instance. The returned pixel buffer is a copy
+ * allocated with malloc(); release it with free(out_image->pixels).
+ *
+ * @param path Journal file written by a decoder
+ * @param out_image Output: RGB24 image (full frame; lines past
+ *                  lines_completed are black or partially written)
+ * @param mode_out Output: mode of the frame (may be NULL)
+ * @param lines_completed Output: number of fully decoded lines (may be NULL)
+ * @return 0 on success, -1 if the file is missing or not a valid journal
+ */
+int sstv_decoder_recover_journal(const char *path, sstv_image_t *out_image,
+                                 sstv_mode_t *mode_out, int *lines_completed);
+
+/**
+ * Line callback, invoked from inside sstv_decoder_feed() each time an
+ * image line is complete
+ *
+ * @param user Opaque pointer given to sstv_decoder_set_line_callback()
+ * @param line Index of the completed line (0-based)
+ * @param rgb Completed line, width * 3 bytes of RGB24 (valid during the call)
+ * @param width Image width in pixels
+ * @param height Image height in lines
+ */
+typedef void (*sstv_line_callback_t)(void *user, int line, const uint8_t *rgb,
+                                     int width, int height);
+
+/**
+ * Register a line callback (e.g. to stream rows into sstv_image_writer_t)
+ *
+ * @param dec Decoder handle
+ * @param cb Callback, or NULL to disable
+ * @param user Opaque pointer passed back to cb
+ */
+void sstv_decoder_set_line_callback(sstv_decoder_t *dec, sstv_line_callback_t cb, void *user);
+
+/**
+ * Line sync tracker status for the current (or last) frame
+ */
+typedef struct {
+    int locked;              /* Tracking the line sync pulses */
+    int lines_found;         /* Sync pulses matched in this frame */
+    int lines_missed;        /* Predicted pulses not found (coasted through) */
+    double period_samples;   /* Measured line period in audio samples */
+    double clock_ppm;        /* Measured period vs the mode's nominal, in ppm */
+    double last_error;       /* Last timing error in audio samples */
+    double last_peak;        /* Normalised correlation of the last pulse (0-1) */
+} sstv_line_sync_t;
+
+/**
+ * Get line sync tracker status
+ *
+ * During image reception a matched filter for the mode's 1200 Hz sync
+ * pulse locks onto the line syncs, and the measured line period corrects
+ * the pixel clock (slant). Modes without a 1200 Hz line sync (AVT, narrow
+ * modes) report all zeros.
+ *
+ * @param dec Decoder handle
+ * @param info Output: tracker status
+ * @return 0 on success, -1 on error
+ */
+int sstv_decoder_get_line_sync(const sstv_decoder_t *dec, sstv_line_sync_t *info);
+
+/**
+ * Signal quality of one received image line
+ */
+typedef struct {
+    float snr_db;            /* Video band (1500-2300 Hz) vs out-of-band noise */
+    float sync_peak;         /* Strongest line sync correlation (0-1), 0 = none */
+    uint8_t confidence;      /* Mean pixel confidence over the line (0-255) */
+} sstv_line_quality_t;
+
+/**
+ * Get per-line signal quality for the current (or last) frame
+ *
+ * Measured from the audio as each line is received: the energy in the
+ * SSTV video band is compared with an out-of-band slot above the SSTV
+ * spectrum (the noise floor), and the line sync matched filter reports
+ * how well the line's pulse correlated. Lets a caller triage images
+ * without a second pass over the audio. Cleared at each VIS lock and by
+ * sstv_decoder_redecode().
+ *
+ * @param dec Decoder handle
+ * @param lines Output: one entry per received line (may be NULL to only count)
+ * @param max_lines Capacity of lines
+ * @return Number of lines measured so far, or -1 on error
+ */
+int sstv_decoder_get_line_quality(const sstv_decoder_t *dec, sstv_line_quality_t *lines,
+                                  int max_lines);
+
+/**
+ * Keep a per-pixel confidence plane alongside the image
+ *
+ * Each pixel is rated from the video band and out-of-band energies over
+ * the few milliseconds around it: 0 at 0 dB SNR or below, rising linearly
+ * to 255 at 30 dB. Noise bursts and fades show up as dark regions. Costs
+ * width * height bytes per frame.
+ *
+ * Takes effect at the next VIS lock.
+ *
+ * @param dec Decoder handle
+ * @param enable 1 to keep the plane, 0 to stop
+ * @return 0 on success, -1 on error
+ */
+int sstv_decoder_set_confidence_enabled(sstv_decoder_t *dec, int enable);
+
+/**
+ * Get the confidence plane of the current (or last) frame
+ *
+ * The plane is owned by the decoder and stays valid until the next VIS
+ * lock, reset or sstv_decoder_redecode(). Lines not yet received are 0.
+ *
+ * @param dec Decoder handle
+ * @param out_plane Output: SSTV_GRAY8 plane with the image's geometry
+ * @return 0 on success, -1 if the plane is disabled or no frame was locked
+ */
+int sstv_decoder_get_confidence(sstv_decoder_t *dec, sstv_image_t *out_plane);
+
+/**
+ * Keep the demodulated frequency track for re-decoding
+ *
+ * While enabled, the decoder stores the instantaneous tone frequency,
+ * averaged down to about 6.4 kHz (twice the Robot 24 pixel rate) as
+ * uint16 values, and the start of every 1200 Hz sync pulse. At each VIS
+ * lock the track is trimmed to 2 seconds before the frame start, so it
+ * holds at most one frame (about 13 KB per second of audio).
+ *
+ * @param dec Decoder handle
+ * @param enable 1 to start recording, 0 to stop and free the track
+ * @return 0 on success, -1 on error
+ */
+int sstv_decoder_set_track_enabled(sstv_decoder_t *dec, int enable);
+
+/**
+ * Rebuild the last frame from the frequency track
+ *
+ * Re-runs pixel timing over the stored track instead of the audio, so a
+ * wrong mode, slanted image or misplaced start can be corrected in a few
+ * milliseconds. The result replaces the decoder image (read it with
+ * sstv_decoder_get_image()); the line callback fires for each line.
+ *
+ * @param dec Decoder handle
+ * @param mode Mode to decode the frame as
+ * @param slant_ppm Sample clock correction in ppm (positive = longer lines)
+ * @param offset Frame start shift in audio samples (negative = earlier)
+ * @return Number of complete lines rebuilt, or -1 if tracking is off, no
+ *         frame was locked, the mode is invalid or a frame is still
+ *         being received
+ */
+int sstv_decoder_redecode(sstv_decoder_t *dec, sstv_mode_t mode, double slant_ppm, int offset);
+
+/**
+ * Get the sync pulses seen in the frequency track
+ *
+ * @param dec Decoder handle
+ * @param offsets Output: pulse start positions in audio samples, relative
+ *                to the last frame start (may be NULL to only count)
+ * @param max_offsets Capacity of offsets
+ * @return Total number of pulses recorded, or -1 if tracking is off
+ */
+int sstv_decoder_get_sync_events(sstv_decoder_t *dec, int32_t *offsets, int max_offsets);
+
+/**
+ * Record a replay trace of this decoder session
+ *
+ * The trace holds the decoder configuration, every state-changing API
+ * call (reset, mode hint, VIS/AGC settings), each sstv_decoder_feed()
+ * block with its exact chunk boundaries, arrival time, processing time
+ * and returned status, plus a state checksum once per second of audio.
+ * Sample blocks are stored losslessly (Rice-coded when they are int16
+ * PCM). Replay it with the sstv_replay tool.
+ *
+ * Must be called before any samples are fed (or right after a reset).
+ *
+ * @param dec Decoder handle
+ * @param path Trace file to create
+ * @return 0 on success, -1 on error or if samples were already fed
+ */
+int sstv_decoder_enable_trace(sstv_decoder_t *dec, const char *path);
+
+/**
+ * Stop tracing and close the trace file (also done by sstv_decoder_free)
+ *
+ * @param dec Decoder handle
+ * @return 0 on success, -1 if no trace was open or a write failed
+ */
+int sstv_decoder_disable_trace(sstv_decoder_t *dec);
+
+/**
+ * Checksum of the decoder's signal-dependent state
+ *
+ * Covers the acquisition state machine, front-end AGC, image decoder
+ * position and pixel buffer. Two decoders fed identical input report
+ * identical checksums; used by trace replay to locate divergence.
+ *
+ * @param dec Decoder handle
+ * @return 64-bit FNV-1a checksum (0 if dec is NULL)
+ */
+uint64_t sstv_decoder_get_checksum(const sstv_decoder_t *dec);
+
+/**
+ * Per-stage processing time estimates
+ */
+typedef struct {
+    uint64_t samples;        /* Samples processed while profiling */
+    uint64_t sampled;        /* Samples actually timed (1 in 32) */
+    uint64_t frontend_ns;    /* Clip, BPF, AGC */
+    uint64_t tone_ns;        /* 1080/1200/1320/1900 Hz tone detectors */
+    uint64_t sync_ns;        /* Sync/VIS state machine */
+    uint64_t image_ns;       /* Pixel demodulation */
+} sstv_decoder_profile_t;
+
+/**
+ * Enable or disable per-stage profiling (also clears the counters)
+ *
+ * While profiling, samples go through the decoder one at a time so each
+ * stage can be timed (idle and image reception normally run in blocks);
+ * the results are identical, only the dispatch overhead differs.
+ *
+ * @param dec Decoder handle
+ * @param enable 1 to enable, 0 to disable
+ */
+void sstv_decoder_set_profiling(sstv_decoder_t *dec, int enable);
+
+/**
+ * Get per-stage time estimates, scaled from the timed samples to all
+ * samples processed since profiling was enabled
+ *
+ * @param dec Decoder handle
+ * @param profile Output: stage times
+ * @return 0 on success, -1 on error
+ */
+int sstv_decoder_get_profile(const sstv_decoder_t *dec, sstv_decoder_profile_t *profile);
+
 /**
  * Set debug level (0=quiet, 1=errors, 2=verbose)
  *
@@ -106,7 +106,11 @@ typedef struct {
     int is_color;                 /* 1=color, 0=grayscale */
 } sstv_mode_info_t;
 
-/* Encoder handle (opaque) */
+/* Encoder handle (opaque)
+ *
+ * Thread safety: all mutable state lives in the handle, so distinct
+ * handles may be used concurrently from different threads. A single
+ * handle must not be used by two threads at once. */
 typedef struct sstv_encoder_s sstv_encoder_t;
 
 /*==============================================================================
@@ -225,6 +229,121 @@ const sstv_mode_info_t* sstv_get_all_modes(size_t *count);
  */
 int sstv_find_mode_by_name(const char *name);
 
+/*==============================================================================
+ * MODE REGISTRY API
+ *
+ * Every mode, built-in or registered at runtime, is described by one
+ * sstv_mode_desc_t. The encoder, the decoder's VIS lookup and its line
+ * sync take timing, geometry and VIS from here, and lookups by VIS code,
+ * name and line period are constant time (perfect-hash or direct-address
+ * indexes rebuilt on registration). Readers never lock: registration
+ * publishes a new index snapshot and earlier descriptor pointers stay
+ * valid. Each registration keeps its descriptor (a few hundred bytes)
+ * for the life of the process; index snapshots are reused.
+ *============================================================================*/
+
+/* First mode id handed out by sstv_register_mode() */
+#define SSTV_MODE_CUSTOM_FIRST 256
+
+/* Custom modes that can be registered at once */
+#define SSTV_MAX_CUSTOM_MODES 32
+
+/* Order of the colour channels within one transmitted line */
+typedef enum {
+    SSTV_LAYOUT_YC = 0,      /* Y, R-Y, B-Y (Robot 24/72, MR, ML) */
+    SSTV_LAYOUT_YC_ALT,      /* Y, then R-Y or B-Y on alternate lines (Robot 36) */
+    SSTV_LAYOUT_YC_PAIR,     /* Y0, R-Y, B-Y, Y1: two image lines per sync (PD, MP, MN) */
+    SSTV_LAYOUT_GBR,         /* Green, blue, red (Martin, Scottie) */
+    SSTV_LAYOUT_RGB,         /* Red, green, blue (AVT, SC2, Pasokon, MC) */
+    SSTV_LAYOUT_MONO         /* Luminance only (B/W) */
+} sstv_channel_layout_t;
+
+/* Full mode description */
+typedef struct {
+    sstv_mode_t mode;              /* Mode id */
+    const char *name;              /* Mode name */
+    uint32_t width;                /* Image width */
+    uint32_t height;               /* Image height */
+    int is_color;                  /* 1=color, 0=grayscale */
+    uint8_t vis_code;              /* VIS byte (after the 0x23 prefix for 16-bit) */
+    uint8_t vis_bits;              /* 8, 16, or 0 when the mode has no VIS */
+    double line_ms;                /* One transmitted line, sync to sync */
+    uint32_t lines;                /* Transmitted lines per frame */
+    double sync_ms;                /* Line sync pulse length */
+    double sync_hz;                /* Line sync tone (1200, or 1900 for narrow modes) */
+    double black_hz;               /* Frequency of level 0 */
+    double white_hz;               /* Frequency of level 255 */
+    sstv_channel_layout_t layout;  /* Channel order */
+    sstv_mode_t base;              /* Built-in mode whose line format is used */
+} sstv_mode_desc_t;
+
+/* Definition of a runtime mode (see sstv_register_mode) */
+typedef struct {
+    const char *name;              /* Unique, case-insensitive, up to 31 chars */
+    sstv_mode_t base;              /* Built-in mode providing line format and width */
+    uint32_t height;               /* Image height, 0 = base height */
+    double line_ms;                /* Line period, 0 = base; the line is stretched to fit */
+    uint8_t vis_code;              /* VIS byte, 0 = no VIS */
+    int vis_extended;              /* 1 = send 0x23 then vis_code (16-bit VIS) */
+} sstv_custom_mode_t;
+
+/**
+ * Get the full description of a mode
+ *
+ * @param mode Built-in or registered mode
+ * @return Descriptor (valid for the life of the process), or NULL
+ */
+const sstv_mode_desc_t* sstv_get_mode_desc(sstv_mode_t mode);
+
+/**
+ * Find the mode a VIS code announces
+ *
+ * @param vis_code VIS byte as received (parity bit included)
+ * @param extended 1 if the byte followed the 0x23 prefix of a 16-bit VIS
+ * @return Mode, or -1 if no mode uses this code
+ */
+int sstv_find_mode_by_vis(uint8_t vis_code, int extended);
+
+/**
+ * Find modes whose line period is within tol_ms of line_ms
+ *
+ * Several modes share a period (MP73 and MP73-N), so all matches are
+ * returned, nearest first.
+ *
+ * @param line_ms Measured sync-to-sync interval
+ * @param tol_ms Tolerance (at most 8 ms)
+ * @param modes Output modes (may be NULL to only count)
+ * @param max_modes Capacity of modes
+ * @return Number of matches, or -1 on invalid arguments
+ */
+int sstv_find_modes_by_line_ms(double line_ms, double tol_ms,
+                               sstv_mode_t *modes, size_t max_modes);
+
+/**
+ * Register a mode at runtime
+ *
+ * The new mode reuses a built-in line format, optionally with another
+ * height, line period and VIS code, and can then be used with the
+ * encoder and decoder like a built-in mode.
+ *
+ * @param def Mode definition
+ * @return New mode id (SSTV_MODE_CUSTOM_FIRST or above), or -1 if the
+ *         definition is invalid, the name or VIS code is taken, or the
+ *         registry is full
+ */
+int sstv_register_mode(const sstv_custom_mode_t *def);
+
+/**
+ * Remove a registered mode
+ *
+ * Descriptors already handed out stay readable; new lookups no longer
+ * find the mode and encoders can no longer be created for it.
+ *
+ * @param mode Mode returned by sstv_register_mode()
+ * @return 0 on success, -1 if mode is not a registered custom mode
+ */
+int sstv_unregister_mode(sstv_mode_t mode);
+
 /*==============================================================================
  * UTILITY API
  *============================================================================*/
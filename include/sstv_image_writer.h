@@ -0,0 +1,90 @@
+/*
+ * libsstv_decoder - Streaming image writers for decoded SSTV frames
+ *
+ * Copyright (C) 2026 (library port)
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef SSTV_IMAGE_WRITER_H
+#define SSTV_IMAGE_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Output formats */
+typedef enum {
+    SSTV_IMAGE_PPM = 0,        /* Binary PPM (P6) */
+    SSTV_IMAGE_QOI,            /* Quite OK Image format */
+    SSTV_IMAGE_PNG,            /* PNG, fast fixed-Huffman deflate */
+    SSTV_IMAGE_PNG_STORED      /* PNG, stored (uncompressed) deflate blocks */
+} sstv_image_format_t;
+
+/* Opaque writer handle */
+typedef struct sstv_image_writer_s sstv_image_writer_t;
+
+/**
+ * Open a streaming image writer
+ *
+ * Rows are encoded and written as they arrive; the writer keeps at most
+ * two rows of state, so memory does not grow with image height. The file
+ * is complete as soon as the last row has been written.
+ *
+ * @param path Output file path
+ * @param format Output format
+ * @param width Image width in pixels
+ * @param height Image height in pixels
+ * @return Writer handle, or NULL on error
+ */
+sstv_image_writer_t* sstv_image_writer_open(const char *path,
+                                            sstv_image_format_t format,
+                                            uint32_t width, uint32_t height);
+
+/**
+ * Append the next RGB24 row
+ *
+ * @param w Writer handle
+ * @param rgb Row of width * 3 bytes (R, G, B)
+ * @return 0 on success, -1 on I/O error or if all rows were already written
+ */
+int sstv_image_writer_write_row(sstv_image_writer_t *w, const uint8_t *rgb);
+
+/**
+ * Number of rows written so far
+ *
+ * @param w Writer handle
+ * @return Rows written, or -1 if w is NULL
+ */
+int sstv_image_writer_rows(const sstv_image_writer_t *w);
+
+/**
+ * Finish the file and free the writer
+ *
+ * If fewer than `height` rows were written, the remainder is filled with
+ * black so the file is still a valid image.
+ *
+ * @param w Writer handle (may be NULL)
+ * @return 0 on success, -1 on I/O error
+ */
+int sstv_image_writer_close(sstv_image_writer_t *w);
+
+/**
+ * Conventional file extension for a format (without the dot)
+ *
+ * @param format Output format
+ * @return Extension string ("ppm", "qoi" or "png")
+ */
+const char* sstv_image_format_ext(sstv_image_format_t format);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SSTV_IMAGE_WRITER_H */
@@ -0,0 +1,347 @@
+/*
+ * libsstv_pipeline - Composable stage graph around the encoder and decoder
+ *
+ * Copyright (C) 2026 (library port)
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef SSTV_PIPELINE_H
+#define SSTV_PIPELINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sstv_encoder.h"
+#include "sstv_decoder.h"
+#include "sstv_image_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A pipeline is a graph of stages (sources, filters, sinks) that pass
+ * blocks to each other. Blocks are reference counted and shared: a stage
+ * with several outputs hands the same block to all of them, stages that
+ * do not change the audio forward the block they received, and a stage
+ * that modifies audio in place only copies when someone else still holds
+ * a reference. Audio is mono float at 16-bit PCM scale (+-32767), the
+ * level sstv_decoder_feed() expects.
+ *
+ * Stages are added and linked before sstv_pipeline_run(). The pipeline
+ * runs either inline on the calling thread (blocks pushed depth-first,
+ * so each block stays cache-hot through the whole chain) or threaded
+ * (one thread per stage, bounded queues between them). Both modes
+ * deliver the same blocks in the same order to every stage, so the
+ * output is identical.
+ */
+
+/* Opaque handles */
+typedef struct sstv_pipeline_s sstv_pipeline_t;
+typedef struct sstv_stage_s sstv_stage_t;
+
+/* Block payload types; a link must join stages of the same type */
+typedef enum {
+    SSTV_BLOCK_AUDIO = 0,       /* Mono float samples */
+    SSTV_BLOCK_IMAGE_ROW        /* One decoded RGB24 image row */
+} sstv_block_type_t;
+
+/* Read-only view of a block handed to callback sinks */
+typedef struct {
+    sstv_block_type_t type;
+
+    /* SSTV_BLOCK_AUDIO */
+    const float *samples;
+    size_t count;
+    double sample_rate;
+    uint64_t position;          /* Index of samples[0] in the stream */
+
+    /* SSTV_BLOCK_IMAGE_ROW */
+    const uint8_t *row;         /* width * 3 bytes, R G B */
+    uint32_t width;
+    uint32_t height;
+    uint32_t line;              /* Row index within the frame */
+    uint32_t frame;             /* Frame index, counted per decoder stage */
+    sstv_mode_t mode;
+    int last_row;               /* 1 on the final row of the frame */
+} sstv_block_t;
+
+/* Run modes */
+typedef enum {
+    SSTV_PIPELINE_INLINE = 0,   /* Calling thread, depth-first */
+    SSTV_PIPELINE_THREADED      /* One thread per stage, bounded queues */
+} sstv_pipeline_mode_t;
+
+/* Channel simulator settings (see sstv_pipeline_add_channel) */
+typedef struct {
+    float gain;                 /* Signal gain before impairments (1.0 = unchanged) */
+    float noise_rms;            /* AWGN level in PCM units (0 = none) */
+    float fade_hz;              /* Rayleigh fading bandwidth (0 = no fading) */
+    float fade_depth_db;        /* Deepest fade, e.g. 6.0 */
+    float hum_level;            /* 50/100/150 Hz mains hum amplitude (0 = none) */
+    uint32_t seed;              /* Noise and fading seed; same seed, same output */
+} sstv_channel_params_t;
+
+/* Per-stage counters (see sstv_pipeline_get_stage_stats) */
+typedef struct {
+    uint64_t blocks_in;
+    uint64_t blocks_out;
+    uint64_t samples_in;        /* Audio samples, or rows for image blocks */
+    uint64_t samples_out;
+    uint64_t busy_ns;           /* Time spent in the stage's own processing */
+    uint64_t copies;            /* Blocks copied because they were shared */
+    int queue_peak;             /* Deepest input queue seen (threaded runs) */
+} sstv_stage_stats_t;
+
+/* Callback sink; return 0 to continue, non-zero to stop the pipeline */
+typedef int (*sstv_block_callback_t)(void *user, const sstv_block_t *block);
+
+/*==============================================================================
+ * PIPELINE
+ *============================================================================*/
+
+/**
+ * Create an empty pipeline
+ *
+ * @return Pipeline handle, or NULL on allocation failure
+ */
+sstv_pipeline_t* sstv_pipeline_create(void);
+
+/**
+ * Free a pipeline and all of its stages
+ *
+ * Encoders and decoders passed to the stage constructors are not freed.
+ *
+ * @param p Pipeline handle (may be NULL)
+ */
+void sstv_pipeline_free(sstv_pipeline_t *p);
+
+/**
+ * Set the audio block size used by sources and resamplers
+ *
+ * Default 1024 samples (4 KB), small enough that a block stays in L1
+ * while it travels through the chain.
+ *
+ * @param p Pipeline handle
+ * @param samples Samples per block (64 to 1048576)
+ * @return 0 on success, -1 on invalid arguments or while running
+ */
+int sstv_pipeline_set_block_size(sstv_pipeline_t *p, size_t samples);
+
+/**
+ * Set the bounded queue depth between stages in threaded runs
+ *
+ * A producer blocks once its consumer has this many blocks waiting, so
+ * memory stays bounded when a later stage is slower. Default 8.
+ *
+ * @param p Pipeline handle
+ * @param depth Blocks per queue (1 to 1024)
+ * @return 0 on success, -1 on invalid arguments or while running
+ */
+int sstv_pipeline_set_queue_depth(sstv_pipeline_t *p, int depth);
+
+/**
+ * Connect the output of one stage to the input of another
+ *
+ * A stage may feed any number of stages (they share its blocks) but
+ * takes its input from exactly one. Both ends must carry the same block
+ * type, and the graph must stay acyclic.
+ *
+ * @param p Pipeline handle
+ * @param from Producing stage (a source or filter)
+ * @param to Consuming stage (a filter or sink)
+ * @return 0 on success, -1 on type mismatch, second input or invalid stage
+ */
+int sstv_pipeline_link(sstv_pipeline_t *p, sstv_stage_t *from, sstv_stage_t *to);
+
+/**
+ * Run the pipeline until every source is exhausted
+ *
+ * All stages see end-of-stream and flush (resampler and DNR tails, WAV
+ * header, image padding) before this returns. A pipeline can be run
+ * once.
+ *
+ * @param p Pipeline handle
+ * @param mode SSTV_PIPELINE_INLINE or SSTV_PIPELINE_THREADED
+ * @return 0 on success, -1 on error (see sstv_pipeline_error)
+ */
+int sstv_pipeline_run(sstv_pipeline_t *p, sstv_pipeline_mode_t mode);
+
+/**
+ * Describe the last error
+ *
+ * @param p Pipeline handle
+ * @return Message naming the failing stage, or "" if none
+ */
+const char* sstv_pipeline_error(const sstv_pipeline_t *p);
+
+/**
+ * Get a stage's counters
+ *
+ * @param stage Stage handle
+ * @param stats Output counters
+ * @return 0 on success, -1 on invalid arguments
+ */
+int sstv_pipeline_get_stage_stats(const sstv_stage_t *stage, sstv_stage_stats_t *stats);
+
+/*==============================================================================
+ * SOURCES (audio out)
+ *============================================================================*/
+
+/**
+ * WAV file source
+ *
+ * Accepts PCM 16/24/32-bit and 32-bit float, any channel count (mixed
+ * down to mono). On POSIX systems the file is memory-mapped and blocks
+ * are converted straight from the mapping.
+ *
+ * @param p Pipeline handle
+ * @param path WAV file path
+ * @return Stage handle, or NULL if the file is missing or unsupported
+ */
+sstv_stage_t* sstv_pipeline_add_wav_source(sstv_pipeline_t *p, const char *path);
+
+/**
+ * Caller-memory source
+ *
+ * Blocks point straight into @p samples, which must stay valid and
+ * unchanged until the run finishes; nothing is copied unless a later
+ * stage modifies audio in place.
+ *
+ * @param p Pipeline handle
+ * @param samples Audio at PCM scale
+ * @param count Number of samples
+ * @param sample_rate Sample rate in Hz
+ * @return Stage handle, or NULL on invalid arguments
+ */
+sstv_stage_t* sstv_pipeline_add_buffer_source(sstv_pipeline_t *p, const float *samples,
+                                              size_t count, double sample_rate);
+
+/**
+ * Encoder source
+ *
+ * Generates audio from a configured encoder (image and VIS already
+ * set) until it completes, scaled from +-1.0 to PCM by @p amplitude.
+ * The encoder stays owned by the caller.
+ *
+ * @param p Pipeline handle
+ * @param enc Encoder handle
+ * @param sample_rate Rate the encoder was created with
+ * @param amplitude Peak level, e.g. 16000
+ * @return Stage handle, or NULL on invalid arguments
+ */
+sstv_stage_t* sstv_pipeline_add_encoder_source(sstv_pipeline_t *p, sstv_encoder_t *enc,
+                                               double sample_rate, float amplitude);
+
+/*==============================================================================
+ * FILTERS (audio in, audio or image rows out)
+ *============================================================================*/
+
+/**
+ * Sample rate converter
+ *
+ * Windowed-sinc polyphase interpolator for any ratio; when the input
+ * already runs at @p out_rate, blocks pass through untouched.
+ *
+ * @param p Pipeline handle
+ * @param out_rate Output sample rate in Hz
+ * @return Stage handle, or NULL on invalid arguments
+ */
+sstv_stage_t* sstv_pipeline_add_resampler(sstv_pipeline_t *p, double out_rate);
+
+/**
+ * HF channel simulator: gain, Rayleigh fading, AWGN and mains hum
+ *
+ * Deterministic for a given seed. Modifies blocks in place when it holds
+ * the only reference.
+ *
+ * @param p Pipeline handle
+ * @param params Channel settings
+ * @return Stage handle, or NULL on invalid arguments
+ */
+sstv_stage_t* sstv_pipeline_add_channel(sstv_pipeline_t *p, const sstv_channel_params_t *params);
+
+/**
+ * Spectral-subtraction noise reduction
+ *
+ * Streams the same subtraction the offline DNR applies, normalised to
+ * unity gain. The stage holds back frame_size - hop_size samples and
+ * flushes them at end of stream, so output stays aligned with input and
+ * the sample count is preserved.
+ *
+ * @param p Pipeline handle
+ * @param frame_size FFT size, power of two (0 = 1024)
+ * @param hop_size Hop, at most frame_size / 2 (0 = frame_size / 4)
+ * @return Stage handle, or NULL on invalid arguments
+ */
+sstv_stage_t* sstv_pipeline_add_dnr(sstv_pipeline_t *p, size_t frame_size, size_t hop_size);
+
+/**
+ * Decoder stage: audio in, image rows out
+ *
+ * Feeds every block to @p dec and emits each completed line as an
+ * SSTV_BLOCK_IMAGE_ROW block. After a frame completes the decoder is
+ * reset so later transmissions in the same stream are decoded too (the
+ * reset clears any mode hint, so later frames need VIS).
+ * Incoming audio must run at @p sample_rate. The decoder stays owned by
+ * the caller, and its line callback is taken over for the run.
+ *
+ * @param p Pipeline handle
+ * @param dec Decoder handle
+ * @param sample_rate Rate the decoder was created with
+ * @return Stage handle, or NULL on invalid arguments
+ */
+sstv_stage_t* sstv_pipeline_add_decoder(sstv_pipeline_t *p, sstv_decoder_t *dec,
+                                        double sample_rate);
+
+/*==============================================================================
+ * SINKS
+ *============================================================================*/
+
+/**
+ * 16-bit mono WAV file sink (audio)
+ *
+ * @param p Pipeline handle
+ * @param path Output file path
+ * @return Stage handle, or NULL if the file cannot be created
+ */
+sstv_stage_t* sstv_pipeline_add_wav_sink(sstv_pipeline_t *p, const char *path);
+
+/**
+ * Image file sink (image rows)
+ *
+ * Streams rows through sstv_image_writer; each frame goes to its own
+ * file named "<prefix>_<frame>.<ext>". A frame cut short by the end of
+ * the stream is padded with black rows.
+ *
+ * @param p Pipeline handle
+ * @param prefix Output path prefix
+ * @param format Image format
+ * @return Stage handle, or NULL on invalid arguments
+ */
+sstv_stage_t* sstv_pipeline_add_image_sink(sstv_pipeline_t *p, const char *prefix,
+                                           sstv_image_format_t format);
+
+/**
+ * Callback sink (either block type)
+ *
+ * In threaded runs the callback runs on the sink's own thread.
+ *
+ * @param p Pipeline handle
+ * @param type Block type the sink accepts
+ * @param cb Callback, invoked once per block
+ * @param user Passed through to @p cb
+ * @return Stage handle, or NULL on invalid arguments
+ */
+sstv_stage_t* sstv_pipeline_add_callback_sink(sstv_pipeline_t *p, sstv_block_type_t type,
+                                              sstv_block_callback_t cb, void *user);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SSTV_PIPELINE_H */
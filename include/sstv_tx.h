@@ -0,0 +1,113 @@
+/*
+ * libsstv_encoder - Pull-model transmit adapter for real-time audio callbacks
+ *
+ * Copyright (C) 2026 (library port)
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef SSTV_TX_H
+#define SSTV_TX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sstv_encoder.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The adapter runs an encoder on its own producer thread, which keeps a
+ * single-producer/single-consumer ring filled a latency budget ahead of
+ * the reader. The audio callback calls sstv_tx_pull(), which only copies
+ * out of the ring: no locks, no allocation, no system calls. Line set-up
+ * and color conversion in sstv_encoder_generate() then never run inside
+ * the callback.
+ */
+
+/* Opaque adapter handle */
+typedef struct sstv_tx_s sstv_tx_t;
+
+/* Counters (see sstv_tx_get_stats) */
+typedef struct {
+    uint64_t frames_generated;   /* Samples written into the ring */
+    uint64_t frames_pulled;      /* Encoder samples handed to the reader */
+    uint64_t underruns;          /* Pulls that came up short before the end */
+    uint64_t underrun_frames;    /* Silence frames inserted by those pulls */
+    uint32_t capacity;           /* Ring size in frames */
+    uint32_t min_fill;           /* Lowest fill seen by a pull after start */
+    int complete;                /* Encoder finished and ring drained */
+} sstv_tx_stats_t;
+
+/**
+ * Create an adapter around a configured encoder
+ *
+ * The encoder (image and VIS already set) stays owned by the caller and
+ * must not be used directly until sstv_tx_free().
+ *
+ * @param enc Encoder handle
+ * @param sample_rate Rate the encoder was created with
+ * @param latency_ms How far ahead the producer keeps the ring (1 to 2000)
+ * @return Adapter handle, or NULL on invalid arguments or allocation failure
+ */
+sstv_tx_t* sstv_tx_create(sstv_encoder_t *enc, double sample_rate, double latency_ms);
+
+/**
+ * Pre-fill the ring to the latency budget and start the producer thread
+ *
+ * Call before the audio stream starts pulling.
+ *
+ * @param tx Adapter handle
+ * @return 0 on success, -1 if already started or the thread cannot start
+ */
+int sstv_tx_start(sstv_tx_t *tx);
+
+/**
+ * Copy the next frames into out (real-time safe)
+ *
+ * Always fills all `frames` samples: once the ring runs dry the rest is
+ * silence, counted as an underrun unless the encoder has finished.
+ *
+ * @param tx Adapter handle
+ * @param out Destination, mono float +-1.0
+ * @param frames Samples wanted
+ * @return Encoder samples copied (the rest of out is silence)
+ */
+size_t sstv_tx_pull(sstv_tx_t *tx, float *out, size_t frames);
+
+/**
+ * Check whether the whole transmission has been pulled
+ *
+ * @param tx Adapter handle
+ * @return 1 when the encoder finished and the ring is empty, else 0
+ */
+int sstv_tx_is_done(const sstv_tx_t *tx);
+
+/**
+ * Read the counters (real-time safe)
+ *
+ * @param tx Adapter handle
+ * @param stats Output counters
+ * @return 0 on success, -1 on invalid arguments
+ */
+int sstv_tx_get_stats(const sstv_tx_t *tx, sstv_tx_stats_t *stats);
+
+/**
+ * Stop the producer thread and free the adapter
+ *
+ * The encoder is not freed.
+ *
+ * @param tx Adapter handle (may be NULL)
+ */
+void sstv_tx_free(sstv_tx_t *tx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SSTV_TX_H */
@@ -7,55 +7,103 @@
 #include <cmath>
 
 SpectralSubtractionDNR::SpectralSubtractionDNR(size_t frame_size, size_t hop_size)
-    : frame_size_(frame_size), hop_size_(hop_size) {}
-
-void SpectralSubtractionDNR::process(std::vector<double>& audio) {
-    size_t n = audio.size();
-    if (n < frame_size_) return;
-    std::vector<double> window(frame_size_, 0.0);
+    : frame_size_(frame_size), hop_size_(hop_size), window_(frame_size, 0.0) {
     // Hann window
     for (size_t i = 0; i < frame_size_; ++i)
-        window[i] = 0.5 * (1 - cos(2 * M_PI * i / (frame_size_ - 1)));
-    std::vector<double> output(n, 0.0);
-    std::vector<double> overlap(frame_size_ - hop_size_, 0.0);
+        window_[i] = 0.5 * (1 - cos(2 * M_PI * i / (frame_size_ - 1)));
+    // Mean overlap-add gain of the squared window at this hop
+    double sum = 0.0;
+    for (size_t i = 0; i < frame_size_; ++i) sum += window_[i] * window_[i];
+    if (sum > 0.0) stream_gain_ = (double)hop_size_ / sum;
+    stream_in_.assign(frame_size_, 0.0);
+    stream_ola_.assign(frame_size_, 0.0);
+    // Prime with silence so the first frame ends hop_size_ samples in
+    stream_fill_ = frame_size_ - hop_size_;
+    stream_skip_ = frame_size_ - hop_size_;
+}
+
+void SpectralSubtractionDNR::subtract_frame(std::vector<double>& frame) {
     constexpr double noise_floor_factor = 0.08; // 8% spectral floor (more aggressive)
     constexpr double noise_smooth_alpha = 0.90; // Faster EMA smoothing for noise estimate
-    for (size_t pos = 0; pos + frame_size_ <= n; pos += hop_size_) {
-        std::vector<double> frame(audio.begin() + pos, audio.begin() + pos + frame_size_);
-        for (size_t i = 0; i < frame_size_; ++i) frame[i] *= window[i];
-        std::vector<std::complex<double>> spectrum(frame_size_);
-        fft(frame, spectrum);
-        std::vector<double> mag(frame_size_);
-        for (size_t i = 0; i < frame_size_; ++i) mag[i] = std::abs(spectrum[i]);
-        if (!noise_initialized_) {
-            noise_mag_ = mag;
-            noise_initialized_ = true;
-        } else {
-            // Exponential moving average smoothing for noise estimate
-            for (size_t i = 0; i < frame_size_; ++i) {
-                noise_mag_[i] = noise_smooth_alpha * noise_mag_[i] + (1.0 - noise_smooth_alpha) * mag[i];
-            }
-        }
-        // Spectral subtraction with spectral floor
+    for (size_t i = 0; i < frame_size_; ++i) frame[i] *= window_[i];
+    std::vector<std::complex<double>> spectrum(frame_size_);
+    fft(frame, spectrum);
+    std::vector<double> mag(frame_size_);
+    for (size_t i = 0; i < frame_size_; ++i) mag[i] = std::abs(spectrum[i]);
+    if (!noise_initialized_) {
+        noise_mag_ = mag;
+        noise_initialized_ = true;
+    } else {
+        // Exponential moving average smoothing for noise estimate
         for (size_t i = 0; i < frame_size_; ++i) {
-            double floor_val = noise_floor_factor * noise_mag_[i];
-            double clean_mag = std::max(mag[i] - noise_mag_[i], floor_val);
-            double phase = std::arg(spectrum[i]);
-            spectrum[i] = std::polar(clean_mag, phase);
+            noise_mag_[i] = noise_smooth_alpha * noise_mag_[i] + (1.0 - noise_smooth_alpha) * mag[i];
         }
-        std::vector<double> frame_out(frame_size_);
-        ifft(spectrum, frame_out);
+    }
+    // Spectral subtraction with spectral floor
+    for (size_t i = 0; i < frame_size_; ++i) {
+        double floor_val = noise_floor_factor * noise_mag_[i];
+        double clean_mag = std::max(mag[i] - noise_mag_[i], floor_val);
+        double phase = std::arg(spectrum[i]);
+        spectrum[i] = std::polar(clean_mag, phase);
+    }
+    ifft(spectrum, frame);
+    for (size_t i = 0; i < frame_size_; ++i) frame[i] *= window_[i];
+}
+
+void SpectralSubtractionDNR::process(std::vector<double>& audio) {
+    size_t n = audio.size();
+    if (n < frame_size_) return;
+    std::vector<double> output(n, 0.0);
+    std::vector<double> frame(frame_size_);
+    for (size_t pos = 0; pos + frame_size_ <= n; pos += hop_size_) {
+        std::copy(audio.begin() + pos, audio.begin() + pos + frame_size_, frame.begin());
+        subtract_frame(frame);
         // Overlap-add
         for (size_t i = 0; i < frame_size_; ++i) {
             size_t out_idx = pos + i;
             if (out_idx < n) {
-                output[out_idx] += frame_out[i] * window[i];
+                output[out_idx] += frame[i];
             }
         }
     }
     audio = output;
 }
 
+void SpectralSubtractionDNR::stream_push(double x, std::vector<float>& out) {
+    stream_in_[stream_fill_++] = x;
+    if (stream_fill_ < frame_size_) return;
+
+    std::vector<double> frame(stream_in_);
+    subtract_frame(frame);
+    for (size_t i = 0; i < frame_size_; ++i) stream_ola_[i] += frame[i];
+
+    // The first hop_size_ samples have all their overlapping frames now
+    for (size_t i = 0; i < hop_size_; ++i) {
+        if (stream_skip_) {
+            stream_skip_--;
+        } else if (stream_out_total_ < stream_in_total_) {
+            out.push_back((float)(stream_ola_[i] * stream_gain_));
+            stream_out_total_++;
+        }
+    }
+    std::copy(stream_ola_.begin() + hop_size_, stream_ola_.end(), stream_ola_.begin());
+    std::fill(stream_ola_.end() - hop_size_, stream_ola_.end(), 0.0);
+    std::copy(stream_in_.begin() + hop_size_, stream_in_.end(), stream_in_.begin());
+    stream_fill_ -= hop_size_;
+}
+
+void SpectralSubtractionDNR::process_stream(const float* in, size_t n, std::vector<float>& out) {
+    for (size_t i = 0; i < n; ++i) {
+        stream_in_total_++;
+        stream_push((double)in[i], out);
+    }
+}
+
+void SpectralSubtractionDNR::flush_stream(std::vector<float>& out) {
+    // Silence pushes the held-back samples through; it adds no output
+    while (stream_out_total_ < stream_in_total_) stream_push(0.0, out);
+}
+
 void SpectralSubtractionDNR::set_noise_estimate(const std::vector<double>& noise_mag) {
     noise_mag_ = noise_mag;
     noise_initialized_ = true;
@@ -2,6 +2,7 @@
 // Simple spectral subtraction DNR module for SSTV DSP pipeline
 // (C) 2026
 #pragma once
+#include <complex>
 #include <vector>
 #include <cstddef>
 
@@ -10,11 +11,28 @@ public:
     SpectralSubtractionDNR(size_t frame_size = 1024, size_t hop_size = 256); // 75% overlap by default
     // Process a mono audio buffer in-place
     void process(std::vector<double>& audio);
+    // Streaming: appends the output for n more input samples to out. Output
+    // is aligned with input and normalised to unity overlap-add gain; the
+    // last frame_size - hop_size samples are held back until flush_stream().
+    void process_stream(const float* in, size_t n, std::vector<float>& out);
+    void flush_stream(std::vector<float>& out);
     // Optionally set noise estimate externally
     void set_noise_estimate(const std::vector<double>& noise_mag);
 private:
     size_t frame_size_;
     size_t hop_size_;
+    std::vector<double> window_;    // Hann, applied before FFT and after IFFT
+    // Streaming state
+    std::vector<double> stream_in_; // last frame_size_ input samples
+    std::vector<double> stream_ola_;
+    size_t stream_fill_ = 0;
+    size_t stream_skip_ = 0;        // pre-roll outputs still to drop
+    size_t stream_in_total_ = 0;
+    size_t stream_out_total_ = 0;
+    double stream_gain_ = 1.0;      // 1 / overlap-add gain of window^2
+    // Window, subtract and window again, in place
+    void subtract_frame(std::vector<double>& frame);
+    void stream_push(double x, std::vector<float>& out);
     std::vector<double> noise_mag_; // running noise estimate (magnitude spectrum)
     bool noise_initialized_ = false;
     // Placeholder FFT/IFFT methods (replace with your FFT library)
@@ -0,0 +1,240 @@
+/*
+ * Y/R-Y/B-Y <-> RGB row conversion
+ *
+ * TX keeps the exact double-precision arithmetic of MMSSTV's transform so
+ * that encoded images do not change: no integer form reproduces it (gray
+ * 240 gives R-Y 127 while its neighbours give 128), so the SIMD kernel
+ * runs the same multiplies and adds in the same order in two lanes. RX
+ * has no such constraint and uses Q13 fixed point.
+ */
+
+#include "color.h"
+
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define SSTV_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+/* Inverse transform in Q13 (MMSSTV YCtoRGB coefficients) */
+#define YC_SHIFT 13
+#define YC_ROUND (1 << (YC_SHIFT - 1))
+static const int kYcY = 9539;                /* 1.164457 */
+static const int kYcRV = 13075;              /* 1.596128 */
+static const int kYcGV = 6660;               /* 0.813022 */
+static const int kYcGU = 3210;               /* 0.391786 */
+static const int kYcBU = 16526;              /* 2.017364 */
+
+static inline int clamp_0_255(int v) {
+    if (v < 0) return 0;
+    if (v > 255) return 255;
+    return v;
+}
+
+void sstv_color_rgb_to_yc_px(int r, int g, int b, int *y, int *ry, int *by) {
+    double R = r;
+    double G = g;
+    double B = b;
+    *y = clamp_0_255((int)(16.0 + (0.256773 * R + 0.504097 * G + 0.097900 * B)));
+    *ry = clamp_0_255((int)(128.0 + (0.439187 * R - 0.367766 * G - 0.071421 * B)));
+    *by = clamp_0_255((int)(128.0 + (-0.148213 * R - 0.290974 * G + 0.439187 * B)));
+}
+
+static inline void yc_to_rgb_px(int y, int ry, int by, uint8_t *p) {
+    int yy = kYcY * (y - 16);
+    int v = ry - 128;
+    int u = by - 128;
+    p[0] = (uint8_t)clamp_0_255((yy + kYcRV * v + YC_ROUND) >> YC_SHIFT);
+    p[1] = (uint8_t)clamp_0_255((yy - kYcGV * v - kYcGU * u + YC_ROUND) >> YC_SHIFT);
+    p[2] = (uint8_t)clamp_0_255((yy + kYcBU * u + YC_ROUND) >> YC_SHIFT);
+}
+
+/* === TX: RGB -> Y, R-Y, B-Y === */
+
+#ifdef SSTV_HAVE_SSE2
+/* Two pixels of one output plane, in get_ry's operation order */
+static inline __m128i yc_lanes(__m128d R, __m128d G, __m128d B,
+                               double base, double kr, double kg, double kb) {
+    __m128d s = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(kr), R), _mm_mul_pd(_mm_set1_pd(kg), G));
+    s = _mm_add_pd(s, _mm_mul_pd(_mm_set1_pd(kb), B));
+    return _mm_cvttpd_epi32(_mm_add_pd(_mm_set1_pd(base), s));
+}
+
+/* Four pixels: two pairs per plane, saturated down to bytes */
+static inline void rgb24_to_yc4(const uint8_t *p, uint8_t *y, uint8_t *ry, uint8_t *by) {
+    __m128i yv[2], rv[2], bv[2];
+    for (int h = 0; h < 2; h++) {
+        const uint8_t *q = p + h * 6;
+        __m128d R = _mm_cvtepi32_pd(_mm_setr_epi32(q[0], q[3], 0, 0));
+        __m128d G = _mm_cvtepi32_pd(_mm_setr_epi32(q[1], q[4], 0, 0));
+        __m128d B = _mm_cvtepi32_pd(_mm_setr_epi32(q[2], q[5], 0, 0));
+        yv[h] = yc_lanes(R, G, B, 16.0, 0.256773, 0.504097, 0.097900);
+        /* a - b*G is a + (-b)*G exactly */
+        rv[h] = yc_lanes(R, G, B, 128.0, 0.439187, -0.367766, -0.071421);
+        bv[h] = yc_lanes(R, G, B, 128.0, -0.148213, -0.290974, 0.439187);
+    }
+    __m128i yr = _mm_packs_epi32(_mm_unpacklo_epi64(yv[0], yv[1]), _mm_unpacklo_epi64(rv[0], rv[1]));
+    __m128i bb = _mm_packs_epi32(_mm_unpacklo_epi64(bv[0], bv[1]), _mm_setzero_si128());
+    __m128i out = _mm_packus_epi16(yr, bb);
+    uint32_t w = (uint32_t)_mm_cvtsi128_si32(out);
+    memcpy(y, &w, 4);
+    w = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(out, 4));
+    memcpy(ry, &w, 4);
+    w = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(out, 8));
+    memcpy(by, &w, 4);
+}
+#endif
+
+void sstv_color_rgb24_to_yc(const uint8_t *rgb, size_t width,
+                            uint8_t *y, uint8_t *ry, uint8_t *by) {
+    size_t x = 0;
+#ifdef SSTV_HAVE_SSE2
+    for (; x + 4 <= width; x += 4) {
+        rgb24_to_yc4(rgb + x * 3, y + x, ry + x, by + x);
+    }
+#endif
+    for (; x < width; x++) {
+        const uint8_t *p = rgb + x * 3;
+        int yy, rr, bb;
+        sstv_color_rgb_to_yc_px(p[0], p[1], p[2], &yy, &rr, &bb);
+        y[x] = (uint8_t)yy;
+        ry[x] = (uint8_t)rr;
+        by[x] = (uint8_t)bb;
+    }
+}
+
+typedef struct {
+    uint8_t y[256];
+    uint8_t ry[256];
+    uint8_t by[256];
+} gray_yc_lut_t;
+
+static gray_yc_lut_t make_gray_yc_lut(void) {
+    gray_yc_lut_t lut;
+    for (int v = 0; v < 256; v++) {
+        int yy, rr, bb;
+        sstv_color_rgb_to_yc_px(v, v, v, &yy, &rr, &bb);
+        lut.y[v] = (uint8_t)yy;
+        lut.ry[v] = (uint8_t)rr;
+        lut.by[v] = (uint8_t)bb;
+    }
+    return lut;
+}
+
+void sstv_color_gray_to_yc(const uint8_t *gray, size_t width,
+                           uint8_t *y, uint8_t *ry, uint8_t *by) {
+    static const gray_yc_lut_t lut = make_gray_yc_lut();
+    for (size_t x = 0; x < width; x++) {
+        uint8_t v = gray[x];
+        y[x] = lut.y[v];
+        ry[x] = lut.ry[v];
+        by[x] = lut.by[v];
+    }
+}
+
+/* === RX: Y, R-Y, B-Y -> RGB === */
+
+#ifdef SSTV_HAVE_SSE2
+/* (a, b) word pairs dotted with (ka, kb), rounded and shifted back */
+static inline __m128i yc_madd(__m128i ab, __m128i k, __m128i extra) {
+    return _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(ab, k), extra), YC_SHIFT);
+}
+
+/* Eight pixels; chroma already widened to one byte per pixel */
+static inline void yc_to_rgb8(__m128i y8, __m128i v8, __m128i u8, uint8_t *rgb) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i y = _mm_sub_epi16(_mm_unpacklo_epi8(y8, zero), _mm_set1_epi16(16));
+    __m128i v = _mm_sub_epi16(_mm_unpacklo_epi8(v8, zero), _mm_set1_epi16(128));
+    __m128i u = _mm_sub_epi16(_mm_unpacklo_epi8(u8, zero), _mm_set1_epi16(128));
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i rnd = _mm_set1_epi32(YC_ROUND);
+    const __m128i kr = _mm_setr_epi16(kYcY, kYcRV, kYcY, kYcRV, kYcY, kYcRV, kYcY, kYcRV);
+    const __m128i kg = _mm_setr_epi16(kYcY, -kYcGV, kYcY, -kYcGV, kYcY, -kYcGV, kYcY, -kYcGV);
+    const __m128i kgu = _mm_setr_epi16(-kYcGU, YC_ROUND, -kYcGU, YC_ROUND,
+                                       -kYcGU, YC_ROUND, -kYcGU, YC_ROUND);
+    const __m128i kb = _mm_setr_epi16(kYcY, kYcBU, kYcY, kYcBU, kYcY, kYcBU, kYcY, kYcBU);
+
+    __m128i yv_lo = _mm_unpacklo_epi16(y, v), yv_hi = _mm_unpackhi_epi16(y, v);
+    __m128i yu_lo = _mm_unpacklo_epi16(y, u), yu_hi = _mm_unpackhi_epi16(y, u);
+    __m128i u1_lo = _mm_unpacklo_epi16(u, one), u1_hi = _mm_unpackhi_epi16(u, one);
+
+    __m128i r = _mm_packs_epi32(yc_madd(yv_lo, kr, rnd), yc_madd(yv_hi, kr, rnd));
+    __m128i g = _mm_packs_epi32(yc_madd(yv_lo, kg, _mm_madd_epi16(u1_lo, kgu)),
+                                yc_madd(yv_hi, kg, _mm_madd_epi16(u1_hi, kgu)));
+    __m128i b = _mm_packs_epi32(yc_madd(yu_lo, kb, rnd), yc_madd(yu_hi, kb, rnd));
+
+    uint8_t pr[16], pg[16], pb[16];
+    _mm_storeu_si128((__m128i*)pr, _mm_packus_epi16(r, r));
+    _mm_storeu_si128((__m128i*)pg, _mm_packus_epi16(g, g));
+    _mm_storeu_si128((__m128i*)pb, _mm_packus_epi16(b, b));
+    for (int i = 0; i < 8; i++) {
+        rgb[i * 3 + 0] = pr[i];
+        rgb[i * 3 + 1] = pg[i];
+        rgb[i * 3 + 2] = pb[i];
+    }
+}
+
+/* Four chroma bytes, each doubled */
+static inline __m128i load_chroma_half(const uint8_t *c) {
+    uint32_t w;
+    memcpy(&w, c, 4);
+    __m128i v = _mm_cvtsi32_si128((int)w);
+    return _mm_unpacklo_epi8(v, v);
+}
+#endif
+
+void sstv_color_yc_to_rgb24(const uint8_t *y, const uint8_t *ry, const uint8_t *by,
+                            size_t width, int chroma_shift, uint8_t *rgb) {
+    int cs = chroma_shift ? 1 : 0;
+    size_t x = 0;
+#ifdef SSTV_HAVE_SSE2
+    for (; x + 8 <= width; x += 8) {
+        __m128i y8 = _mm_loadl_epi64((const __m128i*)(y + x));
+        __m128i v8, u8;
+        if (cs) {
+            v8 = load_chroma_half(ry + (x >> 1));
+            u8 = load_chroma_half(by + (x >> 1));
+        } else {
+            v8 = _mm_loadl_epi64((const __m128i*)(ry + x));
+            u8 = _mm_loadl_epi64((const __m128i*)(by + x));
+        }
+        yc_to_rgb8(y8, v8, u8, rgb + x * 3);
+    }
+#endif
+    for (; x < width; x++) {
+        yc_to_rgb_px(y[x], ry[x >> cs], by[x >> cs], rgb + x * 3);
+    }
+}
+
+void sstv_color_yc_pair_to_rgb24(const uint8_t *y0, const uint8_t *y1,
+                                 const uint8_t *ry, const uint8_t *by,
+                                 size_t width, int chroma_shift,
+                                 uint8_t *rgb0, uint8_t *rgb1) {
+    sstv_color_yc_to_rgb24(y0, ry, by, width, chroma_shift, rgb0);
+    sstv_color_yc_to_rgb24(y1, ry, by, width, chroma_shift, rgb1);
+}
+
+typedef struct {
+    uint8_t v[256];
+} y_rgb_lut_t;
+
+static y_rgb_lut_t make_y_rgb_lut(void) {
+    y_rgb_lut_t lut;
+    for (int y = 0; y < 256; y++) {
+        uint8_t p[3];
+        yc_to_rgb_px(y, 128, 128, p);
+        lut.v[y] = p[0];
+    }
+    return lut;
+}
+
+void sstv_color_y_to_rgb24(const uint8_t *y, size_t width, uint8_t *rgb) {
+    static const y_rgb_lut_t lut = make_y_rgb_lut();
+    for (size_t x = 0; x < width; x++) {
+        uint8_t v = lut.v[y[x]];
+        rgb[x * 3 + 0] = v;
+        rgb[x * 3 + 1] = v;
+        rgb[x * 3 + 2] = v;
+    }
+}
@@ -0,0 +1,105 @@
+/*
+ * Y/R-Y/B-Y <-> RGB row conversion - internal header
+ *
+ * Shared by the encoder (RGB rows to the planar Y, R-Y and B-Y it sends)
+ * and the decoder (received planes back to interleaved RGB24). All values
+ * are the BT.601 studio-range bytes MMSSTV transmits: Y 16-235, R-Y and
+ * B-Y 16-240 centred on 128.
+ */
+#ifndef SSTV_COLOR_H
+#define SSTV_COLOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Convert one RGB24 row to planar Y, R-Y and B-Y
+ *
+ * Bit-identical to the encoder's original per-pixel double-precision
+ * transform (sstv_color_rgb_to_yc_px), two pixels at a time where SSE2
+ * is available.
+ *
+ * @param rgb Interleaved R, G, B bytes
+ * @param width Pixels in the row
+ * @param y Output: width luminance bytes
+ * @param ry Output: width R-Y bytes
+ * @param by Output: width B-Y bytes
+ */
+void sstv_color_rgb24_to_yc(const uint8_t *rgb, size_t width,
+                            uint8_t *y, uint8_t *ry, uint8_t *by);
+
+/**
+ * Convert one 8-bit grayscale row to planar Y, R-Y and B-Y
+ *
+ * Table lookup; same result as sstv_color_rgb24_to_yc with R = G = B.
+ *
+ * @param gray Grayscale bytes
+ * @param width Pixels in the row
+ * @param y Output: width luminance bytes
+ * @param ry Output: width R-Y bytes
+ * @param by Output: width B-Y bytes
+ */
+void sstv_color_gray_to_yc(const uint8_t *gray, size_t width,
+                           uint8_t *y, uint8_t *ry, uint8_t *by);
+
+/**
+ * Scalar reference for one pixel (the encoder's original get_ry)
+ *
+ * @param r Red 0-255
+ * @param g Green 0-255
+ * @param b Blue 0-255
+ * @param y Output: luminance
+ * @param ry Output: R-Y
+ * @param by Output: B-Y
+ */
+void sstv_color_rgb_to_yc_px(int r, int g, int b, int *y, int *ry, int *by);
+
+/**
+ * Convert planar Y, R-Y and B-Y to one interleaved RGB24 row
+ *
+ * Q13 fixed point, rounded, eight pixels at a time where SSE2 is
+ * available. With chroma_shift 1 the chroma planes hold one sample per
+ * two pixels (4:2:2) and each is used for both.
+ *
+ * @param y width luminance bytes
+ * @param ry R-Y bytes (width >> chroma_shift, rounded up)
+ * @param by B-Y bytes (width >> chroma_shift, rounded up)
+ * @param width Pixels in the row
+ * @param chroma_shift 0 (full-rate chroma) or 1 (half-rate)
+ * @param rgb Output: width * 3 bytes
+ */
+void sstv_color_yc_to_rgb24(const uint8_t *y, const uint8_t *ry, const uint8_t *by,
+                            size_t width, int chroma_shift, uint8_t *rgb);
+
+/**
+ * Convert a line pair sharing one set of chroma to two RGB24 rows (4:2:0)
+ *
+ * Robot 36 sends R-Y on even lines and B-Y on odd ones; PD, MP and MN
+ * send Y of two lines with one R-Y and one B-Y between them.
+ *
+ * @param y0 First line luminance
+ * @param y1 Second line luminance
+ * @param ry R-Y shared by both lines
+ * @param by B-Y shared by both lines
+ * @param width Pixels per row
+ * @param chroma_shift 0 or 1, as for sstv_color_yc_to_rgb24
+ * @param rgb0 Output: first row
+ * @param rgb1 Output: second row
+ */
+void sstv_color_yc_pair_to_rgb24(const uint8_t *y0, const uint8_t *y1,
+                                 const uint8_t *ry, const uint8_t *by,
+                                 size_t width, int chroma_shift,
+                                 uint8_t *rgb0, uint8_t *rgb1);
+
+/**
+ * Convert luminance only to an RGB24 row (R-Y = B-Y = 128)
+ *
+ * Table lookup; same result as sstv_color_yc_to_rgb24 with neutral chroma.
+ *
+ * @param y width luminance bytes
+ * @param width Pixels in the row
+ * @param rgb Output: width * 3 bytes
+ */
+void sstv_color_y_to_rgb24(const uint8_t *y, size_t width, uint8_t *rgb);
+
+#endif
@@ -13,9 +13,24 @@
 #include <math.h>
 #include <stdio.h>
 #include <vector>
+#include <chrono>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define SSTV_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SSTV_HAVE_MMAP 1
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 #include "sstv_decoder.h"
 #include "dsp_filters.h"
+#include "trace.h"
 
 /* === WAV FILE HELPERS === */
 static void write_u16_le(FILE *f, uint16_t val) {
@@ -100,34 +115,53 @@ typedef struct {
     int sample_count;        /* Samples accumulated in bit period */
     int start_bit_samples;   /* Samples accumulated for VIS start bit detection */
     int start_bit_pending;   /* 1 if next bit is the VIS start bit */
-    /* Buffered VIS decoding */
-    double *mark_buf;        /* Mark energy buffer */
-    double *space_buf;       /* Space energy buffer */
-    int buf_size;            /* Buffer size in samples */
-    int buf_pos;             /* Current buffer write position */
+    /* Soft-decision VIS: running sums of the mark/space detectors from the
+     * start of start-bit validation, so any bit window sums in O(1) */
+    double *diff_sum;        /* diff_sum[i]: sum of mark - space over samples 0..i-1 */
+    double *level_sum;       /* level_sum[i]: sum of mark + space over samples 0..i-1 */
+    int buf_size;            /* Array length (sums for buf_size - 1 samples) */
+    int buf_pos;             /* Samples summed so far */
     int buffering;           /* 1 while buffering VIS window */
     int invert_polarity;     /* 1 if space > mark consistently (inverted polarity) */
     int polarity_samples;    /* Number of samples used for polarity detection */
 } vis_decoder_t;
 
-/* === LEVEL/AGC (ported from MMSSTV CLVL) === */
+/* === BLOCK AGC ===
+ * Normalises the band-passed signal to the MMSSTV CLVL level (peak at
+ * 16384) without CLVL's 100 ms gain steps. Samples pass through a short
+ * delay line; the peak of each block entering it sets the gain target, so
+ * the gain has already come down (attack) when a transient leaves the
+ * delay line, and recovers gradually (release) after it. */
+#define AGC_BLOCK 16                 /* Samples per peak block */
+#define AGC_MAX_BLOCKS 64            /* Delay line limit, in blocks */
+#define AGC_TARGET 16384.0           /* Peak level after the gain */
+#define AGC_MIN_PEAK 32.0            /* Gain stops rising below this peak */
+#define AGC_DEFAULT_LOOKAHEAD_MS 5.0
+#define AGC_DEFAULT_ATTACK_MS 1.0
+#define AGC_DEFAULT_RELEASE_MS 100.0
+#define AGC_MAX_LOOKAHEAD_MS 20.0
+#define AGC_MAX_TIME_MS 10000.0
+#define AGC_RING (AGC_BLOCK * (AGC_MAX_BLOCKS + 1))
+
 typedef struct {
-    double m_Cur;
-    double m_PeakMax;
-    double m_PeakAGC;
-    double m_Peak;
-    double m_CurMax;
-    double m_Max;
-    double m_agc;
-    int m_CntPeak;
-    int m_agcfast;
-    int m_Cnt;
-    int m_CntMax;
-} level_agc_t;
+    float sig[AGC_RING];             /* Band-passed samples */
+    float raw[AGC_RING];             /* Clipped input, delayed alike */
+    float peak[AGC_MAX_BLOCKS + 1];  /* Abs peak of each block slot */
+    int blocks;                      /* Lookahead in blocks */
+    int len;                         /* (blocks + 1) * AGC_BLOCK */
+    int pos;                         /* Write position */
+    double gain;
+    double target;                   /* Gain the current block heads for */
+    double coef;                     /* Per-sample smoothing towards target */
+    double attack, release;          /* Coefficients for falling/rising gain */
+    double lookahead_ms, attack_ms, release_ms;
+} block_agc_t;
 
 /* === IMAGE BUFFER === */
 typedef struct {
     uint8_t *pixels;         /* RGB24 or grayscale */
+    size_t size;             /* Bytes allocated from the decoder allocator */
+    size_t clean_end;        /* Bytes past the write position known zero */
     int width, height;
     int bytes_per_pixel;     /* 1 for grayscale, 3 for RGB */
     int current_line;        /* Current line being filled */
@@ -139,11 +173,172 @@ typedef struct {
     image_decode_state_t state;  /* Current decode state */
     int sample_counter;          /* Sample counter for timing */
     double samples_per_pixel;    /* Samples per pixel (from mode timing) */
+    double pixel_clock;          /* Fractional samples elapsed in current pixel */
     int current_channel;         /* Current color channel (0=R, 1=G, 2=B or Y) */
     double freq_accum;           /* Accumulated frequency for averaging */
     int freq_samples;            /* Number of samples accumulated */
 } image_decoder_t;
 
+/* === IMAGE JOURNAL (memory-mapped image buffer) ===
+ * File layout: 64-byte header followed by width * height * 3 RGB24 bytes.
+ * Fields are in host byte order; the journal is meant to be recovered on
+ * the machine that wrote it. */
+#define JOURNAL_MAGIC "SSTVJNL1"
+#define JOURNAL_VERSION 1
+
+typedef struct {
+    char magic[8];               /* JOURNAL_MAGIC once the header is valid */
+    uint32_t version;            /* JOURNAL_VERSION */
+    uint32_t header_size;        /* sizeof(journal_header_t) */
+    uint32_t mode;               /* sstv_mode_t */
+    uint32_t width;
+    uint32_t height;
+    uint32_t bytes_per_pixel;    /* 3 (RGB24) */
+    uint32_t lines_completed;    /* Lines fully written to the pixel area */
+    uint32_t complete;           /* 1 once the whole frame was decoded */
+    double sample_rate;          /* Decoder sample rate */
+    uint8_t reserved[16];
+} journal_header_t;
+
+typedef struct {
+    char *path;                  /* Journal file path (NULL = disabled) */
+    int fd;                      /* Open file while a frame is mapped */
+    void *map;                   /* Mapping: header + pixels */
+    size_t map_len;
+} image_journal_t;
+
+/* === FREQUENCY TRACK (re-decode cache) ===
+ * The demodulated frequency, box-averaged to about twice the pixel rate
+ * of the fastest colour mode (Robot 24: 3200 px/s) and stored as uint16,
+ * plus the positions of 1200 Hz sync pulses. A frame can be rebuilt from
+ * it with any mode, slant and offset without running the DSP again. */
+#define TRACK_RATE_HZ 6400.0         /* Target track sample rate */
+#define TRACK_HZ_SCALE 16.0          /* Stored code = Hz * 16 */
+#define TRACK_PREROLL_SEC 2.0        /* Kept before each frame start */
+#define TRACK_MAX_SEC 600.0          /* Recording stops past this */
+#define TRACK_SYNC_MIN_MS 3.0        /* Shortest 1200 Hz run logged as a pulse */
+
+typedef struct {
+    int enabled;
+    int decim;                       /* Audio samples per track sample */
+    std::vector<uint16_t> freq;      /* Mean frequency per track sample */
+    std::vector<uint32_t> sync;      /* Track indices where sync pulses start */
+    uint64_t origin;                 /* Audio sample index of freq[0] */
+    uint64_t pos;                    /* Audio samples seen */
+    uint64_t lock_pos;               /* Audio sample index of the last frame start */
+    sstv_mode_t lock_mode;           /* Mode of the last frame (SSTV_MODE_COUNT = none) */
+    double accum;                    /* Partial track sample */
+    int accum_n;
+    int sync_run;                    /* Consecutive samples with sync tone dominant */
+    int sync_min;                    /* sync_run length that counts as a pulse */
+} freq_track_t;
+
+/* === LINE SYNC CORRELATOR ===
+ * Boxcar matched filter for the mode's 1200 Hz line sync pulse, run on
+ * the tone detector envelopes decimated to ~4 kHz. The output is the
+ * normalised difference (d12 - d19) / (d12 + d19) over one pulse length,
+ * so it reaches ~1 only when a whole pulse fills the window regardless of
+ * signal level. Peaks are refined by parabolic interpolation. Once three
+ * pulses a line period apart are found, the tracker only searches a small
+ * window around each predicted pulse. A least-squares line through the
+ * matched pulse positions gives the sender's line period (slant) and the
+ * next prediction; it is robust to the per-pulse jitter at low SNR. */
+#define LSYNC_RATE_HZ 4000.0         /* Correlator rate after decimation */
+#define LSYNC_ACQUIRE 0.35           /* Peak needed while searching */
+#define LSYNC_HOLD 0.20              /* Peak needed inside the locked window */
+#define LSYNC_WINDOW_MS 3.0          /* Locked search half-width */
+#define LSYNC_LOCK_HITS 3            /* Spaced pulses needed to lock */
+#define LSYNC_LOSE_MISSES 4          /* Consecutive misses before unlocking */
+#define LSYNC_FIT_MIN 8              /* Pulses before the fitted period is used */
+#define LSYNC_MAX_PPM 10000.0        /* Line period correction limit */
+
+typedef struct {
+    int active;                      /* Mode has a 1200 Hz line sync */
+    int decim;                       /* Audio samples per correlator step */
+    int len;                         /* Pulse length in correlator steps */
+    std::vector<double> ring_diff;   /* Last len step values of d12 - d19 */
+    std::vector<double> ring_sum;    /* Last len step values of d12 + d19 */
+    int ring_pos;
+    double s_diff, s_sum;            /* Running box sums */
+    double acc_diff, acc_sum;        /* Partial decimated step */
+    int acc_n;
+    int64_t t;                       /* Correlator steps since frame start */
+    double c1, c2;                   /* Correlation at t-1 and t-2 */
+    double nominal;                  /* Mode line period in steps */
+    double period;                   /* Tracked line period in steps */
+    double last_peak;                /* Position of the last accepted pulse */
+    int line;                        /* Line index of the open window (locked) */
+    double fit_n, fit_k, fit_kk;     /* Least-squares sums over (line, position) */
+    double fit_x, fit_kx;
+    double fit_a;                    /* Fitted position of line 0 */
+    double last_c;                   /* Its correlation */
+    double best_pos, best_c;         /* Best candidate in the open window */
+    int locked, hits, misses;
+    int found, missed;               /* Frame statistics */
+    double last_err;                 /* Last timing error in steps */
+    double spp_nominal;              /* Image samples per pixel at nominal rate */
+} line_sync_t;
+
+/* === ZERO-CROSSING DEMODULATOR (SSTV_DEMOD_ZC) ===
+ * Low-CPU alternative to the tone detector bank during image reception.
+ * Crossings of the band-passed signal are located by linear interpolation
+ * between samples. Each crossing closes a full cycle (this half-cycle plus
+ * the previous one, so a DC offset or uneven duty cycle cancels), and the
+ * median of the last ZC_MEDIAN cycle lengths rejects noise crossings.
+ * Costs a compare per sample plus a few operations per crossing. */
+#define ZC_MEDIAN 5                  /* Cycle lengths in the median */
+#define ZC_SYNC_HZ 1350.0            /* Below this the tone counts as sync */
+#define ZC_MIN_HZ 1000.0             /* Output clamp */
+#define ZC_MAX_HZ 2500.0
+
+typedef struct {
+    double prev;                     /* Previous input sample */
+    double elapsed;                  /* Samples since the last crossing */
+    double last_half;                /* Previous half-cycle length */
+    double cycle[ZC_MEDIAN];         /* Recent cycle lengths (ring) */
+    int cycle_n, cycle_pos;
+    double freq;                     /* Current estimate (held between crossings) */
+} zc_demod_t;
+
+/* === LINE QUALITY ===
+ * Energy in the video band (1500-2300 Hz) against an out-of-band slot
+ * above the SSTV spectrum, measured on the input audio during image
+ * reception. The slot energy scaled to the video bandwidth is taken as
+ * the noise floor inside the band. The slot is three cascaded biquads:
+ * a single one lets enough of a 2300 Hz tone through to cap the reading
+ * near 15 dB. Pixel confidence maps the same ratio, smoothed over a few
+ * milliseconds, linearly from 0 dB (0) to QUAL_CONF_FULL_DB (255). */
+#define QUAL_SIG_FC 1900.0
+#define QUAL_SIG_BW 800.0
+#define QUAL_NOISE_FC 3300.0
+#define QUAL_NOISE_FC_LOW 600.0      /* Slot used when 3300 Hz is too close to Nyquist */
+#define QUAL_NOISE_BW 400.0          /* Per-stage bandwidth */
+#define QUAL_NOISE_STAGES 3
+/* Noise bandwidth ratio: (pi/2) B for one stage, (3 pi/16) B for three */
+#define QUAL_NOISE_SCALE (QUAL_SIG_BW * 8.0 / (3.0 * QUAL_NOISE_BW))
+#define QUAL_SMOOTH_MS 4.0           /* Pixel confidence energy smoothing */
+#define QUAL_CONF_FULL_DB 30.0       /* SNR rated fully confident */
+
+/* RBJ band-pass biquad (constant 0 dB peak gain) */
+typedef struct {
+    double b0, b2, a1, a2;
+    double x1, x2, y1, y2;
+} qual_biquad_t;
+
+typedef struct {
+    qual_biquad_t sig;               /* Video band */
+    qual_biquad_t noise[QUAL_NOISE_STAGES];  /* Out-of-band slot */
+    double alpha;                    /* Smoothing coefficient */
+    double sm_sig, sm_noise;         /* Smoothed energies (pixel confidence) */
+    double line_sig, line_noise;     /* Energies since the last line finished */
+    double line_sync;                /* Strongest sync correlation in this line */
+    double conf_sum;                 /* Pixel confidence over this line */
+    int conf_n;
+    int plane_enabled;               /* Keep the per-pixel plane */
+    std::vector<sstv_line_quality_t> lines;  /* Measured lines of this frame */
+    std::vector<uint8_t> plane;      /* width * height confidence (if enabled) */
+} line_quality_t;
+
 /* CSYNCINT: Leader interval tracker (MMSSTV parity) */
 #define MSYNCLINE 8
 typedef struct {
@@ -155,6 +350,51 @@ typedef struct {
     int sync_phase;                   /* Narrow sync phase (for 1900 Hz) */
 } sync_tracker_t;
 
+/* Noise-adaptive acquisition thresholds: each detector's idle output is
+ * tracked as a running mean/deviation, and a tone only counts when it sits
+ * k deviations above that floor (never below the fixed MMSSTV level).
+ * k is steered so that abandoned acquisitions settle at the target rate. */
+#define SENSE_FLOOR_SEC 1.0          /* Floor averaging time constant */
+#define SENSE_K_INIT 4.0             /* Deviations above the floor to trigger */
+#define SENSE_K_MIN 2.0
+#define SENSE_K_MAX 12.0
+#define SENSE_K_STEP 0.5             /* k raised per false start */
+#define SENSE_HYST 1.0               /* Hold level sits this many deviations lower */
+#define SENSE_DEFAULT_RATE 6.0       /* Target false starts per hour */
+#define SENSE_LEVEL_STRIDE 32        /* Idle samples between level updates */
+
+typedef struct {
+    double mean, sq;                 /* Running mean of x and x^2 */
+} sense_floor_t;
+
+typedef struct {
+    double rate;                     /* Target false starts per hour, 0 = fixed levels */
+    double alpha;                    /* Floor smoothing coefficient */
+    double k_decay;                  /* k lowered per idle sample */
+    double k;                        /* Trigger deviations above the floor */
+    uint32_t warm;                   /* Idle samples averaged so far (warm-up) */
+    uint32_t tick;                   /* Idle sample counter for the level stride */
+    sense_floor_t f12, f11, f13;     /* Sync, VIS mark, VIS space detectors */
+    double on12, hold12;             /* 1200 Hz trigger / hold levels */
+    double vis11, vis13;             /* VIS tone-present levels */
+    uint64_t triggers;               /* Counters, see sstv_sense_stats_t */
+    uint64_t vis_attempts;
+    uint64_t false_starts;
+    uint64_t vis_locks;
+    uint64_t vis_repairs;
+    double vis_conf;                 /* Soft-decision confidence of the last lock */
+} sense_adapt_t;
+
+/* Stage profiling times one sample in this many (clock reads cost more
+ * than the per-sample DSP work, so timing every sample would skew it) */
+#define DECODER_PROFILE_STRIDE 32
+
+/* Samples per idle run (detector outputs are staged in block arrays) */
+#define DECODER_RUN 256
+
+/* Default replay-trace checksum spacing in seconds of audio */
+#define DECODER_TRACE_CHECK_SEC 1.0
+
 /* === MAIN DECODER STRUCT === */
 struct sstv_decoder_s {
     double sample_rate;
@@ -190,9 +430,14 @@ struct sstv_decoder_s {
     
     /* === DEMOD STATE === */
     double prev_sample;              /* For simple LPF (adjacent average) */
-    level_agc_t lvl;                 /* MMSSTV AGC */
+    block_agc_t agc;                 /* Lookahead block AGC */
+    double run12[DECODER_RUN];       /* Detector outputs of the idle run */
+    double run19[DECODER_RUN];
+    double run11[DECODER_RUN];
+    double run13[DECODER_RUN];
     
     /* === IMAGE BUFFER === */
+    sstv_allocator_t alloc;          /* Frames and VIS scratch come from here */
     image_buffer_t image_buf;
     
     /* === IMAGE DECODER === */
@@ -206,18 +451,60 @@ struct sstv_decoder_s {
     int vis_cnt;                     /* MMSSTV VIS bit count (m_VisCnt, 7 for data bits) */
     int vis_parity_pending;          /* Waiting to decode parity bit */
     int vis_extended;                /* MMSSTV extended VIS flag (0x23 prefix) */
+    int vis_misses;                  /* Bit samples in this VIS that failed the tone check */
+    int vis_tail;                    /* Samples still to sum before the soft decision */
     int sense_level;                 /* MMSSTV sense level (m_SenseLvl) */
     double s_lvl;                    /* MMSSTV m_SLvl */
     double s_lvl2;                   /* MMSSTV m_SLvl2 */
     double s_lvl3;                   /* MMSSTV m_SLvl3 */
-    
+    sense_adapt_t sense;             /* Noise-adaptive levels and counters */
+
     /* MMSSTV leader trackers (m_sint1/m_sint2/m_sint3) */
     sync_tracker_t sint1;            /* Primary 1200 Hz sync tracker */
     sync_tracker_t sint2;            /* Secondary sync tracker */
     sync_tracker_t sint3;            /* 1900 Hz narrow sync tracker */
     
+    /* === IMAGE JOURNAL === */
+    image_journal_t journal;         /* Optional mmap-backed image buffer */
+    
+    /* === FREQUENCY TRACK === */
+    freq_track_t track;              /* Optional re-decode cache */
+    
+    /* === LINE SYNC === */
+    line_sync_t lsync;               /* Matched-filter line sync tracker */
+    
+    /* === DEMODULATOR TIER === */
+    sstv_demod_t demod;              /* Image demodulator (tone bank or ZC) */
+    size_t (*image_run)(sstv_decoder_t *dec, const float *in, size_t n);
+                                     /* Image run for demod/line sync/track */
+    zc_demod_t zc;                   /* Zero-crossing estimator state */
+    
+    /* === LINE QUALITY === */
+    line_quality_t qual;             /* Per-line SNR / sync, pixel confidence */
+    
+    /* === REPLAY TRACE / PROFILING === */
+    trace_writer_t trace;            /* Open while tracing (trace.fp != NULL) */
+    uint64_t samples_fed;            /* Samples fed since create/reset */
+    uint64_t front_samples;          /* Samples through the front end so far */
+    uint64_t lock_sample;            /* Input position of the last VIS lock */
+    uint64_t trace_feeds;            /* Feed calls recorded */
+    uint64_t trace_next_check;       /* Stream position of next checksum */
+    uint32_t trace_check_interval;   /* Samples between checksums */
+    std::chrono::steady_clock::time_point trace_t0;
+    double vis_mark_hz;              /* Current VIS mark tone (for trace config) */
+    double vis_space_hz;             /* Current VIS space tone */
+    int prof_enabled;                /* Stage profiling on */
+    uint32_t prof_tick;              /* Sample counter for 1-in-N timing */
+    sstv_decoder_profile_t prof;     /* Accumulated stage estimates */
+    
+    /* === LINE CALLBACK === */
+    sstv_line_callback_t line_cb;    /* Called as each image line completes */
+    void *line_cb_user;              /* Opaque pointer passed to line_cb */
+    
     /* === DEBUGGING === */
     int debug_level;                 /* 0=off, 1=errors, 2=info, 3=verbose */
+    int debug_first_sample_logged;   /* First-sample banner printed */
+    uint32_t debug_sync_log_counter; /* Rate limiter for verbose sync log */
     
     /* === DEBUG WAV OUTPUT === */
     FILE *debug_wav_before;          /* Before filtering (after LPF) */
@@ -227,64 +514,6 @@ struct sstv_decoder_s {
     uint32_t debug_wav_sample_count; /* Number of samples written */
 };
 
-/* === VIS CODE MAPPING === */
-typedef struct {
-    uint8_t vis_code;        /* 8-bit VIS code */
-    sstv_mode_t mode;        /* Corresponding SSTV mode */
-} vis_map_entry_t;
-
-/* VIS code to mode lookup table */
-/* Codes match standard VIS values (LSB-first transmission) */
-static const vis_map_entry_t VIS_CODE_MAP[] = {
-    /* Standard VIS codes (7-bit + parity) */
-    { 0x84, SSTV_R24 },         /* Robot 24 */
-    { 0x88, SSTV_R36 },         /* Robot 36 */
-    { 0x0C, SSTV_R72 },         /* Robot 72 */
-    { 0x44, SSTV_AVT90 },       /* AVT 90 */
-    { 0x3C, SSTV_SCOTTIE1 },    /* Scottie 1 */
-    { 0xB8, SSTV_SCOTTIE2 },    /* Scottie 2 */
-    { 0xCC, SSTV_SCOTTIEX },    /* Scottie DX */
-    { 0xAC, SSTV_MARTIN1 },     /* Martin 1 */
-    { 0x28, SSTV_MARTIN2 },     /* Martin 2 */
-    { 0xB7, SSTV_SC2_180 },     /* SC2-180 */
-    { 0x3F, SSTV_SC2_120 },     /* SC2-120 */
-    { 0xBB, SSTV_SC2_60 },      /* SC2-60 */
-    { 0xDD, SSTV_PD50 },        /* PD 50 */
-    { 0x63, SSTV_PD90 },        /* PD 90 */
-    { 0x5F, SSTV_PD120 },       /* PD 120 */
-    { 0xE2, SSTV_PD160 },       /* PD 160 */
-    { 0x60, SSTV_PD180 },       /* PD 180 */
-    { 0xE1, SSTV_PD240 },       /* PD 240 */
-    { 0xDE, SSTV_PD290 },       /* PD 290 */
-    { 0x71, SSTV_P3 },          /* Pasokon P3 */
-    { 0x72, SSTV_P5 },          /* Pasokon P5 */
-    { 0xF3, SSTV_P7 },          /* Pasokon P7 */
-    { 0x82, SSTV_BW8 },         /* Robot B/W 8 */
-    { 0x86, SSTV_BW12 },        /* Robot B/W 12 */
-    
-    /* Extended VIS codes (16-bit, second byte after 0x23 prefix) */
-    { 0x45, SSTV_MR73 },        /* Martin R73 (extended) */
-    { 0x46, SSTV_MR90 },        /* Martin R90 (extended) */
-    { 0x49, SSTV_MR115 },       /* Martin R115 (extended) */
-    { 0x4A, SSTV_MR140 },       /* Martin R140 (extended) */
-    { 0x4C, SSTV_MR175 },       /* Martin R175 (extended) */
-    { 0x25, SSTV_MP73 },        /* Martin P73 (extended) */
-    { 0x29, SSTV_MP115 },       /* Martin P115 (extended) */
-    { 0x2A, SSTV_MP140 },       /* Martin P140 (extended) */
-    { 0x2C, SSTV_MP175 },       /* Martin P175 (extended) */
-    { 0x85, SSTV_ML180 },       /* Martin L180 (extended) */
-    { 0x86, SSTV_ML240 },       /* Martin L240 (extended - note: same code as BW12, disambiguated by prefix) */
-    { 0x89, SSTV_ML280 },       /* Martin L280 (extended) */
-    { 0x8A, SSTV_ML320 },       /* Martin L320 (extended) */
-    { 0x73, SSTV_MN73 },        /* Martin N73 (extended) */
-    { 0x6E, SSTV_MN110 },       /* Martin N110 (extended) */
-    { 0x8C, SSTV_MN140 },       /* Martin N140 (extended) */
-    { 0x6A, SSTV_MC110 },       /* Martin C110 (extended) */
-    { 0x8D, SSTV_MC140 },       /* Martin C140 (extended) */
-    { 0x8E, SSTV_MC180 },       /* Martin C180 (extended) */
-};
-
-#define VIS_MAP_SIZE (sizeof(VIS_CODE_MAP) / sizeof(vis_map_entry_t))
 
 /* Sync tracker forward declarations */
 static void sync_tracker_init(sync_tracker_t *st);
@@ -297,35 +526,106 @@ static int sync_tracker_start(sync_tracker_t *st, double sample_rate);
 static void decoder_reset_state(sstv_decoder_t *dec);
 static void decoder_process_sample(sstv_decoder_t *dec, double sample);
 static int decoder_check_vis_ready(sstv_decoder_t *dec, sstv_mode_t *mode_out);
-static int decoder_try_vis_from_buffer(sstv_decoder_t *dec, sstv_mode_t *mode_out);
 static int vis_parity_ok(uint8_t vis_code);
 static sstv_mode_t vis_code_to_mode(uint8_t vis_code, int is_extended);
 static double agc_calculate_gain(sstv_decoder_t *dec, double vis_energy);
 static int decoder_allocate_image_buffer(sstv_decoder_t *dec, sstv_mode_t mode);
+static void decoder_lock_mode(sstv_decoder_t *dec, sstv_mode_t mode);
+static void decoder_trace_call(sstv_decoder_t *dec, uint32_t op, int arg, double a, double b);
+static void decoder_profile_account(sstv_decoder_t *dec,
+                                    std::chrono::steady_clock::time_point t_in,
+                                    std::chrono::steady_clock::time_point t_fe,
+                                    std::chrono::steady_clock::time_point t_tone,
+                                    int in_image);
+static void decoder_release_image_buffer(sstv_decoder_t *dec);
+static void decoder_clear_unwritten(sstv_decoder_t *dec);
+static int journal_map_frame(sstv_decoder_t *dec, sstv_mode_t mode, size_t pixel_bytes);
+static void journal_line_done(sstv_decoder_t *dec);
 static int frequency_to_color(double freq_hz);
+static double image_estimate_freq(double freq_11, double freq_13);
+static void decoder_finish_line(sstv_decoder_t *dec);
+static void track_reset(freq_track_t *tr);
+static void track_push(sstv_decoder_t *dec, double freq_hz, int sync_tone);
+static void track_mark_frame(sstv_decoder_t *dec, sstv_mode_t mode);
+static void line_sync_start(sstv_decoder_t *dec, sstv_mode_t mode);
+static void line_sync_push(sstv_decoder_t *dec, double d12, double d19);
 static void decoder_store_pixel(sstv_decoder_t *dec, int color_value, int channel);
 
-static void level_agc_init(level_agc_t *lvl, double sample_rate);
-static void level_agc_do(level_agc_t *lvl, double d);
-static void level_agc_fix(level_agc_t *lvl);
-static double level_agc_apply(level_agc_t *lvl, double d);
+static void block_agc_init(block_agc_t *a, double sample_rate);
+static double block_agc_do(block_agc_t *a, double d, double raw, double *raw_out);
 static void decoder_set_sense_levels(sstv_decoder_t *dec);
-static void decoder_process_image_sample(sstv_decoder_t *dec, double freq_11, double freq_13, double freq_19);
+static void decoder_process_image_sample(sstv_decoder_t *dec, double freq_hz);
+static void decoder_select_image_run(sstv_decoder_t *dec);
+static void zc_demod_reset(zc_demod_t *zc);
+static double zc_demod_do(zc_demod_t *zc, double x, double sample_rate);
+static void quality_init(line_quality_t *q, double sample_rate);
+static void quality_start(sstv_decoder_t *dec);
+static void quality_push(line_quality_t *q, double x);
+static void quality_pixel(sstv_decoder_t *dec);
+static void quality_line_done(sstv_decoder_t *dec);
+
+static void* default_alloc(void *user, size_t size) {
+    (void)user;
+    return malloc(size);
+}
+
+static void default_free(void *user, void *ptr, size_t size) {
+    (void)user;
+    (void)size;
+    free(ptr);
+}
 
 sstv_decoder_t* sstv_decoder_create(double sample_rate) {
+    return sstv_decoder_create_with_allocator(sample_rate, NULL);
+}
+
+sstv_decoder_t* sstv_decoder_create_with_allocator(double sample_rate,
+                                                   const sstv_allocator_t *allocator) {
     if (sample_rate <= 0.0) {
         return NULL;
     }
+    if (allocator && (!allocator->alloc || !allocator->free)) {
+        return NULL;
+    }
     sstv_decoder_t *dec = new sstv_decoder_t();
     if (!dec) {
         return NULL;
     }
     dec->sample_rate = sample_rate;
+    if (allocator) {
+        dec->alloc = *allocator;
+    } else {
+        dec->alloc.alloc = default_alloc;
+        dec->alloc.free = default_free;
+        dec->alloc.user = NULL;
+    }
     dec->mode_hint = SSTV_MODE_COUNT; /* no hint */
     dec->detected_mode = SSTV_MODE_COUNT; /* no mode detected yet */
     dec->vis_enabled = 1;
     dec->last_status = SSTV_RX_NEED_MORE;
     dec->debug_level = 0;
+    dec->debug_first_sample_logged = 0;
+    dec->debug_sync_log_counter = 0;
+    dec->line_cb = NULL;
+    dec->line_cb_user = NULL;
+    memset(&dec->trace, 0, sizeof(dec->trace));
+    dec->samples_fed = 0;
+    dec->front_samples = 0;
+    dec->lock_sample = 0;
+    dec->trace_feeds = 0;
+    dec->trace_next_check = 0;
+    dec->trace_check_interval = 0;
+    dec->vis_mark_hz = 1080.0;
+    dec->vis_space_hz = 1320.0;
+    dec->prof_enabled = 0;
+    dec->prof_tick = 0;
+    memset(&dec->prof, 0, sizeof(dec->prof));
+    dec->journal.path = NULL;
+    dec->journal.fd = -1;
+    dec->journal.map = NULL;
+    dec->journal.map_len = 0;
+    dec->track.enabled = 0;
+    track_reset(&dec->track);
     
     /* Initialize debug WAV files to NULL */
     dec->debug_wav_before = NULL;
@@ -336,17 +636,23 @@ sstv_decoder_t* sstv_decoder_create(double sample_rate) {
     
     /* Initialize AGC */
     dec->agc_mode = SSTV_AGC_AUTO;   /* Default to AUTO mode (kept for API) */
+    dec->demod = SSTV_DEMOD_TONE;
+    zc_demod_reset(&dec->zc);
+    quality_init(&dec->qual, sample_rate);
     dec->agc_gain = 1.0;
     dec->agc_peak_level = 0.0;
     dec->agc_sample_count = 0;
     
-        /* Allocate VIS buffers (store ~800ms of energies) */
+        /* Allocate VIS running sums (~800ms: start bit, 16 bits and margin) */
         dec->vis.buf_size = (int)(0.800 * sample_rate);
         if (dec->vis.buf_size < 1) {
             dec->vis.buf_size = 1;
         }
-        dec->vis.mark_buf = (double *)calloc((size_t)dec->vis.buf_size, sizeof(double));
-        dec->vis.space_buf = (double *)calloc((size_t)dec->vis.buf_size, sizeof(double));
+        size_t vis_bytes = (size_t)dec->vis.buf_size * sizeof(double);
+        dec->vis.diff_sum = (double *)dec->alloc.alloc(dec->alloc.user, vis_bytes);
+        dec->vis.level_sum = (double *)dec->alloc.alloc(dec->alloc.user, vis_bytes);
+        if (dec->vis.diff_sum) memset(dec->vis.diff_sum, 0, vis_bytes);
+        if (dec->vis.level_sum) memset(dec->vis.level_sum, 0, vis_bytes);
         dec->vis.buf_pos = 0;
         dec->vis.buffering = 0;
     
@@ -372,8 +678,12 @@ sstv_decoder_t* sstv_decoder_create(double sample_rate) {
     dec->bpf.Create(dec->bpftap);
     
     dec->sense_level = 0;            /* Default to lowest (most sensitive) */
+    dec->sense.rate = SENSE_DEFAULT_RATE;
     decoder_set_sense_levels(dec);
-    level_agc_init(&dec->lvl, sample_rate);
+    dec->agc.lookahead_ms = AGC_DEFAULT_LOOKAHEAD_MS;
+    dec->agc.attack_ms = AGC_DEFAULT_ATTACK_MS;
+    dec->agc.release_ms = AGC_DEFAULT_RELEASE_MS;
+    block_agc_init(&dec->agc, sample_rate);
     
     /* Initialize MMSSTV sync trackers */
     sync_tracker_init(&dec->sint1);
@@ -407,15 +717,14 @@ void sstv_decoder_free(sstv_decoder_t *dec) {
             fclose(dec->debug_wav_final);
         }
         
-        if (dec->image_buf.pixels) {
-            free(dec->image_buf.pixels);
-        }
-        if (dec->vis.mark_buf) {
-            free(dec->vis.mark_buf);
-        }
-        if (dec->vis.space_buf) {
-            free(dec->vis.space_buf);
+        decoder_release_image_buffer(dec);
+        free(dec->journal.path);
+        if (dec->trace.fp) {
+            trace_writer_close(&dec->trace);
         }
+        size_t vis_bytes = (size_t)dec->vis.buf_size * sizeof(double);
+        dec->alloc.free(dec->alloc.user, dec->vis.diff_sum, vis_bytes);
+        dec->alloc.free(dec->alloc.user, dec->vis.level_sum, vis_bytes);
         delete dec;
     }
 }
@@ -426,6 +735,7 @@ void sstv_decoder_reset(sstv_decoder_t *dec) {
     decoder_reset_state(dec);
     dec->mode_hint = SSTV_MODE_COUNT;
     dec->last_status = SSTV_RX_NEED_MORE;
+    decoder_trace_call(dec, TRACE_CALL_RESET, 0, 0.0, 0.0);
 }
 
 int sstv_decoder_enable_debug_wav(sstv_decoder_t *dec,
@@ -595,64 +905,79 @@ static int sync_tracker_start(sync_tracker_t *st, double sample_rate) {
     return 1;
 }
 
-/* === MMSSTV CLVL AGC === */static void level_agc_init(level_agc_t *lvl, double sample_rate) {
-    if (!lvl) return;
-    lvl->m_agcfast = 1;
-    lvl->m_CntMax = (int)(sample_rate * 100.0 / 1000.0);
-    lvl->m_PeakMax = 0.0;
-    lvl->m_PeakAGC = 0.0;
-    lvl->m_Peak = 0.0;
-    lvl->m_Cur = 0.0;
-    lvl->m_CurMax = 0.0;
-    lvl->m_Max = 0.0;
-    lvl->m_agc = 1.0;
-    lvl->m_CntPeak = 0;
-    lvl->m_Cnt = 0;
-}
-
-static void level_agc_do(level_agc_t *lvl, double d) {
-    if (!lvl) return;
-    lvl->m_Cur = d;
-    if (d < 0.0) d = -d;
-    if (lvl->m_Max < d) lvl->m_Max = d;
-    lvl->m_Cnt++;
-}
-
-static void level_agc_fix(level_agc_t *lvl) {
-    if (!lvl) return;
-    if (lvl->m_Cnt < lvl->m_CntMax) return;
-    lvl->m_Cnt = 0;
-    lvl->m_CntPeak++;
-    if (lvl->m_Peak < lvl->m_Max) lvl->m_Peak = lvl->m_Max;
-    if (lvl->m_CntPeak >= 5) {
-        lvl->m_CntPeak = 0;
-        lvl->m_PeakMax = lvl->m_Max;
-        lvl->m_PeakAGC = (lvl->m_PeakAGC + lvl->m_Max) * 0.5;
-        lvl->m_Peak = 0.0;
-        if (!lvl->m_agcfast) {
-            if ((lvl->m_PeakAGC > 32) && lvl->m_PeakMax) {
-                lvl->m_agc = 16384.0 / lvl->m_PeakMax;
-            } else {
-                lvl->m_agc = 16384.0 / 32.0;
-            }
-        }
-    } else {
-        if (lvl->m_PeakMax < lvl->m_Max) lvl->m_PeakMax = lvl->m_Max;
+/* === BLOCK AGC === */
+/* (Re)start with an empty delay line at the silent-input gain, keeping the
+ * configured times */
+static void block_agc_init(block_agc_t *a, double sample_rate) {
+    int n = (int)ceil(a->lookahead_ms * sample_rate / 1000.0 / AGC_BLOCK);
+    if (n < 1) n = 1;
+    if (n > AGC_MAX_BLOCKS) n = AGC_MAX_BLOCKS;
+    a->blocks = n;
+    a->len = (n + 1) * AGC_BLOCK;
+    a->pos = 0;
+    memset(a->sig, 0, sizeof(a->sig));
+    memset(a->raw, 0, sizeof(a->raw));
+    memset(a->peak, 0, sizeof(a->peak));
+    a->attack = 1.0 - exp(-1000.0 / (a->attack_ms * sample_rate));
+    a->release = 1.0 - exp(-1000.0 / (a->release_ms * sample_rate));
+    a->gain = a->target = AGC_TARGET / AGC_MIN_PEAK;
+    a->coef = a->release;
+}
+
+/* Largest |x| over one block */
+static float block_agc_peak(const float *x) {
+#ifdef SSTV_HAVE_SSE2
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 m0 = _mm_andnot_ps(sign, _mm_loadu_ps(x));
+    __m128 m1 = _mm_andnot_ps(sign, _mm_loadu_ps(x + 4));
+    for (int i = 8; i < AGC_BLOCK; i += 8) {
+        m0 = _mm_max_ps(m0, _mm_andnot_ps(sign, _mm_loadu_ps(x + i)));
+        m1 = _mm_max_ps(m1, _mm_andnot_ps(sign, _mm_loadu_ps(x + i + 4)));
     }
-    lvl->m_CurMax = lvl->m_Max;
-    if (lvl->m_agcfast) {
-        if (lvl->m_CurMax > 32) {
-            lvl->m_agc = 16384.0 / lvl->m_CurMax;
-        } else {
-            lvl->m_agc = 16384.0 / 32.0;
-        }
+    m0 = _mm_max_ps(m0, m1);
+    m0 = _mm_max_ps(m0, _mm_movehl_ps(m0, m0));
+    m0 = _mm_max_ss(m0, _mm_shuffle_ps(m0, m0, 1));
+    return _mm_cvtss_f32(m0);
+#else
+    float m = 0.0f;
+    for (int i = 0; i < AGC_BLOCK; i++) {
+        float v = fabsf(x[i]);
+        if (v > m) m = v;
+    }
+    return m;
+#endif
+}
+
+/* A block just entered the delay line: aim the gain at the peak of
+ * everything now waiting in it */
+static void block_agc_block(block_agc_t *a, int start) {
+    int slot = start / AGC_BLOCK;
+    a->peak[slot] = block_agc_peak(a->sig + start);
+    /* The next slot is about to be overwritten; its samples are already out */
+    int skip = (slot + 1) % (a->blocks + 1);
+    float pk = 0.0f;
+    for (int i = 0; i <= a->blocks; i++) {
+        if (i != skip && a->peak[i] > pk) pk = a->peak[i];
     }
-    lvl->m_Max = 0.0;
+    a->target = AGC_TARGET / (pk > AGC_MIN_PEAK ? pk : AGC_MIN_PEAK);
+    a->coef = a->target < a->gain ? a->attack : a->release;
 }
 
-static double level_agc_apply(level_agc_t *lvl, double d) {
-    if (!lvl) return d;
-    return d * lvl->m_agc;
+/* Push one sample; returns the gain-adjusted sample from `blocks` blocks
+ * ago, and the matching raw input in *raw_out */
+static double block_agc_do(block_agc_t *a, double d, double raw, double *raw_out) {
+    int rd = a->pos + AGC_BLOCK;
+    if (rd >= a->len) rd -= a->len;
+    double out = a->sig[rd] * a->gain;
+    *raw_out = a->raw[rd];
+    a->sig[a->pos] = (float)d;
+    a->raw[a->pos] = (float)raw;
+    a->gain += (a->target - a->gain) * a->coef;
+    if (++a->pos % AGC_BLOCK == 0) {
+        block_agc_block(a, a->pos - AGC_BLOCK);
+        if (a->pos == a->len) a->pos = 0;
+    }
+    return out;
 }
 
 static void decoder_set_sense_levels(sstv_decoder_t *dec) {
@@ -679,6 +1004,72 @@ static void decoder_set_sense_levels(sstv_decoder_t *dec) {
             dec->s_lvl3 = 5000.0;
             break;
     }
+    dec->sense.on12 = dec->sense.hold12 = dec->s_lvl;
+    dec->sense.vis11 = dec->sense.vis13 = dec->s_lvl2;
+}
+
+/* Restart the floors and counters; keeps the target rate */
+static void sense_adapt_reset(sstv_decoder_t *dec) {
+    sense_adapt_t *sa = &dec->sense;
+    double rate = sa->rate;
+    memset(sa, 0, sizeof(*sa));
+    sa->rate = rate;
+    sa->alpha = 1.0 / (SENSE_FLOOR_SEC * dec->sample_rate);
+    sa->k_decay = SENSE_K_STEP * rate / (3600.0 * dec->sample_rate);
+    sa->k = SENSE_K_INIT;
+    sa->on12 = sa->hold12 = dec->s_lvl;
+    sa->vis11 = sa->vis13 = dec->s_lvl2;
+}
+
+/* Level `k` deviations above a floor, never below the fixed level */
+static inline double sense_level(const sense_floor_t *f, double k, double fixed) {
+    double var = f->sq - f->mean * f->mean;
+    double lvl = f->mean + k * (var > 0.0 ? sqrt(var) : 0.0);
+    return lvl > fixed ? lvl : fixed;
+}
+
+static inline void sense_floor_push(sense_floor_t *f, double x, double a) {
+    f->mean += a * (x - f->mean);
+    f->sq += a * (x * x - f->sq);
+}
+
+/* Idle sample (no acquisition running): update the floors and levels */
+static void sense_adapt_idle(sstv_decoder_t *dec, double d12, double d11, double d13) {
+    sense_adapt_t *sa = &dec->sense;
+    if (sa->rate <= 0.0) return;
+    /* Plain running average until one time constant is filled */
+    double a = sa->alpha;
+    if (sa->warm * a < 1.0) {
+        sa->warm++;
+        a = 1.0 / sa->warm;
+    }
+    sense_floor_push(&sa->f12, d12, a);
+    sense_floor_push(&sa->f11, d11, a);
+    sense_floor_push(&sa->f13, d13, a);
+    if (sa->k > SENSE_K_MIN) sa->k -= sa->k_decay;
+    if (++sa->tick % SENSE_LEVEL_STRIDE != 0) return;
+
+    double hold = sa->k - SENSE_HYST;
+    sa->on12 = sense_level(&sa->f12, sa->k, dec->s_lvl);
+    sa->hold12 = sense_level(&sa->f12, hold, dec->s_lvl);
+    sa->vis11 = sense_level(&sa->f11, hold, dec->s_lvl2);
+    sa->vis13 = sense_level(&sa->f13, hold, dec->s_lvl2);
+}
+
+/* An acquisition was abandoned without a VIS lock */
+static void sense_false_start(sstv_decoder_t *dec) {
+    sense_adapt_t *sa = &dec->sense;
+    sa->false_starts++;
+    if (sa->rate > 0.0) {
+        sa->k += SENSE_K_STEP;
+        if (sa->k > SENSE_K_MAX) sa->k = SENSE_K_MAX;
+    }
+}
+
+/* MMSSTV start-bit test against the trigger (or, once counting, hold) level */
+static inline int sense_sync_tone(const sstv_decoder_t *dec, double d12, double d19, int holding) {
+    double lvl = holding ? dec->sense.hold12 : dec->sense.on12;
+    return (d12 > d19) && (d12 > lvl) && ((d12 - d19) >= dec->s_lvl);
 }
 
 static void decoder_reset_state(sstv_decoder_t *dec) {
@@ -686,12 +1077,24 @@ static void decoder_reset_state(sstv_decoder_t *dec) {
     
     /* Reset sync/VIS state machine (MMSSTV) */
     dec->sync_state = SYNC_IDLE;
+    dec->detected_mode = SSTV_MODE_COUNT;
+    dec->samples_fed = 0;
+    dec->front_samples = 0;
+    dec->lock_sample = 0;
+    track_reset(&dec->track);
+    dec->lsync.active = 0;
+    decoder_select_image_run(dec);
+    dec->qual.lines.clear();
+    dec->qual.plane.clear();
+    dec->trace_next_check = dec->trace_check_interval;
     dec->sync_mode = 0;
     dec->sync_time = 0;
     dec->leader_drop_count = 0;
     dec->vis_data = 0;
     dec->vis_cnt = 0;
     dec->vis_extended = 0;
+    dec->vis_tail = 0;
+    sense_adapt_reset(dec);
     
     /* Reset MMSSTV sync trackers */
     sync_tracker_init(&dec->sint1);
@@ -719,13 +1122,10 @@ static void decoder_reset_state(sstv_decoder_t *dec) {
 
     /* Reset demod state */
     dec->prev_sample = 0.0;
-    level_agc_init(&dec->lvl, dec->sample_rate);
+    block_agc_init(&dec->agc, dec->sample_rate);
     
     /* Clear image buffer */
-    if (dec->image_buf.pixels) {
-        free(dec->image_buf.pixels);
-        dec->image_buf.pixels = NULL;
-    }
+    decoder_release_image_buffer(dec);
     dec->image_buf.width = 0;
     dec->image_buf.height = 0;
     dec->image_buf.current_line = 0;
@@ -734,30 +1134,18 @@ static void decoder_reset_state(sstv_decoder_t *dec) {
     /* Reset image decoder state */
     dec->img_dec.state = IMAGE_IDLE;
     dec->img_dec.sample_counter = 0;
+    dec->img_dec.pixel_clock = 0.0;
     dec->img_dec.samples_per_pixel = 1.0;
     dec->img_dec.current_channel = 0;
     dec->img_dec.freq_accum = 0.0;
     dec->img_dec.freq_samples = 0;
 }
 
-/**
- * Process a single audio sample through the demod pipeline
- * 
- * Flow:
- *   1. BPF (800-3000 Hz)
- *   2. CIIRTANK tone detectors (mark, space, sync)
- *   3. Sync detection
- *   4. VIS decoding (if enabled)
- */
-static void decoder_process_sample(sstv_decoder_t *dec, double sample) {
-    if (!dec) return;
-    
-    static int first_call = 1;
-    if (first_call && dec->debug_level >= 2) {
-        fprintf(stderr, "[DECODER] decoder_process_sample() called, sample_rate=%.0f\n", dec->sample_rate);
-        first_call = 0;
-    }
-    
+/* Clip, LPF, BPF and AGC for one input sample. Returns the x32-scaled
+ * signal for the tone detectors; *ad gets the AGC output. */
+static inline double decoder_front_end(sstv_decoder_t *dec, double sample, int in_image, double *ad) {
+    dec->front_samples++;
+
     /* Clip to prevent overflow */
     if (sample > 24576.0) sample = 24576.0;
     if (sample < -24576.0) sample = -24576.0;
@@ -772,7 +1160,6 @@ static void decoder_process_sample(sstv_decoder_t *dec, double sample) {
     }
 
     /* BPF (MMSSTV: HBPFS before sync, HBPF after) */
-    #if 1
     if (dec->use_bpf) {
         if (dec->sync_mode >= 3 && !dec->hbpf.empty()) {
             d = dec->bpf.Do(d, dec->hbpf.data());
@@ -780,28 +1167,27 @@ static void decoder_process_sample(sstv_decoder_t *dec, double sample) {
             d = dec->bpf.Do(d, dec->hbpfs.data());
         }
     }
-    #endif
 
     /* Debug WAV: Write AFTER BPF */
     if (dec->debug_wav_after_bpf) {
         write_sample_to_wav(dec->debug_wav_after_bpf, d);
     }
 
-    /* AGC (MMSSTV) */
-    #if 1
-    level_agc_do(&dec->lvl, d);
-    level_agc_fix(&dec->lvl);
-    double ad = level_agc_apply(&dec->lvl, d);
-    #else
-    double ad = d;
-    #endif
+    /* AGC: everything from here on runs agc.blocks blocks behind the input */
+    double raw;
+    *ad = block_agc_do(&dec->agc, d, sample, &raw);
+    if (in_image) {
+        /* Raw input (ahead of the adjacent average, which would tilt the
+         * two bands), delayed like the signal it is measured against */
+        quality_push(&dec->qual, raw);
+    }
 
     /* Debug WAV: Write AFTER AGC (clean normalized signal) */
     if (dec->debug_wav_after_agc) {
-        write_sample_to_wav(dec->debug_wav_after_agc, ad);
+        write_sample_to_wav(dec->debug_wav_after_agc, *ad);
     }
 
-    d = ad * 32.0;
+    d = *ad * 32.0;
     if (d > 16384.0) d = 16384.0;
     if (d < -16384.0) d = -16384.0;
 
@@ -811,7 +1197,7 @@ static void decoder_process_sample(sstv_decoder_t *dec, double sample) {
      * For debug WAV output, we write the clean AGC output 'ad' at full scale instead.
      * This lets you hear the actual signal quality going into tone detection. */
     if (dec->debug_wav_final) {
-        write_sample_to_wav(dec->debug_wav_final, ad * 2.0);
+        write_sample_to_wav(dec->debug_wav_final, *ad * 2.0);
     }
     
     /* Increment sample count if any debug WAV is active */
@@ -819,35 +1205,283 @@ static void decoder_process_sample(sstv_decoder_t *dec, double sample) {
         dec->debug_wav_after_agc || dec->debug_wav_final) {
         dec->debug_wav_sample_count++;
     }
+    return d;
+}
 
-    /* Tone detectors + 50 Hz LPF (MMSSTV) */
-    double d12 = dec->iir12.Do(d);
-    if (d12 < 0.0) d12 = -d12;
-    d12 = dec->lpf12.Do(d12);
+/* Tone detectors + 50 Hz LPF (MMSSTV), feeding the frequency track */
+template <bool Track>
+static inline void decoder_tone_bank(sstv_decoder_t *dec, double d,
+                                     double *d12, double *d19, double *d11, double *d13) {
+    double t = dec->iir12.Do(d);
+    *d12 = dec->lpf12.Do(t < 0.0 ? -t : t);
+
+    t = dec->iir19.Do(d);
+    *d19 = dec->lpf19.Do(t < 0.0 ? -t : t);
 
-    double d19 = dec->iir19.Do(d);
-    if (d19 < 0.0) d19 = -d19;
-    d19 = dec->lpf19.Do(d19);
-    
     /* Additional tone detectors for image data */
-    double d11 = dec->iir11.Do(d);
-    if (d11 < 0.0) d11 = -d11;
-    d11 = dec->lpf11.Do(d11);
-
-    double d13 = dec->iir13.Do(d);
-    if (d13 < 0.0) d13 = -d13;
-    d13 = dec->lpf13.Do(d13);
-    
-    /* If we're in image decoding mode, process the sample for image data */
-    if (dec->sync_state == SYNC_DATA_WAIT && dec->image_buf.pixels) {
-        if (dec->img_dec.state != IMAGE_COMPLETE) {
-            decoder_process_image_sample(dec, d11, d13, d19);
+    t = dec->iir11.Do(d);
+    *d11 = dec->lpf11.Do(t < 0.0 ? -t : t);
+
+    t = dec->iir13.Do(d);
+    *d13 = dec->lpf13.Do(t < 0.0 ? -t : t);
+
+    if (Track) {
+        track_push(dec, image_estimate_freq(*d11, *d13),
+                   (*d12 > *d19) && (*d12 > dec->s_lvl));
+    }
+}
+
+static inline void decoder_tones(sstv_decoder_t *dec, double d,
+                                 double *d12, double *d19, double *d11, double *d13) {
+    if (dec->track.enabled) {
+        decoder_tone_bank<true>(dec, d, d12, d19, d11, d13);
+    } else {
+        decoder_tone_bank<false>(dec, d, d12, d19, d11, d13);
+    }
+}
+
+/* 1500 Hz black to 2300 Hz white; the scale folds to a constant */
+#define IMAGE_BLACK_HZ 1500.0
+#define IMAGE_WHITE_HZ 2300.0
+
+static inline int image_level(double freq_hz) {
+    if (freq_hz <= IMAGE_BLACK_HZ) return 0;
+    if (freq_hz >= IMAGE_WHITE_HZ) return 255;
+    return (int)((freq_hz - IMAGE_BLACK_HZ) * (255.0 / (IMAGE_WHITE_HZ - IMAGE_BLACK_HZ)) + 0.5);
+}
+
+static inline int decoder_in_image(const sstv_decoder_t *dec) {
+    return dec->sync_state == SYNC_DATA_WAIT && dec->image_buf.pixels &&
+           dec->img_dec.state != IMAGE_COMPLETE;
+}
+
+/* One sample of image reception after the front end; *t_tone (if given)
+ * is stamped once the demodulator has run */
+static inline void decoder_image_sample(sstv_decoder_t *dec, double d, double ad,
+                                        std::chrono::steady_clock::time_point *t_tone) {
+    /* Zero-crossing tier: the tone detectors are only needed for sync/VIS,
+     * so during image reception they are skipped entirely */
+    if (dec->demod == SSTV_DEMOD_ZC) {
+        /* Before the x32 clamp: a hard-limited wave loses the crossing position */
+        double fz = zc_demod_do(&dec->zc, ad, dec->sample_rate);
+        int sync_tone = fz < ZC_SYNC_HZ;
+        if (dec->track.enabled) {
+            track_push(dec, fz, sync_tone);
+        }
+        if (t_tone) *t_tone = std::chrono::steady_clock::now();
+        if (dec->lsync.active) {
+            /* Hard 1200/1900 decision in place of the envelopes */
+            line_sync_push(dec, sync_tone ? 1.0 : 0.0, sync_tone ? 0.0 : 1.0);
+        }
+        decoder_process_image_sample(dec, fz);
+        return;
+    }
+
+    double d12, d19, d11, d13;
+    decoder_tones(dec, d, &d12, &d19, &d11, &d13);
+    if (t_tone) *t_tone = std::chrono::steady_clock::now();
+    if (dec->lsync.active) {
+        line_sync_push(dec, d12, d19);
+    }
+    decoder_process_image_sample(dec, image_estimate_freq(d11, d13));
+}
+
+/* === SOFT-DECISION VIS ===
+ * The state machine below takes one hard mark/space decision per bit at a
+ * fixed time after the start bit. While a VIS is received the mark and
+ * space detector outputs are also kept as running sums, so any window of
+ * mark - space costs two lookups. Once all bits are in, every timing in
+ * the search range (start offset and bit length) is scored by the sum of
+ * |mark - space| over the middle of each bit, and the word is sliced at
+ * the best one; the decision waits VIS_SOFT_SEARCH_MS past the last bit
+ * sample so that late timings are covered too. Each bit keeps its margin
+ * (mark - space) / (mark + space), and a byte that fails parity has its
+ * weakest bit flipped. Standard 8-bit VIS uses even parity, both bytes of
+ * the MMSSTV 16-bit word (0x23 prefix, then the mode byte) odd parity. */
+#define VIS_SOFT_FIRST_MS 15.0       /* Start of bit 0 after validation began */
+#define VIS_SOFT_BIT_MS 30.0         /* Nominal bit length */
+#define VIS_SOFT_SEARCH_MS 12.0      /* Start offset searched either side */
+#define VIS_SOFT_SPREAD 0.015        /* Bit length searched +-1.5% */
+#define VIS_SOFT_WINDOW 0.8          /* Part of each bit summed */
+#define VIS_SOFT_MISSES 1            /* Faint bit samples tolerated per VIS */
+
+typedef struct {
+    uint16_t code;                   /* Sliced bits, LSB first */
+    double margin[16];               /* Per-bit |mark - space| / (mark + space) */
+    int repairs;                     /* Bits flipped to fix parity */
+} vis_soft_t;
+
+static inline void vis_soft_push(vis_decoder_t *v, double d11, double d13) {
+    if (!v->diff_sum || !v->level_sum || v->buf_pos + 1 >= v->buf_size) return;
+    v->diff_sum[v->buf_pos + 1] = v->diff_sum[v->buf_pos] + (d11 - d13);
+    v->level_sum[v->buf_pos + 1] = v->level_sum[v->buf_pos] + (d11 + d13);
+    v->buf_pos++;
+}
+
+/* Window [*a, *b) of bit k for a timing, in summed samples */
+static inline void vis_soft_window(double first, double len, int w, int k, int *a, int *b) {
+    *a = (int)floor(first + (k + 0.5) * len) - w / 2;
+    *b = *a + w;
+}
+
+/**
+ * Find the best bit timing over the summed samples and slice nbits there
+ *
+ * @param dec Decoder handle
+ * @param nbits 8 or 16
+ * @param out Sliced word and per-bit margins (no parity repair yet)
+ * @return 0 on success, -1 if not enough samples are summed
+ */
+static int vis_soft_slice(const sstv_decoder_t *dec, int nbits, vis_soft_t *out) {
+    const vis_decoder_t *v = &dec->vis;
+    if (!v->diff_sum || !v->level_sum) return -1;
+    double ms = dec->sample_rate / 1000.0;
+    int reach = (int)(VIS_SOFT_SEARCH_MS * ms);
+    double best = -1.0, best_first = 0.0, best_len = 0.0;
+    int best_w = 0;
+
+    for (int l = -1; l <= 1; l++) {
+        double len = VIS_SOFT_BIT_MS * ms * (1.0 + l * VIS_SOFT_SPREAD);
+        int w = (int)(len * VIS_SOFT_WINDOW);
+        if (w < 1) w = 1;
+        for (int off = -reach; off <= reach; off++) {
+            double first = VIS_SOFT_FIRST_MS * ms + off;
+            int a, b;
+            vis_soft_window(first, len, w, 0, &a, &b);
+            if (a < 0) continue;
+            vis_soft_window(first, len, w, nbits - 1, &a, &b);
+            if (b > v->buf_pos) break;
+            /* Correlation with the best-matching bit pattern */
+            double score = 0.0;
+            for (int k = 0; k < nbits; k++) {
+                vis_soft_window(first, len, w, k, &a, &b);
+                score += fabs(v->diff_sum[b] - v->diff_sum[a]);
+            }
+            if (score > best) {
+                best = score;
+                best_first = first;
+                best_len = len;
+                best_w = w;
+            }
+        }
+    }
+    if (best < 0.0) return -1;
+
+    out->code = 0;
+    out->repairs = 0;
+    for (int k = 0; k < nbits; k++) {
+        int a, b;
+        vis_soft_window(best_first, best_len, best_w, k, &a, &b);
+        double diff = v->diff_sum[b] - v->diff_sum[a];
+        double level = v->level_sum[b] - v->level_sum[a];
+        if (diff > 0.0) out->code |= (uint16_t)(1u << k);   /* 1080 Hz = bit 1 */
+        out->margin[k] = level > 0.0 ? fabs(diff) / level : 0.0;
+    }
+    return 0;
+}
+
+/* Flip the weakest bit of byte `byte` if it fails (odd ? odd : even) parity */
+static void vis_soft_parity(vis_soft_t *vs, int byte, int odd) {
+    int even = vis_parity_ok((uint8_t)(vs->code >> (8 * byte)));
+    if (odd ? !even : even) return;
+    int weak = 8 * byte;
+    for (int k = weak + 1; k < 8 * byte + 8; k++) {
+        if (vs->margin[k] < vs->margin[weak]) weak = k;
+    }
+    vs->code ^= (uint16_t)(1u << weak);
+    vs->margin[weak] = -vs->margin[weak];
+    vs->repairs++;
+}
+
+/* Mean bit margin, a flipped bit counting against it (0-1) */
+static double vis_soft_confidence(const vis_soft_t *vs, int nbits) {
+    double sum = 0.0;
+    for (int k = 0; k < nbits; k++) sum += vs->margin[k];
+    return sum > 0.0 ? sum / nbits : 0.0;
+}
+
+/**
+ * A VIS byte is complete: follow the 0x23 prefix, lock the mode or give up
+ *
+ * The soft decision over the summed samples is tried first; the hard
+ * per-bit decisions in vis_data (accepted even with bad parity) remain
+ * the fallback when it yields no known mode.
+ *
+ * @param dec Decoder handle (sync_mode 2: first byte, 9: extended byte)
+ */
+static void decoder_vis_complete(sstv_decoder_t *dec) {
+    uint8_t hard = (uint8_t)dec->vis_data;
+    int extended = dec->sync_mode == 9;
+    vis_soft_t soft;
+    int have_soft = vis_soft_slice(dec, extended ? 16 : 8, &soft) == 0;
+    sstv_mode_t mode = SSTV_MODE_COUNT;
+
+    if (!extended) {
+        int prefix = 0;
+        if (have_soft && (soft.code & 0x7F) == 0x23) {
+            prefix = 1;
+        } else {
+            if (have_soft) {
+                vis_soft_parity(&soft, 0, 0);
+                mode = vis_code_to_mode((uint8_t)soft.code, 0);
+            }
+            if (mode == SSTV_MODE_COUNT) {
+                have_soft = 0;
+                prefix = (hard & 0x7F) == 0x23;
+                if (!prefix) mode = vis_code_to_mode(hard, 0);
+            }
+        }
+        if (prefix) {
+            /* Extended VIS code follows */
+            dec->sync_mode = 9;
+            dec->vis_data = 0;
+            dec->vis_cnt = 8;
+            dec->vis_extended = 1;
+            return;
+        }
+    } else {
+        if (have_soft) {
+            vis_soft_parity(&soft, 0, 1);
+            vis_soft_parity(&soft, 1, 1);
+            mode = vis_code_to_mode((uint8_t)(soft.code >> 8), 1);
+        }
+        if (mode == SSTV_MODE_COUNT) {
+            have_soft = 0;
+            mode = vis_code_to_mode(hard, 1);
+        }
+    }
+
+    uint8_t code = hard;
+    double conf = 0.0;
+    int repairs = 0;
+    if (have_soft) {
+        code = (uint8_t)(soft.code >> (extended ? 8 : 0));
+        conf = vis_soft_confidence(&soft, extended ? 16 : 8);
+        repairs = soft.repairs;
+    }
+    if (mode != SSTV_MODE_COUNT) {
+        decoder_lock_mode(dec, mode);
+        dec->sense.vis_locks++;
+        dec->sense.vis_repairs += (uint64_t)repairs;
+        dec->sense.vis_conf = conf;
+        if (dec->debug_level >= 2) {
+            fprintf(stderr, "[DECODER] VIS decoded: 0x%02x → mode %d%s (%s, confidence %.2f, %d repaired)\n",
+                    code, mode, extended ? " extended" : "", have_soft ? "soft" : "hard",
+                    conf, repairs);
+        }
+    } else {
+        if (dec->debug_level >= 2) {
+            fprintf(stderr, "[VIS] VIS code 0x%02x not recognized\n", code);
         }
+        sense_false_start(dec);
     }
+    dec->sync_mode = 0;
+}
 
+/* One sample of the sync/VIS state machine, given the detector outputs */
+static void decoder_acq_step(sstv_decoder_t *dec, double d12, double d19, double d11, double d13) {
     if (dec->debug_level >= 3) {
-        static int sync_log_counter = 0;
-        if ((sync_log_counter++ % 5000) == 0) {
+        if ((dec->debug_sync_log_counter++ % 5000) == 0) {
             fprintf(stderr, "[SYNC] mode=%d d12=%.2f d19=%.2f s_lvl=%.2f\n",
                     dec->sync_mode, d12, d19, dec->s_lvl);
         }
@@ -860,6 +1494,12 @@ static void decoder_process_sample(sstv_decoder_t *dec, double sample) {
         sync_tracker_inc(&dec->sint3);
     }
 
+    if (dec->sync_mode == 0 && dec->sync_time == 0) {
+        sense_adapt_idle(dec, d12, d11, d13);
+    } else if (dec->sync_mode == 1 || dec->sync_mode == 2 || dec->sync_mode == 9) {
+        vis_soft_push(&dec->vis, d11, d13);
+    }
+
     /* Sync/VIS state machine (MMSSTV parity with leader tracking) */
     switch (dec->sync_mode) {
         case 0:
@@ -870,7 +1510,7 @@ static void decoder_process_sample(sstv_decoder_t *dec, double sample) {
              * CRITICAL: Must not trigger on the 10ms VIS break (also at 1200 Hz)
              * Solution: Require sustained 1200 Hz for 12ms before starting validation
              */
-            if ((d12 > d19) && (d12 > dec->s_lvl) && ((d12 - d19) >= dec->s_lvl)) {
+            if (sense_sync_tone(dec, d12, d19, dec->sync_time != 0)) {
                 /* 1200 Hz detected - accumulate samples */
                 if (dec->sync_time == 0) {
                     /* First detection - start counter */
@@ -885,6 +1525,8 @@ static void decoder_process_sample(sstv_decoder_t *dec, double sample) {
                         dec->sync_mode = 1;
                         dec->sync_time = (int)(15.0 * dec->sample_rate / 1000.0);  /* 15ms validation */
                         dec->sync_state = SYNC_DETECTED;
+                        dec->sense.triggers++;
+                        dec->vis.buf_pos = 0;
                         sync_tracker_init(&dec->sint1);
                     }
                 }
@@ -895,7 +1537,7 @@ static void decoder_process_sample(sstv_decoder_t *dec, double sample) {
             break;
         case 1:
             /* MMSSTV: Validate START BIT continues for 15ms */
-            if ((d12 > d19) && (d12 > dec->s_lvl) && ((d12 - d19) >= dec->s_lvl)) {
+            if (sense_sync_tone(dec, d12, d19, 1)) {
                 /* Start bit still strong */
                 dec->sync_time--;
                 if (!dec->sync_time) {
@@ -908,8 +1550,11 @@ static void decoder_process_sample(sstv_decoder_t *dec, double sample) {
                     dec->vis_data = 0;
                     dec->vis_cnt = 8;  /* 8 bits to decode */
                     dec->vis_parity_pending = 0;
+                    dec->vis_misses = 0;
+                    dec->vis_tail = 0;
                     dec->vis_extended = 0;
                     dec->sync_state = SYNC_VIS_DECODING;
+                    dec->sense.vis_attempts++;
                 }
             }
             else {
@@ -919,6 +1564,7 @@ static void decoder_process_sample(sstv_decoder_t *dec, double sample) {
                 }
                 dec->sync_mode = 0;
                 dec->sync_state = SYNC_IDLE;
+                sense_false_start(dec);
             }
             break;
         case 3:
@@ -931,6 +1577,15 @@ static void decoder_process_sample(sstv_decoder_t *dec, double sample) {
         case 9: {
             /* Use d11, d13 already computed at outer scope - don't run filters twice! */
 
+            if (dec->vis_tail > 0) {
+                /* Byte sampled; a late bit timing needs a few more summed
+                 * samples. The next byte's bit clock keeps running. */
+                dec->sync_time--;
+                if (--dec->vis_tail == 0) {
+                    decoder_vis_complete(dec);
+                }
+                break;
+            }
             dec->sync_time--;
             if (!dec->sync_time) {
                 if (dec->debug_level >= 2) {
@@ -940,14 +1595,22 @@ static void decoder_process_sample(sstv_decoder_t *dec, double sample) {
                 /* Check if VIS tones are discriminable:
                  * - Ideally, at least one tone should be above d19
                  * - But if both are below, accept if they differ enough (s_lvl2) for discrimination
+                 * - With no tone at all (e.g. silence after a transmission) every
+                 *   detector sits near zero; reject instead of decoding noise bits
+                 *   (on a noisy channel "near zero" is the detector's noise floor)
+                 * A single failing sample is let through: the bit is decided
+                 * over its whole window by the soft decision anyway.
                  */
-                if ((d11 < d19) && (d13 < d19) && (fabs(d11 - d13) < dec->s_lvl2)) {
+                int faint = ((d11 < d19) && (d13 < d19) && (fabs(d11 - d13) < dec->s_lvl2)) ||
+                            ((d11 < dec->sense.vis11) && (d13 < dec->sense.vis13));
+                if (faint && ++dec->vis_misses > VIS_SOFT_MISSES) {
                     if (dec->debug_level >= 2) {
                         fprintf(stderr, "[VIS] RESET at cnt=%d: tones not discriminable (d11=%.2f d13=%.2f d19=%.2f diff=%.2f) partial_data=0x%02x\n",
                                 dec->vis_cnt, d11, d13, d19, fabs(d11 - d13), dec->vis_data & 0xFF);
                     }
                     dec->sync_mode = 0;
                     dec->sync_state = SYNC_IDLE;
+                    sense_false_start(dec);
                 } else {
                     dec->sync_time = (int)(30.0 * dec->sample_rate / 1000.0);
                     
@@ -983,41 +1646,7 @@ static void decoder_process_sample(sstv_decoder_t *dec, double sample) {
                                     (parity_bit == calculated_parity) ? "OK" : "FAIL");
                         }
                         
-                        /* Accept VIS even if parity fails (for robustness) */
-                        if (dec->sync_mode == 2) {
-                            if (data_bits == 0x23) {
-                                /* Extended VIS code follows */
-                                dec->sync_mode = 9;
-                                dec->vis_data = 0;
-                                dec->vis_cnt = 8;
-                                dec->vis_extended = 1;
-                            } else {
-                                /* Look up mode using full VIS code (including parity bit) */
-                                sstv_mode_t mode = vis_code_to_mode((uint8_t)dec->vis_data, 0);
-                                if (mode != SSTV_MODE_COUNT) {
-                                    dec->detected_mode = mode;
-                                    dec->sync_state = SYNC_DATA_WAIT;
-                                    if (dec->debug_level >= 2) {
-                                        fprintf(stderr, "[DECODER] VIS decoded: 0x%02x → mode %d\n",
-                                                (uint8_t)dec->vis_data, mode);
-                                    }
-                                } else if (dec->debug_level >= 2) {
-                                    fprintf(stderr, "[VIS] VIS code 0x%02x not recognized\n", (uint8_t)dec->vis_data);
-                                }
-                                dec->sync_mode = 0;
-                            }
-                        } else {  /* sync_mode == 9: extended VIS */
-                            sstv_mode_t mode = vis_code_to_mode((uint8_t)dec->vis_data, 1);
-                            if (mode != SSTV_MODE_COUNT) {
-                                dec->detected_mode = mode;
-                                dec->sync_state = SYNC_DATA_WAIT;
-                                if (dec->debug_level >= 2) {
-                                    fprintf(stderr, "[DECODER] VIS decoded: 0x%02x → mode %d (extended)\n",
-                                            (uint8_t)dec->vis_data, mode);
-                                }
-                            }
-                            dec->sync_mode = 0;
-                        }
+                        dec->vis_tail = (int)(VIS_SOFT_SEARCH_MS * dec->sample_rate / 1000.0) + 1;
                     }
                 }
             }
@@ -1031,129 +1660,248 @@ static void decoder_process_sample(sstv_decoder_t *dec, double sample) {
 }
 
 /**
- * Convert VIS code to SSTV mode
+ * Process a single audio sample through the demod pipeline
  * 
- * @param vis_code 8-bit VIS code (after bit accumulation)
- * @param is_extended 1 if this is an extended (16-bit) VIS code
- * @return SSTV mode or SSTV_MODE_COUNT if not found
+ * Flow:
+ *   1. BPF (800-3000 Hz)
+ *   2. CIIRTANK tone detectors (mark, space, sync)
+ *   3. Sync detection
+ *   4. VIS decoding (if enabled)
+ *
+ * Used for the short acquisition states and whenever profiling or verbose
+ * logging is on; idle and image reception go through the run handlers
+ * below, which share the same stage functions.
  */
-static sstv_mode_t vis_code_to_mode(uint8_t vis_code, int is_extended) {
-    /* Special case: 0x23 is the prefix for extended VIS (16-bit) */
-    if (!is_extended && vis_code == 0x23) {
-        return SSTV_MODE_COUNT; /* Signal to expect extended VIS */
-    }
-    
-    /* Search lookup table */
-    for (size_t i = 0; i < VIS_MAP_SIZE; i++) {
-        if (VIS_CODE_MAP[i].vis_code == vis_code) {
-            sstv_mode_t mode = VIS_CODE_MAP[i].mode;
-            
-            /* Disambiguate extended codes that share same byte value */
-            if (is_extended) {
-                /* Extended VIS codes: MR, MP, ML, MN, MC series (NOT Robot 24, B/W 8, B/W 12) */
-                /* MR series: 21-25, MP series: 26-29, ML series: 30-33, MN series: 38-40, MC series: 41-43 */
-                if ((mode >= SSTV_MR73 && mode <= SSTV_ML320) ||
-                    (mode >= SSTV_MN73 && mode <= SSTV_MC180)) {
-                    return mode;
-                }
-            } else {
-                /* Standard VIS codes: exclude modes that only exist in extended form */
-                if ((mode < SSTV_MR73 || mode > SSTV_ML320) &&
-                    (mode < SSTV_MN73 || mode > SSTV_MC180)) {
-                    return mode;
-                }
-            }
-        }
+static void decoder_process_sample(sstv_decoder_t *dec, double sample) {
+    /* Stage profiling: time one sample in DECODER_PROFILE_STRIDE */
+    int timed = 0;
+    std::chrono::steady_clock::time_point t_in, t_fe, t_tone;
+    if (dec->prof_enabled) {
+        dec->prof.samples++;
+        timed = (dec->prof_tick++ % DECODER_PROFILE_STRIDE) == 0;
+        if (timed) t_in = std::chrono::steady_clock::now();
     }
-    
-    return SSTV_MODE_COUNT; /* Not found */
-}
 
-/**
- * Try decoding VIS by sweeping phase offsets over buffered energies.
- */
-static int decoder_try_vis_from_buffer(sstv_decoder_t *dec, sstv_mode_t *mode_out) {
-    if (!dec || !mode_out || !dec->vis.mark_buf || !dec->vis.space_buf) {
-        return 0;
-    }
+    int in_image = decoder_in_image(dec);
+    double ad;
+    double d = decoder_front_end(dec, sample, in_image, &ad);
+    if (timed) t_fe = std::chrono::steady_clock::now();
 
-    const double bit_durations[] = { 0.029, 0.030, 0.031 };
-    const int step = (int)(0.002 * dec->sample_rate); /* 2ms phase step */
-    const int step_samples = (step > 0) ? step : 1;
+    if (in_image) {
+        decoder_image_sample(dec, d, ad, timed ? &t_tone : NULL);
+        if (timed) {
+            decoder_profile_account(dec, t_in, t_fe, t_tone, 1);
+        }
+        /* VIS acquisition stays disarmed until the frame is finished:
+         * the VIS stop bit and in-image 1200 Hz line syncs would otherwise
+         * re-trigger the start-bit detector and abort the image. */
+        return;
+    }
 
-    sstv_mode_t best_mode = SSTV_MODE_COUNT;
-    uint8_t best_code = 0x00;
-    double best_conf = 0.0;
+    double d12, d19, d11, d13;
+    decoder_tones(dec, d, &d12, &d19, &d11, &d13);
+    if (timed) t_tone = std::chrono::steady_clock::now();
+    decoder_acq_step(dec, d12, d19, d11, d13);
 
-    for (size_t bd = 0; bd < sizeof(bit_durations) / sizeof(bit_durations[0]); bd++) {
-        int bit_samples = (int)(bit_durations[bd] * dec->sample_rate);
-        if (bit_samples <= 0) {
-            continue;
-        }
+    if (timed) {
+        decoder_profile_account(dec, t_in, t_fe, t_tone, 0);
+    }
+}
 
-        int required_samples = bit_samples * 8;
-        if (dec->vis.buf_pos < required_samples) {
-            continue;
+/* === IMAGE RUNS ===
+ * Image reception runs in an instantiation of image_run() for the choices
+ * that stay fixed over a frame and would otherwise be tested on every
+ * sample: the demodulator, whether the mode has a line sync to follow and
+ * whether the frequency track is recording. decoder_select_image_run()
+ * picks it at VIS lock and again if the demodulator or the track is
+ * switched mid-frame. Every mode is received as luminance on one pixel
+ * clock, so the pixel step is the same for all of them: the level comes
+ * from image_level() and goes straight into the current row, which the
+ * column and line invariants keep in bounds. It must match
+ * decoder_process_image_sample() exactly (test_state_runs). */
+template <sstv_demod_t Demod, bool LineSync, bool Track>
+static size_t image_run(sstv_decoder_t *dec, const float *in, size_t n) {
+    image_buffer_t *ib = &dec->image_buf;
+    image_decoder_t *id = &dec->img_dec;
+    const int width = ib->width;
+    uint8_t *row = ib->pixels + (size_t)ib->current_line * width * 3;
+    size_t i = 0;
+    while (i < n) {
+        double ad, freq;
+        double d = decoder_front_end(dec, (double)in[i++], 1, &ad);
+        if (Demod == SSTV_DEMOD_ZC) {
+            freq = zc_demod_do(&dec->zc, ad, dec->sample_rate);
+            int sync_tone = freq < ZC_SYNC_HZ;
+            if (Track) track_push(dec, freq, sync_tone);
+            if (LineSync) line_sync_push(dec, sync_tone ? 1.0 : 0.0, sync_tone ? 0.0 : 1.0);
+        } else {
+            double d12, d19, d11, d13;
+            decoder_tone_bank<Track>(dec, d, &d12, &d19, &d11, &d13);
+            if (LineSync) line_sync_push(dec, d12, d19);
+            freq = image_estimate_freq(d11, d13);
         }
 
-        for (int start_pos = 0; start_pos <= dec->vis.buf_pos - required_samples; start_pos += step_samples) {
-            uint8_t data = 0x00;
-            double conf = 0.0;
-            int ok = 1;
-
-            for (int bit = 0; bit < 8; bit++) {
-                int start = start_pos + bit * bit_samples;
-                int end = start + bit_samples;
-                if (end > dec->vis.buf_pos) {
-                    ok = 0;
-                    break;
-                }
+        id->freq_accum += (double)image_level(freq);
+        id->freq_samples++;
+        id->sample_counter++;
+        id->pixel_clock += 1.0;
+        if (id->pixel_clock < id->samples_per_pixel) continue;
+
+        id->pixel_clock -= id->samples_per_pixel;
+        uint8_t *px = row + (size_t)ib->current_col * 3;
+        px[0] = px[1] = px[2] = (uint8_t)(int)(id->freq_accum / (double)id->freq_samples + 0.5);
+        quality_pixel(dec);
+        id->sample_counter = 0;
+        id->freq_accum = 0.0;
+        id->freq_samples = 0;
+        if (++ib->current_col < width) continue;
+
+        quality_line_done(dec);
+        decoder_finish_line(dec);
+        /* The line callback may have reset or re-armed the decoder, or
+         * switched the demodulator or track (another instantiation) */
+        if (!decoder_in_image(dec) || dec->image_run != &image_run<Demod, LineSync, Track>) break;
+        row = ib->pixels + (size_t)ib->current_line * width * 3;
+    }
+    return i;
+}
 
-                double sum_mark = 0.0;
-                double sum_space = 0.0;
-                for (int i = start; i < end; i++) {
-                    sum_mark += dec->vis.mark_buf[i];
-                    sum_space += dec->vis.space_buf[i];
-                }
+static void decoder_select_image_run(sstv_decoder_t *dec) {
+    typedef size_t (*image_run_fn)(sstv_decoder_t *, const float *, size_t);
+    static const image_run_fn runs[2][2][2] = {
+        { { image_run<SSTV_DEMOD_TONE, false, false>, image_run<SSTV_DEMOD_TONE, false, true> },
+          { image_run<SSTV_DEMOD_TONE, true, false>, image_run<SSTV_DEMOD_TONE, true, true> } },
+        { { image_run<SSTV_DEMOD_ZC, false, false>, image_run<SSTV_DEMOD_ZC, false, true> },
+          { image_run<SSTV_DEMOD_ZC, true, false>, image_run<SSTV_DEMOD_ZC, true, true> } },
+    };
+    dec->image_run = runs[dec->demod == SSTV_DEMOD_ZC][dec->lsync.active != 0][dec->track.enabled != 0];
+}
 
-                double avg_mark = sum_mark / (double)bit_samples;
-                double avg_space = sum_space / (double)bit_samples;
-                double diff = avg_mark - avg_space;
-                conf += fabs(diff);
+/* First i with the start-bit condition (sense_sync_tone, not holding) */
+static size_t sync_tone_search(const double *d12, const double *d19, size_t n,
+                               double lvl, double min_diff) {
+    size_t i = 0;
+#ifdef SSTV_HAVE_SSE2
+    const __m128d vl = _mm_set1_pd(lvl);
+    const __m128d vd = _mm_set1_pd(min_diff);
+    for (; i + 2 <= n; i += 2) {
+        __m128d a = _mm_loadu_pd(d12 + i);
+        __m128d b = _mm_loadu_pd(d19 + i);
+        __m128d hit = _mm_and_pd(_mm_and_pd(_mm_cmpgt_pd(a, b), _mm_cmpgt_pd(a, vl)),
+                                 _mm_cmpge_pd(_mm_sub_pd(a, b), vd));
+        int bits = _mm_movemask_pd(hit);
+        if (bits) return i + ((bits & 1) ? 0 : 1);
+    }
+#endif
+    for (; i < n; i++) {
+        if ((d12[i] > d19[i]) && (d12[i] > lvl) && ((d12[i] - d19[i]) >= min_diff)) return i;
+    }
+    return n;
+}
 
-                data >>= 1;
-                if (diff > 0.0) {
-                    data |= 0x80;
-                }
-            }
+/*
+ * Idle (mode 0, no start bit pending): the front end and detectors run
+ * over a whole run into the block arrays, then the start bit is searched
+ * for across the run. Nothing in the run can change the front end: after
+ * a trigger, the earliest change (VIS lock, extended VIS) is 8 bits away,
+ * so samples after the trigger go through the per-sample state machine
+ * from the same arrays.
+ */
+static size_t decoder_run_idle(sstv_decoder_t *dec, const float *in, size_t n) {
+    if (n > DECODER_RUN) n = DECODER_RUN;
+    double *d12 = dec->run12, *d19 = dec->run19, *d11 = dec->run11, *d13 = dec->run13;
+    for (size_t i = 0; i < n; i++) {
+        double ad;
+        double d = decoder_front_end(dec, (double)in[i], 0, &ad);
+        decoder_tones(dec, d, &d12[i], &d19[i], &d11[i], &d13[i]);
+    }
 
-            if (!ok) {
-                continue;
-            }
+    /* Levels only move every SENSE_LEVEL_STRIDE idle samples (on the
+     * sample that completes the stride, before its own test), so search
+     * between those points with fixed levels */
+    sense_adapt_t *sa = &dec->sense;
+    size_t i = 0, hit = n;
+    while (i < n) {
+        size_t end = n;
+        if (sa->rate > 0.0) {
+            size_t to_tick = SENSE_LEVEL_STRIDE - 1 - sa->tick % SENSE_LEVEL_STRIDE;
+            if (i + to_tick < end) end = i + to_tick;
+        }
+        size_t k = i + sync_tone_search(d12 + i, d19 + i, end - i, sa->on12, dec->s_lvl);
+        for (; i < k; i++) {
+            sense_adapt_idle(dec, d12[i], d11[i], d13[i]);
+        }
+        if (k < end) {
+            hit = k;
+            break;
+        }
+        if (i == n) break;
+        /* Sample that moves the levels: test it with the new ones */
+        sense_adapt_idle(dec, d12[i], d11[i], d13[i]);
+        if (sense_sync_tone(dec, d12[i], d19[i], 0)) {
+            hit = i;
+            i++;
+            break;
+        }
+        i++;
+    }
 
-            if (!vis_parity_ok(data)) {
-                continue;
-            }
-            sstv_mode_t mode = vis_code_to_mode(data, 0);
-            if (mode != SSTV_MODE_COUNT && conf > best_conf) {
-                best_mode = mode;
-                best_code = data;
-                best_conf = conf;
-            }
+    if (hit < n && i == hit) {
+        /* Trigger found by the search: its floor update still belongs to idle */
+        sense_adapt_idle(dec, d12[i], d11[i], d13[i]);
+        i++;
+    }
+    dec->sint1.sync_cnt += (uint32_t)i;
+    dec->sint2.sync_cnt += (uint32_t)i;
+    dec->sint3.sync_cnt += (uint32_t)i;
+    if (hit < n) {
+        /* First detection - start counter (as in decoder_acq_step) */
+        dec->sync_time = (int)(12.0 * dec->sample_rate / 1000.0);
+        for (; i < n; i++) {
+            decoder_acq_step(dec, d12[i], d19[i], d11[i], d13[i]);
         }
     }
+    return n;
+}
 
-    if (best_mode != SSTV_MODE_COUNT) {
-        dec->vis.data = best_code;
-        dec->vis.bit_count = 8;
-        *mode_out = best_mode;
-        if (dec->debug_level >= 2) {
-            fprintf(stderr, "[DECODER] VIS decoded (buffered): 0x%02x → mode %d\n", best_code, best_mode);
+/* Dispatch runs of samples to the handler for the current state */
+static void decoder_run(sstv_decoder_t *dec, const float *in, size_t n) {
+    if (dec->prof_enabled || dec->debug_level >= 3) {
+        /* Per-sample timing and logging */
+        for (size_t i = 0; i < n; i++) {
+            decoder_process_sample(dec, (double)in[i]);
         }
-        return 1;
+        return;
+    }
+    size_t i = 0;
+    while (i < n) {
+        if (decoder_in_image(dec)) {
+            i += dec->image_run(dec, in + i, n - i);
+        } else if (dec->sync_mode == 0 && dec->sync_time == 0) {
+            i += decoder_run_idle(dec, in + i, n - i);
+        } else {
+            decoder_process_sample(dec, (double)in[i++]);
+        }
+    }
+}
+
+/**
+ * Convert VIS code to SSTV mode
+ * 
+ * @param vis_code 8-bit VIS code (after bit accumulation)
+ * @param is_extended 1 if this is an extended (16-bit) VIS code
+ * @return SSTV mode or SSTV_MODE_COUNT if not found
+ */
+static sstv_mode_t vis_code_to_mode(uint8_t vis_code, int is_extended) {
+    /* Special case: 0x23 is the prefix for extended VIS (16-bit) */
+    if (!is_extended && vis_code == 0x23) {
+        return SSTV_MODE_COUNT; /* Signal to expect extended VIS */
     }
 
-    return 0;
+    /* Registry index: 8-bit and extended codes are separate tables, so
+     * ML240 and B/W 12 (both 0x86) need no disambiguation */
+    int mode = sstv_find_mode_by_vis(vis_code, is_extended);
+    return mode >= 0 ? (sstv_mode_t)mode : SSTV_MODE_COUNT;
 }
 
 static int vis_parity_ok(uint8_t vis_code) {
@@ -1169,40 +1917,170 @@ static int vis_parity_ok(uint8_t vis_code) {
 }
 
 /**
- * Allocate image buffer for the detected mode
- * 
+ * Release the frame buffer (heap or journal mapping)
+ *
+ * The journal file itself is left on disk so it can be recovered.
+ *
  * @param dec Decoder handle
- * @param mode SSTV mode
- * @return 0 on success, -1 on error
  */
-static int decoder_allocate_image_buffer(sstv_decoder_t *dec, sstv_mode_t mode) {
-    if (!dec) return -1;
-    
-    const sstv_mode_info_t *info = sstv_get_mode_info(mode);
-    if (!info) return -1;
-    
-    /* Free existing buffer if any */
+static void decoder_release_image_buffer(sstv_decoder_t *dec) {
+    if (!dec) return;
+#ifdef SSTV_HAVE_MMAP
+    if (dec->journal.map) {
+        munmap(dec->journal.map, dec->journal.map_len);
+        close(dec->journal.fd);
+        dec->journal.map = NULL;
+        dec->journal.map_len = 0;
+        dec->journal.fd = -1;
+        dec->image_buf.pixels = NULL;
+        return;
+    }
+#endif
     if (dec->image_buf.pixels) {
-        free(dec->image_buf.pixels);
+        dec->alloc.free(dec->alloc.user, dec->image_buf.pixels, dec->image_buf.size);
         dec->image_buf.pixels = NULL;
+        dec->image_buf.size = 0;
     }
-    
-    /* Allocate RGB24 buffer */
+}
+
+/**
+ * Zero the part of the frame that has not been written yet
+ *
+ * Frame buffers are not cleared when allocated (a recycled slab still
+ * holds an old frame), since pixels are written strictly in order and a
+ * completed frame overwrites every byte. Only a partial frame that is
+ * handed out needs its unreceived tail blanked, once.
+ *
+ * @param dec Decoder handle
+ */
+static void decoder_clear_unwritten(sstv_decoder_t *dec) {
+    image_buffer_t *ib = &dec->image_buf;
+    size_t total = (size_t)ib->width * ib->height * 3;
+    if (!ib->pixels || ib->clean_end >= total) return;
+    size_t pos = total;
+    if (ib->current_line < ib->height) {
+        pos = ((size_t)ib->current_line * ib->width + ib->current_col) * 3;
+    }
+    if (pos < ib->clean_end) pos = ib->clean_end;
+    if (pos < total) memset(ib->pixels + pos, 0, total - pos);
+    ib->clean_end = total;
+}
+
+/**
+ * Create the journal file for a new frame and map it as the image buffer
+ *
+ * @param dec Decoder handle (journal.path set)
+ * @param mode Locked SSTV mode
+ * @param pixel_bytes Size of the RGB24 frame
+ * @return 0 on success (image_buf.pixels points into the mapping), -1 on error
+ */
+static int journal_map_frame(sstv_decoder_t *dec, sstv_mode_t mode, size_t pixel_bytes) {
+#ifdef SSTV_HAVE_MMAP
+    size_t len = sizeof(journal_header_t) + pixel_bytes;
+    int fd = open(dec->journal.path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return -1;
+    /* ftruncate() zero-fills, so the frame starts out black */
+    if (ftruncate(fd, (off_t)len) != 0) {
+        close(fd);
+        return -1;
+    }
+    void *map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+
+    journal_header_t *hdr = (journal_header_t*)map;
+    hdr->version = JOURNAL_VERSION;
+    hdr->header_size = (uint32_t)sizeof(journal_header_t);
+    hdr->mode = (uint32_t)mode;
+    hdr->width = (uint32_t)dec->image_buf.width;
+    hdr->height = (uint32_t)dec->image_buf.height;
+    hdr->bytes_per_pixel = 3;
+    hdr->lines_completed = 0;
+    hdr->complete = 0;
+    hdr->sample_rate = dec->sample_rate;
+    /* Magic last: a header is only trusted once every field is in place */
+    memcpy(hdr->magic, JOURNAL_MAGIC, sizeof(hdr->magic));
+
+    dec->journal.fd = fd;
+    dec->journal.map = map;
+    dec->journal.map_len = len;
+    dec->image_buf.pixels = (uint8_t*)map + sizeof(journal_header_t);
+    return 0;
+#else
+    (void)dec;
+    (void)mode;
+    (void)pixel_bytes;
+    return -1;
+#endif
+}
+
+/**
+ * Record a finished line in the journal header
+ *
+ * Pixels are already in the shared mapping, so a crashed process loses
+ * nothing the kernel has seen; the asynchronous flush bounds how much a
+ * power loss can take. The final line is flushed synchronously.
+ *
+ * @param dec Decoder handle
+ */
+static void journal_line_done(sstv_decoder_t *dec) {
+#ifdef SSTV_HAVE_MMAP
+    if (!dec->journal.map) return;
+    journal_header_t *hdr = (journal_header_t*)dec->journal.map;
+    hdr->lines_completed = (uint32_t)dec->image_buf.current_line;
+    if (dec->image_buf.current_line >= dec->image_buf.height) {
+        hdr->complete = 1;
+        msync(dec->journal.map, dec->journal.map_len, MS_SYNC);
+    } else {
+        msync(dec->journal.map, dec->journal.map_len, MS_ASYNC);
+    }
+#else
+    (void)dec;
+#endif
+}
+
+/**
+ * Allocate image buffer for the detected mode
+ * 
+ * @param dec Decoder handle
+ * @param mode SSTV mode
+ * @return 0 on success, -1 on error
+ */
+static int decoder_allocate_image_buffer(sstv_decoder_t *dec, sstv_mode_t mode) {
+    if (!dec) return -1;
+    
+    const sstv_mode_info_t *info = sstv_get_mode_info(mode);
+    if (!info) return -1;
+    
+    /* Free existing buffer if any */
+    decoder_release_image_buffer(dec);
+    
+    /* Allocate RGB24 buffer */
     dec->image_buf.width = info->width;
     dec->image_buf.height = info->height;
     dec->image_buf.bytes_per_pixel = 3;  /* RGB24 */
     size_t buffer_size = (size_t)info->width * info->height * 3;
     
-    dec->image_buf.pixels = (uint8_t*)malloc(buffer_size);
-    if (!dec->image_buf.pixels) {
-        dec->image_buf.width = 0;
-        dec->image_buf.height = 0;
-        return -1;
+    /* Journal first (pixels land directly in the mapped file), heap otherwise */
+    if (!dec->journal.path || journal_map_frame(dec, mode, buffer_size) != 0) {
+        if (dec->journal.path && dec->debug_level >= 1) {
+            fprintf(stderr, "[DECODER] Journal %s unavailable, using heap buffer\n", dec->journal.path);
+        }
+        dec->image_buf.pixels = (uint8_t*)dec->alloc.alloc(dec->alloc.user, buffer_size);
+        if (!dec->image_buf.pixels) {
+            dec->image_buf.width = 0;
+            dec->image_buf.height = 0;
+            return -1;
+        }
+        dec->image_buf.size = buffer_size;
+        /* Black is filled in lazily (decoder_clear_unwritten) */
+        dec->image_buf.clean_end = 0;
+    } else {
+        dec->image_buf.clean_end = buffer_size;   /* Fresh file pages are zero */
     }
     
-    /* Initialize to black */
-    memset(dec->image_buf.pixels, 0, buffer_size);
-    
     /* Reset position counters */
     dec->image_buf.current_line = 0;
     dec->image_buf.current_col = 0;
@@ -1210,6 +2088,7 @@ static int decoder_allocate_image_buffer(sstv_decoder_t *dec, sstv_mode_t mode)
     /* Initialize image decoder state */
     dec->img_dec.state = IMAGE_SYNC_WAIT;
     dec->img_dec.sample_counter = 0;
+    dec->img_dec.pixel_clock = 0.0;
     dec->img_dec.current_channel = 0;
     dec->img_dec.freq_accum = 0.0;
     dec->img_dec.freq_samples = 0;
@@ -1238,6 +2117,37 @@ static int decoder_allocate_image_buffer(sstv_decoder_t *dec, sstv_mode_t mode)
     return 0;
 }
 
+/**
+ * Lock onto a VIS-decoded mode and start image decoding at this sample
+ *
+ * The frame buffer is allocated here rather than at the end of
+ * sstv_decoder_feed() so that the first image sample does not depend on
+ * how the caller chunks its input.
+ *
+ * @param dec Decoder handle
+ * @param mode SSTV mode from VIS
+ */
+static void decoder_lock_mode(sstv_decoder_t *dec, sstv_mode_t mode) {
+    if (!dec) return;
+    dec->detected_mode = mode;
+    dec->sync_state = SYNC_DATA_WAIT;
+    /* Locks happen in acq_step, one sample at a time (an idle run ends
+     * long before a VIS can complete), so the front end count is exact.
+     * The AGC delay is taken out to place it in the input. */
+    uint64_t lag = (uint64_t)dec->agc.blocks * AGC_BLOCK;
+    dec->lock_sample = dec->front_samples > lag ? dec->front_samples - lag : 0;
+    if (decoder_allocate_image_buffer(dec, mode) != 0 && dec->debug_level >= 1) {
+        fprintf(stderr, "[DECODER] Failed to allocate image buffer\n");
+    }
+    line_sync_start(dec, mode);
+    zc_demod_reset(&dec->zc);
+    quality_start(dec);
+    if (dec->track.enabled) {
+        track_mark_frame(dec, mode);
+    }
+    decoder_select_image_run(dec);
+}
+
 /**
  * Convert frequency (Hz) to color value (0-255)
  * SSTV uses 1500-2300 Hz for black-to-white
@@ -1246,21 +2156,7 @@ static int decoder_allocate_image_buffer(sstv_decoder_t *dec, sstv_mode_t mode)
  * @return Color value 0-255
  */
 static int frequency_to_color(double freq_hz) {
-    /* SSTV standard: 1500 Hz = black (0), 2300 Hz = white (255) */
-    const double f_black = 1500.0;
-    const double f_white = 2300.0;
-    
-    if (freq_hz <= f_black) return 0;
-    if (freq_hz >= f_white) return 255;
-    
-    /* Linear mapping */
-    double normalized = (freq_hz - f_black) / (f_white - f_black);
-    int color = (int)(normalized * 255.0 + 0.5);
-    
-    /* Clamp to valid range */
-    if (color < 0) return 0;
-    if (color > 255) return 255;
-    return color;
+    return image_level(freq_hz);
 }
 
 /**
@@ -1299,30 +2195,136 @@ static void decoder_store_pixel(sstv_decoder_t *dec, int color_value, int channe
 }
 
 /**
- * Process image data sample - decode pixels from frequency tones
- * 
- * This is a simplified decoder that treats all modes as grayscale for now.
- * Future enhancement: add per-mode color decoding (RGB sequential, YC, etc.)
- * 
- * @param dec Decoder handle
+ * Estimate the instantaneous tone frequency from the tone detector outputs
+ *
+ * Very rough ratio-based approximation - real SSTV decoders use a PLL.
+ *
  * @param freq_11 1100 Hz tone energy (or similar low freq)
  * @param freq_13 1300 Hz tone energy (or similar high freq)
- * @param freq_19 1900 Hz sync tone energy
+ * @return Frequency in the 1500-2300 Hz image range
  */
-static void decoder_process_image_sample(sstv_decoder_t *dec, double freq_11, double freq_13, double freq_19) {
-    if (!dec || !dec->image_buf.pixels) return;
-    
-    /* Simple frequency estimation from tone detector outputs */
-    /* This is a very rough approximation - real SSTV decoders use PLL */
+static double image_estimate_freq(double freq_11, double freq_13) {
     double total_energy = freq_11 + freq_13;
     if (total_energy < 1.0) total_energy = 1.0;
     
-    /* Ratio-based frequency estimation */
     /* freq_13 (high) vs freq_11 (low) gives us approximate frequency */
     double ratio = freq_13 / total_energy;  /* 0.0 to 1.0 */
     
     /* Map ratio to SSTV frequency range (1500-2300 Hz) */
-    double estimated_freq = 1500.0 + ratio * 800.0;  /* 1500-2300 Hz */
+    return 1500.0 + ratio * 800.0;
+}
+
+/**
+ * Complete the current image line: notify the consumer, advance to the
+ * next line and mark the frame complete after the last one
+ *
+ * @param dec Decoder handle
+ */
+static void decoder_finish_line(sstv_decoder_t *dec) {
+    /* Hand the finished row to the consumer before moving on */
+    if (dec->line_cb) {
+        int line = dec->image_buf.current_line;
+        dec->line_cb(dec->line_cb_user, line,
+                     dec->image_buf.pixels + (size_t)line * dec->image_buf.width * 3,
+                     dec->image_buf.width, dec->image_buf.height);
+    }
+    
+    /* Move to next line */
+    dec->image_buf.current_col = 0;
+    dec->image_buf.current_line++;
+    journal_line_done(dec);
+    
+    if (dec->debug_level >= 2 && (dec->image_buf.current_line % 10 == 0)) {
+        fprintf(stderr, "[DECODER] Line %d/%d complete\n",
+                dec->image_buf.current_line, dec->image_buf.height);
+    }
+    
+    /* Check if image is complete */
+    if (dec->image_buf.current_line >= dec->image_buf.height) {
+        dec->img_dec.state = IMAGE_COMPLETE;
+        if (dec->debug_level >= 2) {
+            fprintf(stderr, "[DECODER] Image decoding complete\n");
+        }
+    }
+}
+
+/* === ZERO-CROSSING DEMODULATOR === */
+
+static void zc_demod_reset(zc_demod_t *zc) {
+    memset(zc, 0, sizeof(*zc));
+    zc->freq = 1500.0;
+}
+
+/**
+ * Feed one band-passed sample to the zero-crossing estimator
+ *
+ * @param zc Estimator state
+ * @param x Band-passed, level-controlled sample
+ * @param sample_rate Sample rate in Hz
+ * @return Current frequency estimate in Hz
+ */
+static double zc_demod_do(zc_demod_t *zc, double x, double sample_rate) {
+    zc->elapsed += 1.0;
+    if ((x >= 0.0) != (zc->prev >= 0.0)) {
+        /* The crossing lies (1 - frac) samples before this one */
+        double frac = zc->prev / (zc->prev - x);
+        double half = zc->elapsed - (1.0 - frac);
+        zc->elapsed = 1.0 - frac;
+        double cycle = half + zc->last_half;
+        zc->last_half = half;
+        if (cycle <= 0.0) {
+            zc->prev = x;
+            return zc->freq;
+        }
+
+        zc->cycle[zc->cycle_pos] = cycle;
+        if (++zc->cycle_pos >= ZC_MEDIAN) zc->cycle_pos = 0;
+        if (zc->cycle_n < ZC_MEDIAN) zc->cycle_n++;
+
+        /* Median by insertion sort of a copy (at most ZC_MEDIAN values) */
+        double v[ZC_MEDIAN];
+        int n = zc->cycle_n;
+        for (int i = 0; i < n; i++) {
+            double h = zc->cycle[i];
+            int j = i;
+            while (j > 0 && v[j - 1] > h) {
+                v[j] = v[j - 1];
+                j--;
+            }
+            v[j] = h;
+        }
+        double f = sample_rate / v[n / 2];
+        if (f < ZC_MIN_HZ) f = ZC_MIN_HZ;
+        if (f > ZC_MAX_HZ) f = ZC_MAX_HZ;
+        zc->freq = f;
+    }
+    zc->prev = x;
+    return zc->freq;
+}
+
+int sstv_decoder_set_demod(sstv_decoder_t *dec, sstv_demod_t demod) {
+    if (!dec) return -1;
+    if (demod != SSTV_DEMOD_TONE && demod != SSTV_DEMOD_ZC) return -1;
+    dec->demod = demod;
+    zc_demod_reset(&dec->zc);
+    decoder_select_image_run(dec);
+    decoder_trace_call(dec, TRACE_CALL_DEMOD, (int)demod, 0.0, 0.0);
+    return 0;
+}
+
+/**
+ * Process image data sample - decode pixels from frequency tones
+ * 
+ * This is a simplified decoder that treats all modes as grayscale for now.
+ * Future enhancement: add per-mode color decoding (RGB sequential, YC, etc.)
+ * 
+ * @param dec Decoder handle
+ * @param freq_hz Instantaneous frequency from the selected demodulator
+ */
+static void decoder_process_image_sample(sstv_decoder_t *dec, double freq_hz) {
+    if (!dec || !dec->image_buf.pixels) return;
+    
+    double estimated_freq = freq_hz;
     
     /* Convert frequency to color value */
     int color = frequency_to_color(estimated_freq);
@@ -1331,9 +2333,13 @@ static void decoder_process_image_sample(sstv_decoder_t *dec, double freq_11, do
     dec->img_dec.freq_accum += (double)color;
     dec->img_dec.freq_samples++;
     dec->img_dec.sample_counter++;
+    dec->img_dec.pixel_clock += 1.0;
     
-    /* When we've accumulated enough samples for one pixel */
-    if (dec->img_dec.sample_counter >= (int)dec->img_dec.samples_per_pixel) {
+    /* When we've accumulated enough samples for one pixel. The fractional
+     * remainder is carried over so the frame spans the full transmission
+     * instead of finishing early (and re-arming VIS inside image data). */
+    if (dec->img_dec.pixel_clock >= dec->img_dec.samples_per_pixel) {
+        dec->img_dec.pixel_clock -= dec->img_dec.samples_per_pixel;
         /* Average the accumulated values */
         int avg_color = 0;
         if (dec->img_dec.freq_samples > 0) {
@@ -1342,26 +2348,13 @@ static void decoder_process_image_sample(sstv_decoder_t *dec, double freq_11, do
         
         /* Store the pixel (grayscale for now) */
         decoder_store_pixel(dec, avg_color, -1);  /* -1 = grayscale (all channels) */
+        quality_pixel(dec);
         
         /* Move to next pixel */
         dec->image_buf.current_col++;
         if (dec->image_buf.current_col >= dec->image_buf.width) {
-            /* Move to next line */
-            dec->image_buf.current_col = 0;
-            dec->image_buf.current_line++;
-            
-            if (dec->debug_level >= 2 && (dec->image_buf.current_line % 10 == 0)) {
-                fprintf(stderr, "[DECODER] Line %d/%d complete\n",
-                        dec->image_buf.current_line, dec->image_buf.height);
-            }
-            
-            /* Check if image is complete */
-            if (dec->image_buf.current_line >= dec->image_buf.height) {
-                dec->img_dec.state = IMAGE_COMPLETE;
-                if (dec->debug_level >= 2) {
-                    fprintf(stderr, "[DECODER] Image decoding complete\n");
-                }
-            }
+            quality_line_done(dec);
+            decoder_finish_line(dec);
         }
         
         /* Reset accumulators */
@@ -1390,11 +2383,13 @@ static int decoder_check_vis_ready(sstv_decoder_t *dec, sstv_mode_t *mode_out) {
 void sstv_decoder_set_mode_hint(sstv_decoder_t *dec, sstv_mode_t mode) {
     if (!dec) return;
     dec->mode_hint = mode;
+    decoder_trace_call(dec, TRACE_CALL_MODE_HINT, (int)mode, 0.0, 0.0);
 }
 
 void sstv_decoder_set_vis_enabled(sstv_decoder_t *dec, int enable) {
     if (!dec) return;
     dec->vis_enabled = enable ? 1 : 0;
+    decoder_trace_call(dec, TRACE_CALL_VIS_ENABLED, dec->vis_enabled, 0.0, 0.0);
 }
 
 void sstv_decoder_set_vis_tones(sstv_decoder_t *dec, double mark_hz, double space_hz) {
@@ -1402,22 +2397,71 @@ void sstv_decoder_set_vis_tones(sstv_decoder_t *dec, double mark_hz, double spac
     if (mark_hz <= 0.0 || space_hz <= 0.0) return;
     dec->iir11.SetFreq(mark_hz, dec->sample_rate, 80.0);
     dec->iir13.SetFreq(space_hz, dec->sample_rate, 80.0);
+    dec->vis_mark_hz = mark_hz;
+    dec->vis_space_hz = space_hz;
+    decoder_trace_call(dec, TRACE_CALL_VIS_TONES, 0, mark_hz, space_hz);
 }
 
-sstv_rx_status_t sstv_decoder_feed(
+int sstv_decoder_set_agc_timing(sstv_decoder_t *dec, double lookahead_ms,
+                                double attack_ms, double release_ms) {
+    if (!dec || !(lookahead_ms > 0.0 && lookahead_ms <= AGC_MAX_LOOKAHEAD_MS) ||
+        !(attack_ms > 0.0 && attack_ms <= AGC_MAX_TIME_MS) ||
+        !(release_ms > 0.0 && release_ms <= AGC_MAX_TIME_MS)) {
+        return -1;
+    }
+    /* Whole microseconds, so the trace call below replays exactly */
+    int us = (int)lround(lookahead_ms * 1000.0);
+    if (us < 1) return -1;
+    dec->agc.lookahead_ms = us / 1000.0;
+    dec->agc.attack_ms = attack_ms;
+    dec->agc.release_ms = release_ms;
+    block_agc_init(&dec->agc, dec->sample_rate);
+    decoder_trace_call(dec, TRACE_CALL_AGC_TIMING, us, attack_ms, release_ms);
+    return 0;
+}
+
+int sstv_decoder_set_false_alarm_rate(sstv_decoder_t *dec, double per_hour) {
+    if (!dec || !(per_hour >= 0.0 && per_hour <= 3600.0)) return -1;
+    sense_adapt_t *sa = &dec->sense;
+    sa->rate = per_hour;
+    sa->k_decay = SENSE_K_STEP * per_hour / (3600.0 * dec->sample_rate);
+    if (per_hour <= 0.0) {
+        sa->on12 = sa->hold12 = dec->s_lvl;
+        sa->vis11 = sa->vis13 = dec->s_lvl2;
+    }
+    decoder_trace_call(dec, TRACE_CALL_SENSE, 0, per_hour, 0.0);
+    return 0;
+}
+
+int sstv_decoder_get_sense_stats(const sstv_decoder_t *dec, sstv_sense_stats_t *stats) {
+    if (!dec || !stats) return -1;
+    const sense_adapt_t *sa = &dec->sense;
+    memset(stats, 0, sizeof(*stats));
+    stats->triggers = sa->triggers;
+    stats->vis_attempts = sa->vis_attempts;
+    stats->false_starts = sa->false_starts;
+    stats->vis_locks = sa->vis_locks;
+    stats->noise_floor = sa->f12.mean;
+    stats->sync_level = sa->on12;
+    stats->hold_level = sa->hold12;
+    stats->k = sa->k;
+    stats->vis_repairs = sa->vis_repairs;
+    stats->vis_confidence = sa->vis_conf;
+    return 0;
+}
+
+static sstv_rx_status_t decoder_feed_block(
     sstv_decoder_t *dec,
     const float *samples,
     size_t sample_count
 ) {
-    if (!dec || !samples || sample_count == 0) {
-        return SSTV_RX_ERROR;
+    if (!dec->debug_first_sample_logged && dec->debug_level >= 2) {
+        fprintf(stderr, "[DECODER] first samples in, sample_rate=%.0f\n", dec->sample_rate);
+        dec->debug_first_sample_logged = 1;
     }
 
-    /* Process each sample through demod pipeline */
-    for (size_t i = 0; i < sample_count; i++) {
-        double sample = (double)samples[i];
-        decoder_process_sample(dec, sample);
-    }
+    /* Process the samples through the demod pipeline */
+    decoder_run(dec, samples, sample_count);
 
     /* Check VIS readiness and allocate image buffer if mode detected */
     sstv_mode_t detected_mode;
@@ -1449,6 +2493,51 @@ sstv_rx_status_t sstv_decoder_feed(
     return SSTV_RX_NEED_MORE;
 }
 
+sstv_rx_status_t sstv_decoder_feed(
+    sstv_decoder_t *dec,
+    const float *samples,
+    size_t sample_count
+) {
+    if (!dec || !samples || sample_count == 0) {
+        return SSTV_RX_ERROR;
+    }
+
+    if (!dec->trace.fp) {
+        sstv_rx_status_t st = decoder_feed_block(dec, samples, sample_count);
+        dec->samples_fed += sample_count;
+        return st;
+    }
+
+    /* Tracing: record the block with its timing, then checksum on schedule */
+    auto t_start = std::chrono::steady_clock::now();
+    sstv_rx_status_t st = decoder_feed_block(dec, samples, sample_count);
+    auto t_end = std::chrono::steady_clock::now();
+
+    trace_feed_t rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.index = dec->trace_feeds++;
+    rec.first_sample = dec->samples_fed;
+    rec.arrival_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        t_start - dec->trace_t0).count();
+    rec.proc_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        t_end - t_start).count();
+    rec.status = (int32_t)st;
+    rec.count = (uint32_t)sample_count;
+    trace_write_feed(&dec->trace, &rec, samples);
+
+    dec->samples_fed += sample_count;
+    if (dec->samples_fed >= dec->trace_next_check) {
+        trace_check_t chk;
+        chk.sample_pos = dec->samples_fed;
+        chk.checksum = sstv_decoder_get_checksum(dec);
+        trace_write_check(&dec->trace, &chk);
+        while (dec->trace_next_check <= dec->samples_fed) {
+            dec->trace_next_check += dec->trace_check_interval;
+        }
+    }
+    return st;
+}
+
 int sstv_decoder_get_image(sstv_decoder_t *dec, sstv_image_t *out_image) {
     if (!dec || !out_image) {
         return -1;
@@ -1460,6 +2549,7 @@ int sstv_decoder_get_image(sstv_decoder_t *dec, sstv_image_t *out_image) {
     }
     
     /* Fill output structure */
+    decoder_clear_unwritten(dec);
     out_image->pixels = dec->image_buf.pixels;
     out_image->width = (uint32_t)dec->image_buf.width;
     out_image->height = (uint32_t)dec->image_buf.height;
@@ -1488,10 +2578,744 @@ int sstv_decoder_get_state(sstv_decoder_t *dec, sstv_decoder_state_t *state) {
     state->image_ready = (dec->last_status == SSTV_RX_IMAGE_READY);
     state->current_line = dec->image_buf.current_line;
     state->total_lines = dec->image_buf.height;
+    state->lock_sample = (dec->detected_mode != SSTV_MODE_COUNT) ? dec->lock_sample : 0;
     
     return 0;
 }
 
+int sstv_decoder_set_journal(sstv_decoder_t *dec, const char *path) {
+    if (!dec) return -1;
+#ifdef SSTV_HAVE_MMAP
+    /* Takes effect at the next VIS lock; a frame in progress keeps its buffer */
+    free(dec->journal.path);
+    dec->journal.path = NULL;
+    if (path && path[0]) {
+        size_t n = strlen(path) + 1;
+        dec->journal.path = (char*)malloc(n);
+        if (!dec->journal.path) return -1;
+        memcpy(dec->journal.path, path, n);
+    }
+    return 0;
+#else
+    (void)path;
+    return -1;
+#endif
+}
+
+int sstv_decoder_recover_journal(const char *path, sstv_image_t *out_image,
+                                 sstv_mode_t *mode_out, int *lines_completed) {
+    if (!path || !out_image) return -1;
+#ifdef SSTV_HAVE_MMAP
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(journal_header_t)) {
+        close(fd);
+        return -1;
+    }
+    size_t len = (size_t)st.st_size;
+    void *map = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    const journal_header_t *hdr = (const journal_header_t*)map;
+    int rc = -1;
+    if (memcmp(hdr->magic, JOURNAL_MAGIC, sizeof(hdr->magic)) == 0 &&
+        hdr->version == JOURNAL_VERSION &&
+        hdr->header_size == sizeof(journal_header_t) &&
+        hdr->bytes_per_pixel == 3 &&
+        sstv_get_mode_info((sstv_mode_t)hdr->mode) != NULL &&
+        hdr->width > 0 && hdr->height > 0 &&
+        hdr->lines_completed <= hdr->height) {
+        size_t pixel_bytes = (size_t)hdr->width * hdr->height * 3;
+        if (len >= sizeof(journal_header_t) + pixel_bytes) {
+            uint8_t *pixels = (uint8_t*)malloc(pixel_bytes);
+            if (pixels) {
+                /* Lines past lines_completed may be partial; copy the whole
+                 * frame anyway so the caller can see the torn line too. */
+                memcpy(pixels, (const uint8_t*)map + sizeof(journal_header_t), pixel_bytes);
+                out_image->pixels = pixels;
+                out_image->width = hdr->width;
+                out_image->height = hdr->height;
+                out_image->stride = hdr->width * 3;
+                out_image->format = SSTV_RGB24;
+                if (mode_out) *mode_out = (sstv_mode_t)hdr->mode;
+                if (lines_completed) *lines_completed = (int)hdr->lines_completed;
+                rc = 0;
+            }
+        }
+    }
+    munmap(map, len);
+    return rc;
+#else
+    (void)mode_out;
+    (void)lines_completed;
+    return -1;
+#endif
+}
+
+/* === FREQUENCY TRACK === */
+
+static void track_reset(freq_track_t *tr) {
+    tr->freq.clear();
+    tr->sync.clear();
+    tr->origin = 0;
+    tr->pos = 0;
+    tr->lock_pos = 0;
+    tr->lock_mode = SSTV_MODE_COUNT;
+    tr->accum = 0.0;
+    tr->accum_n = 0;
+    tr->sync_run = 0;
+}
+
+/* Append one audio sample's frequency estimate (called for every sample) */
+static void track_push(sstv_decoder_t *dec, double freq_hz, int sync_tone) {
+    freq_track_t *tr = &dec->track;
+    tr->pos++;
+
+    if (sync_tone) {
+        if (++tr->sync_run == tr->sync_min) {
+            /* Log where the pulse began, in track samples */
+            uint64_t start = tr->pos - (uint64_t)tr->sync_min;
+            if (start >= tr->origin) {
+                tr->sync.push_back((uint32_t)((start - tr->origin) / (uint64_t)tr->decim));
+            }
+        }
+    } else {
+        tr->sync_run = 0;
+    }
+
+    tr->accum += freq_hz;
+    if (++tr->accum_n < tr->decim) return;
+
+    if (tr->freq.size() < (size_t)(TRACK_MAX_SEC * dec->sample_rate / tr->decim)) {
+        double code = tr->accum / tr->accum_n * TRACK_HZ_SCALE + 0.5;
+        if (code > 65535.0) code = 65535.0;
+        tr->freq.push_back((uint16_t)code);
+    }
+    tr->accum = 0.0;
+    tr->accum_n = 0;
+}
+
+/* A frame starts at the next sample: keep a short pre-roll, drop the rest */
+static void track_mark_frame(sstv_decoder_t *dec, sstv_mode_t mode) {
+    freq_track_t *tr = &dec->track;
+    size_t keep = (size_t)(TRACK_PREROLL_SEC * dec->sample_rate / tr->decim);
+    if (tr->freq.size() > keep) {
+        size_t drop = tr->freq.size() - keep;
+        tr->freq.erase(tr->freq.begin(), tr->freq.begin() + drop);
+        size_t first = 0;
+        while (first < tr->sync.size() && tr->sync[first] < drop) first++;
+        tr->sync.erase(tr->sync.begin(), tr->sync.begin() + first);
+        for (uint32_t &s : tr->sync) s -= (uint32_t)drop;
+        tr->origin += (uint64_t)drop * tr->decim;
+    }
+    tr->lock_pos = tr->pos;
+    tr->lock_mode = mode;
+}
+
+int sstv_decoder_set_track_enabled(sstv_decoder_t *dec, int enable) {
+    if (!dec) return -1;
+    freq_track_t *tr = &dec->track;
+    if (!enable) {
+        tr->enabled = 0;
+        track_reset(tr);
+        std::vector<uint16_t>().swap(tr->freq);
+        std::vector<uint32_t>().swap(tr->sync);
+        decoder_select_image_run(dec);
+        return 0;
+    }
+    if (tr->enabled) return 0;
+
+    track_reset(tr);
+    tr->decim = (int)(dec->sample_rate / TRACK_RATE_HZ);
+    if (tr->decim < 1) tr->decim = 1;
+    tr->sync_min = (int)(TRACK_SYNC_MIN_MS * dec->sample_rate / 1000.0);
+    if (tr->sync_min < 1) tr->sync_min = 1;
+    /* Count from here; positions are relative to the enable point */
+    tr->enabled = 1;
+    decoder_select_image_run(dec);
+    return 0;
+}
+
+int sstv_decoder_get_sync_events(sstv_decoder_t *dec, int32_t *offsets, int max_offsets) {
+    if (!dec || !dec->track.enabled) return -1;
+    const freq_track_t *tr = &dec->track;
+    int n = (int)tr->sync.size();
+    for (int i = 0; offsets && i < n && i < max_offsets; i++) {
+        int64_t at = (int64_t)(tr->origin + (uint64_t)tr->sync[i] * tr->decim);
+        offsets[i] = (int32_t)(at - (int64_t)tr->lock_pos);
+    }
+    return n;
+}
+
+int sstv_decoder_redecode(sstv_decoder_t *dec, sstv_mode_t mode, double slant_ppm, int offset) {
+    if (!dec || !dec->track.enabled) return -1;
+    freq_track_t *tr = &dec->track;
+    if (tr->lock_mode == SSTV_MODE_COUNT) return -1;
+    /* Do not pull the buffer out from under a frame still being received */
+    if (dec->sync_state == SYNC_DATA_WAIT && dec->image_buf.pixels &&
+        dec->img_dec.state != IMAGE_COMPLETE) {
+        return -1;
+    }
+    const sstv_mode_info_t *info = sstv_get_mode_info(mode);
+    if (!info || decoder_allocate_image_buffer(dec, mode) != 0) return -1;
+    dec->detected_mode = mode;
+    /* Quality is measured from the audio, which the track no longer has */
+    dec->qual.lines.clear();
+    dec->qual.plane.clear();
+
+    /* Per-sample colours of the track, then box-integrate each pixel span */
+    const size_t n = tr->freq.size();
+    std::vector<uint8_t> color(n);
+    for (size_t k = 0; k < n; k++) {
+        color[k] = (uint8_t)frequency_to_color(tr->freq[k] / TRACK_HZ_SCALE);
+    }
+
+    const double spp = info->duration_sec / (double)info->height * dec->sample_rate /
+                       (double)info->width * (1.0 + slant_ppm * 1e-6);
+    const double step = spp / tr->decim;
+    const double start = ((double)tr->lock_pos + offset - (double)tr->origin) / tr->decim;
+    const int width = dec->image_buf.width;
+
+    for (int line = 0; line < dec->image_buf.height; line++) {
+        double line_end = start + (double)(line + 1) * width * step;
+        if (line_end > (double)n) break;   /* Track ends inside this line */
+        for (int x = 0; x < width; x++) {
+            double a = start + ((double)line * width + x) * step;
+            double b = a + step;
+            double sum = 0.0;
+            long k0 = (long)std::floor(a);
+            if (k0 < 0) k0 = 0;
+            for (long k = k0; k < (long)n && (double)k < b; k++) {
+                double lo = a > (double)k ? a : (double)k;
+                double hi = b < (double)(k + 1) ? b : (double)(k + 1);
+                if (hi > lo) sum += color[k] * (hi - lo);
+            }
+            dec->image_buf.current_col = x;
+            decoder_store_pixel(dec, (int)(sum / step + 0.5), -1);
+        }
+        decoder_finish_line(dec);
+    }
+
+    /* The frame is final either way; the live decoder must not resume into it */
+    dec->img_dec.state = IMAGE_COMPLETE;
+    return dec->image_buf.current_line;
+}
+
+/* === LINE SYNC CORRELATOR === */
+
+/* Sync pulse length and transmitted lines per frame; 0 ms = no 1200 Hz sync */
+static double line_sync_spec(sstv_mode_t mode, int *lines) {
+    const sstv_mode_desc_t *desc = sstv_get_mode_desc(mode);
+    if (!desc) return 0.0;
+    *lines = (int)desc->lines;
+    /* AVT has no line sync; narrow modes sync at 1900 Hz */
+    return desc->sync_hz == 1200.0 ? desc->sync_ms : 0.0;
+}
+
+static void line_sync_start(sstv_decoder_t *dec, sstv_mode_t mode) {
+    line_sync_t *ls = &dec->lsync;
+    int lines = 0;
+    double sync_ms = line_sync_spec(mode, &lines);
+    const sstv_mode_info_t *info = sstv_get_mode_info(mode);
+    ls->active = 0;
+    if (sync_ms <= 0.0 || lines <= 0 || !info) return;
+
+    ls->decim = (int)(dec->sample_rate / LSYNC_RATE_HZ);
+    if (ls->decim < 1) ls->decim = 1;
+    double rate = dec->sample_rate / ls->decim;
+    ls->len = (int)(sync_ms * rate / 1000.0 + 0.5);
+    if (ls->len < 2) ls->len = 2;
+    ls->ring_diff.assign((size_t)ls->len, 0.0);
+    ls->ring_sum.assign((size_t)ls->len, 0.0);
+    ls->ring_pos = 0;
+    ls->s_diff = ls->s_sum = 0.0;
+    ls->acc_diff = ls->acc_sum = 0.0;
+    ls->acc_n = 0;
+    ls->t = 0;
+    ls->c1 = ls->c2 = 0.0;
+    ls->nominal = info->duration_sec / lines * rate;
+    ls->period = ls->nominal;
+    ls->last_peak = 0.0;
+    ls->line = 0;
+    ls->fit_n = ls->fit_k = ls->fit_kk = ls->fit_x = ls->fit_kx = 0.0;
+    ls->fit_a = 0.0;
+    ls->last_c = 0.0;
+    ls->best_pos = 0.0;
+    ls->best_c = 0.0;
+    ls->locked = ls->hits = ls->misses = 0;
+    ls->found = ls->missed = 0;
+    ls->last_err = 0.0;
+    ls->spp_nominal = dec->img_dec.samples_per_pixel;
+    ls->active = 1;
+}
+
+/* Add a matched pulse to the fit and refresh the period and line 0 position */
+static void line_sync_fit(line_sync_t *ls, double k, double pos) {
+    ls->fit_n += 1.0;
+    ls->fit_k += k;
+    ls->fit_kk += k * k;
+    ls->fit_x += pos;
+    ls->fit_kx += k * pos;
+
+    double slope = ls->nominal;
+    double den = ls->fit_n * ls->fit_kk - ls->fit_k * ls->fit_k;
+    if (ls->fit_n >= LSYNC_FIT_MIN && den > 0.0) {
+        double lim = ls->nominal * LSYNC_MAX_PPM * 1e-6;
+        slope = (ls->fit_n * ls->fit_kx - ls->fit_k * ls->fit_x) / den;
+        if (slope > ls->nominal + lim) slope = ls->nominal + lim;
+        if (slope < ls->nominal - lim) slope = ls->nominal - lim;
+    }
+    ls->period = slope;
+    ls->fit_a = (ls->fit_x - slope * ls->fit_k) / ls->fit_n;
+}
+
+/* A pulse matched where the tracker expected it: follow its timing */
+static void line_sync_accept(sstv_decoder_t *dec, double pos, double c, double err) {
+    line_sync_t *ls = &dec->lsync;
+    line_sync_fit(ls, (double)ls->line, pos);
+    ls->last_peak = pos;
+    ls->last_c = c;
+    ls->last_err = err;
+    ls->found++;
+    if (c > dec->qual.line_sync) dec->qual.line_sync = c;
+    ls->misses = 0;
+    if (ls->fit_n >= LSYNC_FIT_MIN) {
+        dec->img_dec.samples_per_pixel = ls->spp_nominal * ls->period / ls->nominal;
+    }
+}
+
+/* Local correlation maximum at pos (searching: any pulse; locked: in window) */
+static void line_sync_peak(sstv_decoder_t *dec, double pos, double c) {
+    line_sync_t *ls = &dec->lsync;
+    double win = LSYNC_WINDOW_MS * dec->sample_rate / ls->decim / 1000.0;
+    if (ls->locked) {
+        if (c >= LSYNC_HOLD && c > ls->best_c &&
+            fabs(pos - (ls->fit_a + ls->period * ls->line)) <= win) {
+            ls->best_c = c;
+            ls->best_pos = pos;
+        }
+        return;
+    }
+    if (c < LSYNC_ACQUIRE) return;
+    if (c > dec->qual.line_sync) dec->qual.line_sync = c;
+
+    double d = pos - ls->last_peak;
+    if (ls->hits > 0 && d < ls->len) {
+        /* Same pulse, better peak */
+        if (c > ls->last_c) {
+            ls->last_peak = pos;
+            ls->last_c = c;
+        }
+        return;
+    }
+    double n = floor(d / ls->period + 0.5);
+    if (ls->hits > 0 && n >= 1.0 && n <= 2.0 && fabs(d - n * ls->period) <= win) {
+        ls->hits++;
+        ls->found++;
+    } else {
+        ls->hits = 1;
+    }
+    ls->last_peak = pos;
+    ls->last_c = c;
+    if (ls->hits >= LSYNC_LOCK_HITS) {
+        ls->locked = 1;
+        ls->misses = 0;
+        ls->best_c = 0.0;
+        ls->fit_n = ls->fit_k = ls->fit_kk = ls->fit_x = ls->fit_kx = 0.0;
+        ls->period = ls->nominal;
+        line_sync_fit(ls, 0.0, pos);
+        ls->line = 1;
+        if (dec->debug_level >= 2) {
+            fprintf(stderr, "[LSYNC] Locked at step %.1f (c=%.2f)\n", pos, c);
+        }
+    }
+}
+
+/* Feed one audio sample's 1200/1900 Hz envelopes during image reception */
+static void line_sync_push(sstv_decoder_t *dec, double d12, double d19) {
+    line_sync_t *ls = &dec->lsync;
+    ls->acc_diff += d12 - d19;
+    ls->acc_sum += d12 + d19;
+    if (++ls->acc_n < ls->decim) return;
+
+    /* Box sums over one pulse length */
+    ls->s_diff += ls->acc_diff - ls->ring_diff[ls->ring_pos];
+    ls->s_sum += ls->acc_sum - ls->ring_sum[ls->ring_pos];
+    ls->ring_diff[ls->ring_pos] = ls->acc_diff;
+    ls->ring_sum[ls->ring_pos] = ls->acc_sum;
+    if (++ls->ring_pos >= ls->len) ls->ring_pos = 0;
+    ls->acc_diff = ls->acc_sum = 0.0;
+    ls->acc_n = 0;
+
+    double c = ls->s_sum > 1e-9 ? ls->s_diff / ls->s_sum : 0.0;
+    int64_t k = ls->t - 1;
+    ls->t++;
+
+    /* Local maximum at k: refine by fitting a parabola through k-1..k+1 */
+    if (k >= ls->len && ls->c1 > ls->c2 && ls->c1 >= c) {
+        double den = ls->c2 - 2.0 * ls->c1 + c;
+        double delta = den < 0.0 ? 0.5 * (ls->c2 - c) / den : 0.0;
+        line_sync_peak(dec, (double)k + delta, ls->c1);
+    }
+    ls->c2 = ls->c1;
+    ls->c1 = c;
+
+    /* Close the locked window once it has passed */
+    if (ls->locked) {
+        double pred = ls->fit_a + ls->period * ls->line;
+        double win = LSYNC_WINDOW_MS * dec->sample_rate / ls->decim / 1000.0;
+        if ((double)k > pred + win) {
+            if (ls->best_c > 0.0 && fabs(ls->best_pos - pred) <= win) {
+                line_sync_accept(dec, ls->best_pos, ls->best_c, ls->best_pos - pred);
+            } else {
+                /* Coast on the prediction */
+                ls->missed++;
+                if (++ls->misses >= LSYNC_LOSE_MISSES) {
+                    ls->locked = 0;
+                    ls->hits = 0;
+                    if (dec->debug_level >= 2) {
+                        fprintf(stderr, "[LSYNC] Lost lock at step %lld\n", (long long)k);
+                    }
+                }
+            }
+            ls->best_c = 0.0;
+            ls->line++;
+        }
+    }
+}
+
+int sstv_decoder_get_line_sync(const sstv_decoder_t *dec, sstv_line_sync_t *info) {
+    if (!dec || !info) return -1;
+    const line_sync_t *ls = &dec->lsync;
+    memset(info, 0, sizeof(*info));
+    if (!ls->active && ls->nominal <= 0.0) return 0;
+    info->locked = ls->active && ls->locked;
+    info->lines_found = ls->found;
+    info->lines_missed = ls->missed;
+    info->period_samples = ls->period * ls->decim;
+    info->clock_ppm = ls->nominal > 0.0 ? (ls->period / ls->nominal - 1.0) * 1e6 : 0.0;
+    info->last_error = ls->last_err * ls->decim;
+    info->last_peak = ls->last_c;
+    return 0;
+}
+
+/* === LINE QUALITY === */
+
+static void quality_biquad(qual_biquad_t *bq, double fc, double bw_hz, double fs) {
+    double w0 = 2.0 * M_PI * fc / fs;
+    double alpha = sin(w0) / (2.0 * (fc / bw_hz));
+    double a0 = 1.0 + alpha;
+    bq->b0 = alpha / a0;
+    bq->b2 = -alpha / a0;
+    bq->a1 = -2.0 * cos(w0) / a0;
+    bq->a2 = (1.0 - alpha) / a0;
+    bq->x1 = bq->x2 = bq->y1 = bq->y2 = 0.0;
+}
+
+static double quality_biquad_do(qual_biquad_t *bq, double x) {
+    double y = bq->b0 * x + bq->b2 * bq->x2 - bq->a1 * bq->y1 - bq->a2 * bq->y2;
+    bq->x2 = bq->x1;
+    bq->x1 = x;
+    bq->y2 = bq->y1;
+    bq->y1 = y;
+    return y;
+}
+
+static void quality_init(line_quality_t *q, double sample_rate) {
+    quality_biquad(&q->sig, QUAL_SIG_FC, QUAL_SIG_BW, sample_rate);
+    double nfc = QUAL_NOISE_FC;
+    if (nfc + QUAL_NOISE_BW > sample_rate * 0.5) nfc = QUAL_NOISE_FC_LOW;
+    for (int i = 0; i < QUAL_NOISE_STAGES; i++) {
+        quality_biquad(&q->noise[i], nfc, QUAL_NOISE_BW, sample_rate);
+    }
+    q->alpha = 1.0 - exp(-1000.0 / (QUAL_SMOOTH_MS * sample_rate));
+    q->sm_sig = q->sm_noise = 0.0;
+    q->line_sig = q->line_noise = 0.0;
+    q->line_sync = 0.0;
+    q->conf_sum = 0.0;
+    q->conf_n = 0;
+    q->plane_enabled = 0;
+}
+
+/* New frame locked: size the per-line table and the plane */
+static void quality_start(sstv_decoder_t *dec) {
+    line_quality_t *q = &dec->qual;
+    q->line_sig = q->line_noise = 0.0;
+    q->line_sync = 0.0;
+    q->conf_sum = 0.0;
+    q->conf_n = 0;
+    q->lines.clear();
+    q->lines.reserve((size_t)dec->image_buf.height);
+    if (q->plane_enabled && dec->image_buf.pixels) {
+        q->plane.assign((size_t)dec->image_buf.width * dec->image_buf.height, 0);
+    } else {
+        q->plane.clear();
+    }
+}
+
+/* One input sample during image reception */
+static void quality_push(line_quality_t *q, double x) {
+    double s = quality_biquad_do(&q->sig, x);
+    double n = x;
+    for (int i = 0; i < QUAL_NOISE_STAGES; i++) {
+        n = quality_biquad_do(&q->noise[i], n);
+    }
+    s *= s;
+    n *= n;
+    q->line_sig += s;
+    q->line_noise += n;
+    q->sm_sig += q->alpha * (s - q->sm_sig);
+    q->sm_noise += q->alpha * (n - q->sm_noise);
+}
+
+static double quality_snr_db(double sig, double noise_slot) {
+    double noise = noise_slot * QUAL_NOISE_SCALE;
+    double s = sig - noise;
+    if (noise <= 1e-9) return 99.0;
+    if (s <= noise * 1e-3) return -30.0;
+    double db = 10.0 * log10(s / noise);
+    return db > 99.0 ? 99.0 : db;
+}
+
+/* A pixel was just stored at the current line/column */
+static void quality_pixel(sstv_decoder_t *dec) {
+    line_quality_t *q = &dec->qual;
+    double db = quality_snr_db(q->sm_sig, q->sm_noise);
+    int c = 0;
+    if (db >= QUAL_CONF_FULL_DB) c = 255;
+    else if (db > 0.0) c = (int)(255.0 * db / QUAL_CONF_FULL_DB + 0.5);
+    q->conf_sum += c;
+    q->conf_n++;
+    if (!q->plane.empty()) {
+        int line = dec->image_buf.current_line;
+        int col = dec->image_buf.current_col;
+        if (line >= 0 && line < dec->image_buf.height && col >= 0 && col < dec->image_buf.width) {
+            q->plane[(size_t)line * dec->image_buf.width + col] = (uint8_t)c;
+        }
+    }
+}
+
+/* The current line is complete: record its figures */
+static void quality_line_done(sstv_decoder_t *dec) {
+    line_quality_t *q = &dec->qual;
+    sstv_line_quality_t lq;
+    lq.snr_db = (float)quality_snr_db(q->line_sig, q->line_noise);
+    lq.sync_peak = (float)q->line_sync;
+    lq.confidence = (uint8_t)(q->conf_n ? (int)(q->conf_sum / q->conf_n + 0.5) : 0);
+    q->lines.push_back(lq);
+    q->line_sig = q->line_noise = 0.0;
+    q->line_sync = 0.0;
+    q->conf_sum = 0.0;
+    q->conf_n = 0;
+}
+
+int sstv_decoder_get_line_quality(const sstv_decoder_t *dec, sstv_line_quality_t *lines,
+                                  int max_lines) {
+    if (!dec || max_lines < 0) return -1;
+    int n = (int)dec->qual.lines.size();
+    if (lines) {
+        int m = n < max_lines ? n : max_lines;
+        if (m > 0) memcpy(lines, dec->qual.lines.data(), (size_t)m * sizeof(*lines));
+    }
+    return n;
+}
+
+int sstv_decoder_set_confidence_enabled(sstv_decoder_t *dec, int enable) {
+    if (!dec) return -1;
+    dec->qual.plane_enabled = enable ? 1 : 0;
+    return 0;
+}
+
+int sstv_decoder_get_confidence(sstv_decoder_t *dec, sstv_image_t *out_plane) {
+    if (!dec || !out_plane || dec->qual.plane.empty()) return -1;
+    out_plane->pixels = dec->qual.plane.data();
+    out_plane->width = (uint32_t)dec->image_buf.width;
+    out_plane->height = (uint32_t)dec->image_buf.height;
+    out_plane->stride = (uint32_t)dec->image_buf.width;
+    out_plane->format = SSTV_GRAY8;
+    return 0;
+}
+
+/* === REPLAY TRACE === */
+
+static void decoder_trace_call(sstv_decoder_t *dec, uint32_t op, int arg, double a, double b) {
+    if (!dec->trace.fp) return;
+    trace_call_t call;
+    memset(&call, 0, sizeof(call));
+    call.op = op;
+    call.arg = arg;
+    call.a = a;
+    call.b = b;
+    trace_write_call(&dec->trace, &call);
+}
+
+int sstv_decoder_enable_trace(sstv_decoder_t *dec, const char *path) {
+    if (!dec || !path) return -1;
+    /* A replay starts from a freshly created (or reset) decoder */
+    if (dec->samples_fed != 0) return -1;
+    if (dec->trace.fp) {
+        trace_writer_close(&dec->trace);
+    }
+
+    uint32_t interval = (uint32_t)(dec->sample_rate * DECODER_TRACE_CHECK_SEC);
+    if (interval == 0) interval = 1;
+
+    trace_config_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.sample_rate = dec->sample_rate;
+    cfg.vis_enabled = dec->vis_enabled;
+    cfg.mode_hint = (int32_t)dec->mode_hint;
+    cfg.agc_mode = (int32_t)dec->agc_mode;
+    cfg.vis_mark_hz = dec->vis_mark_hz;
+    cfg.vis_space_hz = dec->vis_space_hz;
+    cfg.check_interval = interval;
+
+    if (trace_writer_open(&dec->trace, path, &cfg) != 0) {
+        trace_writer_close(&dec->trace);
+        if (dec->debug_level >= 1) {
+            fprintf(stderr, "[DECODER] Cannot create trace %s\n", path);
+        }
+        return -1;
+    }
+    dec->trace_check_interval = interval;
+    dec->trace_next_check = interval;
+    dec->trace_feeds = 0;
+    dec->trace_t0 = std::chrono::steady_clock::now();
+    /* Settings without a config field are replayed as calls */
+    if (dec->demod != SSTV_DEMOD_TONE) {
+        decoder_trace_call(dec, TRACE_CALL_DEMOD, (int)dec->demod, 0.0, 0.0);
+    }
+    if (dec->sense.rate != SENSE_DEFAULT_RATE) {
+        decoder_trace_call(dec, TRACE_CALL_SENSE, 0, dec->sense.rate, 0.0);
+    }
+    if (dec->agc.lookahead_ms != AGC_DEFAULT_LOOKAHEAD_MS ||
+        dec->agc.attack_ms != AGC_DEFAULT_ATTACK_MS ||
+        dec->agc.release_ms != AGC_DEFAULT_RELEASE_MS) {
+        decoder_trace_call(dec, TRACE_CALL_AGC_TIMING, (int)lround(dec->agc.lookahead_ms * 1000.0),
+                           dec->agc.attack_ms, dec->agc.release_ms);
+    }
+    return 0;
+}
+
+int sstv_decoder_disable_trace(sstv_decoder_t *dec) {
+    if (!dec || !dec->trace.fp) return -1;
+    return trace_writer_close(&dec->trace);
+}
+
+/* FNV-1a over a byte range */
+static uint64_t fnv1a(uint64_t h, const void *p, size_t n) {
+    const uint8_t *b = (const uint8_t*)p;
+    for (size_t i = 0; i < n; i++) {
+        h ^= b[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+#define FNV_FIELD(h, v) ((h) = fnv1a((h), &(v), sizeof(v)))
+
+uint64_t sstv_decoder_get_checksum(const sstv_decoder_t *dec) {
+    if (!dec) return 0;
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    /* Acquisition state */
+    int32_t v = (int32_t)dec->sync_state;   FNV_FIELD(h, v);
+    v = (int32_t)dec->detected_mode;        FNV_FIELD(h, v);
+    FNV_FIELD(h, dec->sync_mode);
+    FNV_FIELD(h, dec->sync_time);
+    FNV_FIELD(h, dec->vis_data);
+    FNV_FIELD(h, dec->vis_cnt);
+    FNV_FIELD(h, dec->vis_extended);
+    FNV_FIELD(h, dec->sense.k);
+    FNV_FIELD(h, dec->sense.f12.mean);
+
+    /* Front end: a single differing bit here shows up long before pixels do */
+    FNV_FIELD(h, dec->prev_sample);
+    FNV_FIELD(h, dec->agc.gain);
+    FNV_FIELD(h, dec->agc.target);
+    FNV_FIELD(h, dec->agc.pos);
+    FNV_FIELD(h, dec->agc.blocks);
+
+    /* Image decoder */
+    v = (int32_t)dec->img_dec.state;        FNV_FIELD(h, v);
+    FNV_FIELD(h, dec->img_dec.sample_counter);
+    FNV_FIELD(h, dec->img_dec.pixel_clock);
+    FNV_FIELD(h, dec->img_dec.current_channel);
+    FNV_FIELD(h, dec->img_dec.freq_accum);
+    FNV_FIELD(h, dec->img_dec.freq_samples);
+    FNV_FIELD(h, dec->img_dec.samples_per_pixel);
+    v = (int32_t)dec->demod;                FNV_FIELD(h, v);
+    FNV_FIELD(h, dec->zc.freq);
+    FNV_FIELD(h, dec->lsync.period);
+    FNV_FIELD(h, dec->lsync.found);
+    FNV_FIELD(h, dec->qual.line_sig);
+    FNV_FIELD(h, dec->qual.line_noise);
+    uint32_t qlines = (uint32_t)dec->qual.lines.size();
+    FNV_FIELD(h, qlines);
+    FNV_FIELD(h, dec->image_buf.current_line);
+    FNV_FIELD(h, dec->image_buf.current_col);
+    if (dec->image_buf.pixels) {
+        /* Written pixels only: what lies past them depends on the allocator */
+        size_t n = (size_t)dec->image_buf.width * dec->image_buf.height * 3;
+        if (dec->image_buf.current_line < dec->image_buf.height) {
+            n = ((size_t)dec->image_buf.current_line * dec->image_buf.width +
+                 dec->image_buf.current_col) * 3;
+        }
+        h = fnv1a(h, dec->image_buf.pixels, n);
+    }
+    return h;
+}
+
+/* === STAGE PROFILING === */
+
+static void decoder_profile_account(sstv_decoder_t *dec,
+                                    std::chrono::steady_clock::time_point t_in,
+                                    std::chrono::steady_clock::time_point t_fe,
+                                    std::chrono::steady_clock::time_point t_tone,
+                                    int in_image) {
+    using std::chrono::duration_cast;
+    using std::chrono::nanoseconds;
+    auto t_out = std::chrono::steady_clock::now();
+    dec->prof.sampled++;
+    dec->prof.frontend_ns += (uint64_t)duration_cast<nanoseconds>(t_fe - t_in).count();
+    dec->prof.tone_ns += (uint64_t)duration_cast<nanoseconds>(t_tone - t_fe).count();
+    uint64_t tail = (uint64_t)duration_cast<nanoseconds>(t_out - t_tone).count();
+    if (in_image) {
+        dec->prof.image_ns += tail;
+    } else {
+        dec->prof.sync_ns += tail;
+    }
+}
+
+void sstv_decoder_set_profiling(sstv_decoder_t *dec, int enable) {
+    if (!dec) return;
+    dec->prof_enabled = enable ? 1 : 0;
+    dec->prof_tick = 0;
+    memset(&dec->prof, 0, sizeof(dec->prof));
+}
+
+int sstv_decoder_get_profile(const sstv_decoder_t *dec, sstv_decoder_profile_t *profile) {
+    if (!dec || !profile) return -1;
+    *profile = dec->prof;
+    /* Scale the timed subset up to every sample processed */
+    if (profile->sampled) {
+        double k = (double)profile->samples / (double)profile->sampled;
+        profile->frontend_ns = (uint64_t)(profile->frontend_ns * k);
+        profile->tone_ns = (uint64_t)(profile->tone_ns * k);
+        profile->sync_ns = (uint64_t)(profile->sync_ns * k);
+        profile->image_ns = (uint64_t)(profile->image_ns * k);
+    }
+    return 0;
+}
+
+void sstv_decoder_set_line_callback(sstv_decoder_t *dec, sstv_line_callback_t cb, void *user) {
+    if (!dec) return;
+    dec->line_cb = cb;
+    dec->line_cb_user = user;
+}
+
 void sstv_decoder_set_debug_level(sstv_decoder_t *dec, int level) {
     if (!dec) return;
     dec->debug_level = level;
@@ -1504,6 +3328,7 @@ void sstv_decoder_set_agc_mode(sstv_decoder_t *dec, sstv_agc_mode_t mode) {
     dec->agc_gain = 1.0;
     dec->agc_peak_level = 0.0;
     dec->agc_sample_count = 0;
+    decoder_trace_call(dec, TRACE_CALL_AGC_MODE, (int)mode, 0.0, 0.0);
     
     if (dec->debug_level >= 2) {
         const char *mode_names[] = {"OFF", "LOW", "MED", "HIGH", "SEMI", "AUTO"};
@@ -8,6 +8,8 @@
  *  - CFIR2 + MakeFilter: Kaiser‑windowed FIR design + runtime convolution
  *  - MakeHilbert: FIR Hilbert transformer taps
  *  - DoFIR: lightweight FIR evaluate with circular buffer
+ *  - CFastFIR: CFIR2 sibling using partitioned FFT convolution for long filters
+ *  - CHalfBand/CHalfBandCascade: 2^k FIR decimation
  *
  * Tests: tests/test_dsp_reference.cpp
  * Consolidated documentation: docs/DSP_CONSOLIDATED_GUIDE.md
@@ -15,6 +17,7 @@
 
 #include "dsp_filters.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <vector>
@@ -408,4 +411,297 @@ void CFIR2::Do(double &d, double &j, double *hp) {
     if (w_ > tap_) w_ = 0;
 }
 
+// ===== Partitioned overlap-save FIR =====
+
+// In-place iterative radix-2 FFT. tw holds exp(-2*pi*i*k/n) for k < n/2.
+static void FftInPlace(std::complex<double> *x, int n,
+                       const std::vector<std::complex<double>> &tw,
+                       const std::vector<int> &rev, bool inverse) {
+    for (int i = 0; i < n; i++) {
+        if (i < rev[i]) std::swap(x[i], x[rev[i]]);
+    }
+    for (int len = 2; len <= n; len <<= 1) {
+        const int half = len >> 1;
+        const int step = n / len;
+        for (int i = 0; i < n; i += len) {
+            for (int j = 0; j < half; j++) {
+                std::complex<double> w = tw[j * step];
+                if (inverse) w = std::conj(w);
+                const std::complex<double> t = x[i + j + half] * w;
+                x[i + j + half] = x[i + j] - t;
+                x[i + j] += t;
+            }
+        }
+    }
+}
+
+CFastFIR::CFastFIR()
+    : tap_(0), block_(0), nfft_(0), parts_(0), fdl_pos_(0), fill_(0) {}
+
+void CFastFIR::Create(int tap, int type, double fs, double fcl, double fch, double att, double gain) {
+    if (tap < 1) tap = 1;
+    if (tap > kFftTapMax) tap = kFftTapMax;
+    h_.assign(tap + 1, 0.0);
+    MakeFilter(h_.data(), tap, type, fs, fcl, fch, att, gain);
+    tap_ = tap;
+    Setup();
+}
+
+void CFastFIR::Create(int tap, const double *hp) {
+    if (tap < 1) tap = 1;
+    if (tap > kFftTapMax) tap = kFftTapMax;
+    h_.assign(hp, hp + tap + 1);
+    tap_ = tap;
+    Setup();
+}
+
+// Pick the block size and precompute the partition spectra.
+void CFastFIR::Setup(void) {
+    if (tap_ < kFftTapThreshold) {
+        parts_ = 0;
+        direct_.Create(tap_);
+        direct_.Clear();
+        return;
+    }
+
+    // B ~ taps/4 balances FFT cost against the partition sum while
+    // keeping the latency a small fraction of the filter length.
+    block_ = 32;
+    while (block_ * 4 < tap_ + 1 && block_ < 1024) block_ <<= 1;
+    nfft_ = block_ * 2;
+    parts_ = (tap_ + 1 + block_ - 1) / block_;
+
+    twiddle_.resize(nfft_ / 2);
+    for (int k = 0; k < nfft_ / 2; k++) {
+        twiddle_[k] = std::polar(1.0, -2.0 * kPi * k / nfft_);
+    }
+    bitrev_.assign(nfft_, 0);
+    int bits = 0;
+    while ((1 << bits) < nfft_) bits++;
+    for (int i = 0; i < nfft_; i++) {
+        int r = 0;
+        for (int b = 0; b < bits; b++) {
+            if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+        }
+        bitrev_[i] = r;
+    }
+
+    hspec_.assign((size_t)parts_ * nfft_, std::complex<double>(0.0, 0.0));
+    for (int p = 0; p < parts_; p++) {
+        std::complex<double> *H = &hspec_[(size_t)p * nfft_];
+        for (int i = 0; i < block_ && p * block_ + i <= tap_; i++) {
+            H[i] = h_[p * block_ + i];
+        }
+        FftInPlace(H, nfft_, twiddle_, bitrev_, false);
+    }
+    acc_.resize(nfft_);
+    fdl_.resize((size_t)parts_ * nfft_);
+    in_.resize(nfft_);
+    out_.resize(block_);
+    Clear();
+}
+
+void CFastFIR::Clear(void) {
+    if (!parts_) {
+        direct_.Clear();
+        return;
+    }
+    std::fill(fdl_.begin(), fdl_.end(), std::complex<double>(0.0, 0.0));
+    std::fill(in_.begin(), in_.end(), 0.0);
+    std::fill(out_.begin(), out_.end(), 0.0);
+    fdl_pos_ = 0;
+    fill_ = 0;
+}
+
+// Transform the 2B input window, multiply-accumulate against every
+// partition's delayed spectrum, and keep the B valid output samples.
+void CFastFIR::ProcessBlock(void) {
+    std::complex<double> *X = &fdl_[(size_t)fdl_pos_ * nfft_];
+    for (int i = 0; i < nfft_; i++) X[i] = in_[i];
+    FftInPlace(X, nfft_, twiddle_, bitrev_, false);
+
+    std::fill(acc_.begin(), acc_.end(), std::complex<double>(0.0, 0.0));
+    for (int p = 0; p < parts_; p++) {
+        int slot = fdl_pos_ - p;
+        if (slot < 0) slot += parts_;
+        const std::complex<double> *Xp = &fdl_[(size_t)slot * nfft_];
+        const std::complex<double> *H = &hspec_[(size_t)p * nfft_];
+        for (int k = 0; k < nfft_; k++) acc_[k] += Xp[k] * H[k];
+    }
+    FftInPlace(acc_.data(), nfft_, twiddle_, bitrev_, true);
+
+    const double scale = 1.0 / nfft_;
+    for (int i = 0; i < block_; i++) out_[i] = acc_[block_ + i].real() * scale;
+
+    std::memcpy(in_.data(), in_.data() + block_, sizeof(double) * block_);
+    fdl_pos_++;
+    if (fdl_pos_ >= parts_) fdl_pos_ = 0;
+}
+
+double CFastFIR::Do(double d) {
+    if (!parts_) return direct_.Do(d, h_.data());
+    in_[block_ + fill_] = d;
+    double y = out_[fill_];
+    if (++fill_ == block_) {
+        ProcessBlock();
+        fill_ = 0;
+    }
+    return y;
+}
+
+void CFastFIR::Do(const double *in, int n, double *out) {
+    if (!parts_) {
+        for (int i = 0; i < n; i++) out[i] = direct_.Do(in[i], h_.data());
+        return;
+    }
+    int i = 0;
+    while (i < n) {
+        int chunk = std::min(block_ - fill_, n - i);
+        std::memcpy(&in_[block_ + fill_], in + i, sizeof(double) * chunk);
+        std::memcpy(out + i, &out_[fill_], sizeof(double) * chunk);
+        fill_ += chunk;
+        i += chunk;
+        if (fill_ == block_) {
+            ProcessBlock();
+            fill_ = 0;
+        }
+    }
+}
+
+// ===== Half-band decimator =====
+
+CHalfBand::CHalfBand() : center_(0.0), tap_(0), phase_(0) {}
+
+// Design taps with MakeFilter and keep only the non-zero half.
+void CHalfBand::Create(int tap, double att) {
+    if (tap < 6) tap = 6;
+    tap = ((tap + 1) / 4) * 4 + 2;   // 4m+2: centre index M = 2m+1 is odd
+    if (tap > kTapMax + 2) tap = kTapMax + 2;
+    tap_ = tap;
+
+    std::vector<double> h(tap + 1);
+    MakeFilter(h.data(), tap, kFfLPF, 1.0, 0.25, 0.25, att, 1.0);
+
+    // MakeFilter normalises DC gain to 1; renormalise over the taps we keep
+    // so dropping the (near-zero) even taps does not shift the gain.
+    const int m = tap / 2;
+    c_.assign((m + 1) / 2, 0.0);
+    double sum = h[m];
+    for (int i = 0; i < (int)c_.size(); i++) {
+        c_[i] = h[m - (2 * i + 1)];
+        sum += 2.0 * c_[i];
+    }
+    center_ = h[m] / sum;
+    for (double &c : c_) c /= sum;
+
+    hist_.assign(tap, 0.0);
+    phase_ = 0;
+}
+
+void CHalfBand::Clear(void) {
+    std::fill(hist_.begin(), hist_.end(), 0.0);
+    phase_ = 0;
+}
+
+int CHalfBand::Do(const double *in, int n, double *out) {
+    if (n <= 0 || !tap_) return 0;
+
+    // Keep the working set in cache for long inputs.
+    const int kBlock = 4096;
+    if (n > kBlock) {
+        int got = 0;
+        for (int off = 0; off < n; off += kBlock) {
+            got += Do(in + off, std::min(kBlock, n - off), out + got);
+        }
+        return got;
+    }
+
+    // Working buffer: history followed by the new block.
+    buf_.resize(tap_ + n);
+    std::memcpy(buf_.data(), hist_.data(), sizeof(double) * tap_);
+    std::memcpy(buf_.data() + tap_, in, sizeof(double) * n);
+
+    // An output is produced after every second input sample.
+    const int p0 = tap_ + (phase_ ? 0 : 1);
+    const int total = tap_ + n;
+    const int k_out = (p0 < total) ? (total - 1 - p0) / 2 + 1 : 0;
+
+    if (k_out > 0) {
+        // For output k (newest sample at p0 + 2k), the odd taps read
+        // x[p0 + 2k - tap + 2j] and the centre reads the other phase.
+        const int half = tap_ / 2;        // M
+        const int m = (half - 1) / 2;
+        const int na = k_out + half;
+        even_.resize(na);
+        odd_.resize(k_out);
+        const double *x = buf_.data() + (p0 - tap_);
+        for (int j = 0; j < na; j++) even_[j] = x[2 * j];
+        for (int k = 0; k < k_out; k++) odd_[k] = x[2 * (k + m) + 1];
+
+        for (int k = 0; k < k_out; k++) out[k] = center_ * odd_[k];
+        const double *a = even_.data();
+        for (int i = 0; i <= m; i++) {
+            const double c = c_[i];
+            const double *lo = a + (m - i);
+            const double *hi = a + (m + 1 + i);
+            for (int k = 0; k < k_out; k++) {
+                out[k] += c * (lo[k] + hi[k]);
+            }
+        }
+    }
+
+    std::memcpy(hist_.data(), buf_.data() + n, sizeof(double) * tap_);
+    phase_ = (phase_ + n) & 1;
+    return k_out;
+}
+
+// ===== 2^k cascade =====
+
+CHalfBandCascade::CHalfBandCascade() : factor_(1) {}
+
+int CHalfBandCascade::Create(int factor, int tap, double att) {
+    int stages = 0;
+    while ((1 << stages) < factor) stages++;
+    if (factor < 2 || factor > 256 || (1 << stages) != factor) return -1;
+
+    stages_.assign(stages, CHalfBand());
+    int t = tap;
+    for (int s = stages - 1; s >= 0; s--) {
+        stages_[s].Create(t, att);
+        t /= 2;
+    }
+    factor_ = factor;
+    return 0;
+}
+
+void CHalfBandCascade::Clear(void) {
+    for (CHalfBand &hb : stages_) hb.Clear();
+}
+
+int CHalfBandCascade::Do(const double *in, int n, double *out) {
+    if (stages_.empty() || n <= 0) return 0;
+    if (stages_.size() == 1) return stages_[0].Do(in, n, out);
+
+    // Ping-pong through the two halves of scratch_; the last stage writes out.
+    const int half = n / 2 + 1;
+    scratch_.resize(2 * half);
+    double *bufs[2] = { scratch_.data(), scratch_.data() + half };
+    const double *src = in;
+    int len = n;
+    for (size_t s = 0; s < stages_.size(); s++) {
+        double *dst = (s + 1 == stages_.size()) ? out : bufs[s & 1];
+        len = stages_[s].Do(src, len, dst);
+        src = dst;
+    }
+    return len;
+}
+
+int CHalfBandCascade::GetDelay(void) const {
+    int delay = 0;
+    for (size_t s = 0; s < stages_.size(); s++) {
+        delay += stages_[s].GetDelay() << s;
+    }
+    return delay;
+}
+
 } // namespace sstv_dsp
@@ -5,6 +5,7 @@
 #ifndef SSTV_DSP_FILTERS_H
 #define SSTV_DSP_FILTERS_H
 
+#include <complex>
 #include <vector>
 
 namespace sstv_dsp {
@@ -94,6 +95,102 @@ private:
     int tap_half_;
 };
 
+// FIR with the same interface as CFIR2 that switches to uniformly
+// partitioned overlap-save FFT convolution for long filters.
+// Below kFftTapThreshold it runs CFIR2 directly (no added latency).
+// Above it, output is delayed by GetLatency() samples (one FFT block):
+// Do() returns the filtered sample from GetLatency() calls earlier.
+constexpr int kFftTapThreshold = 128;
+constexpr int kFftTapMax = 16384;
+
+class CFastFIR {
+public:
+    CFastFIR();
+    void Create(int tap, int type, double fs, double fcl, double fch, double att, double gain);
+    // Use caller-designed taps (tap + 1 coefficients, CFIR2 order).
+    void Create(int tap, const double *hp);
+    void Clear(void);
+    double Do(double d);
+    void Do(const double *in, int n, double *out);
+
+    inline int GetTap(void) const { return tap_; }
+    inline bool IsFFT(void) const { return parts_ > 0; }
+    // Added delay in samples (0 in direct mode).
+    inline int GetLatency(void) const { return parts_ > 0 ? block_ : 0; }
+
+private:
+    void Setup(void);
+    void ProcessBlock(void);
+
+    CFIR2 direct_;
+    std::vector<double> h_;
+    int tap_;
+    int block_;                 // Partition/block length B
+    int nfft_;                  // 2B
+    int parts_;                 // Partitions (0 = direct mode)
+    int fdl_pos_;               // Newest spectrum in fdl_
+    int fill_;                  // Samples of the current block received
+    std::vector<std::complex<double>> hspec_;   // parts_ x nfft_ filter spectra
+    std::vector<std::complex<double>> fdl_;     // parts_ x nfft_ input spectra
+    std::vector<std::complex<double>> acc_;
+    std::vector<std::complex<double>> twiddle_;
+    std::vector<int> bitrev_;
+    std::vector<double> in_;    // Previous block followed by current block
+    std::vector<double> out_;   // Output of the last processed block
+};
+
+// Half-band FIR decimator (rate / 2).
+// Taps come from MakeFilter (Kaiser LPF at fs/4). Every even-offset tap
+// except the centre is zero, and the rest are symmetric, so each output
+// costs (tap + 2) / 4 multiplies. Input is processed in blocks and split
+// into even/odd phases so the inner loop runs unit-stride.
+class CHalfBand {
+public:
+    CHalfBand();
+    // tap: filter order as in MakeFilter, rounded up to 4m+2 (min 6).
+    void Create(int tap, double att);
+    void Clear(void);
+    // Decimate n samples; writes up to (n + 1) / 2 outputs, returns the count.
+    int Do(const double *in, int n, double *out);
+
+    inline int GetTap(void) const { return tap_; }
+    // Group delay in input samples.
+    inline int GetDelay(void) const { return tap_ / 2; }
+
+private:
+    std::vector<double> c_;     // Folded odd taps h[M-1], h[M-3], ..., h[0]
+    double center_;             // h[M]
+    std::vector<double> hist_;  // Last tap_ input samples
+    std::vector<double> buf_;   // hist_ + current block
+    std::vector<double> even_;  // Phase carrying the odd taps
+    std::vector<double> odd_;   // Phase carrying the centre tap
+    int tap_;
+    int phase_;                 // Input samples seen, mod 2
+};
+
+// Cascade of CHalfBand stages for 2^k decimation (48 kHz / 4 -> 12 kHz).
+// The last stage gets the requested order; each earlier stage has a
+// proportionally wider transition band and gets half the order of the
+// stage after it.
+class CHalfBandCascade {
+public:
+    CHalfBandCascade();
+    // factor: power of two (2..256). Returns 0, or -1 if factor is invalid.
+    int Create(int factor, int tap, double att);
+    void Clear(void);
+    // Decimate n samples; writes at most n / factor + 1 outputs.
+    int Do(const double *in, int n, double *out);
+
+    inline int GetFactor(void) const { return factor_; }
+    // Total group delay in input samples.
+    int GetDelay(void) const;
+
+private:
+    std::vector<CHalfBand> stages_;
+    std::vector<double> scratch_;
+    int factor_;
+};
+
 } // namespace sstv_dsp
 
 #endif
@@ -13,6 +13,7 @@
 
 #include "vco.h"
 #include "vis.h"
+#include "color.h"
 
 /* Internal mode timing (derived from MMSSTV CSSTVSET::SetSampFreq/GetTiming) */
 struct ModeTiming {
@@ -45,12 +46,6 @@ struct Segment {
     size_t samples;
 };
 
-static int clamp_0_255(int v) {
-    if (v < 0) return 0;
-    if (v > 255) return 255;
-    return v;
-}
-
 static int color_to_freq(int d) {
     d = d * (2300 - 1500) / 256;
     return d + 1500;
@@ -78,144 +73,52 @@ static void get_pixel_rgb(const sstv_image_t *image, int x, int y, int &r, int &
     }
 }
 
-static void get_ry(int r, int g, int b, int &y, int &ry, int &by) {
-    double R = r;
-    double G = g;
-    double B = b;
-    y = (int)(16.0 + (0.256773 * R + 0.504097 * G + 0.097900 * B));
-    ry = (int)(128.0 + (0.439187 * R - 0.367766 * G - 0.071421 * B));
-    by = (int)(128.0 + (-0.148213 * R - 0.290974 * G + 0.439187 * B));
-    y = clamp_0_255(y);
-    ry = clamp_0_255(ry);
-    by = clamp_0_255(by);
-}
+/* Y, R-Y and B-Y of one image line */
+struct RowYC {
+    std::vector<uint8_t> y;
+    std::vector<uint8_t> ry;
+    std::vector<uint8_t> by;
+};
 
-static bool is_narrow_mode(sstv_mode_t mode) {
-    switch (mode) {
-        case SSTV_MN73:
-        case SSTV_MN110:
-        case SSTV_MN140:
-        case SSTV_MC110:
-        case SSTV_MC140:
-        case SSTV_MC180:
-            return true;
-        default:
-            return false;
+static void get_row_yc(const sstv_image_t *image, size_t line, RowYC &row) {
+    size_t width = image->width;
+    row.y.resize(width);
+    row.ry.resize(width);
+    row.by.resize(width);
+    if (!image->pixels) {
+        int y, ry, by;
+        sstv_color_rgb_to_yc_px(0, 0, 0, &y, &ry, &by);
+        std::fill(row.y.begin(), row.y.end(), (uint8_t)y);
+        std::fill(row.ry.begin(), row.ry.end(), (uint8_t)ry);
+        std::fill(row.by.begin(), row.by.end(), (uint8_t)by);
+        return;
     }
-}
-
-static bool is_pd_mode(sstv_mode_t mode) {
-    switch (mode) {
-        case SSTV_PD50:
-        case SSTV_PD90:
-        case SSTV_PD120:
-        case SSTV_PD160:
-        case SSTV_PD180:
-        case SSTV_PD240:
-        case SSTV_PD290:
-            return true;
-        default:
-            return false;
+    const uint8_t *src = image->pixels + line * image->stride;
+    if (image->format == SSTV_RGB24) {
+        sstv_color_rgb24_to_yc(src, width, row.y.data(), row.ry.data(), row.by.data());
+    } else {
+        sstv_color_gray_to_yc(src, width, row.y.data(), row.ry.data(), row.by.data());
     }
 }
 
-static bool is_mmsstv_vis_mode(sstv_mode_t mode) {
-    switch (mode) {
-        case SSTV_MP73:
-        case SSTV_MP115:
-        case SSTV_MP140:
-        case SSTV_MP175:
-        case SSTV_MR73:
-        case SSTV_MR90:
-        case SSTV_MR115:
-        case SSTV_MR140:
-        case SSTV_MR175:
-        case SSTV_ML180:
-        case SSTV_ML240:
-        case SSTV_ML280:
-        case SSTV_ML320:
-            return true;
-        default:
-            return false;
-    }
+/* Narrow modes sync at 1900 Hz and carry no VIS this encoder can send */
+static bool is_narrow_mode(const sstv_mode_desc_t *desc) {
+    return desc->sync_hz != 1200.0;
 }
 
-static uint16_t get_mmsstv_vis_word(sstv_mode_t mode) {
-    switch (mode) {
-        case SSTV_MP73:  return 0x2523;
-        case SSTV_MP115: return 0x2923;
-        case SSTV_MP140: return 0x2a23;
-        case SSTV_MP175: return 0x2c23;
-        case SSTV_MR73:  return 0x4523;
-        case SSTV_MR90:  return 0x4623;
-        case SSTV_MR115: return 0x4923;
-        case SSTV_MR140: return 0x4a23;
-        case SSTV_MR175: return 0x4c23;
-        case SSTV_ML180: return 0x8523;
-        case SSTV_ML240: return 0x8623;
-        case SSTV_ML280: return 0x8923;
-        case SSTV_ML320: return 0x8a23;
-        default:         return 0x0000;
-    }
+/* MMSSTV 16-bit VIS word: the 0x23 prefix, then the mode byte */
+static uint16_t get_mmsstv_vis_word(const sstv_mode_desc_t *desc) {
+    if (desc->vis_bits != 16 || is_narrow_mode(desc)) return 0x0000;
+    return (uint16_t)((desc->vis_code << 8) | 0x23);
 }
 
-static double get_preamble_ms(sstv_mode_t mode) {
-    if (is_narrow_mode(mode)) {
+static double get_preamble_ms(const sstv_mode_desc_t *desc) {
+    if (is_narrow_mode(desc)) {
         return 400.0; /* 4 tones × 100ms */
     }
     return 800.0;     /* 8 tones × 100ms */
 }
 
-static double get_line_ms(sstv_mode_t mode) {
-    switch (mode) {
-        case SSTV_R36:      return 150.0;
-        case SSTV_R72:      return 300.0;
-        case SSTV_AVT90:    return 375.0;
-        case SSTV_SCOTTIE2: return 277.692;
-        case SSTV_SCOTTIEX: return 1050.3;
-        case SSTV_MARTIN1:  return 446.446;
-        case SSTV_MARTIN2:  return 226.798;
-        case SSTV_SC2_180:  return 711.0437;
-        case SSTV_SC2_120:  return 475.52248;
-        case SSTV_SC2_60:   return 240.3846;
-        case SSTV_PD50:     return 388.160;
-        case SSTV_PD90:     return 703.040;
-        case SSTV_PD120:    return 508.480;
-        case SSTV_PD160:    return 804.416;
-        case SSTV_PD180:    return 754.24;
-        case SSTV_PD240:    return 1000.00;
-        case SSTV_PD290:    return 937.28;
-        case SSTV_P3:       return 409.375;
-        case SSTV_P5:       return 614.0625;
-        case SSTV_P7:       return 818.75;
-        case SSTV_MR73:     return 286.3;
-        case SSTV_MR90:     return 352.3;
-        case SSTV_MR115:    return 450.3;
-        case SSTV_MR140:    return 548.3;
-        case SSTV_MR175:    return 684.3;
-        case SSTV_MP73:     return 570.0;
-        case SSTV_MP115:    return 902.0;
-        case SSTV_MP140:    return 1090.0;
-        case SSTV_MP175:    return 1370.0;
-        case SSTV_ML180:    return 363.3;
-        case SSTV_ML240:    return 483.3;
-        case SSTV_ML280:    return 565.3;
-        case SSTV_ML320:    return 645.3;
-        case SSTV_R24:      return 200.0;
-        case SSTV_BW8:      return 66.89709;
-        case SSTV_BW12:     return 100.0;
-        case SSTV_MN73:     return 570.0;
-        case SSTV_MN110:    return 858.0;
-        case SSTV_MN140:    return 1090.0;
-        case SSTV_MC110:    return 428.5;
-        case SSTV_MC140:    return 548.5;
-        case SSTV_MC180:    return 704.5;
-        case SSTV_SCOTTIE1:
-        default:
-            return 428.22;
-    }
-}
-
 static void compute_mode_timing(sstv_mode_t mode, double sample_rate, ModeTiming *timing) {
     if (!timing) return;
     std::memset(timing, 0, sizeof(*timing));
@@ -658,7 +561,7 @@ static void compute_mode_timing(sstv_mode_t mode, double sample_rate, ModeTiming
             break;
     }
 
-    timing->line_ms = get_line_ms(mode);
+    timing->line_ms = sstv_get_mode_desc(mode)->line_ms;
     timing->line_samples = timing->line_ms * sample_rate / 1000.0;
 
     switch (mode) {
@@ -722,6 +625,8 @@ static void compute_mode_timing(sstv_mode_t mode, double sample_rate, ModeTiming
 /* Internal encoder structure */
 struct sstv_encoder_s {
     sstv_mode_t mode;
+    const sstv_mode_desc_t *desc;   /* Registry entry, valid for the process */
+    double line_scale;              /* Mode line period / base line format period */
     double sample_rate;
     const sstv_image_t *image;
     int vis_enabled;
@@ -756,29 +661,26 @@ static void recompute_total_samples(sstv_encoder_t *enc) {
         double total_ms = enc->timing.line_ms * enc->timing.line_count;
         enc->total_samples = (size_t)((total_ms / 1000.0) * enc->sample_rate);
     } else {
-        const sstv_mode_info_t *info = sstv_get_mode_info(enc->mode);
-        if (info) {
-            enc->total_samples = (size_t)(info->duration_sec * enc->sample_rate);
-        }
+        enc->total_samples = (size_t)(enc->desc->line_ms * enc->desc->lines / 1000.0 * enc->sample_rate);
     }
     if (enc->vis_enabled) {
-        const sstv_mode_info_t *info = sstv_get_mode_info(enc->mode);
-        if (info && info->vis_code != 0x00) {
+        if (enc->desc->vis_bits != 0 && !is_narrow_mode(enc->desc)) {
             // Standard 8-bit VIS: 300ms leader + 10ms break + 300ms leader +
             // 30ms start bit + 8×30ms data bits + 30ms stop bit = 910ms
             // 16-bit VIS (MR/MP/ML): adds 8 more data bits + 2 parity bits = 1210ms
-            uint16_t vis_word = get_mmsstv_vis_word(enc->mode);
+            uint16_t vis_word = get_mmsstv_vis_word(enc->desc);
             double vis_duration = (vis_word != 0x0000) ? 1.210 : 0.910;
             enc->total_samples += (size_t)(vis_duration * enc->sample_rate);
         }
     }
     if (enc->preamble_enabled) {
-        enc->total_samples += (size_t)(get_preamble_ms(enc->mode) * enc->sample_rate / 1000.0);
+        enc->total_samples += (size_t)(get_preamble_ms(enc->desc) * enc->sample_rate / 1000.0);
     }
 }
 
 static void push_segment_ms(sstv_encoder_t *enc, double freq, double ms) {
     if (!enc || ms <= 0.0) return;
+    if (enc->stage == 2) ms *= enc->line_scale;   /* Custom line period */
     double exact = ms * enc->sample_rate / 1000.0;
     double total = exact + enc->segment_fraction;
     size_t samples = (size_t)(total);
@@ -792,7 +694,7 @@ static void push_segment_ms(sstv_encoder_t *enc, double freq, double ms) {
 
 static void write_preamble(sstv_encoder_t *enc) {
     if (!enc) return;
-    if (is_narrow_mode(enc->mode)) {
+    if (is_narrow_mode(enc->desc)) {
         push_segment_ms(enc, 1900, 100.0);
         push_segment_ms(enc, 2300, 100.0);
         push_segment_ms(enc, 1900, 100.0);
@@ -809,97 +711,62 @@ static void write_preamble(sstv_encoder_t *enc) {
     push_segment_ms(enc, 1500, 100.0);
 }
 
-static void write_mmsstv_vis(sstv_encoder_t *enc, uint16_t vis_word) {
-    if (!enc) return;
-    // 16-bit VIS: MMSSTV uses standard VIS leader/break/leader/start,
-    // then 16 data bits LSB-first at 30ms each, then stop bit 1200Hz 30ms.
-    push_segment_ms(enc, 1900, 300.0);
-    push_segment_ms(enc, 1200, 10.0);
-    push_segment_ms(enc, 1900, 300.0);
-    push_segment_ms(enc, 1200, 30.0);
-    for (int i = 0; i < 16; i++) {
-        /* MMSSTV: bit 1 = 1080 Hz, bit 0 = 1320 Hz */
-        double freq = (vis_word & 0x0001) ? 1080.0 : 1320.0;
-        push_segment_ms(enc, freq, 30.0);
-        vis_word >>= 1;
-    }
-    push_segment_ms(enc, 1200, 30.0);
-}
-
 static void write_line_r24(sstv_encoder_t *enc) {
     int width = (int)enc->image->width;
-    std::vector<int> ry(width);
-    std::vector<int> by(width);
+    RowYC row;
+    get_row_yc(enc->image, enc->image_line, row);
     push_segment_ms(enc, 1200, 6.0);
     push_segment_ms(enc, 1500, 2.0);
     for (int x = 0; x < width; x++) {
-        int r, g, b, y, ryy, byy;
-        get_pixel_rgb(enc->image, x, (int)enc->image_line, r, g, b);
-        get_ry(r, g, b, y, ryy, byy);
-        ry[x] = ryy;
-        by[x] = byy;
-        push_segment_ms(enc, (double)color_to_freq(y), 92.0 / 320.0);
+        push_segment_ms(enc, (double)color_to_freq(row.y[x]), 92.0 / 320.0);
     }
     push_segment_ms(enc, 1500, 3.0);
     push_segment_ms(enc, 1900, 1.0);
     for (int x = 0; x < width; x++) {
-        push_segment_ms(enc, (double)color_to_freq(ry[x]), 46.0 / 320.0);
+        push_segment_ms(enc, (double)color_to_freq(row.ry[x]), 46.0 / 320.0);
     }
     push_segment_ms(enc, 2300, 3.0);
     push_segment_ms(enc, 1900, 1.0);
     for (int x = 0; x < width; x++) {
-        push_segment_ms(enc, (double)color_to_freq(by[x]), 46.0 / 320.0);
+        push_segment_ms(enc, (double)color_to_freq(row.by[x]), 46.0 / 320.0);
     }
 }
 
 static void write_line_r36(sstv_encoder_t *enc) {
     int width = (int)enc->image->width;
-    std::vector<int> ry(width);
-    std::vector<int> by(width);
+    RowYC row;
+    get_row_yc(enc->image, enc->image_line, row);
     push_segment_ms(enc, 1200, 9.0);
     push_segment_ms(enc, 1500, 3.0);
     for (int x = 0; x < width; x++) {
-        int r, g, b, y, ryy, byy;
-        get_pixel_rgb(enc->image, x, (int)enc->image_line, r, g, b);
-        get_ry(r, g, b, y, ryy, byy);
-        ry[x] = ryy;
-        by[x] = byy;
-        push_segment_ms(enc, (double)color_to_freq(y), 88.0 / 320.0);
+        push_segment_ms(enc, (double)color_to_freq(row.y[x]), 88.0 / 320.0);
     }
     push_segment_ms(enc, (enc->image_line & 1) ? 2300.0 : 1500.0, 4.5);
     push_segment_ms(enc, 1900, 1.5);
     for (int x = 0; x < width; x++) {
-        int y = (enc->image_line & 1) ? by[x] : ry[x];
+        int y = (enc->image_line & 1) ? row.by[x] : row.ry[x];
         push_segment_ms(enc, (double)color_to_freq(y), 44.0 / 320.0);
     }
 }
 
 static void write_line_r72(sstv_encoder_t *enc) {
     int width = (int)enc->image->width;
-    std::vector<int> ry(width);
-    std::vector<int> by(width);
-        push_segment_ms(enc, 1200, 9.0);
-        if (is_mmsstv_vis_mode(enc->mode)) {
-            write_mmsstv_vis(enc, get_mmsstv_vis_word(enc->mode));
-        }
+    RowYC row;
+    get_row_yc(enc->image, enc->image_line, row);
+    push_segment_ms(enc, 1200, 9.0);
     push_segment_ms(enc, 1500, 3.0);
     for (int x = 0; x < width; x++) {
-        int r, g, b, y, ryy, byy;
-        get_pixel_rgb(enc->image, x, (int)enc->image_line, r, g, b);
-        get_ry(r, g, b, y, ryy, byy);
-        ry[x] = ryy;
-        by[x] = byy;
-        push_segment_ms(enc, (double)color_to_freq(y), 138.0 / 320.0);
+        push_segment_ms(enc, (double)color_to_freq(row.y[x]), 138.0 / 320.0);
     }
     push_segment_ms(enc, 1500, 4.5);
     push_segment_ms(enc, 1900, 1.5);
     for (int x = 0; x < width; x++) {
-        push_segment_ms(enc, (double)color_to_freq(ry[x]), 69.0 / 320.0);
+        push_segment_ms(enc, (double)color_to_freq(row.ry[x]), 69.0 / 320.0);
     }
     push_segment_ms(enc, 2300, 4.5);
     push_segment_ms(enc, 1900, 1.5);
     for (int x = 0; x < width; x++) {
-        push_segment_ms(enc, (double)color_to_freq(by[x]), 69.0 / 320.0);
+        push_segment_ms(enc, (double)color_to_freq(row.by[x]), 69.0 / 320.0);
     }
 }
 
@@ -1016,32 +883,26 @@ static void write_line_sc2(sstv_encoder_t *enc, double s, double tw) {
 
 static void write_line_pd(sstv_encoder_t *enc, double tw) {
     int width = (int)enc->image->width;
-    std::vector<int> ry(width);
-    std::vector<int> by(width);
+    RowYC row;
+    get_row_yc(enc->image, enc->image_line, row);
     push_segment_ms(enc, 1200, 20.000);
     push_segment_ms(enc, 1500, 2.080);
     double t = tw / (double)width;
     for (int x = 0; x < width; x++) {
-        int r, g, b, y, ryy, byy;
-        get_pixel_rgb(enc->image, x, (int)enc->image_line, r, g, b);
-        get_ry(r, g, b, y, ryy, byy);
-        ry[x] = ryy;
-        by[x] = byy;
-        push_segment_ms(enc, (double)color_to_freq(y), t);
+        push_segment_ms(enc, (double)color_to_freq(row.y[x]), t);
     }
     for (int x = 0; x < width; x++) {
-        push_segment_ms(enc, (double)color_to_freq(ry[x]), t);
+        push_segment_ms(enc, (double)color_to_freq(row.ry[x]), t);
     }
     for (int x = 0; x < width; x++) {
-        push_segment_ms(enc, (double)color_to_freq(by[x]), t);
+        push_segment_ms(enc, (double)color_to_freq(row.by[x]), t);
     }
     size_t next_line = enc->image_line + 1;
     if (next_line >= enc->image->height) next_line = enc->image->height - 1;
+    RowYC next;
+    get_row_yc(enc->image, next_line, next);
     for (int x = 0; x < width; x++) {
-        int r, g, b, y, ryy, byy;
-        get_pixel_rgb(enc->image, x, (int)next_line, r, g, b);
-        get_ry(r, g, b, y, ryy, byy);
-        push_segment_ms(enc, (double)color_to_freq(y), t);
+        push_segment_ms(enc, (double)color_to_freq(next.y[x]), t);
     }
 }
 
@@ -1072,61 +933,50 @@ static void write_line_p(sstv_encoder_t *enc, double s, double p, double c) {
 
 static void write_line_mp(sstv_encoder_t *enc, double tw) {
     int width = (int)enc->image->width;
-    std::vector<int> ry(width);
-    std::vector<int> by(width);
+    RowYC row;
+    get_row_yc(enc->image, enc->image_line, row);
     push_segment_ms(enc, 1200, 9.0);
     push_segment_ms(enc, 1500, 1.0);
     double t = tw / (double)width;
     for (int x = 0; x < width; x++) {
-        int r, g, b, y, ryy, byy;
-        get_pixel_rgb(enc->image, x, (int)enc->image_line, r, g, b);
-        get_ry(r, g, b, y, ryy, byy);
-        ry[x] = ryy;
-        by[x] = byy;
-        push_segment_ms(enc, (double)color_to_freq(y), t);
+        push_segment_ms(enc, (double)color_to_freq(row.y[x]), t);
     }
     for (int x = 0; x < width; x++) {
-        push_segment_ms(enc, (double)color_to_freq(ry[x]), t);
+        push_segment_ms(enc, (double)color_to_freq(row.ry[x]), t);
     }
     for (int x = 0; x < width; x++) {
-        push_segment_ms(enc, (double)color_to_freq(by[x]), t);
+        push_segment_ms(enc, (double)color_to_freq(row.by[x]), t);
     }
     size_t next_line = enc->image_line + 1;
     if (next_line >= enc->image->height) next_line = enc->image->height - 1;
+    RowYC next;
+    get_row_yc(enc->image, next_line, next);
     for (int x = 0; x < width; x++) {
-        int r, g, b, y, ryy, byy;
-        get_pixel_rgb(enc->image, x, (int)next_line, r, g, b);
-        get_ry(r, g, b, y, ryy, byy);
-        push_segment_ms(enc, (double)color_to_freq(y), t);
+        push_segment_ms(enc, (double)color_to_freq(next.y[x]), t);
     }
 }
 
 static void write_line_mr(sstv_encoder_t *enc, double tw) {
     int width = (int)enc->image->width;
-    std::vector<int> ry(width);
-    std::vector<int> by(width);
+    RowYC row;
+    get_row_yc(enc->image, enc->image_line, row);
     push_segment_ms(enc, 1200, 9.0);
     push_segment_ms(enc, 1500, 1.0);
     double ty = tw / (double)width;
     double tc = ty / 2.0;
     int last_freq = 1500;
     for (int x = 0; x < width; x++) {
-        int r, g, b, y, ryy, byy;
-        get_pixel_rgb(enc->image, x, (int)enc->image_line, r, g, b);
-        get_ry(r, g, b, y, ryy, byy);
-        ry[x] = ryy;
-        by[x] = byy;
-        last_freq = color_to_freq(y);
+        last_freq = color_to_freq(row.y[x]);
         push_segment_ms(enc, (double)last_freq, ty);
     }
     push_segment_ms(enc, (double)last_freq, 0.1);
     for (int x = 0; x < width; x++) {
-        last_freq = color_to_freq(ry[x]);
+        last_freq = color_to_freq(row.ry[x]);
         push_segment_ms(enc, (double)last_freq, tc);
     }
     push_segment_ms(enc, (double)last_freq, 0.1);
     for (int x = 0; x < width; x++) {
-        last_freq = color_to_freq(by[x]);
+        last_freq = color_to_freq(row.by[x]);
         push_segment_ms(enc, (double)last_freq, tc);
     }
     push_segment_ms(enc, (double)last_freq, 0.1);
@@ -1134,55 +984,43 @@ static void write_line_mr(sstv_encoder_t *enc, double tw) {
 
 static void write_line_rm(sstv_encoder_t *enc, double ts, double tw) {
     int width = (int)enc->image->width;
-    std::vector<int> yline(width);
+    RowYC row;
+    get_row_yc(enc->image, enc->image_line, row);
     push_segment_ms(enc, 1200, ts);
     push_segment_ms(enc, 1500, ts / 3.0);
     double t = tw / (double)width;
-    for (int x = 0; x < width; x++) {
-        int r, g, b, y, ryy, byy;
-        get_pixel_rgb(enc->image, x, (int)enc->image_line, r, g, b);
-        get_ry(r, g, b, y, ryy, byy);
-        yline[x] = y;
-    }
     size_t next_line = enc->image_line + 1;
     if (next_line >= enc->image->height) next_line = enc->image->height - 1;
+    RowYC next;
+    get_row_yc(enc->image, next_line, next);
     for (int x = 0; x < width; x++) {
-        int r, g, b, y, ryy, byy;
-        get_pixel_rgb(enc->image, x, (int)next_line, r, g, b);
-        get_ry(r, g, b, y, ryy, byy);
-        int yy = (y + yline[x]) / 2;
+        int yy = (next.y[x] + row.y[x]) / 2;
         push_segment_ms(enc, (double)color_to_freq(yy), t);
     }
 }
 
 static void write_line_mn(sstv_encoder_t *enc, double tw) {
     int width = (int)enc->image->width;
-    std::vector<int> ry(width);
-    std::vector<int> by(width);
+    RowYC row;
+    get_row_yc(enc->image, enc->image_line, row);
     push_segment_ms(enc, NARROW_SYNC, 9.0);
     push_segment_ms(enc, NARROW_LOW, 1.0);
     double t = tw / (double)width;
     for (int x = 0; x < width; x++) {
-        int r, g, b, y, ryy, byy;
-        get_pixel_rgb(enc->image, x, (int)enc->image_line, r, g, b);
-        get_ry(r, g, b, y, ryy, byy);
-        ry[x] = ryy;
-        by[x] = byy;
-        push_segment_ms(enc, (double)color_to_freq_narrow(y), t);
+        push_segment_ms(enc, (double)color_to_freq_narrow(row.y[x]), t);
     }
     for (int x = 0; x < width; x++) {
-        push_segment_ms(enc, (double)color_to_freq_narrow(ry[x]), t);
+        push_segment_ms(enc, (double)color_to_freq_narrow(row.ry[x]), t);
     }
     for (int x = 0; x < width; x++) {
-        push_segment_ms(enc, (double)color_to_freq_narrow(by[x]), t);
+        push_segment_ms(enc, (double)color_to_freq_narrow(row.by[x]), t);
     }
     size_t next_line = enc->image_line + 1;
     if (next_line >= enc->image->height) next_line = enc->image->height - 1;
+    RowYC next;
+    get_row_yc(enc->image, next_line, next);
     for (int x = 0; x < width; x++) {
-        int r, g, b, y, ryy, byy;
-        get_pixel_rgb(enc->image, x, (int)next_line, r, g, b);
-        get_ry(r, g, b, y, ryy, byy);
-        push_segment_ms(enc, (double)color_to_freq_narrow(y), t);
+        push_segment_ms(enc, (double)color_to_freq_narrow(next.y[x]), t);
     }
 }
 
@@ -1216,8 +1054,9 @@ static bool generate_next_line_segments(sstv_encoder_t *enc) {
     enc->segment_index = 0;
     enc->segment_offset = 0;
 
+    /* Line format of the built-in mode (custom modes reuse one) */
     if (enc->timed_line == 0) {
-        switch (enc->mode) {
+        switch (enc->desc->base) {
             case SSTV_SCOTTIE1:
             case SSTV_SCOTTIE2:
             case SSTV_SCOTTIEX:
@@ -1228,7 +1067,7 @@ static bool generate_next_line_segments(sstv_encoder_t *enc) {
         }
     }
 
-    switch (enc->mode) {
+    switch (enc->desc->base) {
         case SSTV_R24:
             write_line_r24(enc);
             enc->timed_line += 1;
@@ -1451,7 +1290,8 @@ static bool generate_next_line_segments(sstv_encoder_t *enc) {
 }
 
 sstv_encoder_t* sstv_encoder_create(sstv_mode_t mode, double sample_rate) {
-    if (mode < 0 || mode >= SSTV_MODE_COUNT) {
+    const sstv_mode_desc_t *desc = sstv_get_mode_desc(mode);
+    if (!desc) {
         return NULL;
     }
     
@@ -1459,12 +1299,18 @@ sstv_encoder_t* sstv_encoder_create(sstv_mode_t mode, double sample_rate) {
     if (!enc) return NULL;
     
     enc->mode = mode;
+    enc->desc = desc;
     enc->sample_rate = sample_rate;
     enc->vis_enabled = 1;  /* Enabled by default */
     enc->complete = 0;
     enc->samples_generated = 0;
 
-    compute_mode_timing(mode, sample_rate, &enc->timing);
+    /* Timing of the base line format, then this mode's period and line count */
+    compute_mode_timing(desc->base, sample_rate, &enc->timing);
+    enc->line_scale = desc->line_ms / enc->timing.line_ms;
+    enc->timing.line_ms = desc->line_ms;
+    enc->timing.line_samples = desc->line_ms * sample_rate / 1000.0;
+    enc->timing.line_count = (int)desc->lines;
 
     new (&enc->vco) VCO(sample_rate);
     new (&enc->vis) VISEncoder();
@@ -1536,16 +1382,16 @@ size_t sstv_encoder_generate(sstv_encoder_t *encoder, float *samples, size_t max
         encoder->image_line = 0;
         encoder->total_timed_lines = (size_t)encoder->timing.line_count;
 
-        const sstv_mode_info_t *info = sstv_get_mode_info(encoder->mode);
-        if (encoder->vis_enabled && info && info->vis_code != 0x00 && !is_narrow_mode(encoder->mode)) {
+        const sstv_mode_desc_t *desc = encoder->desc;
+        if (encoder->vis_enabled && desc->vis_bits != 0 && !is_narrow_mode(desc)) {
             // Check if this is a 16-bit VIS mode (MR/MP/ML)
-            uint16_t vis_word = get_mmsstv_vis_word(encoder->mode);
+            uint16_t vis_word = get_mmsstv_vis_word(desc);
             if (vis_word != 0x0000) {
                 // 16-bit VIS for MR/MP/ML modes
                 encoder->vis.start_16bit(vis_word, encoder->sample_rate);
             } else {
                 // Standard 8-bit VIS
-                encoder->vis.start(info->vis_code, encoder->sample_rate);
+                encoder->vis.start(desc->vis_code, encoder->sample_rate);
             }
             encoder->vis_active = 1;
         } else {
@@ -0,0 +1,477 @@
+/*
+ * Streaming image writers (PPM / QOI / PNG) for decoded SSTV frames
+ *
+ * Each format is encoded incrementally, one RGB24 row at a time:
+ *   PPM  - header, then raw rows
+ *   QOI  - encoder state (index, previous pixel, run) carried across rows
+ *   PNG  - one IDAT chunk per row; the zlib stream is continued across
+ *          chunks, with either stored blocks or a single fixed-Huffman
+ *          block using matches against the previous pixel / previous row
+ *
+ * Memory per writer is O(width): at most the current and previous row
+ * plus one row of encoded output.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "sstv_image_writer.h"
+
+struct sstv_image_writer_s {
+    FILE *fp;
+    sstv_image_format_t format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t rows;
+    int err;
+
+    uint8_t *out;              /* Encoded bytes for one row */
+    size_t out_cap;
+
+    /* PNG */
+    size_t row_bytes;          /* Filter byte + width * 3 */
+    uint8_t *win;              /* [previous row | current row] */
+    uint32_t adler;
+    uint32_t crc_table[256];
+    uint64_t bitbuf;           /* Deflate bit writer (LSB first) */
+    int bitcnt;
+
+    /* QOI */
+    uint8_t qoi_index[64][4];  /* RGBA; starts (0,0,0,0) as the spec says */
+    uint8_t qoi_px[3];
+    int qoi_run;
+};
+
+/* === BYTE HELPERS === */
+
+static void put_be32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static void writer_emit(sstv_image_writer_t *w, const void *data, size_t len) {
+    if (w->err || len == 0) return;
+    if (fwrite(data, 1, len, w->fp) != len) w->err = 1;
+}
+
+/* === PNG: CRC32 / Adler32 / chunks === */
+
+static void png_crc_init(uint32_t table[256]) {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : (c >> 1);
+        }
+        table[n] = c;
+    }
+}
+
+static uint32_t png_crc_update(const uint32_t table[256], uint32_t crc, const uint8_t *p, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        crc = table[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+static uint32_t adler_update(uint32_t adler, const uint8_t *p, size_t n) {
+    uint32_t a = adler & 0xffff, b = adler >> 16;
+    while (n > 0) {
+        size_t k = n < 5552 ? n : 5552;   /* largest run without 32-bit overflow */
+        n -= k;
+        while (k--) {
+            a += *p++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+static void png_chunk(sstv_image_writer_t *w, const char *type, const uint8_t *data, size_t len) {
+    uint8_t hdr[8];
+    uint8_t tail[4];
+    put_be32(hdr, (uint32_t)len);
+    memcpy(hdr + 4, type, 4);
+    uint32_t crc = png_crc_update(w->crc_table, 0xffffffffu, hdr + 4, 4);
+    if (len) crc = png_crc_update(w->crc_table, crc, data, len);
+    put_be32(tail, crc ^ 0xffffffffu);
+    writer_emit(w, hdr, 8);
+    writer_emit(w, data, len);
+    writer_emit(w, tail, 4);
+}
+
+/* === PNG: fixed-Huffman deflate (RFC 1951 3.2.6) === */
+
+static const uint16_t kLenBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t kLenExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t kDistBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t kDistExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static uint32_t bit_reverse(uint32_t code, int len) {
+    uint32_t r = 0;
+    for (int i = 0; i < len; i++) {
+        r = (r << 1) | (code & 1);
+        code >>= 1;
+    }
+    return r;
+}
+
+/* Append bits LSB-first; whole bytes are moved to w->out at *n */
+static void bits_put(sstv_image_writer_t *w, size_t *n, uint32_t bits, int count) {
+    w->bitbuf |= (uint64_t)bits << w->bitcnt;
+    w->bitcnt += count;
+    while (w->bitcnt >= 8) {
+        w->out[(*n)++] = (uint8_t)w->bitbuf;
+        w->bitbuf >>= 8;
+        w->bitcnt -= 8;
+    }
+}
+
+/* Huffman codes are defined MSB-first, so they are reversed on output */
+static void deflate_symbol(sstv_image_writer_t *w, size_t *n, int sym) {
+    if (sym < 144)      bits_put(w, n, bit_reverse(0x30 + sym, 8), 8);
+    else if (sym < 256) bits_put(w, n, bit_reverse(0x190 + sym - 144, 9), 9);
+    else if (sym < 280) bits_put(w, n, bit_reverse(sym - 256, 7), 7);
+    else                bits_put(w, n, bit_reverse(0xC0 + sym - 280, 8), 8);
+}
+
+static void deflate_match(sstv_image_writer_t *w, size_t *n, int len, int dist) {
+    int i = 28;
+    while (kLenBase[i] > len) i--;
+    deflate_symbol(w, n, 257 + i);
+    if (kLenExtra[i]) bits_put(w, n, (uint32_t)(len - kLenBase[i]), kLenExtra[i]);
+
+    int d = 29;
+    while (kDistBase[d] > dist) d--;
+    bits_put(w, n, bit_reverse((uint32_t)d, 5), 5);
+    if (kDistExtra[d]) bits_put(w, n, (uint32_t)(dist - kDistBase[d]), kDistExtra[d]);
+}
+
+static int match_len(const uint8_t *a, const uint8_t *b, int max) {
+    int k = 0;
+    while (k < max && a[k] == b[k]) k++;
+    return k;
+}
+
+/*
+ * Compress the current row (w->win + row_bytes) greedily. Candidate
+ * matches are the previous pixel (distance 3, covers flat runs) and the
+ * pixel directly above (distance row_bytes, covers vertical structure).
+ */
+static size_t deflate_row_fast(sstv_image_writer_t *w, size_t n) {
+    const size_t rb = w->row_bytes;
+    const uint8_t *cur = w->win + rb;
+    const int have_prev = (w->rows > 0);
+    const int up_ok = have_prev && rb <= 32768;
+
+    size_t i = 0;
+    while (i < rb) {
+        int max = (int)((rb - i) < 258 ? (rb - i) : 258);
+        int best = 0, dist = 0;
+
+        if (max >= 3) {
+            if (i >= 3 || have_prev) {
+                int l = match_len(cur + i, cur + i - 3, max);
+                if (l > best) { best = l; dist = 3; }
+            }
+            if (up_ok) {
+                int l = match_len(cur + i, cur + i - rb, max);
+                if (l > best) { best = l; dist = (int)rb; }
+            }
+        }
+
+        if (best >= 3) {
+            deflate_match(w, &n, best, dist);
+            i += (size_t)best;
+        } else {
+            deflate_symbol(w, &n, cur[i]);
+            i++;
+        }
+    }
+    return n;
+}
+
+static size_t deflate_row_stored(sstv_image_writer_t *w, size_t n, int last) {
+    const uint8_t *raw = w->win + w->row_bytes;
+    size_t off = 0;
+    while (off < w->row_bytes) {
+        size_t len = w->row_bytes - off;
+        if (len > 65535) len = 65535;
+        int final = last && (off + len == w->row_bytes);
+        w->out[n++] = (uint8_t)(final ? 1 : 0);   /* BFINAL, BTYPE=00 */
+        w->out[n++] = (uint8_t)(len & 0xff);
+        w->out[n++] = (uint8_t)(len >> 8);
+        w->out[n++] = (uint8_t)(~len & 0xff);
+        w->out[n++] = (uint8_t)((~len >> 8) & 0xff);
+        memcpy(w->out + n, raw + off, len);
+        n += len;
+        off += len;
+    }
+    return n;
+}
+
+static void png_begin(sstv_image_writer_t *w) {
+    static const uint8_t sig[8] = {0x89, 'P', 'N', 'G', 0x0d, 0x0a, 0x1a, 0x0a};
+    uint8_t ihdr[13];
+    png_crc_init(w->crc_table);
+    writer_emit(w, sig, 8);
+    put_be32(ihdr, w->width);
+    put_be32(ihdr + 4, w->height);
+    ihdr[8] = 8;    /* bit depth */
+    ihdr[9] = 2;    /* colour type: truecolour */
+    ihdr[10] = 0;   /* deflate */
+    ihdr[11] = 0;   /* adaptive filtering */
+    ihdr[12] = 0;   /* no interlace */
+    png_chunk(w, "IHDR", ihdr, sizeof(ihdr));
+    w->adler = 1;
+}
+
+static void png_row(sstv_image_writer_t *w, const uint8_t *rgb) {
+    const size_t rb = w->row_bytes;
+    const int last = (w->rows + 1 == w->height);
+    uint8_t *cur = w->win + rb;
+
+    /* Previous row slides down; filter type 0 (none) */
+    memcpy(w->win, cur, rb);
+    cur[0] = 0;
+    memcpy(cur + 1, rgb, (size_t)w->width * 3);
+    w->adler = adler_update(w->adler, cur, rb);
+
+    size_t n = 0;
+    if (w->rows == 0) {
+        w->out[n++] = 0x78;   /* zlib: deflate, 32K window */
+        w->out[n++] = 0x01;   /* no dictionary, fastest */
+        if (w->format == SSTV_IMAGE_PNG) {
+            bits_put(w, &n, 1, 1);   /* BFINAL: one block for the whole image */
+            bits_put(w, &n, 1, 2);   /* BTYPE=01 (fixed Huffman) */
+        }
+    }
+
+    if (w->format == SSTV_IMAGE_PNG) {
+        n = deflate_row_fast(w, n);
+        if (last) {
+            deflate_symbol(w, &n, 256);   /* end of block */
+            if (w->bitcnt > 0) bits_put(w, &n, 0, 8 - w->bitcnt);
+        }
+    } else {
+        n = deflate_row_stored(w, n, last);
+    }
+
+    if (last) {
+        put_be32(w->out + n, w->adler);
+        n += 4;
+    }
+    png_chunk(w, "IDAT", w->out, n);
+    if (last) png_chunk(w, "IEND", NULL, 0);
+}
+
+/* === QOI (https://qoiformat.org/qoi-specification.pdf) === */
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF  0x40
+#define QOI_OP_LUMA  0x80
+#define QOI_OP_RUN   0xc0
+#define QOI_OP_RGB   0xfe
+
+static void qoi_begin(sstv_image_writer_t *w) {
+    uint8_t hdr[14];
+    memcpy(hdr, "qoif", 4);
+    put_be32(hdr + 4, w->width);
+    put_be32(hdr + 8, w->height);
+    hdr[12] = 3;   /* channels: RGB */
+    hdr[13] = 0;   /* colorspace: sRGB */
+    writer_emit(w, hdr, sizeof(hdr));
+}
+
+static void qoi_row(sstv_image_writer_t *w, const uint8_t *rgb) {
+    const int last_row = (w->rows + 1 == w->height);
+    uint8_t *px = w->qoi_px;
+    size_t n = 0;
+
+    for (uint32_t x = 0; x < w->width; x++) {
+        uint8_t r = rgb[x * 3], g = rgb[x * 3 + 1], b = rgb[x * 3 + 2];
+        int last = last_row && (x == w->width - 1);
+
+        if (r == px[0] && g == px[1] && b == px[2]) {
+            w->qoi_run++;
+            if (w->qoi_run == 62 || last) {
+                w->out[n++] = (uint8_t)(QOI_OP_RUN | (w->qoi_run - 1));
+                w->qoi_run = 0;
+            }
+            continue;
+        }
+        if (w->qoi_run > 0) {
+            w->out[n++] = (uint8_t)(QOI_OP_RUN | (w->qoi_run - 1));
+            w->qoi_run = 0;
+        }
+
+        int h = (r * 3 + g * 5 + b * 7 + 255 * 11) % 64;
+        uint8_t *slot = w->qoi_index[h];
+        /* Alpha too: an unwritten slot is transparent black, not black */
+        if (slot[0] == r && slot[1] == g && slot[2] == b && slot[3] == 255) {
+            w->out[n++] = (uint8_t)(QOI_OP_INDEX | h);
+        } else {
+            slot[0] = r;
+            slot[1] = g;
+            slot[2] = b;
+            slot[3] = 255;
+
+            int vr = (int8_t)(r - px[0]);
+            int vg = (int8_t)(g - px[1]);
+            int vb = (int8_t)(b - px[2]);
+            int vg_r = vr - vg;
+            int vg_b = vb - vg;
+
+            if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                w->out[n++] = (uint8_t)(QOI_OP_DIFF | ((vr + 2) << 4) | ((vg + 2) << 2) | (vb + 2));
+            } else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8) {
+                w->out[n++] = (uint8_t)(QOI_OP_LUMA | (vg + 32));
+                w->out[n++] = (uint8_t)(((vg_r + 8) << 4) | (vg_b + 8));
+            } else {
+                w->out[n++] = QOI_OP_RGB;
+                w->out[n++] = r;
+                w->out[n++] = g;
+                w->out[n++] = b;
+            }
+        }
+        px[0] = r;
+        px[1] = g;
+        px[2] = b;
+    }
+
+    if (last_row) {
+        static const uint8_t padding[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+        memcpy(w->out + n, padding, sizeof(padding));
+        n += sizeof(padding);
+    }
+    writer_emit(w, w->out, n);
+}
+
+/* === PUBLIC API === */
+
+sstv_image_writer_t* sstv_image_writer_open(const char *path,
+                                            sstv_image_format_t format,
+                                            uint32_t width, uint32_t height) {
+    if (!path || width == 0 || height == 0) return NULL;
+    if (format < SSTV_IMAGE_PPM || format > SSTV_IMAGE_PNG_STORED) return NULL;
+
+    sstv_image_writer_t *w = (sstv_image_writer_t*)calloc(1, sizeof(sstv_image_writer_t));
+    if (!w) return NULL;
+    w->format = format;
+    w->width = width;
+    w->height = height;
+    w->row_bytes = 1 + (size_t)width * 3;
+
+    /* Worst case per row: QOI 4 bytes/pixel + padding; fixed Huffman
+     * 9 bits/byte; stored adds 5 bytes per 64K block. Plus zlib framing. */
+    w->out_cap = (size_t)width * 4 + w->row_bytes / 8 + w->row_bytes / 65535 * 5 + 64;
+    w->out = (uint8_t*)malloc(w->out_cap);
+    if (format == SSTV_IMAGE_PNG || format == SSTV_IMAGE_PNG_STORED) {
+        w->win = (uint8_t*)calloc(2, w->row_bytes);
+    }
+    if (!w->out || ((format == SSTV_IMAGE_PNG || format == SSTV_IMAGE_PNG_STORED) && !w->win)) {
+        free(w->out);
+        free(w->win);
+        free(w);
+        return NULL;
+    }
+
+    w->fp = fopen(path, "wb");
+    if (!w->fp) {
+        free(w->out);
+        free(w->win);
+        free(w);
+        return NULL;
+    }
+
+    switch (format) {
+        case SSTV_IMAGE_QOI:
+            qoi_begin(w);
+            break;
+        case SSTV_IMAGE_PNG:
+        case SSTV_IMAGE_PNG_STORED:
+            png_begin(w);
+            break;
+        case SSTV_IMAGE_PPM:
+        default:
+            if (fprintf(w->fp, "P6\n%u %u\n255\n", width, height) < 0) w->err = 1;
+            break;
+    }
+    return w;
+}
+
+int sstv_image_writer_write_row(sstv_image_writer_t *w, const uint8_t *rgb) {
+    if (!w || !rgb) return -1;
+    if (w->rows >= w->height) return -1;
+
+    switch (w->format) {
+        case SSTV_IMAGE_QOI:
+            qoi_row(w, rgb);
+            break;
+        case SSTV_IMAGE_PNG:
+        case SSTV_IMAGE_PNG_STORED:
+            png_row(w, rgb);
+            break;
+        case SSTV_IMAGE_PPM:
+        default:
+            writer_emit(w, rgb, (size_t)w->width * 3);
+            break;
+    }
+    w->rows++;
+    return w->err ? -1 : 0;
+}
+
+int sstv_image_writer_rows(const sstv_image_writer_t *w) {
+    if (!w) return -1;
+    return (int)w->rows;
+}
+
+int sstv_image_writer_close(sstv_image_writer_t *w) {
+    if (!w) return 0;
+
+    /* Pad a truncated reception with black so the file stays decodable */
+    if (w->rows < w->height && !w->err) {
+        uint8_t *black = (uint8_t*)calloc(w->width, 3);
+        if (black) {
+            while (w->rows < w->height && !w->err) {
+                sstv_image_writer_write_row(w, black);
+            }
+            free(black);
+        } else {
+            w->err = 1;
+        }
+    }
+
+    int rc = w->err ? -1 : 0;
+    if (fclose(w->fp) != 0) rc = -1;
+    free(w->out);
+    free(w->win);
+    free(w);
+    return rc;
+}
+
+const char* sstv_image_format_ext(sstv_image_format_t format) {
+    switch (format) {
+        case SSTV_IMAGE_QOI:        return "qoi";
+        case SSTV_IMAGE_PNG:
+        case SSTV_IMAGE_PNG_STORED: return "png";
+        case SSTV_IMAGE_PPM:
+        default:                    return "ppm";
+    }
+}
@@ -4,8 +4,15 @@
  */
 
 #include <sstv_encoder.h>
+#include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <ctype.h>
+#include <math.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 /* Mode information table - extracted from MMSSTV 
  * Duration = (ms_per_line / 1000) * num_lines
@@ -57,11 +64,296 @@ static const sstv_mode_info_t mode_table[SSTV_MODE_COUNT] = {
     {SSTV_MC180,     "MC180-N",       320,  256,  0x00,  180.352,    1},    /* 704.5ms/line × 256 lines, VIS not documented */
 };
 
+/* Line timing, VIS and channel layout of the built-in modes, in mode order.
+ * Line periods are MMSSTV's; sync lengths are what the decoder's line sync
+ * correlates against. Narrow modes (MN/MC) sync at 1900 Hz, map pixels to
+ * 2044-2300 Hz and are received by their 16-bit VIS code only.
+ */
+typedef struct {
+    double line_ms;
+    uint32_t lines;
+    double sync_ms;
+    uint8_t vis_bits;
+    uint8_t vis_code;
+    sstv_channel_layout_t layout;
+    int narrow;
+} mode_timing_t;
+
+static const mode_timing_t timing_table[SSTV_MODE_COUNT] = {
+    /* Line ms     Lines Sync ms VIS      Layout               Narrow */
+    { 150.0,       240,  9.0,    8,  0x88, SSTV_LAYOUT_YC_ALT,  0 },   /* Robot 36 */
+    { 300.0,       240,  9.0,    8,  0x0c, SSTV_LAYOUT_YC,      0 },   /* Robot 72 */
+    { 375.0,       240,  0.0,    8,  0x44, SSTV_LAYOUT_RGB,     0 },   /* AVT 90 (no line sync) */
+    { 428.22,      256,  9.0,    8,  0x3c, SSTV_LAYOUT_GBR,     0 },   /* Scottie 1 */
+    { 277.692,     256,  9.0,    8,  0xb8, SSTV_LAYOUT_GBR,     0 },   /* Scottie 2 */
+    { 1050.3,      256,  9.0,    8,  0xcc, SSTV_LAYOUT_GBR,     0 },   /* Scottie DX */
+    { 446.446,     256,  4.862,  8,  0xac, SSTV_LAYOUT_GBR,     0 },   /* Martin 1 */
+    { 226.798,     256,  4.862,  8,  0x28, SSTV_LAYOUT_GBR,     0 },   /* Martin 2 */
+    { 711.0437,    256,  5.5,    8,  0xb7, SSTV_LAYOUT_RGB,     0 },   /* SC2 180 */
+    { 475.52248,   256,  5.5,    8,  0x3f, SSTV_LAYOUT_RGB,     0 },   /* SC2 120 */
+    { 240.3846,    256,  5.5,    8,  0xbb, SSTV_LAYOUT_RGB,     0 },   /* SC2 60 */
+    { 388.160,     128,  20.0,   8,  0xdd, SSTV_LAYOUT_YC_PAIR, 0 },   /* PD50 */
+    { 703.040,     128,  20.0,   8,  0x63, SSTV_LAYOUT_YC_PAIR, 0 },   /* PD90 */
+    { 508.480,     248,  20.0,   8,  0x5f, SSTV_LAYOUT_YC_PAIR, 0 },   /* PD120 */
+    { 804.416,     200,  20.0,   8,  0xe2, SSTV_LAYOUT_YC_PAIR, 0 },   /* PD160 */
+    { 754.24,      248,  20.0,   8,  0x60, SSTV_LAYOUT_YC_PAIR, 0 },   /* PD180 */
+    { 1000.00,     248,  20.0,   8,  0xe1, SSTV_LAYOUT_YC_PAIR, 0 },   /* PD240 */
+    { 937.28,      308,  20.0,   8,  0xde, SSTV_LAYOUT_YC_PAIR, 0 },   /* PD290 */
+    { 409.375,     496,  5.208,  8,  0x71, SSTV_LAYOUT_RGB,     0 },   /* P3 */
+    { 614.0625,    496,  7.813,  8,  0x72, SSTV_LAYOUT_RGB,     0 },   /* P5 */
+    { 818.75,      496,  10.417, 8,  0xf3, SSTV_LAYOUT_RGB,     0 },   /* P7 */
+    { 286.3,       256,  9.0,    16, 0x45, SSTV_LAYOUT_YC,      0 },   /* MR73 */
+    { 352.3,       256,  9.0,    16, 0x46, SSTV_LAYOUT_YC,      0 },   /* MR90 */
+    { 450.3,       256,  9.0,    16, 0x49, SSTV_LAYOUT_YC,      0 },   /* MR115 */
+    { 548.3,       256,  9.0,    16, 0x4a, SSTV_LAYOUT_YC,      0 },   /* MR140 */
+    { 684.3,       256,  9.0,    16, 0x4c, SSTV_LAYOUT_YC,      0 },   /* MR175 */
+    { 570.0,       128,  9.0,    16, 0x25, SSTV_LAYOUT_YC_PAIR, 0 },   /* MP73 */
+    { 902.0,       128,  9.0,    16, 0x29, SSTV_LAYOUT_YC_PAIR, 0 },   /* MP115 */
+    { 1090.0,      128,  9.0,    16, 0x2a, SSTV_LAYOUT_YC_PAIR, 0 },   /* MP140 */
+    { 1370.0,      128,  9.0,    16, 0x2c, SSTV_LAYOUT_YC_PAIR, 0 },   /* MP175 */
+    { 363.3,       496,  9.0,    16, 0x85, SSTV_LAYOUT_YC,      0 },   /* ML180 */
+    { 483.3,       496,  9.0,    16, 0x86, SSTV_LAYOUT_YC,      0 },   /* ML240 */
+    { 565.3,       496,  9.0,    16, 0x89, SSTV_LAYOUT_YC,      0 },   /* ML280 */
+    { 645.3,       496,  9.0,    16, 0x8a, SSTV_LAYOUT_YC,      0 },   /* ML320 */
+    { 200.0,       120,  6.0,    8,  0x84, SSTV_LAYOUT_YC,      0 },   /* Robot 24 */
+    { 66.89709,    120,  6.0,    8,  0x82, SSTV_LAYOUT_MONO,    0 },   /* B/W 8 */
+    { 100.0,       120,  6.0,    8,  0x86, SSTV_LAYOUT_MONO,    0 },   /* B/W 12 */
+    { 570.0,       128,  9.0,    16, 0x73, SSTV_LAYOUT_YC_PAIR, 1 },   /* MP73-N */
+    { 858.0,       128,  9.0,    16, 0x6e, SSTV_LAYOUT_YC_PAIR, 1 },   /* MP110-N */
+    { 1090.0,      128,  9.0,    16, 0x8c, SSTV_LAYOUT_YC_PAIR, 1 },   /* MP140-N */
+    { 428.5,       256,  8.0,    16, 0x6a, SSTV_LAYOUT_RGB,     1 },   /* MC110-N */
+    { 548.5,       256,  8.0,    16, 0x8d, SSTV_LAYOUT_RGB,     1 },   /* MC140-N */
+    { 704.5,       256,  8.0,    16, 0x8e, SSTV_LAYOUT_RGB,     1 },   /* MC180-N */
+};
+
+/* === MODE REGISTRY === */
+
+#define REG_CAPACITY (SSTV_MODE_COUNT + SSTV_MAX_CUSTOM_MODES)
+#define REG_NONE 0xff
+#define REG_NAME_MAX 32
+#define REG_NAME_SLOTS 4096          /* Power of two; sparse enough that a seed is found quickly */
+#define REG_LINE_BUCKETS 2048        /* 1 ms buckets; longer periods share the last */
+#define REG_MAX_TOL_MS 8.0
+
+/*
+ * One custom mode; the public structs point into it. Allocated once per
+ * registration and never freed, so descriptors handed out stay valid
+ * after the mode is unregistered.
+ */
+typedef struct {
+    char name[REG_NAME_MAX];
+    sstv_mode_info_t info;
+    sstv_mode_desc_t desc;
+} custom_mode_t;
+
+/*
+ * Immutable snapshot of the registry. Lookups pin the current snapshot
+ * without locking; sstv_register_mode() builds the next one under a mutex
+ * and publishes it. A snapshot is rebuilt in place once it is neither
+ * current nor pinned, so the pool only grows with concurrent lookups.
+ *
+ * Indexes hold positions into desc[] (REG_NONE = empty):
+ *   - vis8/vis16: direct-address tables by VIS byte
+ *   - name_slot: perfect hash of the lower-cased name; name_seed is
+ *     searched at build time until no two names collide
+ *   - line_start/line_list: modes grouped by whole-millisecond line period
+ */
+typedef struct {
+    const sstv_mode_desc_t *desc[REG_CAPACITY];
+    const sstv_mode_info_t *info[REG_CAPACITY];
+    int count;
+    const custom_mode_t *custom[SSTV_MAX_CUSTOM_MODES];   /* By slot, NULL = free */
+
+    uint8_t vis8[256];
+    uint8_t vis16[256];
+    uint32_t name_seed;
+    uint8_t name_slot[REG_NAME_SLOTS];
+    uint16_t line_start[REG_LINE_BUCKETS + 1];
+    uint8_t line_list[REG_CAPACITY];
+
+    mutable std::atomic<int> readers;   /* Lookups currently pinning it */
+} registry_t;
+
+static sstv_mode_desc_t builtin_desc[SSTV_MODE_COUNT];
+static std::atomic<const registry_t*> g_registry(nullptr);
+static std::mutex g_registry_lock;
+static std::once_flag g_registry_once;
+static std::vector<std::unique_ptr<registry_t> > g_snapshots;      /* Pool, reused */
+static std::vector<std::unique_ptr<custom_mode_t> > g_customs;     /* Owned, never freed */
+
+static uint32_t name_hash(const char *name, uint32_t seed) {
+    uint32_t h = 2166136261u ^ seed;
+    for (const char *p = name; *p; p++) {
+        h ^= (uint8_t)tolower((unsigned char)*p);
+        h *= 16777619u;
+    }
+    h ^= h >> 15;
+    return h;
+}
+
+static int line_bucket(double line_ms) {
+    if (line_ms < 0.0) return 0;
+    if (line_ms >= (double)(REG_LINE_BUCKETS - 1)) return REG_LINE_BUCKETS - 1;
+    return (int)line_ms;
+}
+
+static void fill_desc(sstv_mode_desc_t *d, const sstv_mode_info_t *info,
+                      const mode_timing_t *t, sstv_mode_t base) {
+    d->mode = info->mode;
+    d->name = info->name;
+    d->width = info->width;
+    d->height = info->height;
+    d->is_color = info->is_color;
+    d->vis_code = t->vis_code;
+    d->vis_bits = t->vis_bits;
+    d->line_ms = t->line_ms;
+    d->lines = t->lines;
+    d->sync_ms = t->sync_ms;
+    d->sync_hz = t->narrow ? 1900.0 : 1200.0;
+    d->black_hz = t->narrow ? 2044.0 : 1500.0;
+    d->white_hz = 2300.0;
+    d->layout = t->layout;
+    d->base = base;
+}
+
+/* Rebuild desc[] and every index from the built-ins and reg->custom */
+static int registry_index(registry_t *reg) {
+    reg->count = 0;
+    for (int i = 0; i < SSTV_MODE_COUNT; i++) {
+        reg->desc[reg->count] = &builtin_desc[i];
+        reg->info[reg->count] = &mode_table[i];
+        reg->count++;
+    }
+    for (int i = 0; i < SSTV_MAX_CUSTOM_MODES; i++) {
+        const custom_mode_t *c = reg->custom[i];
+        if (!c) continue;
+        reg->desc[reg->count] = &c->desc;
+        reg->info[reg->count] = &c->info;
+        reg->count++;
+    }
+
+    /* VIS: first mode in table order wins, as the old linear scan did */
+    memset(reg->vis8, REG_NONE, sizeof(reg->vis8));
+    memset(reg->vis16, REG_NONE, sizeof(reg->vis16));
+    for (int i = reg->count - 1; i >= 0; i--) {
+        const sstv_mode_desc_t *d = reg->desc[i];
+        if (d->vis_bits == 8) reg->vis8[d->vis_code] = (uint8_t)i;
+        else if (d->vis_bits == 16) reg->vis16[d->vis_code] = (uint8_t)i;
+    }
+
+    /* Names: search for a seed with no collisions */
+    for (uint32_t seed = 0; seed < 100000; seed++) {
+        memset(reg->name_slot, REG_NONE, sizeof(reg->name_slot));
+        int ok = 1;
+        for (int i = 0; i < reg->count && ok; i++) {
+            uint32_t slot = name_hash(reg->desc[i]->name, seed) & (REG_NAME_SLOTS - 1);
+            if (reg->name_slot[slot] != REG_NONE) ok = 0;
+            else reg->name_slot[slot] = (uint8_t)i;
+        }
+        if (ok) {
+            reg->name_seed = seed;
+            break;
+        }
+        if (seed == 100000 - 1) return -1;
+    }
+
+    /* Line periods: counting sort into buckets */
+    uint16_t fill[REG_LINE_BUCKETS + 1];
+    memset(fill, 0, sizeof(fill));
+    for (int i = 0; i < reg->count; i++) {
+        fill[line_bucket(reg->desc[i]->line_ms) + 1]++;
+    }
+    reg->line_start[0] = 0;
+    for (int b = 1; b <= REG_LINE_BUCKETS; b++) {
+        reg->line_start[b] = (uint16_t)(reg->line_start[b - 1] + fill[b]);
+    }
+    memcpy(fill, reg->line_start, sizeof(fill));
+    for (int i = 0; i < reg->count; i++) {
+        reg->line_list[fill[line_bucket(reg->desc[i]->line_ms)]++] = (uint8_t)i;
+    }
+    return 0;
+}
+
+static void registry_init(void) {
+    for (int i = 0; i < SSTV_MODE_COUNT; i++) {
+        fill_desc(&builtin_desc[i], &mode_table[i], &timing_table[i], (sstv_mode_t)i);
+    }
+    std::unique_ptr<registry_t> reg(new registry_t());
+    registry_index(reg.get());
+    g_registry.store(reg.get());
+    g_snapshots.push_back(std::move(reg));
+}
+
+/*
+ * Pin the current snapshot for one lookup. The count is raised before the
+ * snapshot is confirmed current, and a writer only reuses a snapshot it
+ * has already replaced and finds unpinned (both sequentially consistent),
+ * so a pinned snapshot is never rebuilt underneath its reader.
+ */
+static const registry_t* registry_pin(void) {
+    if (!g_registry.load()) std::call_once(g_registry_once, registry_init);
+    for (;;) {
+        const registry_t *reg = g_registry.load();
+        reg->readers.fetch_add(1);
+        if (g_registry.load() == reg) return reg;
+        reg->readers.fetch_sub(1);
+    }
+}
+
+static void registry_unpin(const registry_t *reg) {
+    reg->readers.fetch_sub(1, std::memory_order_release);
+}
+
+/*
+ * Index and publish a new custom mode set. Caller holds g_registry_lock.
+ *
+ * @return 0, or -1 if no collision-free name hash was found
+ */
+static int registry_publish(const custom_mode_t *const *custom) {
+    const registry_t *cur = g_registry.load();
+    registry_t *reg = NULL;
+    for (size_t i = 0; i < g_snapshots.size() && !reg; i++) {
+        registry_t *s = g_snapshots[i].get();
+        if (s != cur && s->readers.load() == 0) reg = s;
+    }
+    if (!reg) {
+        g_snapshots.push_back(std::unique_ptr<registry_t>(new registry_t()));
+        reg = g_snapshots.back().get();
+    }
+    memcpy(reg->custom, custom, sizeof(reg->custom));
+    if (registry_index(reg) != 0) return -1;
+    g_registry.store(reg);
+    return 0;
+}
+
+/* Position of a mode id in reg->desc[], or -1 */
+static int registry_find(const registry_t *reg, sstv_mode_t mode) {
+    int m = (int)mode;
+    if (m >= 0 && m < SSTV_MODE_COUNT) return m;
+    if (m < SSTV_MODE_CUSTOM_FIRST || m >= SSTV_MODE_CUSTOM_FIRST + SSTV_MAX_CUSTOM_MODES) return -1;
+    for (int i = SSTV_MODE_COUNT; i < reg->count; i++) {
+        if ((int)reg->desc[i]->mode == m) return i;
+    }
+    return -1;
+}
+
 const sstv_mode_info_t* sstv_get_mode_info(sstv_mode_t mode) {
-    if (mode < 0 || mode >= SSTV_MODE_COUNT) {
-        return NULL;
+    if ((int)mode >= 0 && mode < SSTV_MODE_COUNT) {
+        return &mode_table[mode];
     }
-    return &mode_table[mode];
+    const registry_t *reg = registry_pin();
+    int i = registry_find(reg, mode);
+    const sstv_mode_info_t *info = i >= 0 ? reg->info[i] : NULL;
+    registry_unpin(reg);
+    return info;
+}
+
+const sstv_mode_desc_t* sstv_get_mode_desc(sstv_mode_t mode) {
+    const registry_t *reg = registry_pin();
+    int i = registry_find(reg, mode);
+    const sstv_mode_desc_t *d = i >= 0 ? reg->desc[i] : NULL;
+    registry_unpin(reg);
+    return d;
 }
 
 const sstv_mode_info_t* sstv_get_all_modes(size_t *count) {
@@ -73,15 +365,118 @@ const sstv_mode_info_t* sstv_get_all_modes(size_t *count) {
 
 int sstv_find_mode_by_name(const char *name) {
     if (!name) return -1;
-    
-    for (int i = 0; i < SSTV_MODE_COUNT; i++) {
-        /* Case-insensitive comparison */
-        const char *mode_name = mode_table[i].name;
-        if (strcasecmp(name, mode_name) == 0) {
-            return i;
+    const registry_t *reg = registry_pin();
+    uint32_t slot = name_hash(name, reg->name_seed) & (REG_NAME_SLOTS - 1);
+    int i = reg->name_slot[slot];
+    int mode = -1;
+    if (i != REG_NONE && strcasecmp(name, reg->desc[i]->name) == 0) mode = (int)reg->desc[i]->mode;
+    registry_unpin(reg);
+    return mode;
+}
+
+int sstv_find_mode_by_vis(uint8_t vis_code, int extended) {
+    const registry_t *reg = registry_pin();
+    int i = extended ? reg->vis16[vis_code] : reg->vis8[vis_code];
+    int mode = i == REG_NONE ? -1 : (int)reg->desc[i]->mode;
+    registry_unpin(reg);
+    return mode;
+}
+
+int sstv_find_modes_by_line_ms(double line_ms, double tol_ms,
+                               sstv_mode_t *modes, size_t max_modes) {
+    if (!(line_ms > 0.0) || !(tol_ms >= 0.0) || tol_ms > REG_MAX_TOL_MS) return -1;
+    const registry_t *reg = registry_pin();
+    int found = 0;
+    sstv_mode_t hit[REG_CAPACITY];
+    double err[REG_CAPACITY];
+    for (int b = line_bucket(line_ms - tol_ms); b <= line_bucket(line_ms + tol_ms); b++) {
+        for (int k = reg->line_start[b]; k < reg->line_start[b + 1]; k++) {
+            const sstv_mode_desc_t *d = reg->desc[reg->line_list[k]];
+            double e = fabs(d->line_ms - line_ms);
+            if (e > tol_ms) continue;
+            /* Insertion sort, nearest first */
+            int j = found++;
+            while (j > 0 && err[j - 1] > e) {
+                hit[j] = hit[j - 1];
+                err[j] = err[j - 1];
+                j--;
+            }
+            hit[j] = d->mode;
+            err[j] = e;
         }
     }
-    return -1;
+    registry_unpin(reg);
+    for (int j = 0; modes && j < found && (size_t)j < max_modes; j++) {
+        modes[j] = hit[j];
+    }
+    return found;
+}
+
+int sstv_register_mode(const sstv_custom_mode_t *def) {
+    if (!def || !def->name || !def->name[0] || strlen(def->name) >= REG_NAME_MAX) return -1;
+    if ((int)def->base < 0 || def->base >= SSTV_MODE_COUNT) return -1;
+    if (def->vis_code == 0x23 && !def->vis_extended) return -1;   /* 16-bit VIS prefix */
+    if (def->line_ms < 0.0 || def->line_ms > 60000.0) return -1;
+
+    const sstv_mode_desc_t *base = &builtin_desc[def->base];
+    uint32_t per_line = base->height / base->lines;   /* Image lines per transmitted line */
+    uint32_t height = def->height ? def->height : base->height;
+    if (height % per_line != 0 || height > 4096) return -1;
+
+    std::lock_guard<std::mutex> lock(g_registry_lock);
+    if (sstv_find_mode_by_name(def->name) >= 0) return -1;
+    if (def->vis_code && sstv_find_mode_by_vis(def->vis_code, def->vis_extended) >= 0) return -1;
+
+    /* Only writers replace the current snapshot, so it is safe to read here */
+    const custom_mode_t *custom[SSTV_MAX_CUSTOM_MODES];
+    memcpy(custom, g_registry.load()->custom, sizeof(custom));
+    int slot = -1;
+    for (int i = 0; i < SSTV_MAX_CUSTOM_MODES; i++) {
+        if (!custom[i]) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) return -1;
+
+    std::unique_ptr<custom_mode_t> c(new custom_mode_t());
+    snprintf(c->name, sizeof(c->name), "%s", def->name);
+    c->desc = *base;
+    c->desc.mode = (sstv_mode_t)(SSTV_MODE_CUSTOM_FIRST + slot);
+    c->desc.name = c->name;
+    c->desc.height = height;
+    c->desc.lines = height / per_line;
+    if (def->line_ms > 0.0) {
+        c->desc.sync_ms = base->sync_ms * def->line_ms / base->line_ms;
+        c->desc.line_ms = def->line_ms;
+    }
+    c->desc.vis_code = def->vis_code;
+    c->desc.vis_bits = def->vis_code ? (def->vis_extended ? 16 : 8) : 0;
+    c->info.mode = c->desc.mode;
+    c->info.name = c->name;
+    c->info.width = c->desc.width;
+    c->info.height = height;
+    c->info.vis_code = def->vis_code;
+    c->info.duration_sec = c->desc.line_ms * c->desc.lines / 1000.0;
+    c->info.is_color = c->desc.is_color;
+    custom[slot] = c.get();
+    if (registry_publish(custom) != 0) return -1;
+
+    g_customs.push_back(std::move(c));
+    return SSTV_MODE_CUSTOM_FIRST + slot;
+}
+
+int sstv_unregister_mode(sstv_mode_t mode) {
+    int slot = (int)mode - SSTV_MODE_CUSTOM_FIRST;
+    if (slot < 0 || slot >= SSTV_MAX_CUSTOM_MODES) return -1;
+
+    std::lock_guard<std::mutex> lock(g_registry_lock);
+    if (!g_registry.load()) return -1;   /* Nothing registered yet */
+    const custom_mode_t *custom[SSTV_MAX_CUSTOM_MODES];
+    memcpy(custom, g_registry.load()->custom, sizeof(custom));
+    if (!custom[slot]) return -1;
+    custom[slot] = NULL;
+    return registry_publish(custom);
 }
 
 const char* sstv_encoder_version(void) {
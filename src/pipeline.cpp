@@ -0,0 +1,1238 @@
+/*
+ * Stage pipeline - typed stages sharing reference-counted blocks
+ *
+ * Each stage is a small object with pull() (sources), process() and
+ * finish() hooks. Blocks come from a per-pipeline free list and carry a
+ * reference count: emitting to several outputs adds references instead
+ * of copying, and block_writable() copies only when a stage wants to
+ * modify a block that is still shared or points at caller memory.
+ *
+ * Inline runs call process() of the next stage directly from emit(), so
+ * a block goes through the whole chain before the source produces the
+ * next one. Threaded runs give every stage its own thread and a bounded
+ * queue; a NULL block marks end of stream.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define PIPELINE_HAVE_MMAP 1
+#endif
+
+#include "sstv_pipeline.h"
+#include "SpectralSubtractionDNR.h"
+
+#define PIPE_DEFAULT_BLOCK 1024
+#define PIPE_DEFAULT_QUEUE 8
+
+/* Resampler: taps per side at the output Nyquist and phase table size */
+#define RESAMP_HALF_TAPS 16
+#define RESAMP_PHASES 256
+#define RESAMP_CUTOFF 0.90       /* Fraction of the lower Nyquist kept */
+
+typedef struct pipe_block_s {
+    std::atomic<int> refs;
+    sstv_block_type_t type;
+    int owned;                   /* samples points into data */
+    const float *samples;
+    size_t count;
+    double sample_rate;
+    uint64_t position;
+    std::vector<float> data;
+    std::vector<uint8_t> row;
+    uint32_t width, height, line, frame;
+    sstv_mode_t mode;
+    int last_row;
+} pipe_block_t;
+
+static uint64_t now_ns(void) {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* === STAGE BASE === */
+
+struct sstv_stage_s {
+    sstv_pipeline_t *pipe;
+    const char *name;
+    sstv_block_type_t in_type;
+    sstv_block_type_t out_type;
+    int is_source;
+    int is_sink;
+    sstv_stage_s *input;
+    std::vector<sstv_stage_s*> outputs;
+    sstv_stage_stats_t stats;
+    uint64_t emit_ns;            /* Time spent inside emit(), excluded from busy */
+
+    /* Threaded runs */
+    std::deque<pipe_block_t*> queue;
+    std::mutex lock;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::thread thread;
+
+    sstv_stage_s() : pipe(NULL), name(""), in_type(SSTV_BLOCK_AUDIO),
+                     out_type(SSTV_BLOCK_AUDIO), is_source(0), is_sink(0),
+                     input(NULL), emit_ns(0) {
+        memset(&stats, 0, sizeof(stats));
+    }
+    virtual ~sstv_stage_s() {}
+
+    /* Called once before the first block; -1 aborts the run */
+    virtual int start() { return 0; }
+    /* Sources: produce one block into *out (1), end of stream (0), error (-1) */
+    virtual int pull(pipe_block_t **out) { *out = NULL; return 0; }
+    /* Consume the caller's reference to b; emit() any output */
+    virtual int process(pipe_block_t *b);
+    /* End of stream: flush held-back output */
+    virtual int finish() { return 0; }
+    /* Called once after the run, on success or failure */
+    virtual void stop() {}
+};
+
+struct sstv_pipeline_s {
+    std::vector<sstv_stage_s*> stages;
+    size_t block_size;
+    int queue_depth;
+    int ran;
+    int threaded;
+    std::atomic<int> abort;
+
+    std::mutex pool_lock;
+    std::vector<pipe_block_t*> pool_free;
+    std::vector<pipe_block_t*> pool_all;
+
+    std::mutex err_lock;
+    std::string error;
+};
+
+static void pipe_fail(sstv_stage_s *st, const char *fmt, ...) {
+    sstv_pipeline_t *p = st->pipe;
+    char msg[256];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+    {
+        std::lock_guard<std::mutex> guard(p->err_lock);
+        if (p->error.empty()) {
+            p->error = std::string(st->name) + ": " + msg;
+        }
+    }
+    p->abort = 1;
+}
+
+/* === BLOCKS === */
+
+static pipe_block_t* block_get(sstv_pipeline_t *p, sstv_block_type_t type) {
+    pipe_block_t *b = NULL;
+    {
+        std::lock_guard<std::mutex> guard(p->pool_lock);
+        if (!p->pool_free.empty()) {
+            b = p->pool_free.back();
+            p->pool_free.pop_back();
+        }
+    }
+    if (!b) {
+        b = new pipe_block_t();
+        std::lock_guard<std::mutex> guard(p->pool_lock);
+        p->pool_all.push_back(b);
+    }
+    b->refs = 1;
+    b->type = type;
+    b->owned = 0;
+    b->samples = NULL;
+    b->count = 0;
+    b->sample_rate = 0.0;
+    b->position = 0;
+    b->width = b->height = b->line = b->frame = 0;
+    b->mode = SSTV_MODE_COUNT;
+    b->last_row = 0;
+    return b;
+}
+
+/* Owned audio block with room for n samples (storage is recycled) */
+static pipe_block_t* block_audio(sstv_pipeline_t *p, size_t n, double rate, uint64_t position) {
+    pipe_block_t *b = block_get(p, SSTV_BLOCK_AUDIO);
+    if (b->data.size() < n) b->data.resize(n);
+    b->owned = 1;
+    b->samples = b->data.data();
+    b->count = n;
+    b->sample_rate = rate;
+    b->position = position;
+    return b;
+}
+
+static void block_release(sstv_pipeline_t *p, pipe_block_t *b) {
+    if (!b) return;
+    if (--b->refs == 0) {
+        std::lock_guard<std::mutex> guard(p->pool_lock);
+        p->pool_free.push_back(b);
+    }
+}
+
+/* Samples of b the caller may modify: b itself when this stage holds the
+ * only reference to its own storage, otherwise a private copy */
+static pipe_block_t* block_writable(sstv_stage_s *st, pipe_block_t *b) {
+    if (b->owned && b->refs == 1) return b;
+    pipe_block_t *c = block_audio(st->pipe, b->count, b->sample_rate, b->position);
+    memcpy(c->data.data(), b->samples, b->count * sizeof(float));
+    block_release(st->pipe, b);
+    st->stats.copies++;
+    return c;
+}
+
+static float* block_data(pipe_block_t *b) {
+    return b->data.data();
+}
+
+/* === RUNNING === */
+
+static int stage_deliver(sstv_stage_s *to, pipe_block_t *b);
+
+/* Hand b (one reference) to every output of st */
+static int emit(sstv_stage_s *st, pipe_block_t *b) {
+    uint64_t t0 = now_ns();
+    st->stats.blocks_out++;
+    st->stats.samples_out += (b->type == SSTV_BLOCK_AUDIO) ? b->count : 1;
+    size_t n = st->outputs.size();
+    if (n == 0) {
+        block_release(st->pipe, b);
+        st->emit_ns += now_ns() - t0;
+        return 0;
+    }
+    if (n > 1) b->refs += (int)(n - 1);
+    int rc = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (rc != 0) {
+            block_release(st->pipe, b);
+        } else if (stage_deliver(st->outputs[i], b) != 0) {
+            rc = -1;
+        }
+    }
+    st->emit_ns += now_ns() - t0;
+    return rc;
+}
+
+/* Run one stage hook, charging its time minus downstream time */
+#define STAGE_TIMED(st, call, rc) do { \
+    uint64_t t0_ = now_ns(), e0_ = (st)->emit_ns; \
+    rc = (call); \
+    (st)->stats.busy_ns += (now_ns() - t0_) - ((st)->emit_ns - e0_); \
+} while (0)
+
+static int stage_process(sstv_stage_s *st, pipe_block_t *b) {
+    st->stats.blocks_in++;
+    st->stats.samples_in += (b->type == SSTV_BLOCK_AUDIO) ? b->count : 1;
+    int rc;
+    STAGE_TIMED(st, st->process(b), rc);
+    return rc;
+}
+
+static int stage_deliver(sstv_stage_s *to, pipe_block_t *b) {
+    sstv_pipeline_t *p = to->pipe;
+    if (p->abort) {
+        block_release(p, b);
+        return -1;
+    }
+    if (!p->threaded) return stage_process(to, b);
+
+    std::unique_lock<std::mutex> lk(to->lock);
+    while ((int)to->queue.size() >= p->queue_depth && !p->abort) {
+        to->not_full.wait(lk);
+    }
+    if (p->abort) {
+        lk.unlock();
+        block_release(p, b);
+        return -1;
+    }
+    to->queue.push_back(b);
+    if ((int)to->queue.size() > to->stats.queue_peak) {
+        to->stats.queue_peak = (int)to->queue.size();
+    }
+    to->not_empty.notify_one();
+    return 0;
+}
+
+/* Default process(): pass the block on unchanged */
+int sstv_stage_s::process(pipe_block_t *b) {
+    return emit(this, b);
+}
+
+/* Inline end of stream: flush st, then everything below it */
+static int stage_finish_inline(sstv_stage_s *st) {
+    int rc;
+    STAGE_TIMED(st, st->finish(), rc);
+    if (rc != 0) return -1;
+    for (size_t i = 0; i < st->outputs.size(); i++) {
+        if (stage_finish_inline(st->outputs[i]) != 0) return -1;
+    }
+    return 0;
+}
+
+static int source_run_inline(sstv_stage_s *src) {
+    for (;;) {
+        if (src->pipe->abort) return -1;
+        pipe_block_t *b = NULL;
+        int rc;
+        STAGE_TIMED(src, src->pull(&b), rc);
+        if (rc < 0) return -1;
+        if (rc == 0) break;
+        if (emit(src, b) != 0) return -1;
+    }
+    return stage_finish_inline(src);
+}
+
+static void wake_all(sstv_pipeline_t *p) {
+    for (size_t i = 0; i < p->stages.size(); i++) {
+        sstv_stage_s *st = p->stages[i];
+        std::lock_guard<std::mutex> guard(st->lock);
+        st->not_empty.notify_all();
+        st->not_full.notify_all();
+    }
+}
+
+/* Threaded end of stream: a NULL block to every output */
+static void stage_send_eos(sstv_stage_s *st) {
+    for (size_t i = 0; i < st->outputs.size(); i++) {
+        sstv_stage_s *to = st->outputs[i];
+        std::lock_guard<std::mutex> guard(to->lock);
+        to->queue.push_back(NULL);
+        to->not_empty.notify_one();
+    }
+}
+
+static void stage_thread(sstv_stage_s *st) {
+    sstv_pipeline_t *p = st->pipe;
+    int rc = 0;
+    if (st->is_source) {
+        for (;;) {
+            if (p->abort) {
+                rc = -1;
+                break;
+            }
+            pipe_block_t *b = NULL;
+            STAGE_TIMED(st, st->pull(&b), rc);
+            if (rc <= 0) break;
+            if ((rc = emit(st, b)) != 0) break;
+        }
+    } else {
+        for (;;) {
+            pipe_block_t *b;
+            {
+                std::unique_lock<std::mutex> lk(st->lock);
+                while (st->queue.empty() && !p->abort) st->not_empty.wait(lk);
+                if (p->abort) {
+                    rc = -1;
+                    break;
+                }
+                b = st->queue.front();
+                st->queue.pop_front();
+                st->not_full.notify_one();
+            }
+            if (!b) break;
+            if ((rc = stage_process(st, b)) != 0) break;
+        }
+    }
+    if (rc >= 0 && !p->abort) {
+        STAGE_TIMED(st, st->finish(), rc);
+    }
+    if (rc < 0 || p->abort) {
+        p->abort = 1;
+        wake_all(p);
+        return;
+    }
+    stage_send_eos(st);
+}
+
+/* === PIPELINE API === */
+
+sstv_pipeline_t* sstv_pipeline_create(void) {
+    sstv_pipeline_t *p = new sstv_pipeline_t();
+    p->block_size = PIPE_DEFAULT_BLOCK;
+    p->queue_depth = PIPE_DEFAULT_QUEUE;
+    p->ran = 0;
+    p->threaded = 0;
+    p->abort = 0;
+    return p;
+}
+
+void sstv_pipeline_free(sstv_pipeline_t *p) {
+    if (!p) return;
+    for (size_t i = 0; i < p->stages.size(); i++) delete p->stages[i];
+    for (size_t i = 0; i < p->pool_all.size(); i++) delete p->pool_all[i];
+    delete p;
+}
+
+int sstv_pipeline_set_block_size(sstv_pipeline_t *p, size_t samples) {
+    if (!p || p->ran || samples < 64 || samples > 1048576) return -1;
+    p->block_size = samples;
+    return 0;
+}
+
+int sstv_pipeline_set_queue_depth(sstv_pipeline_t *p, int depth) {
+    if (!p || p->ran || depth < 1 || depth > 1024) return -1;
+    p->queue_depth = depth;
+    return 0;
+}
+
+static int stage_belongs(const sstv_pipeline_t *p, const sstv_stage_s *st) {
+    for (size_t i = 0; i < p->stages.size(); i++) {
+        if (p->stages[i] == st) return 1;
+    }
+    return 0;
+}
+
+int sstv_pipeline_link(sstv_pipeline_t *p, sstv_stage_t *from, sstv_stage_t *to) {
+    if (!p || p->ran || !from || !to || from == to) return -1;
+    if (!stage_belongs(p, from) || !stage_belongs(p, to)) return -1;
+    if (from->is_sink || to->is_source || to->input) return -1;
+    if (from->out_type != to->in_type) return -1;
+    /* Every stage has one input, so a cycle would lead back up to `to` */
+    for (sstv_stage_s *s = from; s; s = s->input) {
+        if (s == to) return -1;
+    }
+    to->input = from;
+    from->outputs.push_back(to);
+    return 0;
+}
+
+int sstv_pipeline_run(sstv_pipeline_t *p, sstv_pipeline_mode_t mode) {
+    if (!p) return -1;
+    if (p->ran) {
+        p->error = "pipeline already ran";
+        return -1;
+    }
+    if (mode != SSTV_PIPELINE_INLINE && mode != SSTV_PIPELINE_THREADED) {
+        p->error = "invalid run mode";
+        return -1;
+    }
+    p->ran = 1;
+    p->threaded = (mode == SSTV_PIPELINE_THREADED);
+
+    int sources = 0;
+    for (size_t i = 0; i < p->stages.size(); i++) {
+        sstv_stage_s *st = p->stages[i];
+        if (st->is_source) {
+            sources++;
+        } else if (!st->input) {
+            pipe_fail(st, "stage has no input");
+            return -1;
+        }
+    }
+    if (sources == 0) {
+        p->error = "pipeline has no source";
+        return -1;
+    }
+
+    size_t started = 0;
+    for (; started < p->stages.size(); started++) {
+        sstv_stage_s *st = p->stages[started];
+        if (st->start() != 0) {
+            pipe_fail(st, "start failed");
+            break;
+        }
+    }
+
+    if (!p->abort) {
+        if (p->threaded) {
+            for (size_t i = 0; i < p->stages.size(); i++) {
+                p->stages[i]->thread = std::thread(stage_thread, p->stages[i]);
+            }
+            for (size_t i = 0; i < p->stages.size(); i++) p->stages[i]->thread.join();
+            /* Blocks left queued by an aborted run */
+            for (size_t i = 0; i < p->stages.size(); i++) {
+                std::deque<pipe_block_t*> &q = p->stages[i]->queue;
+                for (size_t j = 0; j < q.size(); j++) block_release(p, q[j]);
+                q.clear();
+            }
+        } else {
+            for (size_t i = 0; i < p->stages.size() && !p->abort; i++) {
+                if (p->stages[i]->is_source) source_run_inline(p->stages[i]);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < started; i++) p->stages[i]->stop();
+    if (p->abort) {
+        std::lock_guard<std::mutex> guard(p->err_lock);
+        if (p->error.empty()) p->error = "pipeline aborted";
+        return -1;
+    }
+    return 0;
+}
+
+const char* sstv_pipeline_error(const sstv_pipeline_t *p) {
+    if (!p) return "";
+    return p->error.c_str();
+}
+
+int sstv_pipeline_get_stage_stats(const sstv_stage_t *stage, sstv_stage_stats_t *stats) {
+    if (!stage || !stats) return -1;
+    *stats = stage->stats;
+    return 0;
+}
+
+static sstv_stage_s* stage_add(sstv_pipeline_t *p, sstv_stage_s *st, const char *name,
+                               sstv_block_type_t in_type, sstv_block_type_t out_type,
+                               int is_source, int is_sink) {
+    st->pipe = p;
+    st->name = name;
+    st->in_type = in_type;
+    st->out_type = out_type;
+    st->is_source = is_source;
+    st->is_sink = is_sink;
+    p->stages.push_back(st);
+    return st;
+}
+
+/* === SOURCES === */
+
+struct buffer_source_t : sstv_stage_s {
+    const float *samples;
+    size_t count;
+    double rate;
+    size_t pos;
+
+    int pull(pipe_block_t **out) {
+        if (pos >= count) return 0;
+        size_t n = count - pos;
+        if (n > pipe->block_size) n = pipe->block_size;
+        /* Zero-copy: the block views caller memory */
+        pipe_block_t *b = block_get(pipe, SSTV_BLOCK_AUDIO);
+        b->samples = samples + pos;
+        b->count = n;
+        b->sample_rate = rate;
+        b->position = pos;
+        pos += n;
+        *out = b;
+        return 1;
+    }
+};
+
+sstv_stage_t* sstv_pipeline_add_buffer_source(sstv_pipeline_t *p, const float *samples,
+                                              size_t count, double sample_rate) {
+    if (!p || p->ran || (!samples && count) || sample_rate <= 0.0) return NULL;
+    buffer_source_t *st = new buffer_source_t();
+    st->samples = samples;
+    st->count = count;
+    st->rate = sample_rate;
+    st->pos = 0;
+    return stage_add(p, st, "buffer source", SSTV_BLOCK_AUDIO, SSTV_BLOCK_AUDIO, 1, 0);
+}
+
+struct encoder_source_t : sstv_stage_s {
+    sstv_encoder_t *enc;
+    double rate;
+    float amplitude;
+    uint64_t pos;
+
+    int pull(pipe_block_t **out) {
+        if (sstv_encoder_is_complete(enc)) return 0;
+        pipe_block_t *b = block_audio(pipe, pipe->block_size, rate, pos);
+        float *x = block_data(b);
+        size_t n = sstv_encoder_generate(enc, x, pipe->block_size);
+        if (n == 0) {
+            block_release(pipe, b);
+            return 0;
+        }
+        for (size_t i = 0; i < n; i++) x[i] *= amplitude;
+        b->count = n;
+        pos += n;
+        *out = b;
+        return 1;
+    }
+};
+
+sstv_stage_t* sstv_pipeline_add_encoder_source(sstv_pipeline_t *p, sstv_encoder_t *enc,
+                                               double sample_rate, float amplitude) {
+    if (!p || p->ran || !enc || sample_rate <= 0.0) return NULL;
+    encoder_source_t *st = new encoder_source_t();
+    st->enc = enc;
+    st->rate = sample_rate;
+    st->amplitude = amplitude;
+    st->pos = 0;
+    return stage_add(p, st, "encoder source", SSTV_BLOCK_AUDIO, SSTV_BLOCK_AUDIO, 1, 0);
+}
+
+#define WAV_FMT_PCM 1
+#define WAV_FMT_FLOAT 3
+#define WAV_FMT_EXTENSIBLE 0xFFFE
+
+static uint16_t rd16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t rd32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+struct wav_source_t : sstv_stage_s {
+    const uint8_t *file;         /* Whole file: mapping or heap copy */
+    size_t file_size;
+    int mapped;
+    const uint8_t *data;         /* Start of the data chunk */
+    size_t frames;
+    int channels;
+    int bits;
+    int is_float;
+    double rate;
+    size_t pos;
+
+    ~wav_source_t() {
+#ifdef PIPELINE_HAVE_MMAP
+        if (mapped) {
+            munmap((void*)file, file_size);
+            return;
+        }
+#endif
+        free((void*)file);
+    }
+
+    /* One interleaved frame mixed down to mono, at 16-bit PCM scale */
+    float frame_at(size_t i) const {
+        const uint8_t *f = data + i * (size_t)channels * (bits / 8);
+        float sum = 0.0f;
+        for (int c = 0; c < channels; c++) {
+            const uint8_t *s = f + c * (bits / 8);
+            if (is_float) {
+                float v;
+                memcpy(&v, s, 4);
+                sum += v * 32767.0f;
+            } else if (bits == 16) {
+                sum += (float)(int16_t)rd16(s);
+            } else if (bits == 24) {
+                int32_t v = (int32_t)((uint32_t)s[0] << 8 | (uint32_t)s[1] << 16 | (uint32_t)s[2] << 24);
+                sum += (float)(v >> 8) / 256.0f;
+            } else {
+                sum += (float)((double)(int32_t)rd32(s) / 65536.0);
+            }
+        }
+        return channels == 1 ? sum : sum / (float)channels;
+    }
+
+    int pull(pipe_block_t **out) {
+        if (pos >= frames) return 0;
+        size_t n = frames - pos;
+        if (n > pipe->block_size) n = pipe->block_size;
+        pipe_block_t *b = block_audio(pipe, n, rate, pos);
+        float *x = block_data(b);
+        if (!is_float && bits == 16 && channels == 1) {
+            const uint8_t *s = data + pos * 2;
+            for (size_t i = 0; i < n; i++) x[i] = (float)(int16_t)rd16(s + i * 2);
+        } else {
+            for (size_t i = 0; i < n; i++) x[i] = frame_at(pos + i);
+        }
+        pos += n;
+        *out = b;
+        return 1;
+    }
+
+    /* Walk the RIFF chunks for "fmt " and "data" */
+    int parse() {
+        if (file_size < 12 || memcmp(file, "RIFF", 4) != 0 || memcmp(file + 8, "WAVE", 4) != 0) {
+            return -1;
+        }
+        const uint8_t *fmt = NULL;
+        size_t off = 12, data_len = 0;
+        data = NULL;
+        while (off + 8 <= file_size) {
+            const uint8_t *ck = file + off;
+            size_t len = rd32(ck + 4);
+            size_t avail = file_size - off - 8;
+            if (memcmp(ck, "fmt ", 4) == 0 && len >= 16 && len <= avail) {
+                fmt = ck + 8;
+            } else if (memcmp(ck, "data", 4) == 0) {
+                data = ck + 8;
+                data_len = len < avail ? len : avail;   /* Tolerate truncated files */
+                break;
+            }
+            off += 8 + len + (len & 1);
+        }
+        if (!fmt || !data) return -1;
+
+        int tag = rd16(fmt);
+        channels = rd16(fmt + 2);
+        rate = (double)rd32(fmt + 4);
+        bits = rd16(fmt + 14);
+        if (tag == WAV_FMT_EXTENSIBLE && rd32(fmt - 4) >= 26) tag = rd16(fmt + 24);
+        is_float = (tag == WAV_FMT_FLOAT);
+        if (channels < 1 || rate <= 0.0) return -1;
+        if (is_float ? bits != 32 : (tag != WAV_FMT_PCM || (bits != 16 && bits != 24 && bits != 32))) {
+            return -1;
+        }
+        frames = data_len / ((size_t)channels * (bits / 8));
+        return 0;
+    }
+};
+
+static int wav_load(wav_source_t *st, const char *path) {
+#ifdef PIPELINE_HAVE_MMAP
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat sb;
+    if (fstat(fd, &sb) == 0 && sb.st_size > 0) {
+        void *m = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m != MAP_FAILED) {
+#ifdef MADV_SEQUENTIAL
+            madvise(m, (size_t)sb.st_size, MADV_SEQUENTIAL);
+#endif
+            st->file = (const uint8_t*)m;
+            st->file_size = (size_t)sb.st_size;
+            st->mapped = 1;
+        }
+    }
+    close(fd);
+    if (st->mapped) return 0;
+#endif
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return -1;
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    uint8_t *buf = size > 0 ? (uint8_t*)malloc((size_t)size) : NULL;
+    if (!buf || fread(buf, 1, (size_t)size, fp) != (size_t)size) {
+        free(buf);
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+    st->file = buf;
+    st->file_size = (size_t)size;
+    return 0;
+}
+
+sstv_stage_t* sstv_pipeline_add_wav_source(sstv_pipeline_t *p, const char *path) {
+    if (!p || p->ran || !path) return NULL;
+    wav_source_t *st = new wav_source_t();
+    st->file = NULL;
+    st->file_size = 0;
+    st->mapped = 0;
+    st->pos = 0;
+    if (wav_load(st, path) != 0 || st->parse() != 0) {
+        delete st;
+        return NULL;
+    }
+    return stage_add(p, st, "wav source", SSTV_BLOCK_AUDIO, SSTV_BLOCK_AUDIO, 1, 0);
+}
+
+/* === FILTERS === */
+
+struct resampler_t : sstv_stage_s {
+    double out_rate;
+    double in_rate;              /* 0 until the first block */
+    int passthrough;
+    double step;                 /* Input samples per output sample */
+    int half;                    /* Taps per side */
+    std::vector<float> table;    /* (RESAMP_PHASES + 1) rows of 2 * half taps */
+    std::vector<float> hist;     /* Input from sample `consumed` on */
+    uint64_t consumed;           /* Input samples dropped from hist */
+    uint64_t next_out;           /* Index of the next output sample */
+    std::vector<float> pending;  /* Output not yet emitted */
+
+    int configure(double rate) {
+        in_rate = rate;
+        passthrough = fabs(rate - out_rate) < 1e-9 * out_rate;
+        if (passthrough) return 0;
+        step = in_rate / out_rate;
+        /* Lowpass at the lower of the two Nyquists; the kernel stretches
+         * by the decimation factor so stopband rejection stays the same */
+        double fc = RESAMP_CUTOFF * (step > 1.0 ? 1.0 / step : 1.0);
+        half = (int)ceil(RESAMP_HALF_TAPS / fc * RESAMP_CUTOFF);
+        int taps = 2 * half;
+        table.assign((size_t)(RESAMP_PHASES + 1) * taps, 0.0f);
+        for (int ph = 0; ph <= RESAMP_PHASES; ph++) {
+            double frac = (double)ph / RESAMP_PHASES;
+            float *row = &table[(size_t)ph * taps];
+            for (int k = 0; k < taps; k++) {
+                /* Tap k sits at input offset (k - half + 1) from floor(t) */
+                double x = (double)(k - half + 1) - frac;
+                double sinc = fabs(x) < 1e-12 ? 1.0 : sin(M_PI * fc * x) / (M_PI * fc * x);
+                double w = 0.0;
+                if (fabs(x) < half) {
+                    /* Blackman window over [-half, half] */
+                    double u = (x + half) / (2.0 * half);
+                    w = 0.42 - 0.5 * cos(2.0 * M_PI * u) + 0.08 * cos(4.0 * M_PI * u);
+                }
+                row[k] = (float)(fc * sinc * w);
+            }
+        }
+        /* half - 1 samples of leading silence centre the first output on input 0 */
+        hist.assign((size_t)(half - 1), 0.0f);
+        consumed = 0;
+        next_out = 0;
+        return 0;
+    }
+
+    /* Produce every output whose kernel is fully inside hist */
+    void run() {
+        int taps = 2 * half;
+        for (;;) {
+            double t = (double)next_out * step;       /* In input samples */
+            double base = floor(t);
+            size_t i0 = (size_t)((uint64_t)base - consumed);   /* hist index of tap 0 */
+            if (i0 + (size_t)taps > hist.size()) break;
+            double pf = (t - base) * RESAMP_PHASES;
+            int ph = (int)pf;
+            float mu = (float)(pf - ph);
+            const float *r0 = &table[(size_t)ph * taps];
+            const float *r1 = r0 + taps;
+            const float *x = &hist[i0];
+            float acc0 = 0.0f, acc1 = 0.0f;
+            for (int k = 0; k < taps; k++) {
+                acc0 += r0[k] * x[k];
+                acc1 += r1[k] * x[k];
+            }
+            pending.push_back(acc0 + mu * (acc1 - acc0));
+            next_out++;
+        }
+        /* Drop input no later output can reach */
+        uint64_t keep_from = (uint64_t)floor((double)next_out * step);
+        if (keep_from > consumed) {
+            size_t drop = (size_t)(keep_from - consumed);
+            if (drop > hist.size()) drop = hist.size();
+            hist.erase(hist.begin(), hist.begin() + drop);
+            consumed += drop;
+        }
+    }
+
+    int flush_pending(int all) {
+        size_t bs = pipe->block_size;
+        size_t off = 0;
+        while (pending.size() - off >= bs || (all && pending.size() > off)) {
+            size_t n = pending.size() - off;
+            if (n > bs) n = bs;
+            pipe_block_t *b = block_audio(pipe, n, out_rate, stats.samples_out);
+            memcpy(block_data(b), &pending[off], n * sizeof(float));
+            off += n;
+            if (emit(this, b) != 0) return -1;
+        }
+        pending.erase(pending.begin(), pending.begin() + off);
+        return 0;
+    }
+
+    int process(pipe_block_t *b) {
+        if (in_rate == 0.0) configure(b->sample_rate);
+        if (fabs(b->sample_rate - in_rate) > 1e-9 * in_rate) {
+            pipe_fail(this, "sample rate changed mid-stream (%.0f -> %.0f Hz)",
+                      in_rate, b->sample_rate);
+            block_release(pipe, b);
+            return -1;
+        }
+        if (passthrough) return emit(this, b);
+        hist.insert(hist.end(), b->samples, b->samples + b->count);
+        block_release(pipe, b);
+        run();
+        return flush_pending(0);
+    }
+
+    int finish() {
+        if (in_rate == 0.0 || passthrough) return 0;
+        /* Pad with silence until every input sample has its outputs */
+        uint64_t in_total = consumed + hist.size() - (uint64_t)(half - 1);
+        uint64_t want = (uint64_t)ceil((double)in_total / step);
+        hist.insert(hist.end(), (size_t)(2 * half), 0.0f);
+        run();
+        if (next_out > want) pending.resize(pending.size() - (size_t)(next_out - want));
+        return flush_pending(1);
+    }
+};
+
+sstv_stage_t* sstv_pipeline_add_resampler(sstv_pipeline_t *p, double out_rate) {
+    if (!p || p->ran || out_rate <= 0.0) return NULL;
+    resampler_t *st = new resampler_t();
+    st->out_rate = out_rate;
+    st->in_rate = 0.0;
+    st->passthrough = 0;
+    st->step = 1.0;
+    st->half = 0;
+    st->consumed = 0;
+    st->next_out = 0;
+    return stage_add(p, st, "resampler", SSTV_BLOCK_AUDIO, SSTV_BLOCK_AUDIO, 0, 0);
+}
+
+struct channel_t : sstv_stage_s {
+    sstv_channel_params_t prm;
+    uint64_t rng;
+    double fade_i, fade_q, fade_alpha, fade_norm, fade_floor;
+    double rate;
+    uint64_t n;                  /* Samples processed, for the hum phase */
+
+    /* xorshift64*: fast, and the same seed gives the same channel anywhere */
+    double uniform() {
+        rng ^= rng >> 12;
+        rng ^= rng << 25;
+        rng ^= rng >> 27;
+        return (double)((rng * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    double gauss() {
+        double u1 = uniform(), u2 = uniform();
+        if (u1 < 1e-300) u1 = 1e-300;
+        return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+    }
+
+    void configure(double r) {
+        rate = r;
+        /* One-pole lowpassed I/Q Gaussians; scaled so the envelope has unit rms */
+        fade_alpha = prm.fade_hz > 0.0f ? 2.0 * M_PI * prm.fade_hz / rate : 0.0;
+        if (fade_alpha > 1.0) fade_alpha = 1.0;
+        double var = fade_alpha > 0.0 ? fade_alpha / (2.0 - fade_alpha) : 1.0;
+        fade_norm = 1.0 / sqrt(2.0 * var);
+        fade_i = fade_q = sqrt(var);
+        fade_floor = pow(10.0, -(double)prm.fade_depth_db / 20.0);
+    }
+
+    int process(pipe_block_t *b) {
+        if (rate == 0.0) configure(b->sample_rate);
+        b = block_writable(this, b);
+        float *x = block_data(b);
+        for (size_t i = 0; i < b->count; i++, n++) {
+            double s = x[i] * (double)prm.gain;
+            if (fade_alpha > 0.0) {
+                fade_i += fade_alpha * (gauss() - fade_i);
+                fade_q += fade_alpha * (gauss() - fade_q);
+                double env = sqrt(fade_i * fade_i + fade_q * fade_q) * fade_norm;
+                if (env > 1.0) env = 1.0;
+                if (env < fade_floor) env = fade_floor;
+                s *= env;
+            }
+            if (prm.noise_rms > 0.0f) s += gauss() * prm.noise_rms;
+            if (prm.hum_level > 0.0f) {
+                double ph = 2.0 * M_PI * 50.0 * (double)n / rate;
+                s += prm.hum_level * (sin(ph) + 0.5 * sin(2.0 * ph) + 0.25 * sin(3.0 * ph));
+            }
+            x[i] = (float)s;
+        }
+        return emit(this, b);
+    }
+};
+
+sstv_stage_t* sstv_pipeline_add_channel(sstv_pipeline_t *p, const sstv_channel_params_t *params) {
+    if (!p || p->ran || !params || params->noise_rms < 0.0f || params->fade_hz < 0.0f ||
+        params->fade_depth_db < 0.0f || params->hum_level < 0.0f) {
+        return NULL;
+    }
+    channel_t *st = new channel_t();
+    st->prm = *params;
+    st->rng = 0x9E3779B97F4A7C15ULL ^ ((uint64_t)params->seed << 1);
+    st->rate = 0.0;
+    st->n = 0;
+    return stage_add(p, st, "channel", SSTV_BLOCK_AUDIO, SSTV_BLOCK_AUDIO, 0, 0);
+}
+
+struct dnr_t : sstv_stage_s {
+    SpectralSubtractionDNR *dnr;
+    double rate;
+    std::vector<float> pending;
+
+    ~dnr_t() { delete dnr; }
+
+    int flush_pending(int all) {
+        size_t bs = pipe->block_size;
+        size_t off = 0;
+        while (pending.size() - off >= bs || (all && pending.size() > off)) {
+            size_t n = pending.size() - off;
+            if (n > bs) n = bs;
+            pipe_block_t *b = block_audio(pipe, n, rate, stats.samples_out);
+            memcpy(block_data(b), &pending[off], n * sizeof(float));
+            off += n;
+            if (emit(this, b) != 0) return -1;
+        }
+        pending.erase(pending.begin(), pending.begin() + off);
+        return 0;
+    }
+
+    int process(pipe_block_t *b) {
+        rate = b->sample_rate;
+        dnr->process_stream(b->samples, b->count, pending);
+        block_release(pipe, b);
+        return flush_pending(0);
+    }
+
+    int finish() {
+        dnr->flush_stream(pending);
+        return flush_pending(1);
+    }
+};
+
+sstv_stage_t* sstv_pipeline_add_dnr(sstv_pipeline_t *p, size_t frame_size, size_t hop_size) {
+    if (!p || p->ran) return NULL;
+    if (frame_size == 0) frame_size = 1024;
+    if (hop_size == 0) hop_size = frame_size / 4;
+    if (frame_size < 16 || (frame_size & (frame_size - 1)) || hop_size > frame_size / 2) {
+        return NULL;
+    }
+    dnr_t *st = new dnr_t();
+    st->dnr = new SpectralSubtractionDNR(frame_size, hop_size);
+    st->rate = 0.0;
+    return stage_add(p, st, "dnr", SSTV_BLOCK_AUDIO, SSTV_BLOCK_AUDIO, 0, 0);
+}
+
+struct decoder_stage_t : sstv_stage_s {
+    sstv_decoder_t *dec;
+    double rate;
+    uint32_t frame;
+    int emit_rc;
+
+    static void on_line(void *user, int line, const uint8_t *rgb, int width, int height) {
+        decoder_stage_t *st = (decoder_stage_t*)user;
+        if (st->emit_rc != 0 || width <= 0 || height <= 0) return;
+        sstv_decoder_state_t ds;
+        pipe_block_t *b = block_get(st->pipe, SSTV_BLOCK_IMAGE_ROW);
+        b->row.assign(rgb, rgb + (size_t)width * 3);
+        b->width = (uint32_t)width;
+        b->height = (uint32_t)height;
+        b->line = (uint32_t)line;
+        b->frame = st->frame;
+        b->mode = sstv_decoder_get_state(st->dec, &ds) == 0 ? ds.current_mode : SSTV_MODE_COUNT;
+        b->last_row = (line == height - 1);
+        st->emit_rc = emit(st, b);
+    }
+
+    int start() {
+        sstv_decoder_set_line_callback(dec, on_line, this);
+        return 0;
+    }
+
+    void stop() {
+        sstv_decoder_set_line_callback(dec, NULL, NULL);
+    }
+
+    int process(pipe_block_t *b) {
+        if (fabs(b->sample_rate - rate) > 1e-9 * rate) {
+            pipe_fail(this, "input at %.0f Hz, decoder expects %.0f Hz", b->sample_rate, rate);
+            block_release(pipe, b);
+            return -1;
+        }
+        sstv_rx_status_t stt = SSTV_RX_NEED_MORE;
+        if (b->count) stt = sstv_decoder_feed(dec, b->samples, b->count);
+        block_release(pipe, b);
+        if (emit_rc != 0) return -1;
+        if (stt == SSTV_RX_ERROR) {
+            pipe_fail(this, "decoder error");
+            return -1;
+        }
+        if (stt == SSTV_RX_IMAGE_READY) {
+            frame++;
+            sstv_decoder_reset(dec);
+        }
+        return 0;
+    }
+};
+
+sstv_stage_t* sstv_pipeline_add_decoder(sstv_pipeline_t *p, sstv_decoder_t *dec,
+                                        double sample_rate) {
+    if (!p || p->ran || !dec || sample_rate <= 0.0) return NULL;
+    decoder_stage_t *st = new decoder_stage_t();
+    st->dec = dec;
+    st->rate = sample_rate;
+    st->frame = 0;
+    st->emit_rc = 0;
+    return stage_add(p, st, "decoder", SSTV_BLOCK_AUDIO, SSTV_BLOCK_IMAGE_ROW, 0, 0);
+}
+
+/* === SINKS === */
+
+struct wav_sink_t : sstv_stage_s {
+    FILE *fp;
+    uint32_t rate;
+    uint32_t frames;
+    std::vector<int16_t> pcm;
+
+    ~wav_sink_t() {
+        if (fp) fclose(fp);
+    }
+
+    int write_header() {
+        uint8_t h[44];
+        uint32_t data_bytes = frames * 2;
+        memcpy(h, "RIFF", 4);
+        uint32_t v = 36 + data_bytes;
+        memcpy(h + 4, &v, 4);
+        memcpy(h + 8, "WAVEfmt ", 8);
+        v = 16;
+        memcpy(h + 16, &v, 4);
+        uint16_t s = 1;
+        memcpy(h + 20, &s, 2);                  /* PCM */
+        memcpy(h + 22, &s, 2);                  /* mono */
+        memcpy(h + 24, &rate, 4);
+        v = rate * 2;
+        memcpy(h + 28, &v, 4);
+        s = 2;
+        memcpy(h + 32, &s, 2);
+        s = 16;
+        memcpy(h + 34, &s, 2);
+        memcpy(h + 36, "data", 4);
+        memcpy(h + 40, &data_bytes, 4);
+        return fwrite(h, 1, sizeof(h), fp) == sizeof(h) ? 0 : -1;
+    }
+
+    int process(pipe_block_t *b) {
+        if (rate == 0) rate = (uint32_t)(b->sample_rate + 0.5);
+        pcm.resize(b->count);
+        for (size_t i = 0; i < b->count; i++) {
+            float v = b->samples[i];
+            if (v > 32767.0f) v = 32767.0f;
+            if (v < -32768.0f) v = -32768.0f;
+            pcm[i] = (int16_t)lrintf(v);
+        }
+        size_t n = b->count;
+        block_release(pipe, b);
+        if (fwrite(pcm.data(), sizeof(int16_t), n, fp) != n) {
+            pipe_fail(this, "write failed");
+            return -1;
+        }
+        frames += (uint32_t)n;
+        return 0;
+    }
+
+    int finish() {
+        if (fseek(fp, 0, SEEK_SET) != 0 || write_header() != 0 || fclose(fp) != 0) {
+            fp = NULL;
+            pipe_fail(this, "write failed");
+            return -1;
+        }
+        fp = NULL;
+        return 0;
+    }
+};
+
+sstv_stage_t* sstv_pipeline_add_wav_sink(sstv_pipeline_t *p, const char *path) {
+    if (!p || p->ran || !path) return NULL;
+    wav_sink_t *st = new wav_sink_t();
+    st->rate = 0;
+    st->frames = 0;
+    st->fp = fopen(path, "wb");
+    if (!st->fp || st->write_header() != 0) {
+        delete st;
+        return NULL;
+    }
+    return stage_add(p, st, "wav sink", SSTV_BLOCK_AUDIO, SSTV_BLOCK_AUDIO, 0, 1);
+}
+
+struct image_sink_t : sstv_stage_s {
+    std::string prefix;
+    sstv_image_format_t format;
+    sstv_image_writer_t *w;
+    uint32_t frame;
+    std::vector<uint8_t> black;
+
+    ~image_sink_t() {
+        sstv_image_writer_close(w);
+    }
+
+    int process(pipe_block_t *b) {
+        int rc = 0;
+        if (w && b->frame != frame) {
+            rc = sstv_image_writer_close(w);
+            w = NULL;
+        }
+        if (rc == 0 && !w) {
+            char path[1024];
+            snprintf(path, sizeof(path), "%s_%u.%s", prefix.c_str(), b->frame,
+                     sstv_image_format_ext(format));
+            frame = b->frame;
+            w = sstv_image_writer_open(path, format, b->width, b->height);
+            if (!w) rc = -1;
+        }
+        /* Lines the decoder skipped are written black */
+        while (rc == 0 && (uint32_t)sstv_image_writer_rows(w) < b->line) {
+            black.assign((size_t)b->width * 3, 0);
+            rc = sstv_image_writer_write_row(w, black.data());
+        }
+        if (rc == 0 && (uint32_t)sstv_image_writer_rows(w) == b->line) {
+            rc = sstv_image_writer_write_row(w, b->row.data());
+        }
+        if (rc == 0 && b->last_row) {
+            rc = sstv_image_writer_close(w);
+            w = NULL;
+        }
+        block_release(pipe, b);
+        if (rc != 0) {
+            pipe_fail(this, "cannot write %s image", sstv_image_format_ext(format));
+            return -1;
+        }
+        return 0;
+    }
+
+    int finish() {
+        int rc = sstv_image_writer_close(w);
+        w = NULL;
+        if (rc != 0) {
+            pipe_fail(this, "cannot write %s image", sstv_image_format_ext(format));
+            return -1;
+        }
+        return 0;
+    }
+};
+
+sstv_stage_t* sstv_pipeline_add_image_sink(sstv_pipeline_t *p, const char *prefix,
+                                           sstv_image_format_t format) {
+    if (!p || p->ran || !prefix || format < SSTV_IMAGE_PPM || format > SSTV_IMAGE_PNG_STORED) {
+        return NULL;
+    }
+    image_sink_t *st = new image_sink_t();
+    st->prefix = prefix;
+    st->format = format;
+    st->w = NULL;
+    st->frame = 0;
+    return stage_add(p, st, "image sink", SSTV_BLOCK_IMAGE_ROW, SSTV_BLOCK_IMAGE_ROW, 0, 1);
+}
+
+struct callback_sink_t : sstv_stage_s {
+    sstv_block_callback_t cb;
+    void *user;
+
+    int process(pipe_block_t *b) {
+        sstv_block_t v;
+        memset(&v, 0, sizeof(v));
+        v.type = b->type;
+        if (b->type == SSTV_BLOCK_AUDIO) {
+            v.samples = b->samples;
+            v.count = b->count;
+            v.sample_rate = b->sample_rate;
+            v.position = b->position;
+            v.mode = SSTV_MODE_COUNT;
+        } else {
+            v.row = b->row.data();
+            v.width = b->width;
+            v.height = b->height;
+            v.line = b->line;
+            v.frame = b->frame;
+            v.mode = b->mode;
+            v.last_row = b->last_row;
+        }
+        int rc = cb(user, &v);
+        block_release(pipe, b);
+        if (rc != 0) {
+            pipe_fail(this, "stopped by callback");
+            return -1;
+        }
+        return 0;
+    }
+};
+
+sstv_stage_t* sstv_pipeline_add_callback_sink(sstv_pipeline_t *p, sstv_block_type_t type,
+                                              sstv_block_callback_t cb, void *user) {
+    if (!p || p->ran || !cb || (type != SSTV_BLOCK_AUDIO && type != SSTV_BLOCK_IMAGE_ROW)) {
+        return NULL;
+    }
+    callback_sink_t *st = new callback_sink_t();
+    st->cb = cb;
+    st->user = user;
+    return stage_add(p, st, "callback sink", type, type, 0, 1);
+}
@@ -0,0 +1,128 @@
+/*
+ * Slab pool - size-classed block allocator shared across decoders
+ *
+ * Each size class keeps a free list of blocks of exactly that size. With
+ * decoder frames the classes are the frame geometries in use, so after
+ * the first frame of each geometry (or an explicit reserve) allocation is
+ * a free-list pop under a mutex and never reaches malloc.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <mutex>
+#include <vector>
+
+#include "sstv_decoder.h"
+
+typedef struct {
+    size_t size;
+    std::vector<void*> free_list;
+} slab_class_t;
+
+struct sstv_slab_pool_s {
+    std::mutex lock;
+    std::vector<slab_class_t> classes;
+    size_t max_bytes;                /* 0 = no limit */
+    sstv_slab_stats_t stats;
+};
+
+/* Caller holds the lock. Few geometries are ever live, so a linear scan wins */
+static slab_class_t* slab_class_find(sstv_slab_pool_t *pool, size_t size, int create) {
+    for (size_t i = 0; i < pool->classes.size(); i++) {
+        if (pool->classes[i].size == size) return &pool->classes[i];
+    }
+    if (!create) return NULL;
+    slab_class_t c;
+    c.size = size;
+    pool->classes.push_back(c);
+    pool->stats.size_classes = (int)pool->classes.size();
+    return &pool->classes.back();
+}
+
+/* Caller holds the lock: a new block within the byte limit, or NULL */
+static void* slab_new_block(sstv_slab_pool_t *pool, size_t size) {
+    void *p = NULL;
+    if (!pool->max_bytes || pool->stats.bytes_total + size <= pool->max_bytes) {
+        /* calloc: large blocks are fresh zero pages, touched only when written */
+        p = calloc(1, size);
+    }
+    if (p) {
+        pool->stats.bytes_total += size;
+    } else {
+        pool->stats.failed++;
+    }
+    return p;
+}
+
+static void* slab_alloc(void *user, size_t size) {
+    sstv_slab_pool_t *pool = (sstv_slab_pool_t*)user;
+    if (size == 0) size = 1;
+    std::lock_guard<std::mutex> guard(pool->lock);
+    slab_class_t *c = slab_class_find(pool, size, 1);
+    void *p = NULL;
+    if (!c->free_list.empty()) {
+        p = c->free_list.back();
+        c->free_list.pop_back();
+        pool->stats.reused++;
+    } else {
+        p = slab_new_block(pool, size);
+    }
+    if (!p) return NULL;
+    pool->stats.allocs++;
+    pool->stats.bytes_in_use += size;
+    return p;
+}
+
+static void slab_free(void *user, void *ptr, size_t size) {
+    sstv_slab_pool_t *pool = (sstv_slab_pool_t*)user;
+    if (!ptr) return;
+    if (size == 0) size = 1;
+    std::lock_guard<std::mutex> guard(pool->lock);
+    slab_class_t *c = slab_class_find(pool, size, 1);
+    c->free_list.push_back(ptr);
+    pool->stats.bytes_in_use -= size;
+}
+
+sstv_slab_pool_t* sstv_slab_pool_create(size_t max_bytes) {
+    sstv_slab_pool_t *pool = new sstv_slab_pool_t();
+    pool->max_bytes = max_bytes;
+    memset(&pool->stats, 0, sizeof(pool->stats));
+    return pool;
+}
+
+void sstv_slab_pool_free(sstv_slab_pool_t *pool) {
+    if (!pool) return;
+    for (size_t i = 0; i < pool->classes.size(); i++) {
+        for (size_t j = 0; j < pool->classes[i].free_list.size(); j++) {
+            free(pool->classes[i].free_list[j]);
+        }
+    }
+    delete pool;
+}
+
+int sstv_slab_pool_allocator(sstv_slab_pool_t *pool, sstv_allocator_t *out) {
+    if (!pool || !out) return -1;
+    out->alloc = slab_alloc;
+    out->free = slab_free;
+    out->user = pool;
+    return 0;
+}
+
+int sstv_slab_pool_reserve(sstv_slab_pool_t *pool, size_t block_size, int count) {
+    if (!pool || block_size == 0 || count < 0) return -1;
+    std::lock_guard<std::mutex> guard(pool->lock);
+    slab_class_t *c = slab_class_find(pool, block_size, 1);
+    while ((int)c->free_list.size() < count) {
+        void *p = slab_new_block(pool, block_size);
+        if (!p) return -1;
+        c->free_list.push_back(p);
+    }
+    return 0;
+}
+
+int sstv_slab_pool_get_stats(sstv_slab_pool_t *pool, sstv_slab_stats_t *stats) {
+    if (!pool || !stats) return -1;
+    std::lock_guard<std::mutex> guard(pool->lock);
+    *stats = pool->stats;
+    return 0;
+}
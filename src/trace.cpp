@@ -0,0 +1,324 @@
+/*
+ * Decoder replay trace - record/read helpers
+ *
+ * See trace.h for the file layout.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "trace.h"
+
+/* Escape for large Rice quotients: 32 ones, then the value in 19 bits
+ * (a zigzagged second-order int16 residual never needs more). */
+#define RICE_ESCAPE_Q 32
+#define RICE_RAW_BITS 19
+#define RICE_MAX_K 16
+
+/* === BLOCK CODEC === */
+
+size_t trace_block_bound(size_t n) {
+    /* Codec, order and k bytes + at most 51 bits per sample + flush */
+    return 3 + n * 7 + 8;
+}
+
+static uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t u) {
+    return (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+}
+
+static int block_is_int16(const float *x, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        float v = x[i];
+        if (!(v >= -32768.0f && v <= 32767.0f)) return 0;
+        if ((float)(int32_t)v != v) return 0;
+        /* Reject -0.0f, which would not survive the round trip */
+        if (v == 0.0f) {
+            uint32_t bits;
+            memcpy(&bits, &v, sizeof(bits));
+            if (bits != 0) return 0;
+        }
+    }
+    return 1;
+}
+
+typedef struct {
+    uint8_t *out;
+    size_t n;
+    uint64_t acc;
+    int cnt;
+} bit_writer_t;
+
+static void bw_put(bit_writer_t *bw, uint32_t bits, int count) {
+    bw->acc |= (uint64_t)bits << bw->cnt;
+    bw->cnt += count;
+    while (bw->cnt >= 8) {
+        bw->out[bw->n++] = (uint8_t)bw->acc;
+        bw->acc >>= 8;
+        bw->cnt -= 8;
+    }
+}
+
+/* Fixed polynomial predictor (FLAC-style): order 1 is a plain delta,
+ * order 2 a linear extrapolation, which suits tone-heavy SSTV audio */
+static int32_t predict(int order, int32_t p1, int32_t p2) {
+    return order == 2 ? 2 * p1 - p2 : p1;
+}
+
+static size_t encode_rice16(const float *x, size_t n, uint8_t *out) {
+    /* Pick the predictor order, then k from the mean zigzagged residual */
+    uint64_t sum[3] = {0, 0, 0};
+    int32_t p1 = 0, p2 = 0;
+    for (size_t i = 0; i < n; i++) {
+        int32_t s = (int32_t)x[i];
+        sum[1] += zigzag(s - predict(1, p1, p2));
+        sum[2] += zigzag(s - predict(2, p1, p2));
+        p2 = p1;
+        p1 = s;
+    }
+    int order = sum[2] < sum[1] ? 2 : 1;
+    uint64_t mean = n ? sum[order] / n : 0;
+    int k = 0;
+    while (k < RICE_MAX_K && ((uint64_t)1 << (k + 1)) <= mean) k++;
+
+    bit_writer_t bw = {out, 0, 0, 0};
+    out[bw.n++] = TRACE_CODEC_RICE16;
+    out[bw.n++] = (uint8_t)order;
+    out[bw.n++] = (uint8_t)k;
+    p1 = p2 = 0;
+    for (size_t i = 0; i < n; i++) {
+        int32_t s = (int32_t)x[i];
+        uint32_t u = zigzag(s - predict(order, p1, p2));
+        p2 = p1;
+        p1 = s;
+        uint32_t q = u >> k;
+        if (q >= RICE_ESCAPE_Q) {
+            bw_put(&bw, 0xffffffffu, RICE_ESCAPE_Q);
+            bw_put(&bw, u, RICE_RAW_BITS);
+        } else {
+            bw_put(&bw, (1u << q) - 1, (int)q);   /* q ones */
+            bw_put(&bw, 0, 1);                     /* terminator */
+            if (k) bw_put(&bw, u & ((1u << k) - 1), k);
+        }
+    }
+    if (bw.cnt > 0) bw_put(&bw, 0, 8 - bw.cnt);
+    return bw.n;
+}
+
+size_t trace_encode_block(const float *x, size_t n, uint8_t *out) {
+    if (n > 0 && block_is_int16(x, n)) {
+        size_t len = encode_rice16(x, n, out);
+        if (len <= 1 + n * sizeof(float)) return len;
+    }
+    out[0] = TRACE_CODEC_F32;
+    memcpy(out + 1, x, n * sizeof(float));
+    return 1 + n * sizeof(float);
+}
+
+typedef struct {
+    const uint8_t *in;
+    size_t len;
+    size_t pos;
+    uint64_t acc;
+    int cnt;
+} bit_reader_t;
+
+static int br_fill(bit_reader_t *br, int need) {
+    while (br->cnt < need) {
+        if (br->pos >= br->len) return -1;
+        br->acc |= (uint64_t)br->in[br->pos++] << br->cnt;
+        br->cnt += 8;
+    }
+    return 0;
+}
+
+static int br_get(bit_reader_t *br, int count, uint32_t *v) {
+    if (count == 0) {
+        *v = 0;
+        return 0;
+    }
+    if (br_fill(br, count) != 0) return -1;
+    *v = (uint32_t)(br->acc & ((count == 32) ? 0xffffffffu : ((1u << count) - 1)));
+    br->acc >>= count;
+    br->cnt -= count;
+    return 0;
+}
+
+int trace_decode_block(const uint8_t *in, size_t len, float *x, size_t n) {
+    if (len < 1) return -1;
+    if (in[0] == TRACE_CODEC_F32) {
+        if (len != 1 + n * sizeof(float)) return -1;
+        memcpy(x, in + 1, n * sizeof(float));
+        return 0;
+    }
+    if (in[0] != TRACE_CODEC_RICE16 || len < 3) return -1;
+
+    int order = in[1];
+    int k = in[2];
+    if ((order != 1 && order != 2) || k > RICE_MAX_K) return -1;
+    bit_reader_t br = {in + 3, len - 3, 0, 0, 0};
+    int32_t p1 = 0, p2 = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t q = 0, bit, u;
+        for (;;) {
+            if (br_get(&br, 1, &bit) != 0) return -1;
+            if (!bit) break;
+            if (++q == RICE_ESCAPE_Q) break;
+        }
+        if (q == RICE_ESCAPE_Q) {
+            if (br_get(&br, RICE_RAW_BITS, &u) != 0) return -1;
+        } else {
+            uint32_t low;
+            if (br_get(&br, k, &low) != 0) return -1;
+            u = (q << k) | low;
+        }
+        int32_t s = predict(order, p1, p2) + unzigzag(u);
+        p2 = p1;
+        p1 = s;
+        x[i] = (float)s;
+    }
+    return 0;
+}
+
+/* === WRITER === */
+
+static void tw_emit(trace_writer_t *w, const void *p, size_t n) {
+    if (w->err || n == 0) return;
+    if (fwrite(p, 1, n, w->fp) != n) w->err = 1;
+}
+
+static void tw_record(trace_writer_t *w, uint8_t type, const void *a, size_t alen,
+                      const void *b, size_t blen) {
+    uint32_t len = (uint32_t)(alen + blen);
+    tw_emit(w, &type, 1);
+    tw_emit(w, &len, 4);
+    tw_emit(w, a, alen);
+    tw_emit(w, b, blen);
+}
+
+int trace_writer_open(trace_writer_t *w, const char *path, const trace_config_t *cfg) {
+    memset(w, 0, sizeof(*w));
+    w->fp = fopen(path, "wb");
+    if (!w->fp) return -1;
+    uint32_t version = TRACE_VERSION;
+    tw_emit(w, TRACE_MAGIC, 8);
+    tw_emit(w, &version, 4);
+    tw_record(w, TRACE_REC_CONFIG, cfg, sizeof(*cfg), NULL, 0);
+    return w->err ? -1 : 0;
+}
+
+void trace_write_call(trace_writer_t *w, const trace_call_t *call) {
+    if (!w->fp) return;
+    tw_record(w, TRACE_REC_CALL, call, sizeof(*call), NULL, 0);
+}
+
+void trace_write_feed(trace_writer_t *w, const trace_feed_t *feed, const float *samples) {
+    if (!w->fp) return;
+    size_t need = trace_block_bound(feed->count);
+    if (need > w->buf_cap) {
+        uint8_t *nb = (uint8_t*)realloc(w->buf, need);
+        if (!nb) {
+            w->err = 1;
+            return;
+        }
+        w->buf = nb;
+        w->buf_cap = need;
+    }
+    size_t len = trace_encode_block(samples, feed->count, w->buf);
+    tw_record(w, TRACE_REC_FEED, feed, sizeof(*feed), w->buf, len);
+}
+
+void trace_write_check(trace_writer_t *w, const trace_check_t *check) {
+    if (!w->fp) return;
+    tw_record(w, TRACE_REC_CHECK, check, sizeof(*check), NULL, 0);
+}
+
+int trace_writer_close(trace_writer_t *w) {
+    int rc = w->err ? -1 : 0;
+    if (w->fp && fclose(w->fp) != 0) rc = -1;
+    free(w->buf);
+    memset(w, 0, sizeof(*w));
+    return rc;
+}
+
+/* === READER === */
+
+int trace_reader_open(trace_reader_t *r, const char *path, trace_config_t *cfg) {
+    memset(r, 0, sizeof(*r));
+    r->fp = fopen(path, "rb");
+    if (!r->fp) return -1;
+
+    char magic[8];
+    uint32_t version = 0;
+    uint8_t type = 0;
+    uint32_t len = 0;
+    if (fread(magic, 1, 8, r->fp) != 8 || memcmp(magic, TRACE_MAGIC, 8) != 0 ||
+        fread(&version, 4, 1, r->fp) != 1 || version != TRACE_VERSION ||
+        fread(&type, 1, 1, r->fp) != 1 || type != TRACE_REC_CONFIG ||
+        fread(&len, 4, 1, r->fp) != 1 || len != sizeof(*cfg) ||
+        fread(cfg, sizeof(*cfg), 1, r->fp) != 1) {
+        trace_reader_close(r);
+        return -1;
+    }
+    return 0;
+}
+
+int trace_read(trace_reader_t *r, trace_record_t *rec) {
+    uint8_t type;
+    uint32_t len;
+    memset(rec, 0, sizeof(*rec));
+    if (fread(&type, 1, 1, r->fp) != 1) return 0;
+    if (fread(&len, 4, 1, r->fp) != 1) return -1;
+
+    if (len > r->buf_cap) {
+        uint8_t *nb = (uint8_t*)realloc(r->buf, len);
+        if (!nb) return -1;
+        r->buf = nb;
+        r->buf_cap = len;
+    }
+    if (len && fread(r->buf, 1, len, r->fp) != len) return -1;
+
+    rec->type = type;
+    switch (type) {
+        case TRACE_REC_CALL:
+            if (len != sizeof(rec->call)) return -1;
+            memcpy(&rec->call, r->buf, sizeof(rec->call));
+            return 1;
+        case TRACE_REC_CHECK:
+            if (len != sizeof(rec->check)) return -1;
+            memcpy(&rec->check, r->buf, sizeof(rec->check));
+            return 1;
+        case TRACE_REC_FEED: {
+            if (len < sizeof(rec->feed)) return -1;
+            memcpy(&rec->feed, r->buf, sizeof(rec->feed));
+            size_t n = rec->feed.count;
+            if (n > r->samples_cap) {
+                float *ns = (float*)realloc(r->samples, n * sizeof(float));
+                if (!ns) return -1;
+                r->samples = ns;
+                r->samples_cap = n;
+            }
+            if (trace_decode_block(r->buf + sizeof(rec->feed), len - sizeof(rec->feed),
+                                   r->samples, n) != 0) {
+                return -1;
+            }
+            rec->samples = r->samples;
+            return 1;
+        }
+        default:
+            /* Unknown record from a newer writer: skip it */
+            rec->type = 0;
+            return trace_read(r, rec);
+    }
+}
+
+void trace_reader_close(trace_reader_t *r) {
+    if (r->fp) fclose(r->fp);
+    free(r->buf);
+    free(r->samples);
+    memset(r, 0, sizeof(*r));
+}
@@ -0,0 +1,139 @@
+/*
+ * Decoder replay trace - record/read helpers (internal)
+ *
+ * A trace captures everything needed to re-run a decoder session
+ * bit-exactly: the configuration at start, every state-changing API call,
+ * and each sstv_decoder_feed() block with its chunk boundary, wall-clock
+ * arrival time, processing time and returned status. Periodic decoder
+ * state checksums let a replay pinpoint where two builds diverge.
+ *
+ * File layout (host byte order):
+ *   "SSTVTRC1" | u32 version
+ *   record*    : u8 type | u32 payload_len | payload
+ *
+ * Sample blocks are stored losslessly. Blocks whose samples are all
+ * integers in int16 range (the usual case for PCM sources) are coded as
+ * first- or second-order prediction residuals, zigzag-mapped and Rice
+ * coded with a per-block parameter; anything else is stored as raw
+ * float32.
+ */
+
+#ifndef SSTV_TRACE_H
+#define SSTV_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TRACE_MAGIC "SSTVTRC1"
+#define TRACE_VERSION 1
+
+/* Record types */
+enum {
+    TRACE_REC_CONFIG = 1,
+    TRACE_REC_CALL   = 2,
+    TRACE_REC_FEED   = 3,
+    TRACE_REC_CHECK  = 4
+};
+
+/* API calls that change decoder behaviour */
+enum {
+    TRACE_CALL_RESET       = 1,
+    TRACE_CALL_MODE_HINT   = 2,
+    TRACE_CALL_VIS_ENABLED = 3,
+    TRACE_CALL_AGC_MODE    = 4,
+    TRACE_CALL_VIS_TONES   = 5,
+    TRACE_CALL_DEMOD       = 6,
+    TRACE_CALL_SENSE       = 7,
+    TRACE_CALL_AGC_TIMING  = 8
+};
+
+/* Sample block codecs */
+enum {
+    TRACE_CODEC_F32    = 0,
+    TRACE_CODEC_RICE16 = 1
+};
+
+typedef struct {
+    double sample_rate;
+    int32_t vis_enabled;
+    int32_t mode_hint;
+    int32_t agc_mode;
+    double vis_mark_hz;
+    double vis_space_hz;
+    uint32_t check_interval;     /* Samples between state checksums */
+} trace_config_t;
+
+typedef struct {
+    uint32_t op;                 /* TRACE_CALL_* */
+    int32_t arg;                 /* Integer argument */
+    double a, b;                 /* Floating-point arguments */
+} trace_call_t;
+
+typedef struct {
+    uint64_t index;              /* Feed call number (0-based) */
+    uint64_t first_sample;       /* Stream position of samples[0] */
+    uint64_t arrival_ns;         /* Wall time since trace start */
+    uint64_t proc_ns;            /* Time spent inside the feed call */
+    int32_t status;              /* sstv_rx_status_t returned */
+    uint32_t count;              /* Samples in the block */
+} trace_feed_t;
+
+typedef struct {
+    uint64_t sample_pos;         /* Stream position the checksum refers to */
+    uint64_t checksum;           /* sstv_decoder_get_checksum() */
+} trace_check_t;
+
+typedef struct {
+    int type;                    /* TRACE_REC_*, 0 at end of file */
+    trace_call_t call;
+    trace_feed_t feed;
+    trace_check_t check;
+    const float *samples;        /* Feed samples (valid until the next read) */
+} trace_record_t;
+
+/* === WRITER === */
+typedef struct {
+    FILE *fp;
+    uint8_t *buf;                /* Scratch for encoded blocks */
+    size_t buf_cap;
+    int err;
+} trace_writer_t;
+
+int trace_writer_open(trace_writer_t *w, const char *path, const trace_config_t *cfg);
+void trace_write_call(trace_writer_t *w, const trace_call_t *call);
+void trace_write_feed(trace_writer_t *w, const trace_feed_t *feed, const float *samples);
+void trace_write_check(trace_writer_t *w, const trace_check_t *check);
+int trace_writer_close(trace_writer_t *w);
+
+/* === READER === */
+typedef struct {
+    FILE *fp;
+    uint8_t *buf;
+    size_t buf_cap;
+    float *samples;
+    size_t samples_cap;
+} trace_reader_t;
+
+int trace_reader_open(trace_reader_t *r, const char *path, trace_config_t *cfg);
+/* Returns 1 with a record, 0 at end of file, -1 on a corrupt trace */
+int trace_read(trace_reader_t *r, trace_record_t *rec);
+void trace_reader_close(trace_reader_t *r);
+
+/* === BLOCK CODEC === */
+/* Worst-case encoded size for n samples */
+size_t trace_block_bound(size_t n);
+/* Encode n samples; returns encoded bytes (codec byte included) */
+size_t trace_encode_block(const float *x, size_t n, uint8_t *out);
+/* Decode a block of n samples; returns 0 on success, -1 if malformed */
+int trace_decode_block(const uint8_t *in, size_t len, float *x, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SSTV_TRACE_H */
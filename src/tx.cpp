@@ -0,0 +1,180 @@
+/*
+ * Pull-model transmit adapter - encoder on a producer thread behind an
+ * SPSC ring
+ *
+ * head and tail are free-running frame counters; the producer alone
+ * writes head, the reader alone writes tail, and each publishes with a
+ * release store that the other side reads with acquire. The producer
+ * generates straight into the ring (at most two contiguous pieces per
+ * refill) and sleeps an eighth of the latency budget between refills,
+ * so the reader never has to wake it and a reader running a few times
+ * faster than real time still finds the ring more than half full.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "sstv_tx.h"
+
+/* Smallest refill worth waking up for */
+#define TX_MIN_REFILL 64
+
+struct sstv_tx_s {
+    sstv_encoder_t *enc;
+    float *ring;
+    uint32_t capacity;           /* Power of two */
+    uint32_t mask;
+    uint32_t target;             /* Fill the producer aims for */
+    std::chrono::microseconds nap;
+
+    std::atomic<uint64_t> head;  /* Frames written (producer) */
+    std::atomic<uint64_t> tail;  /* Frames read (reader) */
+    std::atomic<int> done;       /* Encoder finished, head final */
+    std::atomic<int> quit;
+    int started;
+    std::thread producer;
+
+    /* Reader-side counters, published for sstv_tx_get_stats */
+    std::atomic<uint64_t> underruns;
+    std::atomic<uint64_t> underrun_frames;
+    std::atomic<uint32_t> min_fill;
+};
+
+/* Producer side: top the ring up to the target; 0 once the encoder is done */
+static int tx_refill(sstv_tx_t *tx) {
+    uint64_t head = tx->head.load(std::memory_order_relaxed);
+    uint64_t tail = tx->tail.load(std::memory_order_acquire);
+    uint32_t fill = (uint32_t)(head - tail);
+    if (fill + TX_MIN_REFILL > tx->target) return 1;
+
+    uint32_t want = tx->target - fill;
+    while (want > 0) {
+        if (sstv_encoder_is_complete(tx->enc)) {
+            tx->done.store(1, std::memory_order_release);
+            return 0;
+        }
+        uint32_t pos = (uint32_t)head & tx->mask;
+        uint32_t run = tx->capacity - pos;            /* Contiguous space */
+        if (run > want) run = want;
+        size_t n = sstv_encoder_generate(tx->enc, tx->ring + pos, run);
+        if (n == 0) {
+            tx->done.store(1, std::memory_order_release);
+            return 0;
+        }
+        head += n;
+        want -= (uint32_t)n;
+        tx->head.store(head, std::memory_order_release);
+    }
+    return 1;
+}
+
+static void tx_producer(sstv_tx_t *tx) {
+    while (!tx->quit.load(std::memory_order_relaxed)) {
+        if (!tx_refill(tx)) break;
+        std::this_thread::sleep_for(tx->nap);
+    }
+}
+
+sstv_tx_t* sstv_tx_create(sstv_encoder_t *enc, double sample_rate, double latency_ms) {
+    if (!enc || sample_rate <= 0.0 || latency_ms < 1.0 || latency_ms > 2000.0) return NULL;
+    uint32_t target = (uint32_t)(sample_rate * latency_ms / 1000.0 + 0.5);
+    if (target < 2 * TX_MIN_REFILL) target = 2 * TX_MIN_REFILL;
+    uint32_t capacity = 1;
+    while (capacity < target) capacity <<= 1;
+
+    float *ring = (float*)calloc(capacity, sizeof(float));
+    if (!ring) return NULL;
+    sstv_tx_t *tx = new sstv_tx_t();
+    tx->enc = enc;
+    tx->ring = ring;
+    tx->capacity = capacity;
+    tx->mask = capacity - 1;
+    tx->target = target;
+    long long nap_us = (long long)(latency_ms * 1000.0 / 8.0);
+    if (nap_us < 1000) nap_us = 1000;
+    if (nap_us > 20000) nap_us = 20000;
+    tx->nap = std::chrono::microseconds(nap_us);
+    tx->head = 0;
+    tx->tail = 0;
+    tx->done = 0;
+    tx->quit = 0;
+    tx->started = 0;
+    tx->underruns = 0;
+    tx->underrun_frames = 0;
+    tx->min_fill = capacity;
+    return tx;
+}
+
+int sstv_tx_start(sstv_tx_t *tx) {
+    if (!tx || tx->started) return -1;
+    tx_refill(tx);
+    if (!tx->done.load(std::memory_order_relaxed)) {
+        try {
+            tx->producer = std::thread(tx_producer, tx);
+        } catch (...) {
+            return -1;
+        }
+    }
+    tx->started = 1;
+    return 0;
+}
+
+size_t sstv_tx_pull(sstv_tx_t *tx, float *out, size_t frames) {
+    if (!tx || !out || frames == 0) return 0;
+    /* Read done before head: if done is set, head is already final */
+    int done = tx->done.load(std::memory_order_acquire);
+    uint64_t head = tx->head.load(std::memory_order_acquire);
+    uint64_t tail = tx->tail.load(std::memory_order_relaxed);
+    uint32_t fill = (uint32_t)(head - tail);
+    if (tx->started && fill < tx->min_fill.load(std::memory_order_relaxed)) {
+        tx->min_fill.store(fill, std::memory_order_relaxed);
+    }
+
+    size_t n = frames < fill ? frames : fill;
+    uint32_t pos = (uint32_t)tail & tx->mask;
+    size_t first = tx->capacity - pos;
+    if (first > n) first = n;
+    memcpy(out, tx->ring + pos, first * sizeof(float));
+    memcpy(out + first, tx->ring, (n - first) * sizeof(float));
+    tx->tail.store(tail + n, std::memory_order_release);
+
+    if (n < frames) {
+        memset(out + n, 0, (frames - n) * sizeof(float));
+        if (!done) {
+            tx->underruns.fetch_add(1, std::memory_order_relaxed);
+            tx->underrun_frames.fetch_add(frames - n, std::memory_order_relaxed);
+        }
+    }
+    return n;
+}
+
+int sstv_tx_is_done(const sstv_tx_t *tx) {
+    if (!tx) return 0;
+    int done = tx->done.load(std::memory_order_acquire);
+    return done && tx->head.load(std::memory_order_acquire) ==
+                   tx->tail.load(std::memory_order_acquire);
+}
+
+int sstv_tx_get_stats(const sstv_tx_t *tx, sstv_tx_stats_t *stats) {
+    if (!tx || !stats) return -1;
+    memset(stats, 0, sizeof(*stats));
+    stats->frames_generated = tx->head.load(std::memory_order_acquire);
+    stats->frames_pulled = tx->tail.load(std::memory_order_acquire);
+    stats->underruns = tx->underruns.load(std::memory_order_relaxed);
+    stats->underrun_frames = tx->underrun_frames.load(std::memory_order_relaxed);
+    stats->capacity = tx->capacity;
+    stats->min_fill = tx->min_fill.load(std::memory_order_relaxed);
+    stats->complete = sstv_tx_is_done(tx);
+    return 0;
+}
+
+void sstv_tx_free(sstv_tx_t *tx) {
+    if (!tx) return;
+    tx->quit.store(1, std::memory_order_relaxed);
+    if (tx->producer.joinable()) tx->producer.join();
+    free(tx->ring);
+    delete tx;
+}
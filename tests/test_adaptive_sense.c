@@ -0,0 +1,162 @@
+/*
+ * Noise-adaptive acquisition threshold test
+ *
+ * Tests:
+ *   1. Three minutes of white noise: the fixed MMSSTV levels start many
+ *      phantom acquisitions, the adaptive levels almost none, and the
+ *      counters agree with each other
+ *   2. Robot 36 after a minute of noise, with the noise kept running under
+ *      it: the adaptive decoder still locks the VIS code
+ *   3. A clean frame decodes to the same pixels with and without adaptive
+ *      levels; argument errors are caught and reset clears the counters
+ *
+ * Build: make test_adaptive_sense
+ * Run: ./bin/test_adaptive_sense
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sstv_decoder.h"
+#include "sstv_encoder.h"
+#include "test_signal.h"
+
+#define SAMPLE_RATE 11025.0
+#define TEST_MODE SSTV_R36
+#define CHUNK 4096
+
+/* `lead_sec` of noise, then a gradient frame, all with noise of noise_rms */
+static float* make_signal(double lead_sec, int with_frame, double noise_rms, size_t *count) {
+    size_t lead = (size_t)(lead_sec * SAMPLE_RATE);
+    float *samples;
+    if (with_frame) {
+        samples = encode_frame_padded(TEST_MODE, SAMPLE_RATE, pixel_gradient, lead,
+                                      (size_t)SAMPLE_RATE, count);
+    } else {
+        samples = (float*)calloc(lead, sizeof(float));
+        *count = lead;
+    }
+    add_awgn(samples, *count, 4242, noise_rms);
+    return samples;
+}
+
+/* Feed everything (or up to the first finished image) */
+static sstv_decoder_t* decode(const float *samples, size_t count, double rate, int stop_at_image) {
+    sstv_decoder_t *dec = sstv_decoder_create(SAMPLE_RATE);
+    if (!dec || sstv_decoder_set_false_alarm_rate(dec, rate) != 0) {
+        sstv_decoder_free(dec);
+        return NULL;
+    }
+    for (size_t pos = 0; pos < count; pos += CHUNK) {
+        size_t n = count - pos < CHUNK ? count - pos : CHUNK;
+        if (sstv_decoder_feed(dec, samples + pos, n) == SSTV_RX_IMAGE_READY && stop_at_image) break;
+    }
+    return dec;
+}
+
+static int test_noise_only(void) {
+    printf("TEST 1: White noise starts far fewer acquisitions with adaptive levels\n");
+    size_t count = 0;
+    float *noise = make_signal(180.0, 0, 4000.0, &count);
+    sstv_decoder_t *fixed = noise ? decode(noise, count, 0.0, 0) : NULL;
+    sstv_decoder_t *adapt = noise ? decode(noise, count, 6.0, 0) : NULL;
+    sstv_sense_stats_t f, a;
+    int ok = fixed && adapt &&
+             sstv_decoder_get_sense_stats(fixed, &f) == 0 &&
+             sstv_decoder_get_sense_stats(adapt, &a) == 0;
+    if (ok) {
+        printf("  fixed:    %llu triggers, %llu VIS attempts, %llu false starts, level %.0f\n",
+               (unsigned long long)f.triggers, (unsigned long long)f.vis_attempts,
+               (unsigned long long)f.false_starts, f.sync_level);
+        printf("  adaptive: %llu triggers, %llu VIS attempts, %llu false starts, "
+               "floor %.0f, level %.0f/%.0f, k %.2f\n",
+               (unsigned long long)a.triggers, (unsigned long long)a.vis_attempts,
+               (unsigned long long)a.false_starts, a.noise_floor, a.sync_level,
+               a.hold_level, a.k);
+        ok = f.false_starts >= 20 && a.false_starts * 10 <= f.false_starts &&
+             f.vis_locks == 0 && a.vis_locks == 0 &&
+             f.false_starts == f.triggers && a.false_starts == a.triggers &&
+             f.vis_attempts <= f.triggers && a.vis_attempts <= a.triggers &&
+             a.noise_floor > 0.0 && a.sync_level > a.hold_level &&
+             a.hold_level > a.noise_floor && f.noise_floor == 0.0;
+    }
+    sstv_decoder_free(fixed);
+    sstv_decoder_free(adapt);
+    free(noise);
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+static int test_noisy_frame(void) {
+    printf("TEST 2: Robot 36 under noise still locks after a minute of noise\n");
+    size_t count = 0;
+    float *samples = make_signal(60.0, 1, 8000.0, &count);
+    sstv_decoder_t *dec = samples ? decode(samples, count, 6.0, 1) : NULL;
+    sstv_sense_stats_t st;
+    sstv_decoder_state_t state;
+    int ok = dec && sstv_decoder_get_sense_stats(dec, &st) == 0 &&
+             sstv_decoder_get_state(dec, &state) == 0;
+    if (ok) {
+        printf("  mode %d, %llu locks, %llu false starts, level %.0f\n",
+               (int)state.current_mode, (unsigned long long)st.vis_locks,
+               (unsigned long long)st.false_starts, st.sync_level);
+        ok = st.vis_locks == 1 && state.current_mode == TEST_MODE &&
+             st.triggers == st.false_starts + st.vis_locks;
+    }
+    sstv_decoder_free(dec);
+    free(samples);
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+static int test_clean_and_api(void) {
+    printf("TEST 3: Clean frame unchanged by adaptive levels; arguments and reset\n");
+    size_t count = 0;
+    float *samples = make_signal(1.0, 1, 0.0, &count);
+    sstv_decoder_t *fixed = samples ? decode(samples, count, 0.0, 1) : NULL;
+    sstv_decoder_t *adapt = samples ? decode(samples, count, 6.0, 1) : NULL;
+    sstv_image_t fi, ai;
+    memset(&fi, 0, sizeof(fi));
+    memset(&ai, 0, sizeof(ai));
+    int ok = fixed && adapt &&
+             sstv_decoder_get_image(fixed, &fi) == 0 &&
+             sstv_decoder_get_image(adapt, &ai) == 0 &&
+             fi.width == ai.width && fi.height == ai.height &&
+             memcmp(fi.pixels, ai.pixels, (size_t)fi.width * fi.height * 3) == 0;
+
+    sstv_sense_stats_t st;
+    ok = ok && sstv_decoder_get_sense_stats(adapt, &st) == 0 &&
+         st.vis_locks == 1 && st.false_starts == 0;
+    sstv_decoder_reset(adapt);
+    ok = ok && sstv_decoder_get_sense_stats(adapt, &st) == 0 &&
+         st.triggers == 0 && st.vis_locks == 0 && st.noise_floor == 0.0;
+
+    ok = ok && sstv_decoder_set_false_alarm_rate(adapt, -1.0) == -1 &&
+         sstv_decoder_set_false_alarm_rate(adapt, 4000.0) == -1 &&
+         sstv_decoder_set_false_alarm_rate(adapt, NAN) == -1 &&
+         sstv_decoder_set_false_alarm_rate(NULL, 6.0) == -1 &&
+         sstv_decoder_get_sense_stats(NULL, &st) == -1 &&
+         sstv_decoder_get_sense_stats(adapt, NULL) == -1;
+
+    sstv_decoder_free(fixed);
+    sstv_decoder_free(adapt);
+    free(samples);
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+int main(void) {
+    printf("=== Adaptive Sense Tests ===\n\n");
+
+    int passed = 0;
+    int total = 0;
+
+    total++; passed += test_noise_only();
+    total++; passed += test_noisy_frame();
+    total++; passed += test_clean_and_api();
+
+    printf("\n=== Results: %d/%d passed ===\n", passed, total);
+    return (passed == total) ? 0 : 1;
+}
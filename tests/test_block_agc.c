@@ -0,0 +1,236 @@
+/*
+ * Lookahead block AGC test
+ *
+ * Tests:
+ *   1. A 1900 Hz tone jumping up 20 dB never overshoots the AGC target
+ *      (the gain is down before the loud part arrives), and after dropping
+ *      20 dB the level recovers in small steps rather than one jump
+ *   2. The AGC output lags the band-passed input by the lookahead rounded
+ *      up to whole blocks, for the default and a configured lookahead, and
+ *      reset keeps the setting
+ *   3. Robot 36 with a 20 dB level step in the middle of the image decodes
+ *      close to the constant-level frame; argument errors are caught
+ *
+ * Build: make test_block_agc
+ * Run: ./bin/test_block_agc
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sstv_decoder.h"
+#include "sstv_encoder.h"
+#include "test_signal.h"
+
+#define SAMPLE_RATE 11025.0
+#define CHUNK 4096
+#define AGC_TARGET 16384.0
+#define BLOCK 16
+
+static const char *kBpfPath = "test_block_agc_bpf.wav";
+static const char *kAgcPath = "test_block_agc_agc.wav";
+
+/* 1900 Hz tone starting at full amplitude, level scaled per segment */
+static float* make_tone(size_t count, const size_t *edges, const double *levels, int segments) {
+    float *s = (float*)calloc(count, sizeof(float));
+    if (!s) return NULL;
+    int seg = 0;
+    for (size_t i = 0; i < count; i++) {
+        while (seg + 1 < segments && i >= edges[seg + 1]) seg++;
+        if (i < edges[0]) continue;
+        s[i] = (float)(levels[seg] * cos(2.0 * M_PI * 1900.0 * (double)(i - edges[0]) / SAMPLE_RATE));
+    }
+    return s;
+}
+
+/* Run samples through a decoder, capturing the after-BPF and after-AGC
+ * signals; returns the number of samples read back into bpf/agc */
+static size_t capture(sstv_decoder_t *dec, const float *s, size_t count, short *bpf, short *agc) {
+    if (sstv_decoder_enable_debug_wav(dec, NULL, kBpfPath, kAgcPath, NULL) != 0) return 0;
+    for (size_t pos = 0; pos < count; pos += CHUNK) {
+        size_t n = count - pos < CHUNK ? count - pos : CHUNK;
+        sstv_decoder_feed(dec, s + pos, n);
+    }
+    sstv_decoder_disable_debug_wav(dec);
+
+    size_t got = count;
+    const char *paths[2] = { kBpfPath, kAgcPath };
+    short *dst[2] = { bpf, agc };
+    for (int f = 0; f < 2; f++) {
+        FILE *fp = fopen(paths[f], "rb");
+        size_t n = 0;
+        if (fp && fseek(fp, 44, SEEK_SET) == 0) {
+            n = fread(dst[f], sizeof(short), count, fp);
+        }
+        if (fp) fclose(fp);
+        remove(paths[f]);
+        if (n < got) got = n;
+    }
+    return got;
+}
+
+static double block_peak(const short *x, size_t start) {
+    double m = 0.0;
+    for (size_t i = start; i < start + BLOCK; i++) {
+        double v = fabs((double)x[i]);
+        if (v > m) m = v;
+    }
+    return m;
+}
+
+static int test_steps(void) {
+    printf("TEST 1: 20 dB steps: no overshoot going up, gradual recovery going down\n");
+    size_t count = (size_t)(SAMPLE_RATE * 1.5);
+    size_t up = (size_t)(SAMPLE_RATE * 0.5), down = (size_t)(SAMPLE_RATE * 0.8);
+    size_t edges[3] = { 100, up, down };
+    double levels[3] = { TEST_AMPLITUDE * 0.1, TEST_AMPLITUDE, TEST_AMPLITUDE * 0.1 };
+    float *s = make_tone(count, edges, levels, 3);
+    short *bpf = (short*)malloc(count * sizeof(short));
+    short *agc = (short*)malloc(count * sizeof(short));
+    sstv_decoder_t *dec = sstv_decoder_create(SAMPLE_RATE);
+    size_t n = (s && bpf && agc && dec) ? capture(dec, s, count, bpf, agc) : 0;
+
+    int ok = n == count;
+    double over = 0.0, jump = 1.0, settled = 0.0;
+    if (ok) {
+        /* Loud part arriving: the output must stay at or below the target */
+        for (size_t i = up - 2000; i < up + 2000; i++) {
+            double v = fabs((double)agc[i]);
+            if (v > over) over = v;
+        }
+        /* After the drop: block-to-block growth while the gain recovers */
+        size_t from = down + 200;
+        for (size_t b = from; b + 2 * BLOCK < down + 3000; b += BLOCK) {
+            double p0 = block_peak(agc, b), p1 = block_peak(agc, b + BLOCK);
+            if (p0 > 0.0 && p1 / p0 > jump) jump = p1 / p0;
+        }
+        settled = block_peak(agc, down + (size_t)(SAMPLE_RATE * 0.4));
+        printf("  peak near step up %.0f (target %.0f), largest block step %.2fx, "
+               "level 400 ms after drop %.0f\n", over, AGC_TARGET, jump, settled);
+        ok = over <= AGC_TARGET * 1.05 && over >= AGC_TARGET * 0.8 &&
+             jump < 1.25 && settled > AGC_TARGET * 0.9 && settled <= AGC_TARGET * 1.05;
+    }
+    sstv_decoder_free(dec);
+    free(s);
+    free(bpf);
+    free(agc);
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+/* Samples between the first non-zero band-passed and AGC output samples */
+static long onset_lag(sstv_decoder_t *dec) {
+    size_t count = 4000;
+    size_t edges[1] = { 1000 };
+    double levels[1] = { TEST_AMPLITUDE };
+    float *s = make_tone(count, edges, levels, 1);
+    short *bpf = (short*)malloc(count * sizeof(short));
+    short *agc = (short*)malloc(count * sizeof(short));
+    long lag = -1;
+    size_t n = (s && bpf && agc) ? capture(dec, s, count, bpf, agc) : 0;
+    if (n == count) {
+        size_t a = 0, b = 0;
+        while (a < n && bpf[a] == 0) a++;
+        while (b < n && agc[b] == 0) b++;
+        if (a < n && b < n) lag = (long)b - (long)a;
+    }
+    free(s);
+    free(bpf);
+    free(agc);
+    return lag;
+}
+
+static int test_lookahead(void) {
+    printf("TEST 2: AGC output lags by the lookahead in whole blocks\n");
+    sstv_decoder_t *dec = sstv_decoder_create(SAMPLE_RATE);
+    long def = dec ? onset_lag(dec) : -1;
+    long custom = -1, after_reset = -1;
+    if (dec && sstv_decoder_set_agc_timing(dec, 10.0, 2.0, 200.0) == 0) {
+        sstv_decoder_reset(dec);
+        custom = onset_lag(dec);
+        sstv_decoder_reset(dec);
+        after_reset = onset_lag(dec);
+    }
+    /* 5 ms = 55.1 samples -> 4 blocks; 10 ms = 110.3 samples -> 7 blocks */
+    printf("  default lag %ld, 10 ms lag %ld, after reset %ld\n", def, custom, after_reset);
+    int ok = def == 4 * BLOCK && custom == 7 * BLOCK && after_reset == custom;
+    sstv_decoder_free(dec);
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+/* Robot 36 gradient frame, optionally 20 dB quieter from halfway on */
+static float* make_frame(int step, size_t *count) {
+    size_t lead = (size_t)(SAMPLE_RATE * 0.5);
+    size_t tail = (size_t)SAMPLE_RATE;
+    float *s = encode_frame_padded(SSTV_R36, SAMPLE_RATE, pixel_gradient, lead, tail, count);
+    if (!s || !step) return s;
+    size_t body = *count - lead - tail;
+    for (size_t i = lead + body / 2 + 1; i < *count; i++) s[i] *= 0.1f;
+    return s;
+}
+
+static sstv_decoder_t* decode(const float *s, size_t count) {
+    sstv_decoder_t *dec = sstv_decoder_create(SAMPLE_RATE);
+    for (size_t pos = 0; dec && pos < count; pos += CHUNK) {
+        size_t n = count - pos < CHUNK ? count - pos : CHUNK;
+        if (sstv_decoder_feed(dec, s + pos, n) == SSTV_RX_IMAGE_READY) break;
+    }
+    return dec;
+}
+
+static int test_level_step_frame(void) {
+    printf("TEST 3: Robot 36 with a 20 dB drop mid-image; arguments\n");
+    size_t nc = 0, ns = 0;
+    float *constant = make_frame(0, &nc);
+    float *stepped = make_frame(1, &ns);
+    sstv_decoder_t *a = constant ? decode(constant, nc) : NULL;
+    sstv_decoder_t *b = stepped ? decode(stepped, ns) : NULL;
+    sstv_image_t ia, ib;
+    memset(&ia, 0, sizeof(ia));
+    memset(&ib, 0, sizeof(ib));
+    int ok = a && b && sstv_decoder_get_image(a, &ia) == 0 && sstv_decoder_get_image(b, &ib) == 0 &&
+             ia.width == ib.width && ia.height == ib.height && ia.stride == ib.stride;
+    if (ok) {
+        double err = 0.0;
+        size_t bytes = (size_t)ia.stride * ia.height;
+        for (size_t i = 0; i < bytes; i++) {
+            err += fabs((double)ia.pixels[i] - (double)ib.pixels[i]);
+        }
+        err /= (double)bytes;
+        printf("  mean difference %.2f levels\n", err);
+        ok = err < 2.0;
+    }
+
+    ok = ok && sstv_decoder_set_agc_timing(NULL, 5.0, 1.0, 100.0) == -1 &&
+         sstv_decoder_set_agc_timing(a, 0.0, 1.0, 100.0) == -1 &&
+         sstv_decoder_set_agc_timing(a, 25.0, 1.0, 100.0) == -1 &&
+         sstv_decoder_set_agc_timing(a, 5.0, 0.0, 100.0) == -1 &&
+         sstv_decoder_set_agc_timing(a, 5.0, 1.0, -1.0) == -1 &&
+         sstv_decoder_set_agc_timing(a, NAN, 1.0, 100.0) == -1 &&
+         sstv_decoder_set_agc_timing(a, 5.0, 1.0, 20000.0) == -1 &&
+         sstv_decoder_set_agc_timing(a, 20.0, 0.5, 1000.0) == 0;
+
+    sstv_decoder_free(a);
+    sstv_decoder_free(b);
+    free(constant);
+    free(stepped);
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+int main(void) {
+    printf("=== Block AGC Tests ===\n\n");
+
+    int passed = 0;
+    int total = 0;
+
+    total++; passed += test_steps();
+    total++; passed += test_lookahead();
+    total++; passed += test_level_step_frame();
+
+    printf("\n=== Results: %d/%d passed ===\n", passed, total);
+    return (passed == total) ? 0 : 1;
+}
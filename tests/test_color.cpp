@@ -0,0 +1,197 @@
+/*
+ * Y/R-Y/B-Y colour conversion test
+ *
+ * Tests:
+ *   1. RGB24 rows convert bit-identically to the encoder's original
+ *      per-pixel transform for all 2^24 colours, at row widths with and
+ *      without a SIMD tail; the grayscale table matches R = G = B
+ *   2. Y/R-Y/B-Y rows convert back to within one level of the
+ *      double-precision inverse for all 2^24 inputs; half-rate chroma, line
+ *      pairs and the luminance-only table agree with the full-rate kernel
+ *   3. RGB -> YC -> RGB stays within a few levels over all colours
+ *
+ * Build: make test_color
+ * Run: ./bin/test_color
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+#include "color.h"
+
+/* The encoder's transform as it stood before the row kernels */
+static void ref_get_ry(int r, int g, int b, int &y, int &ry, int &by) {
+    double R = r;
+    double G = g;
+    double B = b;
+    y = (int)(16.0 + (0.256773 * R + 0.504097 * G + 0.097900 * B));
+    ry = (int)(128.0 + (0.439187 * R - 0.367766 * G - 0.071421 * B));
+    by = (int)(128.0 + (-0.148213 * R - 0.290974 * G + 0.439187 * B));
+    y = y < 0 ? 0 : (y > 255 ? 255 : y);
+    ry = ry < 0 ? 0 : (ry > 255 ? 255 : ry);
+    by = by < 0 ? 0 : (by > 255 ? 255 : by);
+}
+
+/* MMSSTV YCtoRGB, rounded instead of truncated */
+static void ref_yc_to_rgb(int y, int ry, int by, double *rgb) {
+    double Y = y - 16.0, V = ry - 128.0, U = by - 128.0;
+    rgb[0] = 1.164457 * Y + 1.596128 * V;
+    rgb[1] = 1.164457 * Y - 0.813022 * V - 0.391786 * U;
+    rgb[2] = 1.164457 * Y + 2.017364 * U;
+    for (int c = 0; c < 3; c++) {
+        rgb[c] = rgb[c] < 0.0 ? 0.0 : (rgb[c] > 255.0 ? 255.0 : rgb[c]);
+    }
+}
+
+static int test_tx_parity(void) {
+    printf("TEST 1: RGB24 -> Y/R-Y/B-Y matches the original transform exactly\n");
+    const size_t widths[] = { 256, 255, 3, 1 };
+    size_t mismatches = 0;
+    std::vector<uint8_t> rgb(256 * 3), y(256), ry(256), by(256);
+    for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+        size_t width = widths[w];
+        /* Every colour once at full width; the short rows sample the cube */
+        int step = width == 256 ? 1 : 17;
+        for (int r = 0; r < 256; r += step) {
+            for (int g = 0; g < 256; g += step) {
+                for (size_t b = 0; b < width; b++) {
+                    rgb[b * 3 + 0] = (uint8_t)r;
+                    rgb[b * 3 + 1] = (uint8_t)g;
+                    rgb[b * 3 + 2] = (uint8_t)(255 - b);
+                }
+                sstv_color_rgb24_to_yc(rgb.data(), width, y.data(), ry.data(), by.data());
+                for (size_t b = 0; b < width; b++) {
+                    int ey, er, eb;
+                    ref_get_ry(r, g, (int)(255 - b), ey, er, eb);
+                    if (y[b] != ey || ry[b] != er || by[b] != eb) mismatches++;
+                }
+            }
+        }
+    }
+
+    std::vector<uint8_t> gray(256);
+    for (int v = 0; v < 256; v++) gray[v] = (uint8_t)v;
+    sstv_color_gray_to_yc(gray.data(), 256, y.data(), ry.data(), by.data());
+    size_t gray_mismatches = 0;
+    for (int v = 0; v < 256; v++) {
+        int ey, er, eb;
+        ref_get_ry(v, v, v, ey, er, eb);
+        if (y[v] != ey || ry[v] != er || by[v] != eb) gray_mismatches++;
+    }
+    printf("  %zu RGB mismatches, %zu grayscale mismatches (gray 240 R-Y %d)\n",
+           mismatches, gray_mismatches, ry[240]);
+    int ok = mismatches == 0 && gray_mismatches == 0;
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+static int test_rx(void) {
+    printf("TEST 2: Y/R-Y/B-Y -> RGB24 within one level; 4:2:2, pairs, luminance only\n");
+    std::vector<uint8_t> y(256), ry(256), by(256), rgb(256 * 3);
+    double worst = 0.0;
+    for (int v = 0; v < 256; v++) {
+        for (int u = 0; u < 256; u++) {
+            for (int k = 0; k < 256; k++) {
+                y[k] = (uint8_t)k;
+                ry[k] = (uint8_t)v;
+                by[k] = (uint8_t)u;
+            }
+            sstv_color_yc_to_rgb24(y.data(), ry.data(), by.data(), 256, 0, rgb.data());
+            for (int k = 0; k < 256; k++) {
+                double e[3];
+                ref_yc_to_rgb(k, v, u, e);
+                for (int c = 0; c < 3; c++) {
+                    double d = fabs((double)rgb[k * 3 + c] - e[c]);
+                    if (d > worst) worst = d;
+                }
+            }
+        }
+    }
+
+    /* Half-rate chroma against the same chroma doubled up, odd width */
+    const size_t width = 320 + 5;
+    const size_t cw = (width + 1) / 2;
+    std::vector<uint8_t> y0(width), y1(width), cr(cw), cb(cw), wide_r(width), wide_b(width);
+    std::vector<uint8_t> half(width * 3), full(width * 3), pair0(width * 3), pair1(width * 3);
+    uint32_t seed = 12345;
+    for (size_t x = 0; x < width; x++) {
+        seed = seed * 1664525u + 1013904223u;
+        y0[x] = (uint8_t)(seed >> 24);
+        y1[x] = (uint8_t)(seed >> 16);
+    }
+    for (size_t x = 0; x < cw; x++) {
+        seed = seed * 1664525u + 1013904223u;
+        cr[x] = (uint8_t)(seed >> 24);
+        cb[x] = (uint8_t)(seed >> 16);
+    }
+    for (size_t x = 0; x < width; x++) {
+        wide_r[x] = cr[x / 2];
+        wide_b[x] = cb[x / 2];
+    }
+    sstv_color_yc_to_rgb24(y0.data(), cr.data(), cb.data(), width, 1, half.data());
+    sstv_color_yc_to_rgb24(y0.data(), wide_r.data(), wide_b.data(), width, 0, full.data());
+    int half_ok = memcmp(half.data(), full.data(), width * 3) == 0;
+
+    sstv_color_yc_pair_to_rgb24(y0.data(), y1.data(), wide_r.data(), wide_b.data(), width, 0,
+                                pair0.data(), pair1.data());
+    sstv_color_yc_to_rgb24(y1.data(), wide_r.data(), wide_b.data(), width, 0, full.data());
+    int pair_ok = memcmp(pair0.data(), half.data(), width * 3) == 0 &&
+                  memcmp(pair1.data(), full.data(), width * 3) == 0;
+
+    std::vector<uint8_t> neutral(width, 128);
+    sstv_color_y_to_rgb24(y0.data(), width, half.data());
+    sstv_color_yc_to_rgb24(y0.data(), neutral.data(), neutral.data(), width, 0, full.data());
+    int gray_ok = memcmp(half.data(), full.data(), width * 3) == 0;
+
+    printf("  worst error %.3f levels, 4:2:2 %d, line pair %d, luminance only %d\n",
+           worst, half_ok, pair_ok, gray_ok);
+    int ok = worst <= 1.0 && half_ok && pair_ok && gray_ok;
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+static int test_round_trip(void) {
+    printf("TEST 3: RGB -> Y/R-Y/B-Y -> RGB round trip\n");
+    std::vector<uint8_t> rgb(256 * 3), y(256), ry(256), by(256), back(256 * 3);
+    int worst = 0;
+    double sum = 0.0;
+    for (int r = 0; r < 256; r++) {
+        for (int g = 0; g < 256; g++) {
+            for (int b = 0; b < 256; b++) {
+                rgb[b * 3 + 0] = (uint8_t)r;
+                rgb[b * 3 + 1] = (uint8_t)g;
+                rgb[b * 3 + 2] = (uint8_t)b;
+            }
+            sstv_color_rgb24_to_yc(rgb.data(), 256, y.data(), ry.data(), by.data());
+            sstv_color_yc_to_rgb24(y.data(), ry.data(), by.data(), 256, 0, back.data());
+            for (int k = 0; k < 256 * 3; k++) {
+                int d = abs((int)back[k] - (int)rgb[k]);
+                if (d > worst) worst = d;
+                sum += d;
+            }
+        }
+    }
+    double mean = sum / (256.0 * 256.0 * 256.0 * 3.0);
+    printf("  worst %d levels, mean %.3f\n", worst, mean);
+    /* Truncation on TX costs up to a level per plane, amplified by the inverse */
+    int ok = worst <= 4 && mean < 1.5;
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+int main(void) {
+    printf("=== Colour Conversion Tests ===\n\n");
+
+    int passed = 0;
+    int total = 0;
+
+    total++; passed += test_tx_parity();
+    total++; passed += test_rx();
+    total++; passed += test_round_trip();
+
+    printf("\n=== Results: %d/%d passed ===\n", passed, total);
+    return (passed == total) ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+/*
+ * Multi-instance concurrency stress test
+ *
+ * Runs N encoder/decoder pairs on N threads at once and checks every
+ * result against a single-threaded run of the same job: encoded samples,
+ * decoder status, decoder state checksum and decoded pixels must be
+ * bit-identical. Distinct handles share no mutable state, so any
+ * difference (or a ThreadSanitizer report when built with
+ * -DENABLE_TSAN=ON) means state leaked out of a handle.
+ *
+ * Build: make test_concurrency
+ * Run: ./bin/test_concurrency [threads] [rounds]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include "sstv_encoder.h"
+#include "sstv_decoder.h"
+
+#define SAMPLE_RATE 22050.0
+#define CHUNK 1024
+
+/* Short modes from different families keep the run time reasonable */
+static const sstv_mode_t kModes[] = { SSTV_R36, SSTV_R24, SSTV_BW8, SSTV_BW12 };
+static const int kNumModes = (int)(sizeof(kModes) / sizeof(kModes[0]));
+
+struct job_result_t {
+    uint64_t audio_hash;        /* FNV-1a of encoded samples */
+    size_t audio_samples;
+    int status;                 /* Last decoder status */
+    uint64_t decoder_checksum;  /* sstv_decoder_get_checksum() at the end */
+    uint64_t image_hash;        /* FNV-1a of decoded pixels (0 if none) */
+    int ok;                     /* Job ran to completion */
+};
+
+static uint64_t fnv1a(uint64_t h, const void *p, size_t n) {
+    const uint8_t *b = static_cast<const uint8_t*>(p);
+    for (size_t i = 0; i < n; i++) {
+        h ^= b[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+/* Encode a per-job test pattern, then decode it with a fresh decoder */
+static void run_job(int job, job_result_t *res) {
+    std::memset(res, 0, sizeof(*res));
+    sstv_mode_t mode = kModes[job % kNumModes];
+    const sstv_mode_info_t *info = sstv_get_mode_info(mode);
+    if (!info) return;
+
+    std::vector<uint8_t> rgb(info->width * info->height * 3);
+    for (uint32_t y = 0; y < info->height; y++) {
+        for (uint32_t x = 0; x < info->width; x++) {
+            uint8_t *p = &rgb[(y * info->width + x) * 3];
+            p[0] = static_cast<uint8_t>((x * 7 + job * 31) & 0xff);
+            p[1] = static_cast<uint8_t>((y * 5 + job * 17) & 0xff);
+            p[2] = static_cast<uint8_t>(((x ^ y) + job) & 0xff);
+        }
+    }
+
+    sstv_image_t image = sstv_image_from_rgb(rgb.data(), info->width, info->height);
+    sstv_encoder_t *enc = sstv_encoder_create(mode, SAMPLE_RATE);
+    if (!enc || sstv_encoder_set_image(enc, &image) != 0) {
+        sstv_encoder_free(enc);
+        return;
+    }
+    sstv_encoder_set_vis_enabled(enc, 1);
+
+    size_t total = sstv_encoder_get_total_samples(enc) + static_cast<size_t>(SAMPLE_RATE);
+    std::vector<float> audio(total, 0.0f);
+    size_t n = 0;
+    while (!sstv_encoder_is_complete(enc) && n < total) {
+        size_t got = sstv_encoder_generate(enc, audio.data() + n, total - n);
+        if (got == 0) break;
+        n += got;
+    }
+    sstv_encoder_free(enc);
+
+    const float scale = 12000.0f + 1000.0f * static_cast<float>(job % 4);
+    for (size_t i = 0; i < total; i++) audio[i] *= scale;
+    res->audio_samples = total;
+    res->audio_hash = fnv1a(0xcbf29ce484222325ULL, audio.data(), total * sizeof(float));
+
+    sstv_decoder_t *dec = sstv_decoder_create(SAMPLE_RATE);
+    if (!dec) return;
+    sstv_rx_status_t st = SSTV_RX_NEED_MORE;
+    for (size_t pos = 0; pos < total; pos += CHUNK) {
+        size_t len = total - pos < CHUNK ? total - pos : CHUNK;
+        st = sstv_decoder_feed(dec, audio.data() + pos, len);
+        if (st == SSTV_RX_IMAGE_READY || st == SSTV_RX_ERROR) break;
+    }
+    res->status = static_cast<int>(st);
+    res->decoder_checksum = sstv_decoder_get_checksum(dec);
+
+    sstv_image_t out;
+    if (st == SSTV_RX_IMAGE_READY && sstv_decoder_get_image(dec, &out) == 0) {
+        res->image_hash = fnv1a(0xcbf29ce484222325ULL, out.pixels,
+                                static_cast<size_t>(out.stride) * out.height);
+    }
+    sstv_decoder_free(dec);
+    res->ok = 1;
+}
+
+static int same_result(const job_result_t &a, const job_result_t &b) {
+    return a.ok && b.ok && a.audio_hash == b.audio_hash &&
+           a.audio_samples == b.audio_samples && a.status == b.status &&
+           a.decoder_checksum == b.decoder_checksum && a.image_hash == b.image_hash;
+}
+
+int main(int argc, char **argv) {
+    int threads = argc > 1 ? std::atoi(argv[1]) : 4;
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 2;
+    if (threads < 1) threads = 1;
+    if (rounds < 1) rounds = 1;
+
+    std::printf("=== Concurrency Stress Test (%d threads, %d rounds) ===\n\n", threads, rounds);
+
+    /* Single-threaded reference */
+    std::vector<job_result_t> ref(threads);
+    for (int j = 0; j < threads; j++) {
+        run_job(j, &ref[j]);
+        if (!ref[j].ok) {
+            std::printf("FAIL: reference job %d did not run\n", j);
+            return 1;
+        }
+        std::printf("  job %d: %s, status=%d image=%016llx\n", j,
+                    sstv_get_mode_info(kModes[j % kNumModes])->name, ref[j].status,
+                    static_cast<unsigned long long>(ref[j].image_hash));
+    }
+
+    int images = 0;
+    for (int j = 0; j < threads; j++) images += (ref[j].status == SSTV_RX_IMAGE_READY);
+    if (images == 0) {
+        std::printf("FAIL: no reference job decoded an image\n");
+        return 1;
+    }
+
+    int failures = 0;
+    for (int r = 0; r < rounds; r++) {
+        std::vector<job_result_t> got(threads);
+        std::vector<std::thread> pool;
+        for (int j = 0; j < threads; j++) {
+            pool.push_back(std::thread(run_job, j, &got[j]));
+        }
+        for (auto &t : pool) t.join();
+
+        for (int j = 0; j < threads; j++) {
+            if (!same_result(ref[j], got[j])) {
+                std::printf("  FAIL: round %d job %d differs from single-threaded run\n", r, j);
+                failures++;
+            }
+        }
+        std::printf("TEST: round %d %s\n", r, failures ? "FAIL" : "PASS");
+    }
+
+    std::printf("\n=== Results: %s ===\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,210 @@
+/*
+ * C++17 API test (include/sstv.hpp)
+ *
+ * Tests:
+ *   1. Encoder::generate<float> writes exactly what the C API writes, and
+ *      the int16_t path is the same audio at full-scale PCM
+ *   2. Decoder::feed from float, int16_t and double gives bit-identical
+ *      decoder state and image
+ *   3. A lambda line callback keeps firing after the Decoder is moved
+ *      mid-frame, temporaries are rejected as callbacks, and handles are
+ *      move-only
+ *   4. image() borrows, image_copy() owns; empty handles fail cleanly
+ *
+ * Build: make test_cpp_api
+ * Run: ./bin/test_cpp_api
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "sstv.hpp"
+#include "test_signal.h"
+
+#define SAMPLE_RATE 11025.0
+#define TEST_MODE SSTV_R36
+
+static void pixel_pattern(uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t *p) {
+    p[0] = (uint8_t)(x * 255 / w);
+    p[1] = (uint8_t)(y * 255 / h);
+    p[2] = (uint8_t)((x ^ y) & 0xff);
+}
+
+static std::vector<uint8_t> test_pattern() {
+    const sstv_mode_info_t *info = sstv_get_mode_info(TEST_MODE);
+    uint8_t *rgb = make_image(TEST_MODE, pixel_pattern);
+    std::vector<uint8_t> v(rgb, rgb + (rgb ? (size_t)info->width * info->height * 3 : 0));
+    free(rgb);
+    return v;
+}
+
+static sstv::ImageView view_of(const std::vector<uint8_t> &rgb, uint32_t w, uint32_t h) {
+    return sstv::ImageView{sstv::span<const uint8_t>(rgb), w, h, w * 3, SSTV_RGB24};
+}
+
+/* Whole transmission through the C++ encoder, in chunks of 3000 */
+template <class SampleT>
+static std::vector<SampleT> encode_all(const std::vector<uint8_t> &rgb) {
+    const sstv_mode_info_t *info = sstv_get_mode_info(TEST_MODE);
+    sstv::Encoder enc = sstv::Encoder::create(TEST_MODE, SAMPLE_RATE);
+    enc.set_image(view_of(rgb, info->width, info->height));
+    enc.set_vis_enabled(true);
+    std::vector<SampleT> out(enc.total_samples() + 4096);
+    size_t n = 0;
+    while (!enc.complete() && n < out.size()) {
+        size_t got = enc.generate(sstv::span<SampleT>(out).subspan(n).first(3000));
+        if (got == 0) break;
+        n += got;
+    }
+    out.resize(n);
+    return out;
+}
+
+static int test_generate() {
+    printf("TEST 1: generate<float> matches the C API, int16_t is the same audio\n");
+    std::vector<uint8_t> rgb = test_pattern();
+
+    /* C API reference, at decoder scale */
+    size_t n = 0;
+    float *ref = encode_frame_padded(TEST_MODE, SAMPLE_RATE, pixel_pattern, 0, 0, &n);
+
+    std::vector<float> f = encode_all<float>(rgb);
+    std::vector<int16_t> s = encode_all<int16_t>(rgb);
+    int ok = ref && f.size() == n && s.size() == n;
+    int float_bad = 0, pcm_bad = 0;
+    for (size_t i = 0; ok && i < n; i++) {
+        if (f[i] * TEST_AMPLITUDE != ref[i]) float_bad++;
+        if (s[i] != (int16_t)std::lrintf(f[i] * 32767.0f)) pcm_bad++;
+    }
+    ok = ok && float_bad == 0 && pcm_bad == 0;
+    printf("  %zu samples, float %s, %d float mismatches, int16 mismatches %d\n", n,
+           f.size() == n ? "same length" : "length differs", float_bad, pcm_bad);
+    free(ref);
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+static int test_feed_types() {
+    printf("TEST 2: feed<float>, feed<int16_t> and feed<double> decode identically\n");
+    std::vector<uint8_t> rgb = test_pattern();
+    std::vector<int16_t> pcm = encode_all<int16_t>(rgb);
+    std::vector<float> f(pcm.begin(), pcm.end());
+    std::vector<double> d(pcm.begin(), pcm.end());
+
+    sstv::Decoder a = sstv::Decoder::create(SAMPLE_RATE);
+    sstv::Decoder b = sstv::Decoder::create(SAMPLE_RATE);
+    sstv::Decoder c = sstv::Decoder::create(SAMPLE_RATE);
+    sstv::Status sa = a.feed(f);
+    sstv::Status sb = b.feed(pcm);
+    sstv::Status sc = c.feed(sstv::span<const double>(d));
+
+    std::optional<sstv::Image> ia = a.image_copy(), ib = b.image_copy(), ic = c.image_copy();
+    int ok = sa == sstv::Status::ImageReady && sb == sa && sc == sa &&
+             a.checksum() == b.checksum() && a.checksum() == c.checksum() &&
+             ia && ib && ic && ia->pixels == ib->pixels && ia->pixels == ic->pixels;
+    printf("  status %d/%d/%d, checksum %016llx %s\n", (int)sa, (int)sb, (int)sc,
+           (unsigned long long)a.checksum(),
+           (a.checksum() == b.checksum() && a.checksum() == c.checksum()) ? "(all equal)" : "(differ)");
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+/* Whether Decoder::on_line accepts an argument of type F */
+template <class F, class = void>
+struct can_on_line : std::false_type {};
+template <class F>
+struct can_on_line<F, std::void_t<decltype(std::declval<sstv::Decoder&>().on_line(std::declval<F>()))>>
+    : std::true_type {};
+
+static int test_callback_move() {
+    printf("TEST 3: Lambda line callback survives a move; handles are move-only\n");
+    static_assert(!std::is_copy_constructible_v<sstv::Decoder>, "Decoder must be move-only");
+    static_assert(!std::is_copy_constructible_v<sstv::Encoder>, "Encoder must be move-only");
+    static_assert(std::is_nothrow_move_constructible_v<sstv::Decoder>, "Decoder move must not throw");
+    static_assert(sizeof(sstv::LineCallback) == 2 * sizeof(void*), "function_ref is two pointers");
+
+    const sstv_mode_info_t *info = sstv_get_mode_info(TEST_MODE);
+    std::vector<uint8_t> rgb = test_pattern();
+    std::vector<float> x;
+    for (int16_t v : encode_all<int16_t>(rgb)) x.push_back(v);
+
+    int lines = 0, last = -1, in_order = 1;
+    long long green = 0;
+    auto count = [&](int line, sstv::span<const uint8_t> row, int width, int) {
+        if (line != last + 1) in_order = 0;
+        last = line;
+        lines++;
+        if ((int)row.size() == width * 3) green += row[3 * (width / 2) + 1];
+    };
+
+    /* The callback is held by reference: temporaries must not bind */
+    static_assert(can_on_line<decltype(count)&>::value, "on_line takes lvalues");
+    static_assert(!can_on_line<decltype(count)>::value, "on_line rejects temporaries");
+
+    sstv::Decoder first = sstv::Decoder::create(SAMPLE_RATE);
+    first.on_line(count);
+    sstv::span<const float> all(x);
+    size_t half = x.size() / 2;
+    first.feed(all.first(half));
+    int before = lines;
+    sstv::Decoder moved = std::move(first);
+    sstv::Status st = moved.feed(all.subspan(half));
+    int stale = first.feed(all.first(16)) == sstv::Status::Error;
+
+    int ok = before > 0 && before < (int)info->height && lines == (int)info->height &&
+             in_order && st == sstv::Status::ImageReady && stale && !first && moved && green > 0;
+    printf("  %d lines before the move, %d after, in order %s\n", before, lines - before,
+           in_order ? "yes" : "no");
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+static int test_image_views() {
+    printf("TEST 4: image() borrows, image_copy() owns, empty handles fail\n");
+    const sstv_mode_info_t *info = sstv_get_mode_info(TEST_MODE);
+    std::vector<uint8_t> rgb = test_pattern();
+    std::vector<int16_t> pcm = encode_all<int16_t>(rgb);
+
+    sstv::Decoder dec = sstv::Decoder::create(SAMPLE_RATE);
+    int ok = !dec.image();                       /* nothing before VIS lock */
+    dec.feed(pcm);
+    std::optional<sstv::ImageView> v = dec.image();
+    std::optional<sstv::Image> copy = dec.image_copy();
+    sstv_image_t raw;
+    sstv_decoder_get_image(dec.handle(), &raw);
+    ok = ok && v && copy && v->pixels.data() == raw.pixels &&
+         copy->pixels.data() != raw.pixels && v->width == info->width &&
+         v->row(10).size() == info->width * 3 &&
+         std::memcmp(v->row(10).data(), copy->view().row(10).data(), info->width * 3) == 0;
+    dec.reset();
+    ok = ok && copy->pixels.size() == (size_t)info->width * info->height * 3;
+
+    sstv::Encoder bad = sstv::Encoder::create(SSTV_MODE_COUNT, SAMPLE_RATE);
+    float buf[16];
+    ok = ok && !bad && bad.generate(sstv::span<float>(buf)) == 0 && bad.complete();
+    sstv::Encoder good = sstv::Encoder::create(TEST_MODE, SAMPLE_RATE);
+    ok = ok && good.set_image(view_of(rgb, info->width / 2, info->height)) == -1;
+    sstv::Decoder none;
+    ok = ok && !none && none.feed(pcm) == sstv::Status::Error && !none.image_copy() &&
+         none.line_quality(sstv::span<sstv_line_quality_t>()) == -1;
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+int main() {
+    printf("=== C++ API Tests ===\n\n");
+
+    int passed = 0;
+    int total = 0;
+
+    total++; passed += test_generate();
+    total++; passed += test_feed_types();
+    total++; passed += test_callback_move();
+    total++; passed += test_image_views();
+
+    printf("\n=== Results: %d/%d passed ===\n", passed, total);
+    return (passed == total) ? 0 : 1;
+}
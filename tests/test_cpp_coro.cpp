@@ -0,0 +1,323 @@
+/*
+ * C++20 coroutine adapter test (include/sstv_coro.hpp)
+ *
+ * Tests:
+ *   1. generate_blocks yields the same audio as Encoder::generate, in views
+ *      of the caller's buffer, and generates nothing before iteration
+ *   2. A coroutine awaiting lines on Robot 36 (inline executor) sees every
+ *      line once, in order, and the image event matches a plain Decoder
+ *   3. Sixteen staggered B/W 8 sessions multiplexed on one thread through
+ *      a queue executor all finish, each with the image a plain Decoder
+ *      gets from its audio
+ *   4. close() resumes waiters with ok = false, a second waiter of the same
+ *      kind is turned away, and feeding a closed decoder fails
+ *
+ * Build: make test_cpp_coro
+ * Run: ./bin/test_cpp_coro
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+#include "sstv_coro.hpp"
+
+#define SAMPLE_RATE 11025.0
+#define AMPLITUDE 16000.0f
+#define CHUNK 1024
+#define SESSIONS 16
+
+/* Coroutine that starts at once and cleans up after itself */
+struct task {
+    struct promise_type {
+        task get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+static std::vector<uint8_t> test_pattern(uint32_t w, uint32_t h) {
+    std::vector<uint8_t> rgb((size_t)w * h * 3);
+    for (uint32_t y = 0; y < h; y++) {
+        for (uint32_t x = 0; x < w; x++) {
+            uint8_t *p = &rgb[((size_t)y * w + x) * 3];
+            p[0] = (uint8_t)(x * 255 / w);
+            p[1] = (uint8_t)(y * 255 / h);
+            p[2] = (uint8_t)((x ^ y) & 0xff);
+        }
+    }
+    return rgb;
+}
+
+static sstv::Encoder make_encoder(sstv_mode_t mode, const std::vector<uint8_t> &rgb) {
+    const sstv_mode_info_t *info = sstv_get_mode_info(mode);
+    sstv::Encoder enc = sstv::Encoder::create(mode, SAMPLE_RATE);
+    enc.set_image(sstv::ImageView{sstv::span<const uint8_t>(rgb), info->width, info->height,
+                                  info->width * 3, SSTV_RGB24});
+    enc.set_vis_enabled(true);
+    return enc;
+}
+
+/* `lead_sec` of silence, the transmission, a second of silence; PCM scale */
+static std::vector<float> make_signal(sstv_mode_t mode, double lead_sec) {
+    const sstv_mode_info_t *info = sstv_get_mode_info(mode);
+    std::vector<uint8_t> rgb = test_pattern(info->width, info->height);
+    sstv::Encoder enc = make_encoder(mode, rgb);
+    std::vector<float> out((size_t)(lead_sec * SAMPLE_RATE));
+    for (sstv::span<const float> block : sstv::generate_blocks(enc, (size_t)CHUNK)) {
+        for (float s : block) out.push_back(s * AMPLITUDE);
+    }
+    out.resize(out.size() + (size_t)SAMPLE_RATE, 0.0f);
+    return out;
+}
+
+static int test_generate_blocks() {
+    printf("TEST 1: generate_blocks matches Encoder::generate, in the caller's buffer\n");
+    const sstv_mode_info_t *info = sstv_get_mode_info(SSTV_R36);
+    std::vector<uint8_t> rgb = test_pattern(info->width, info->height);
+
+    std::vector<float> ref;
+    std::vector<float> tmp(CHUNK);
+    {
+        sstv::Encoder enc = make_encoder(SSTV_R36, rgb);
+        /* An unused range must not consume any audio */
+        auto unused = sstv::generate_blocks(enc, sstv::span<float>(tmp));
+        (void)unused;
+        while (!enc.complete()) {
+            size_t n = enc.generate(tmp);
+            if (n == 0) break;
+            ref.insert(ref.end(), tmp.begin(), tmp.begin() + n);
+        }
+    }
+
+    sstv::Encoder enc = make_encoder(SSTV_R36, rgb);
+    std::vector<float> buffer(3000);
+    std::vector<float> got;
+    size_t blocks = 0, short_blocks = 0;
+    bool in_buffer = true;
+    for (sstv::span<const float> block : sstv::generate_blocks(enc, sstv::span<float>(buffer))) {
+        in_buffer = in_buffer && block.data() == buffer.data() && block.size() <= buffer.size();
+        if (block.size() < buffer.size()) short_blocks++;
+        got.insert(got.end(), block.begin(), block.end());
+        blocks++;
+    }
+
+    sstv::Encoder enc2 = make_encoder(SSTV_R36, rgb);
+    std::vector<float> owned;
+    for (sstv::span<const float> block : sstv::generate_blocks(enc2, (size_t)777)) {
+        owned.insert(owned.end(), block.begin(), block.end());
+    }
+
+    printf("  %zu samples in %zu blocks\n", got.size(), blocks);
+    int ok = !ref.empty() && got == ref && owned == ref && in_buffer &&
+             short_blocks <= 1 && enc.complete() &&
+             blocks == (ref.size() + buffer.size() - 1) / buffer.size();
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+struct LineLog {
+    int next = 0;                /* Next line expected */
+    int events = 0;
+    int height = 0;
+    uint64_t frame = 0;
+    bool in_order = true;
+    bool done = false;
+};
+
+static task watch_lines(sstv::AsyncDecoder &d, LineLog &log) {
+    for (;;) {
+        sstv::LineEvent ev = co_await d.next_line();
+        if (!ev.ok) break;
+        if (ev.frame != log.frame) {
+            log.frame = ev.frame;
+            log.next = 0;
+        }
+        log.in_order = log.in_order && ev.first == log.next && ev.last >= ev.first;
+        log.next = ev.last + 1;
+        log.height = ev.height;
+        log.events++;
+    }
+    log.done = true;
+}
+
+struct ImageLog {
+    int images = 0;
+    uint64_t frame = 0;
+    sstv::Image image;
+};
+
+static task watch_image(sstv::AsyncDecoder &d, ImageLog &log) {
+    for (;;) {
+        sstv::ImageEvent ev = co_await d.next_image();
+        if (!ev.ok) break;
+        log.images++;
+        log.frame = ev.frame;
+        std::optional<sstv::Image> img = d.decoder().image_copy();
+        if (img) log.image = *img;
+    }
+}
+
+/* The image a plain Decoder gets from the same audio */
+static std::optional<sstv::Image> plain_decode(const std::vector<float> &signal) {
+    sstv::Decoder plain = sstv::Decoder::create(SAMPLE_RATE);
+    for (size_t pos = 0; pos < signal.size(); pos += CHUNK) {
+        size_t n = signal.size() - pos < CHUNK ? signal.size() - pos : CHUNK;
+        plain.feed(sstv::span<const float>(signal.data() + pos, n));
+    }
+    return plain.image_copy();
+}
+
+static int test_inline_lines() {
+    printf("TEST 2: Awaited lines on Robot 36 are complete and in order\n");
+    std::vector<float> signal = make_signal(SSTV_R36, 0.5);
+    std::optional<sstv::Image> ref = plain_decode(signal);
+
+    sstv::AsyncDecoder d = sstv::AsyncDecoder::create(SAMPLE_RATE);
+    LineLog lines;
+    ImageLog image;
+    watch_lines(d, lines);
+    watch_image(d, image);
+    for (size_t pos = 0; pos < signal.size(); pos += CHUNK) {
+        size_t n = signal.size() - pos < CHUNK ? signal.size() - pos : CHUNK;
+        d.feed(sstv::span<const float>(signal.data() + pos, n));
+    }
+    d.close();
+
+    printf("  %d line events, %d of %d lines, %d image(s)\n",
+           lines.events, lines.next, lines.height, image.images);
+    int ok = d && ref && lines.done && lines.in_order && lines.frame == 1 &&
+             lines.height > 0 && lines.next == lines.height &&
+             lines.events > 1 && lines.events <= lines.height &&
+             image.images == 1 && image.frame == 1 &&
+             image.image.pixels == ref->pixels;
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+/* Single-threaded run queue standing in for an event loop */
+struct RunQueue {
+    std::deque<std::coroutine_handle<>> ready;
+    size_t posted = 0;
+
+    static void post(void *ctx, std::coroutine_handle<> h) {
+        RunQueue *q = static_cast<RunQueue*>(ctx);
+        q->ready.push_back(h);
+        q->posted++;
+    }
+    void drain() {
+        while (!ready.empty()) {
+            std::coroutine_handle<> h = ready.front();
+            ready.pop_front();
+            h.resume();
+        }
+    }
+};
+
+static int test_multiplexed() {
+    printf("TEST 3: %d staggered B/W 8 sessions on one thread match plain decodes\n", SESSIONS);
+    RunQueue q;
+    sstv::Executor ex{RunQueue::post, &q};
+
+    std::vector<std::vector<float>> signals;
+    std::vector<sstv::AsyncDecoder> sessions;
+    sessions.reserve(SESSIONS);        /* Waiters hold their decoder's address */
+    std::vector<LineLog> lines(SESSIONS);
+    std::vector<ImageLog> images(SESSIONS);
+    size_t longest = 0;
+    for (int i = 0; i < SESSIONS; i++) {
+        signals.push_back(make_signal(SSTV_BW8, 0.1 + 0.37 * i));
+        if (signals.back().size() > longest) longest = signals.back().size();
+        sessions.push_back(sstv::AsyncDecoder::create(SAMPLE_RATE, ex));
+    }
+    for (int i = 0; i < SESSIONS; i++) {
+        watch_lines(sessions[i], lines[i]);
+        watch_image(sessions[i], images[i]);
+    }
+
+    for (size_t pos = 0; pos < longest; pos += CHUNK) {
+        for (int i = 0; i < SESSIONS; i++) {
+            const std::vector<float> &s = signals[i];
+            if (pos >= s.size()) continue;
+            size_t n = s.size() - pos < CHUNK ? s.size() - pos : CHUNK;
+            sessions[i].feed(sstv::span<const float>(s.data() + pos, n));
+        }
+        q.drain();
+    }
+    for (int i = 0; i < SESSIONS; i++) sessions[i].close();
+    q.drain();
+
+    int finished = 0;
+    bool same = true;
+    for (int i = 0; i < SESSIONS; i++) {
+        if (lines[i].done && lines[i].in_order && lines[i].next == lines[i].height &&
+            lines[i].height > 0 && images[i].images == 1) {
+            finished++;
+        }
+        std::optional<sstv::Image> ref = plain_decode(signals[i]);
+        same = same && ref && images[i].image.pixels == ref->pixels;
+    }
+    printf("  %d/%d sessions finished, %zu resumptions posted\n", finished, SESSIONS, q.posted);
+    int ok = finished == SESSIONS && same && q.ready.empty();
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+struct CloseLog {
+    bool resumed = false;
+    bool ok = true;
+};
+
+static task await_line_once(sstv::AsyncDecoder &d, CloseLog &log) {
+    sstv::LineEvent ev = co_await d.next_line();
+    log.resumed = true;
+    log.ok = ev.ok;
+}
+
+static task await_image_once(sstv::AsyncDecoder &d, CloseLog &log) {
+    sstv::ImageEvent ev = co_await d.next_image();
+    log.resumed = true;
+    log.ok = ev.ok;
+}
+
+static int test_close() {
+    printf("TEST 4: close() releases waiters; a second waiter is turned away\n");
+    sstv::AsyncDecoder d = sstv::AsyncDecoder::create(SAMPLE_RATE);
+    CloseLog first, second, image, late;
+    await_line_once(d, first);
+    await_line_once(d, second);
+    await_image_once(d, image);
+    int ok = d && !first.resumed && second.resumed && !second.ok && !image.resumed;
+
+    std::vector<float> silence(CHUNK, 0.0f);
+    ok = ok && d.feed(silence) != sstv::Status::Error && !first.resumed;
+    d.close();
+    ok = ok && first.resumed && !first.ok && image.resumed && !image.ok;
+
+    await_line_once(d, late);
+    ok = ok && late.resumed && !late.ok && d.feed(silence) == sstv::Status::Error;
+
+    sstv::AsyncDecoder empty;
+    ok = ok && !empty;
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+int main() {
+    printf("=== C++20 Coroutine Adapter Tests ===\n\n");
+
+    int passed = 0;
+    int total = 0;
+
+    total++; passed += test_generate_blocks();
+    total++; passed += test_inline_lines();
+    total++; passed += test_multiplexed();
+    total++; passed += test_close();
+
+    printf("\n=== Results: %d/%d passed ===\n", passed, total);
+    return (passed == total) ? 0 : 1;
+}
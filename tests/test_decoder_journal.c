@@ -0,0 +1,147 @@
+/*
+ * Decoder image journal test
+ *
+ * Tests:
+ *   1. Interrupted reception: the journal holds a partial frame with the
+ *      mode, geometry and completed-line count after the decoder is gone
+ *   2. Full reception: the journal is marked complete and its pixels match
+ *      sstv_decoder_get_image()
+ *   3. Recovery rejects a file that is not a journal
+ *
+ * Build: make test_decoder_journal
+ * Run: ./bin/test_decoder_journal
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sstv_decoder.h"
+#include "sstv_encoder.h"
+#include "test_signal.h"
+
+#define SAMPLE_RATE 22050.0
+#define TEST_MODE SSTV_R36
+
+static const char *kJournalPath = "test_decoder_journal.jnl";
+
+static void pixel_bars(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint8_t *p) {
+    (void)y;
+    (void)height;
+    int bar = (int)(x * 8 / width);
+    p[0] = (uint8_t)((bar & 1) ? 255 : 0);
+    p[1] = (uint8_t)((bar & 2) ? 255 : 0);
+    p[2] = (uint8_t)((bar & 4) ? 255 : 0);
+}
+
+/* Test 1: interrupted reception */
+int test_journal_partial(const float *samples, size_t count) {
+    printf("TEST 1: Partial frame survives decoder teardown\n");
+
+    sstv_decoder_t *dec = sstv_decoder_create(SAMPLE_RATE);
+    if (!dec || sstv_decoder_set_journal(dec, kJournalPath) != 0) {
+        printf("  FAIL: could not enable journal\n");
+        sstv_decoder_free(dec);
+        return 0;
+    }
+
+    /* Stop roughly halfway through the image, as a crash would */
+    sstv_decoder_feed(dec, samples, count / 2);
+    sstv_decoder_state_t st;
+    sstv_decoder_get_state(dec, &st);
+    sstv_decoder_free(dec);
+
+    sstv_image_t img;
+    sstv_mode_t mode = SSTV_MODE_COUNT;
+    int lines = -1;
+    if (sstv_decoder_recover_journal(kJournalPath, &img, &mode, &lines) != 0) {
+        printf("  FAIL: recovery failed\n");
+        return 0;
+    }
+
+    const sstv_mode_info_t *info = sstv_get_mode_info(TEST_MODE);
+    int ok = (mode == TEST_MODE) && img.width == info->width && img.height == info->height &&
+             lines == st.current_line && lines > 0 && lines < (int)info->height;
+    printf("  mode=%d %ux%u lines=%d (decoder at line %d)\n",
+           (int)mode, img.width, img.height, lines, st.current_line);
+    free(img.pixels);
+    printf(ok ? "  PASS\n" : "  FAIL: unexpected journal contents\n");
+    return ok;
+}
+
+/* Test 2: full reception */
+int test_journal_complete(const float *samples, size_t count) {
+    printf("TEST 2: Complete frame matches decoder output\n");
+
+    sstv_decoder_t *dec = sstv_decoder_create(SAMPLE_RATE);
+    if (!dec || sstv_decoder_set_journal(dec, kJournalPath) != 0) {
+        printf("  FAIL: could not enable journal\n");
+        sstv_decoder_free(dec);
+        return 0;
+    }
+
+    int ready = 0;
+    for (size_t pos = 0; pos < count && !ready; pos += 4096) {
+        size_t n = count - pos < 4096 ? count - pos : 4096;
+        ready = (sstv_decoder_feed(dec, samples + pos, n) == SSTV_RX_IMAGE_READY);
+    }
+    if (!ready) {
+        printf("  FAIL: decoder never reported IMAGE_READY\n");
+        sstv_decoder_free(dec);
+        return 0;
+    }
+
+    sstv_image_t live;
+    sstv_image_t rec;
+    int lines = -1;
+    int ok = sstv_decoder_get_image(dec, &live) == 0 &&
+             sstv_decoder_recover_journal(kJournalPath, &rec, NULL, &lines) == 0;
+    if (ok) {
+        ok = lines == (int)rec.height && rec.width == live.width && rec.height == live.height &&
+             memcmp(rec.pixels, live.pixels, (size_t)live.stride * live.height) == 0;
+        free(rec.pixels);
+    }
+    sstv_decoder_free(dec);
+    printf(ok ? "  PASS\n" : "  FAIL: journal differs from decoded image\n");
+    return ok;
+}
+
+/* Test 3: invalid file */
+int test_journal_invalid(void) {
+    printf("TEST 3: Recovery rejects non-journal files\n");
+    FILE *fp = fopen(kJournalPath, "wb");
+    if (fp) {
+        for (int i = 0; i < 256; i++) fputc(i, fp);
+        fclose(fp);
+    }
+    sstv_image_t img;
+    int ok = sstv_decoder_recover_journal(kJournalPath, &img, NULL, NULL) != 0 &&
+             sstv_decoder_recover_journal("does/not/exist.jnl", &img, NULL, NULL) != 0;
+    printf(ok ? "  PASS\n" : "  FAIL: invalid journal accepted\n");
+    return ok;
+}
+
+int main(void) {
+    printf("=== Decoder Journal Tests ===\n\n");
+
+    size_t count = 0;
+    float *samples = encode_frame(TEST_MODE, SAMPLE_RATE, pixel_bars, &count);
+    if (!samples) {
+        printf("FAIL: could not encode test frame\n");
+        return 1;
+    }
+
+    int passed = 0;
+    int total = 0;
+
+    total++; passed += test_journal_partial(samples, count);
+    total++; passed += test_journal_complete(samples, count);
+    total++; passed += test_journal_invalid();
+
+    remove(kJournalPath);
+    free(samples);
+
+    printf("\n=== Results: %d/%d passed ===\n", passed, total);
+    return (passed == total) ? 0 : 1;
+}
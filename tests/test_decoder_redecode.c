@@ -0,0 +1,165 @@
+/*
+ * Decoder frequency track / re-decode test
+ *
+ * Tests:
+ *   1. Re-decoding the received frame with the same mode, no slant and
+ *      no offset reproduces the live image
+ *   2. Offset and mode changes take effect (shifted image, new geometry)
+ *   3. Sync pulses are logged relative to the frame start
+ *   4. Re-decode is refused without a track or a locked frame
+ *
+ * Build: make test_decoder_redecode
+ * Run: ./bin/test_decoder_redecode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sstv_decoder.h"
+#include "sstv_encoder.h"
+#include "test_signal.h"
+
+#define SAMPLE_RATE 22050.0
+#define TEST_MODE SSTV_R36
+
+static void pixel_ramp(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint8_t *p) {
+    (void)y;
+    (void)height;
+    p[0] = p[1] = p[2] = (uint8_t)(x * 255 / (width - 1));
+}
+
+/* Feed until the frame is ready; returns a copy of the live image */
+static uint8_t* decode_live(sstv_decoder_t *dec, const float *samples, size_t count,
+                            sstv_image_t *img) {
+    int ready = 0;
+    for (size_t pos = 0; pos < count && !ready; pos += 4096) {
+        size_t n = count - pos < 4096 ? count - pos : 4096;
+        ready = sstv_decoder_feed(dec, samples + pos, n) == SSTV_RX_IMAGE_READY;
+    }
+    if (!ready || sstv_decoder_get_image(dec, img) != 0) return NULL;
+    size_t bytes = (size_t)img->stride * img->height;
+    uint8_t *copy = (uint8_t*)malloc(bytes);
+    if (copy) memcpy(copy, img->pixels, bytes);
+    return copy;
+}
+
+static double mean_abs_diff(const uint8_t *a, const uint8_t *b, size_t n) {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; i++) sum += fabs((double)a[i] - (double)b[i]);
+    return n ? sum / (double)n : 0.0;
+}
+
+int main(void) {
+    printf("=== Decoder Re-decode Tests ===\n\n");
+
+    size_t count = 0;
+    float *samples = encode_frame(TEST_MODE, SAMPLE_RATE, pixel_ramp, &count);
+    if (!samples) {
+        printf("FAIL: could not encode test frame\n");
+        return 1;
+    }
+
+    int passed = 0;
+    int total = 0;
+
+    sstv_decoder_t *dec = sstv_decoder_create(SAMPLE_RATE);
+    sstv_decoder_set_track_enabled(dec, 1);
+    sstv_image_t img;
+    uint8_t *live = decode_live(dec, samples, count, &img);
+    const sstv_mode_info_t *info = sstv_get_mode_info(TEST_MODE);
+    size_t bytes = live ? (size_t)img.stride * img.height : 0;
+
+    /* Test 1: identity re-decode */
+    printf("TEST 1: Same mode, no slant, no offset reproduces the live image\n");
+    total++;
+    {
+        int lines = live ? sstv_decoder_redecode(dec, TEST_MODE, 0.0, 0) : -1;
+        double diff = 999.0;
+        if (lines > 0 && sstv_decoder_get_image(dec, &img) == 0) {
+            diff = mean_abs_diff(live, img.pixels, bytes);
+        }
+        printf("  lines=%d/%u mean |diff|=%.2f\n", lines, info->height, diff);
+        if (lines == (int)info->height && diff < 3.0) {
+            printf("  PASS\n");
+            passed++;
+        } else {
+            printf("  FAIL: re-decoded image does not match\n");
+        }
+    }
+
+    /* Test 2: offset and mode */
+    printf("TEST 2: Offset shifts the image, mode change re-allocates\n");
+    total++;
+    {
+        /* Half a line later: the gradient wraps around mid-row */
+        int half_line = (int)(info->duration_sec / info->height * SAMPLE_RATE / 2.0);
+        int lines = live ? sstv_decoder_redecode(dec, TEST_MODE, 0.0, half_line) : -1;
+        double diff = 0.0;
+        if (lines > 0 && sstv_decoder_get_image(dec, &img) == 0) {
+            diff = mean_abs_diff(live, img.pixels, (size_t)img.stride * (size_t)lines);
+        }
+        const sstv_mode_info_t *alt = sstv_get_mode_info(SSTV_R24);
+        int alt_lines = live ? sstv_decoder_redecode(dec, SSTV_R24, 250.0, 0) : -1;
+        int geom_ok = alt_lines == (int)alt->height &&
+                      sstv_decoder_get_image(dec, &img) == 0 &&
+                      img.width == alt->width && img.height == alt->height;
+        printf("  offset %d: lines=%d mean |diff|=%.2f; R24: lines=%d\n",
+               half_line, lines, diff, alt_lines);
+        if (lines > 0 && diff > 5.0 && geom_ok) {
+            printf("  PASS\n");
+            passed++;
+        } else {
+            printf("  FAIL: offset or mode change had no effect\n");
+        }
+    }
+
+    /* Test 3: sync events */
+    printf("TEST 3: Sync pulses are logged\n");
+    total++;
+    {
+        int n = sstv_decoder_get_sync_events(dec, NULL, 0);
+        int32_t *offs = n > 0 ? (int32_t*)malloc((size_t)n * sizeof(int32_t)) : NULL;
+        int in_frame = 0;
+        if (offs) {
+            sstv_decoder_get_sync_events(dec, offs, n);
+            double frame = info->duration_sec * SAMPLE_RATE;
+            for (int i = 0; i < n; i++) in_frame += (offs[i] >= 0 && offs[i] < frame);
+        }
+        free(offs);
+        printf("  %d pulses, %d inside the frame\n", n, in_frame);
+        if (in_frame >= (int)info->height / 2) {
+            printf("  PASS\n");
+            passed++;
+        } else {
+            printf("  FAIL: too few sync pulses\n");
+        }
+    }
+    free(live);
+    sstv_decoder_free(dec);
+
+    /* Test 4: refused states */
+    printf("TEST 4: Re-decode refused without track or frame\n");
+    total++;
+    {
+        sstv_decoder_t *d = sstv_decoder_create(SAMPLE_RATE);
+        int ok = sstv_decoder_redecode(d, TEST_MODE, 0.0, 0) == -1 &&
+                 sstv_decoder_get_sync_events(d, NULL, 0) == -1;
+        sstv_decoder_set_track_enabled(d, 1);
+        sstv_decoder_feed(d, samples, 4096);
+        ok = ok && sstv_decoder_redecode(d, TEST_MODE, 0.0, 0) == -1;
+        ok = ok && sstv_decoder_redecode(d, SSTV_MODE_COUNT, 0.0, 0) == -1;
+        sstv_decoder_free(d);
+        if (ok) {
+            printf("  PASS\n");
+            passed++;
+        } else {
+            printf("  FAIL: re-decode accepted without a frame\n");
+        }
+    }
+
+    free(samples);
+    printf("\n=== Results: %d/%d passed ===\n", passed, total);
+    return (passed == total) ? 0 : 1;
+}
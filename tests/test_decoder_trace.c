@@ -0,0 +1,170 @@
+/*
+ * Decoder replay trace test
+ *
+ * Tests:
+ *   1. Sample block codec round-trips int16 PCM (Rice) and arbitrary
+ *      floats (raw fallback) bit-exactly
+ *   2. A recorded session reads back with the same chunk boundaries,
+ *      samples, statuses and API calls, and its checksums match a second
+ *      decoder fed the same blocks
+ *   3. Tracing is refused once samples have been fed
+ *
+ * Build: make test_decoder_trace
+ * Run: ./bin/test_decoder_trace
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sstv_decoder.h"
+#include "sstv_encoder.h"
+#include "test_signal.h"
+#include "trace.h"
+
+#define SAMPLE_RATE 22050.0
+#define TEST_MODE SSTV_R36
+#define CHUNK 1000
+
+static const char *kTracePath = "test_decoder_trace.trc";
+
+/* Encode a gradient frame, quantised like a 16-bit PCM source */
+static float* encode_test_frame(size_t *count) {
+    float *samples = encode_frame(TEST_MODE, SAMPLE_RATE, pixel_gradient, count);
+    for (size_t i = 0; samples && i < *count; i++) {
+        samples[i] = floorf(samples[i] + 0.5f);
+    }
+    return samples;
+}
+
+/* Test 1: block codec */
+int test_codec_roundtrip(const float *samples, size_t count) {
+    printf("TEST 1: Block codec round trip\n");
+    size_t n = count < 22050 ? count : 22050;
+    uint8_t *enc = (uint8_t*)malloc(trace_block_bound(n));
+    float *dec = (float*)malloc(n * sizeof(float));
+    float noisy[257];
+    int ok = enc && dec;
+
+    if (ok) {
+        size_t len = trace_encode_block(samples, n, enc);
+        ok = enc[0] == TRACE_CODEC_RICE16 &&
+             trace_decode_block(enc, len, dec, n) == 0 &&
+             memcmp(dec, samples, n * sizeof(float)) == 0;
+        printf("  int16 block: %zu samples -> %zu bytes (%.2f bits/sample)\n",
+               n, len, len * 8.0 / n);
+        /* A truncated block must be rejected, not read past */
+        ok = ok && trace_decode_block(enc, len / 2, dec, n) != 0;
+    }
+    if (ok) {
+        for (int i = 0; i < 257; i++) noisy[i] = sinf(i * 0.37f) * 1234.5f;
+        noisy[5] = -0.0f;
+        size_t len = trace_encode_block(noisy, 257, enc);
+        ok = enc[0] == TRACE_CODEC_F32 &&
+             trace_decode_block(enc, len, dec, 257) == 0 &&
+             memcmp(dec, noisy, sizeof(noisy)) == 0;
+    }
+
+    free(enc);
+    free(dec);
+    printf(ok ? "  PASS\n" : "  FAIL: block did not round-trip\n");
+    return ok;
+}
+
+/* Test 2: record, read back, compare against a second decoder */
+int test_record_readback(const float *samples, size_t count) {
+    printf("TEST 2: Recorded session reads back and checksums agree\n");
+
+    sstv_decoder_t *dec = sstv_decoder_create(SAMPLE_RATE);
+    if (!dec || sstv_decoder_enable_trace(dec, kTracePath) != 0) {
+        printf("  FAIL: could not enable trace\n");
+        sstv_decoder_free(dec);
+        return 0;
+    }
+    sstv_decoder_set_vis_enabled(dec, 1);
+    int statuses[4096];
+    size_t nfeeds = 0;
+    for (size_t pos = 0; pos < count && nfeeds < 4096; pos += CHUNK) {
+        size_t n = count - pos < CHUNK ? count - pos : CHUNK;
+        statuses[nfeeds++] = (int)sstv_decoder_feed(dec, samples + pos, n);
+    }
+    uint64_t final_sum = sstv_decoder_get_checksum(dec);
+    int ok = sstv_decoder_disable_trace(dec) == 0;
+    sstv_decoder_free(dec);
+
+    trace_reader_t rd;
+    trace_config_t cfg;
+    if (!ok || trace_reader_open(&rd, kTracePath, &cfg) != 0) {
+        printf("  FAIL: could not read trace back\n");
+        return 0;
+    }
+    ok = cfg.sample_rate == SAMPLE_RATE && cfg.check_interval == (uint32_t)SAMPLE_RATE;
+
+    sstv_decoder_t *ref = sstv_decoder_create(cfg.sample_rate);
+    size_t feeds = 0;
+    int calls = 0, checks = 0, rc;
+    trace_record_t rec;
+    while (ok && (rc = trace_read(&rd, &rec)) == 1) {
+        if (rec.type == TRACE_REC_CALL) {
+            ok = rec.call.op == TRACE_CALL_VIS_ENABLED && rec.call.arg == 1;
+            sstv_decoder_set_vis_enabled(ref, rec.call.arg);
+            calls++;
+        } else if (rec.type == TRACE_REC_FEED) {
+            size_t pos = feeds * CHUNK;
+            ok = rec.feed.index == feeds && rec.feed.first_sample == pos &&
+                 rec.feed.status == statuses[feeds] &&
+                 memcmp(rec.samples, samples + pos, rec.feed.count * sizeof(float)) == 0;
+            sstv_decoder_feed(ref, rec.samples, rec.feed.count);
+            feeds++;
+        } else if (rec.type == TRACE_REC_CHECK) {
+            ok = sstv_decoder_get_checksum(ref) == rec.check.checksum;
+            checks++;
+        }
+    }
+    ok = ok && feeds == nfeeds && calls == 1 && checks > 0 &&
+         sstv_decoder_get_checksum(ref) == final_sum;
+    printf("  %zu feeds, %d calls, %d checksums\n", feeds, calls, checks);
+
+    sstv_decoder_free(ref);
+    trace_reader_close(&rd);
+    printf(ok ? "  PASS\n" : "  FAIL: trace does not match the session\n");
+    return ok;
+}
+
+/* Test 3: late enable */
+int test_enable_after_feed(const float *samples) {
+    printf("TEST 3: Trace refused after samples were fed\n");
+    sstv_decoder_t *dec = sstv_decoder_create(SAMPLE_RATE);
+    sstv_decoder_feed(dec, samples, CHUNK);
+    int ok = sstv_decoder_enable_trace(dec, kTracePath) != 0;
+    sstv_decoder_reset(dec);
+    ok = ok && sstv_decoder_enable_trace(dec, kTracePath) == 0;
+    sstv_decoder_free(dec);
+    printf(ok ? "  PASS\n" : "  FAIL: enable_trace ignored feed position\n");
+    return ok;
+}
+
+int main(void) {
+    printf("=== Decoder Trace Tests ===\n\n");
+
+    size_t count = 0;
+    float *samples = encode_test_frame(&count);
+    if (!samples) {
+        printf("FAIL: could not encode test frame\n");
+        return 1;
+    }
+
+    int passed = 0;
+    int total = 0;
+
+    total++; passed += test_codec_roundtrip(samples, count);
+    total++; passed += test_record_readback(samples, count);
+    total++; passed += test_enable_after_feed(samples);
+
+    remove(kTracePath);
+    free(samples);
+
+    printf("\n=== Results: %d/%d passed ===\n", passed, total);
+    return (passed == total) ? 0 : 1;
+}
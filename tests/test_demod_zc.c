@@ -0,0 +1,139 @@
+/*
+ * Zero-crossing demodulator tier test
+ *
+ * Tests:
+ *   1. A B/W 8 frame of grey bands decodes with SSTV_DEMOD_ZC, and each
+ *      band comes out at its transmitted level
+ *   2. The ZC tier stays locked to the line sync
+ *   3. Unknown demodulator values are rejected
+ *
+ * Build: make test_demod_zc
+ * Run: ./bin/test_demod_zc
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sstv_decoder.h"
+#include "sstv_encoder.h"
+#include "test_signal.h"
+
+#define SAMPLE_RATE 22050.0
+#define TEST_MODE SSTV_BW8
+#define BANDS 4
+
+static int band_level(int band) {
+    return 40 + band * 60;
+}
+
+/* Pixel value for a band: studio-range luma sent at 1500 + y * 800 / 256 Hz */
+static double band_expected(int band) {
+    int y = (int)(16.0 + 0.858770 * band_level(band));
+    return (double)(y * 800 / 256) * 255.0 / 800.0;
+}
+
+static void pixel_bands(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint8_t *p) {
+    (void)x;
+    (void)width;
+    p[0] = p[1] = p[2] = (uint8_t)band_level((int)(y * BANDS / height));
+}
+
+/* Median of one row (sync pulses land mid-row and are outliers) */
+static int row_median(const uint8_t *row, uint32_t width) {
+    int hist[256] = {0};
+    for (uint32_t x = 0; x < width; x++) hist[row[x * 3]]++;
+    uint32_t seen = 0;
+    for (int v = 0; v < 256; v++) {
+        seen += hist[v];
+        if (seen > width / 2) return v;
+    }
+    return 255;
+}
+
+int main(void) {
+    printf("=== ZC Demodulator Tests ===\n\n");
+
+    size_t count = 0;
+    float *samples = encode_frame(TEST_MODE, SAMPLE_RATE, pixel_bands, &count);
+    if (!samples) {
+        printf("FAIL: could not encode test frame\n");
+        return 1;
+    }
+
+    int passed = 0;
+    int total = 0;
+
+    sstv_decoder_t *dec = sstv_decoder_create(SAMPLE_RATE);
+    int set_ok = sstv_decoder_set_demod(dec, SSTV_DEMOD_ZC) == 0;
+    int ready = 0;
+    for (size_t pos = 0; pos < count && !ready; pos += 4096) {
+        size_t n = count - pos < 4096 ? count - pos : 4096;
+        ready = sstv_decoder_feed(dec, samples + pos, n) == SSTV_RX_IMAGE_READY;
+    }
+
+    /* Test 1: band levels */
+    printf("TEST 1: Grey bands decode at their transmitted level\n");
+    total++;
+    {
+        sstv_image_t img;
+        int ok = set_ok && ready && sstv_decoder_get_image(dec, &img) == 0;
+        int rows = ok ? (int)img.height / BANDS : 0;
+        for (int b = 0; ok && b < BANDS; b++) {
+            double sum = 0.0;
+            int n = 0;
+            for (int y = b * rows + rows / 4; y < (b + 1) * rows - rows / 4; y++) {
+                sum += row_median(img.pixels + (size_t)y * img.stride, img.width);
+                n++;
+            }
+            double got = sum / n;
+            printf("  band %d: expected %.1f got %.1f\n", b, band_expected(b), got);
+            if (fabs(got - band_expected(b)) > 6.0) ok = 0;
+        }
+        if (ok) {
+            printf("  PASS\n");
+            passed++;
+        } else {
+            printf("  FAIL: band levels off\n");
+        }
+    }
+
+    /* Test 2: line sync */
+    printf("TEST 2: Line sync tracker locked\n");
+    total++;
+    {
+        sstv_line_sync_t ls;
+        int ok = sstv_decoder_get_line_sync(dec, &ls) == 0 && ls.locked &&
+                 ls.lines_found >= 110 && fabs(ls.clock_ppm) < 100.0;
+        printf("  found=%d missed=%d ppm=%.1f\n", ls.lines_found, ls.lines_missed, ls.clock_ppm);
+        if (ok) {
+            printf("  PASS\n");
+            passed++;
+        } else {
+            printf("  FAIL: sync not tracked\n");
+        }
+    }
+    sstv_decoder_free(dec);
+
+    /* Test 3: bad values */
+    printf("TEST 3: Unknown tier rejected\n");
+    total++;
+    {
+        sstv_decoder_t *d = sstv_decoder_create(SAMPLE_RATE);
+        int ok = sstv_decoder_set_demod(d, (sstv_demod_t)7) == -1 &&
+                 sstv_decoder_set_demod(NULL, SSTV_DEMOD_ZC) == -1 &&
+                 sstv_decoder_set_demod(d, SSTV_DEMOD_TONE) == 0;
+        sstv_decoder_free(d);
+        if (ok) {
+            printf("  PASS\n");
+            passed++;
+        } else {
+            printf("  FAIL: bad tier accepted\n");
+        }
+    }
+
+    free(samples);
+    printf("\n=== Results: %d/%d passed ===\n", passed, total);
+    return (passed == total) ? 0 : 1;
+}
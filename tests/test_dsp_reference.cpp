@@ -86,7 +86,9 @@ THEORY REFERENCES (if you need deeper understanding):
 ================================================================================
 */
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -97,6 +99,9 @@ THEORY REFERENCES (if you need deeper understanding):
 using sstv_dsp::CIIRTANK;
 using sstv_dsp::CIIR;
 using sstv_dsp::CFIR2;
+using sstv_dsp::CFastFIR;
+using sstv_dsp::CHalfBand;
+using sstv_dsp::CHalfBandCascade;
 using sstv_dsp::DoFIR;
 using sstv_dsp::MakeIIR;
 using sstv_dsp::MakeFilter;
@@ -754,6 +759,170 @@ static int test_cfir2_bef_notch() {
     return 0;
 }
 
+// ===== Partitioned FFT FIR tests =====
+// Max |CFastFIR - CFIR2| after aligning by the reported latency
+static double fastfir_max_error(int tap, int block_feed) {
+    const double fs = 48000.0;
+    CFIR2 ref;
+    ref.Create(tap, sstv_dsp::kFfBPF, fs, 1100.0, 2400.0, 70.0, 1.0);
+    CFastFIR fast;
+    fast.Create(tap, sstv_dsp::kFfBPF, fs, 1100.0, 2400.0, 70.0, 1.0);
+
+    const int n = 6000;
+    std::vector<double> x(n), want(n), got(n);
+    uint32_t seed = 777;
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        x[i] = (double)(seed >> 8) / (double)(1u << 24) - 0.5;
+        want[i] = ref.Do(x[i]);
+    }
+    if (block_feed) {
+        for (int pos = 0; pos < n; pos += 333) {
+            fast.Do(&x[pos], std::min(333, n - pos), &got[pos]);
+        }
+    } else {
+        for (int i = 0; i < n; i++) got[i] = fast.Do(x[i]);
+    }
+
+    const int lat = fast.GetLatency();
+    double max_err = 0.0;
+    for (int i = lat; i < n; i++) {
+        max_err = std::max(max_err, std::fabs(got[i] - want[i - lat]));
+    }
+    return max_err;
+}
+
+static int test_fastfir_matches_cfir2() {
+    /*
+    CFastFIR validation
+
+    Purpose: Above the tap threshold CFastFIR uses partitioned overlap-save
+    FFT convolution; it must match direct-form CFIR2 within rounding, delayed
+    by exactly GetLatency() samples. Below the threshold it is CFIR2 itself.
+    */
+    print_test_header("test_fastfir_matches_cfir2",
+                      "FFT overlap-save FIR equals CFIR2 (after latency)");
+
+    int ok = 1;
+    CFastFIR probe;
+    probe.Create(64, sstv_dsp::kFfLPF, 48000.0, 3000.0, 3000.0, 60.0, 1.0);
+    ok &= compare_double("FastFIR direct mode latency", probe.GetLatency(), 0.0, 0.0);
+    probe.Create(510, sstv_dsp::kFfLPF, 48000.0, 3000.0, 3000.0, 60.0, 1.0);
+    ok &= (probe.IsFFT() && probe.GetLatency() > 0);
+    std::printf("INFO FastFIR 510 taps: latency=%d samples\n", probe.GetLatency());
+
+    ok &= compare_double("FastFIR 64 taps (direct)", fastfir_max_error(64, 0), 0.0, 0.0);
+    ok &= compare_double("FastFIR 255 taps", fastfir_max_error(255, 0), 0.0, 1e-12);
+    ok &= compare_double("FastFIR 510 taps", fastfir_max_error(510, 0), 0.0, 1e-12);
+    ok &= compare_double("FastFIR 510 taps (block feed)", fastfir_max_error(510, 1), 0.0, 1e-12);
+    return ok;
+}
+
+// ===== Half-band decimator tests =====
+static int test_halfband_matches_direct() {
+    /*
+    CHalfBand validation
+
+    Purpose: The folded/polyphase half-band must equal a direct-form
+    convolution with the same MakeFilter taps, sampled every second
+    output, regardless of how the input is split into blocks.
+    */
+    print_test_header("test_halfband_matches_direct",
+                      "Half-band decimator equals direct FIR + keep every 2nd output");
+
+    const int tap = 46;   // 4m+2
+    const double att = 70.0;
+    CHalfBand hb;
+    hb.Create(tap, att);
+    int ok = (hb.GetTap() == tap);
+
+    std::vector<double> h(tap + 1);
+    MakeFilter(h.data(), tap, sstv_dsp::kFfLPF, 1.0, 0.25, 0.25, att, 1.0);
+
+    // Even offsets from the centre are (numerically) zero
+    double max_even = 0.0;
+    for (int j = 2; j <= tap / 2; j += 2) {
+        max_even = std::max(max_even, std::fabs(h[tap / 2 - j]));
+    }
+    ok &= compare_double("HalfBand even taps", max_even, 0.0, 1e-12);
+
+    const int n = 1000;
+    std::vector<double> x(n);
+    uint32_t seed = 12345;
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        x[i] = (double)(seed >> 8) / (double)(1u << 24) - 0.5;
+    }
+
+    // Reference: full-rate direct form, outputs after samples 1, 3, 5, ...
+    std::vector<double> ref;
+    for (int i = 1; i < n; i += 2) {
+        double acc = 0.0;
+        for (int j = 0; j <= tap; j++) {
+            if (i - j >= 0) acc += h[j] * x[i - j];
+        }
+        ref.push_back(acc);
+    }
+
+    // Odd-sized blocks exercise the phase carry between calls
+    std::vector<double> out(n);
+    int got = 0;
+    const int blocks[] = { 1, 7, 64, 3, 200, 1, 500 };
+    int pos = 0;
+    for (int b = 0; pos < n; b++) {
+        int len = std::min(blocks[b % 7], n - pos);
+        got += hb.Do(&x[pos], len, &out[got]);
+        pos += len;
+    }
+    ok &= compare_double("HalfBand output count", got, (double)ref.size(), 0.0);
+
+    double max_err = 0.0;
+    for (int i = 0; i < got && i < (int)ref.size(); i++) {
+        max_err = std::max(max_err, std::fabs(out[i] - ref[i]));
+    }
+    ok &= compare_double("HalfBand max error", max_err, 0.0, 1e-9);
+    return ok;
+}
+
+// Amplitude (RMS x sqrt 2) of a tone after decimation by the cascade
+static double cascade_tone_gain(CHalfBandCascade &dec, double freq, double fs) {
+    const int n = 48000;
+    std::vector<double> x(n);
+    for (int i = 0; i < n; i++) x[i] = std::sin(2.0 * kPi * freq * i / fs);
+    std::vector<double> y(n / dec.GetFactor() + 2);
+    dec.Clear();
+    int got = dec.Do(x.data(), n, y.data());
+    double sum = 0.0;
+    for (int i = got / 2; i < got; i++) sum += y[i] * y[i];
+    return std::sqrt(2.0 * sum / (got - got / 2));
+}
+
+static int test_halfband_cascade_48k_to_12k() {
+    /*
+    CHalfBandCascade validation
+
+    Purpose: 48 kHz -> 12 kHz (factor 4) keeps the SSTV band flat and
+    rejects tones that would alias into it.
+    */
+    print_test_header("test_halfband_cascade_48k_to_12k",
+                      "x4 cascade: SSTV band flat, alias band rejected");
+
+    const double fs = 48000.0;
+    CHalfBandCascade dec;
+    int ok = (dec.Create(4, 62, 70.0) == 0);
+    ok &= (dec.Create(3, 62, 70.0) != 0);   // not a power of two
+    ok &= (dec.Create(4, 62, 70.0) == 0);
+
+    ok &= compare_double("Cascade gain 1200 Hz", cascade_tone_gain(dec, 1200.0, fs), 1.0, 0.01);
+    ok &= compare_double("Cascade gain 2300 Hz", cascade_tone_gain(dec, 2300.0, fs), 1.0, 0.01);
+    // 10 kHz aliases to 2 kHz at 12 kHz; 20 kHz aliases to 4 kHz
+    ok &= compare_double("Cascade alias 10 kHz", cascade_tone_gain(dec, 10000.0, fs), 0.0, 1e-3);
+    ok &= compare_double("Cascade alias 20 kHz", cascade_tone_gain(dec, 20000.0, fs), 0.0, 1e-3);
+
+    std::printf("INFO Cascade delay: %d input samples\n", dec.GetDelay());
+    return ok;
+}
+
 int main() {
     int ok = 1;
     std::printf("\n");
@@ -792,6 +961,13 @@ int main() {
     ok &= test_cfir2_bpf_narrowband();
     ok &= test_cfir2_bef_notch();
 
+    // FFT fast convolution
+    ok &= test_fastfir_matches_cfir2();
+
+    // Half-band decimation
+    ok &= test_halfband_matches_direct();
+    ok &= test_halfband_cascade_48k_to_12k();
+
     std::printf("\n");
     std::printf("================================================================================\n");
     if (!ok) {
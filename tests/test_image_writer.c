@@ -0,0 +1,350 @@
+/*
+ * Streaming image writer tests
+ *
+ * Tests:
+ *   1. PPM output matches the input rows byte for byte
+ *   2. QOI output decodes back to the input (spec decoder below, RGBA index)
+ *   3. PNG (stored) chunk CRCs, zlib framing and payload round-trip
+ *   4. PNG (fast deflate) chunk CRCs and structure; smaller than stored
+ *   5. Closing early pads the image with black rows
+ *   6. QOI black following a colour before its index slot is written
+ *      decodes opaque with a spec decoder
+ *
+ * Build: make test_image_writer
+ * Run: ./bin/test_image_writer
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "sstv_image_writer.h"
+
+#define TEST_W 67
+#define TEST_H 23
+
+static const char *kTmpPath = "test_image_writer.tmp";
+
+/* Flat bars with a noisy band: exercises runs, diffs and literals */
+static void make_test_image(uint8_t *rgb) {
+    uint32_t seed = 12345;
+    for (int y = 0; y < TEST_H; y++) {
+        for (int x = 0; x < TEST_W; x++) {
+            uint8_t *p = rgb + (y * TEST_W + x) * 3;
+            if (y >= 10 && y < 14) {
+                seed = seed * 1103515245u + 12345u;
+                p[0] = (uint8_t)(seed >> 16);
+                p[1] = (uint8_t)(seed >> 8);
+                p[2] = (uint8_t)(seed >> 24);
+            } else {
+                int bar = x / 10;
+                p[0] = (uint8_t)((bar & 1) ? 255 : 0);
+                p[1] = (uint8_t)((bar & 2) ? 255 : x * 3);
+                p[2] = (uint8_t)((bar & 4) ? 255 : y);
+            }
+        }
+    }
+}
+
+static int write_image(sstv_image_format_t fmt, const uint8_t *rgb, int rows) {
+    sstv_image_writer_t *w = sstv_image_writer_open(kTmpPath, fmt, TEST_W, TEST_H);
+    if (!w) return -1;
+    for (int y = 0; y < rows; y++) {
+        if (sstv_image_writer_write_row(w, rgb + y * TEST_W * 3) != 0) {
+            sstv_image_writer_close(w);
+            return -1;
+        }
+    }
+    return sstv_image_writer_close(w);
+}
+
+static uint8_t* read_file(size_t *len) {
+    FILE *fp = fopen(kTmpPath, "rb");
+    if (!fp) return NULL;
+    fseek(fp, 0, SEEK_END);
+    long n = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    uint8_t *buf = (uint8_t*)malloc((size_t)n);
+    if (buf && fread(buf, 1, (size_t)n, fp) != (size_t)n) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(fp);
+    *len = (size_t)n;
+    return buf;
+}
+
+static uint32_t rd_be32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint32_t crc32_calc(const uint8_t *p, size_t n) {
+    uint32_t c = 0xffffffffu;
+    for (size_t i = 0; i < n; i++) {
+        c ^= p[i];
+        for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : (c >> 1);
+    }
+    return c ^ 0xffffffffu;
+}
+
+/* Walk PNG chunks, check CRCs, concatenate IDAT payloads */
+static int png_collect(const uint8_t *buf, size_t len, uint8_t *idat, size_t *idat_len) {
+    static const uint8_t sig[8] = {0x89, 'P', 'N', 'G', 0x0d, 0x0a, 0x1a, 0x0a};
+    if (len < 8 || memcmp(buf, sig, 8) != 0) return -1;
+    size_t pos = 8;
+    int seen_iend = 0;
+    *idat_len = 0;
+    while (pos + 12 <= len) {
+        uint32_t n = rd_be32(buf + pos);
+        if (pos + 12 + n > len) return -1;
+        if (crc32_calc(buf + pos + 4, n + 4) != rd_be32(buf + pos + 8 + n)) return -1;
+        if (memcmp(buf + pos + 4, "IHDR", 4) == 0) {
+            if (rd_be32(buf + pos + 8) != TEST_W || rd_be32(buf + pos + 12) != TEST_H) return -1;
+        } else if (memcmp(buf + pos + 4, "IDAT", 4) == 0) {
+            memcpy(idat + *idat_len, buf + pos + 8, n);
+            *idat_len += n;
+        } else if (memcmp(buf + pos + 4, "IEND", 4) == 0) {
+            seen_iend = 1;
+        }
+        pos += 12 + n;
+    }
+    return (seen_iend && pos == len) ? 0 : -1;
+}
+
+/* Test 1: PPM */
+int test_ppm(const uint8_t *rgb) {
+    printf("TEST 1: PPM streaming output\n");
+    if (write_image(SSTV_IMAGE_PPM, rgb, TEST_H) != 0) {
+        printf("  FAIL: write failed\n");
+        return 0;
+    }
+    size_t len;
+    uint8_t *buf = read_file(&len);
+    char hdr[32];
+    int hl = snprintf(hdr, sizeof(hdr), "P6\n%d %d\n255\n", TEST_W, TEST_H);
+    int ok = buf && len == (size_t)hl + TEST_W * TEST_H * 3 &&
+             memcmp(buf, hdr, (size_t)hl) == 0 &&
+             memcmp(buf + hl, rgb, TEST_W * TEST_H * 3) == 0;
+    free(buf);
+    printf(ok ? "  PASS\n" : "  FAIL: PPM content mismatch\n");
+    return ok;
+}
+
+/* Spec QOI decoder: RGBA index starting at (0,0,0,0), alpha taken from the
+ * stream. Fills TEST_W x TEST_H RGB pixels; returns 0 if the image decodes
+ * completely, fully opaque and followed by the end marker. */
+static int qoi_decode(const uint8_t *buf, size_t len, uint8_t *out) {
+    if (len < 22 || memcmp(buf, "qoif", 4) != 0 ||
+        rd_be32(buf + 4) != TEST_W || rd_be32(buf + 8) != TEST_H) {
+        return -1;
+    }
+    uint8_t index[64][4];
+    uint8_t px[4] = {0, 0, 0, 255};
+    memset(index, 0, sizeof(index));
+    const size_t total = (size_t)TEST_W * TEST_H * 3;
+    size_t p = 14, o = 0;
+    int run = 0, opaque = 1;
+    while (o < total && p < len) {
+        if (run > 0) {
+            run--;
+        } else {
+            uint8_t b = buf[p++];
+            if (b == 0xfe) {
+                px[0] = buf[p]; px[1] = buf[p + 1]; px[2] = buf[p + 2];
+                p += 3;
+            } else if (b == 0xff) {
+                px[0] = buf[p]; px[1] = buf[p + 1]; px[2] = buf[p + 2]; px[3] = buf[p + 3];
+                p += 4;
+            } else if ((b >> 6) == 0) {
+                memcpy(px, index[b], 4);
+            } else if ((b >> 6) == 1) {
+                px[0] = (uint8_t)(px[0] + ((b >> 4) & 3) - 2);
+                px[1] = (uint8_t)(px[1] + ((b >> 2) & 3) - 2);
+                px[2] = (uint8_t)(px[2] + (b & 3) - 2);
+            } else if ((b >> 6) == 2) {
+                uint8_t b2 = buf[p++];
+                int vg = (b & 63) - 32;
+                px[0] = (uint8_t)(px[0] + vg - 8 + (b2 >> 4));
+                px[1] = (uint8_t)(px[1] + vg);
+                px[2] = (uint8_t)(px[2] + vg - 8 + (b2 & 15));
+            } else {
+                run = b & 63;
+            }
+            memcpy(index[(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64], px, 4);
+        }
+        if (px[3] != 255) opaque = 0;
+        memcpy(out + o, px, 3);
+        o += 3;
+    }
+
+    static const uint8_t end[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+    return (o == total && opaque && p + 8 == len && memcmp(buf + p, end, 8) == 0) ? 0 : -1;
+}
+
+/* Test 2: QOI round trip */
+int test_qoi(const uint8_t *rgb) {
+    printf("TEST 2: QOI round trip\n");
+    if (write_image(SSTV_IMAGE_QOI, rgb, TEST_H) != 0) {
+        printf("  FAIL: write failed\n");
+        return 0;
+    }
+    size_t len;
+    uint8_t *buf = read_file(&len);
+    static uint8_t out[TEST_W * TEST_H * 3];
+    int ok = buf && qoi_decode(buf, len, out) == 0 &&
+             memcmp(out, rgb, sizeof(out)) == 0;
+    free(buf);
+    printf(ok ? "  PASS\n" : "  FAIL: decoded QOI differs\n");
+    return ok;
+}
+
+/* Test 6: QOI black before its index slot has been written */
+int test_qoi_black(void) {
+    printf("TEST 6: QOI black after a colour, index slot 53 still empty\n");
+    static uint8_t rgb[TEST_W * TEST_H * 3];
+    memset(rgb, 0, sizeof(rgb));
+    /* Red (slot 5) then black, alternating along the first row */
+    for (int x = 0; x < TEST_W; x += 2) {
+        rgb[x * 3] = 200;
+        rgb[x * 3 + 1] = 10;
+        rgb[x * 3 + 2] = 10;
+    }
+    if (write_image(SSTV_IMAGE_QOI, rgb, TEST_H) != 0) {
+        printf("  FAIL: write failed\n");
+        return 0;
+    }
+    size_t len;
+    uint8_t *buf = read_file(&len);
+    static uint8_t out[TEST_W * TEST_H * 3];
+    int ok = buf && qoi_decode(buf, len, out) == 0 &&
+             memcmp(out, rgb, sizeof(out)) == 0;
+    free(buf);
+    printf(ok ? "  PASS\n" : "  FAIL: black decoded as transparent or wrong colour\n");
+    return ok;
+}
+
+/* Test 3: PNG stored */
+int test_png_stored(const uint8_t *rgb, size_t *stored_size) {
+    printf("TEST 3: PNG (stored deflate) round trip\n");
+    if (write_image(SSTV_IMAGE_PNG_STORED, rgb, TEST_H) != 0) {
+        printf("  FAIL: write failed\n");
+        return 0;
+    }
+    size_t len, zlen;
+    uint8_t *buf = read_file(&len);
+    uint8_t *z = (uint8_t*)malloc(len);
+    if (!buf || !z || png_collect(buf, len, z, &zlen) != 0) {
+        printf("  FAIL: bad chunk structure or CRC\n");
+        free(buf);
+        free(z);
+        return 0;
+    }
+    *stored_size = len;
+
+    /* Unpack stored blocks */
+    const size_t row_bytes = 1 + TEST_W * 3;
+    uint8_t *raw = (uint8_t*)malloc(row_bytes * TEST_H);
+    size_t p = 2, o = 0;
+    int final = 0, ok = (z[0] == 0x78) && raw;
+    while (ok && !final && p + 5 <= zlen) {
+        final = z[p] & 1;
+        ok = ((z[p] >> 1) & 3) == 0;
+        size_t n = z[p + 1] | (z[p + 2] << 8);
+        size_t nn = z[p + 3] | (z[p + 4] << 8);
+        ok = ok && ((n ^ 0xffff) == nn) && o + n <= row_bytes * TEST_H;
+        if (ok) memcpy(raw + o, z + p + 5, n);
+        p += 5 + n;
+        o += n;
+    }
+    ok = ok && final && o == row_bytes * TEST_H && p + 4 == zlen;
+
+    /* Adler-32 of the filtered scanlines */
+    if (ok) {
+        uint32_t a = 1, b = 0;
+        for (size_t i = 0; i < o; i++) {
+            a = (a + raw[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+        ok = rd_be32(z + p) == ((b << 16) | a);
+    }
+    for (int y = 0; ok && y < TEST_H; y++) {
+        ok = raw[y * row_bytes] == 0 &&
+             memcmp(raw + y * row_bytes + 1, rgb + y * TEST_W * 3, TEST_W * 3) == 0;
+    }
+
+    free(raw);
+    free(buf);
+    free(z);
+    printf(ok ? "  PASS\n" : "  FAIL: stored PNG payload mismatch\n");
+    return ok;
+}
+
+/* Test 4: PNG fast deflate */
+int test_png_fast(const uint8_t *rgb, size_t stored_size) {
+    printf("TEST 4: PNG (fast deflate) structure\n");
+    if (write_image(SSTV_IMAGE_PNG, rgb, TEST_H) != 0) {
+        printf("  FAIL: write failed\n");
+        return 0;
+    }
+    size_t len, zlen;
+    uint8_t *buf = read_file(&len);
+    uint8_t *z = (uint8_t*)malloc(len);
+    int ok = buf && z && png_collect(buf, len, z, &zlen) == 0 &&
+             z[0] == 0x78 && ((z[0] << 8) | z[1]) % 31 == 0 &&
+             (z[2] & 7) == 3;   /* BFINAL=1, BTYPE=01 */
+    if (ok && len >= stored_size) {
+        printf("  FAIL: fast PNG (%zu bytes) not smaller than stored (%zu bytes)\n", len, stored_size);
+        ok = 0;
+    } else if (ok) {
+        printf("  %zu bytes (stored: %zu)\n", len, stored_size);
+    }
+    free(buf);
+    free(z);
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+/* Test 5: early close pads with black */
+int test_padding(const uint8_t *rgb) {
+    printf("TEST 5: Early close pads missing rows\n");
+    if (write_image(SSTV_IMAGE_PPM, rgb, 5) != 0) {
+        printf("  FAIL: write failed\n");
+        return 0;
+    }
+    size_t len;
+    uint8_t *buf = read_file(&len);
+    char hdr[32];
+    int hl = snprintf(hdr, sizeof(hdr), "P6\n%d %d\n255\n", TEST_W, TEST_H);
+    int ok = buf && len == (size_t)hl + TEST_W * TEST_H * 3 &&
+             memcmp(buf + hl, rgb, TEST_W * 5 * 3) == 0;
+    for (size_t i = (size_t)hl + TEST_W * 5 * 3; ok && i < len; i++) {
+        ok = buf[i] == 0;
+    }
+    free(buf);
+    printf(ok ? "  PASS\n" : "  FAIL: padding mismatch\n");
+    return ok;
+}
+
+int main(void) {
+    printf("=== Image Writer Tests ===\n\n");
+
+    static uint8_t rgb[TEST_W * TEST_H * 3];
+    make_test_image(rgb);
+
+    int passed = 0;
+    int total = 0;
+    size_t stored_size = 0;
+
+    total++; passed += test_ppm(rgb);
+    total++; passed += test_qoi(rgb);
+    total++; passed += test_png_stored(rgb, &stored_size);
+    total++; passed += test_png_fast(rgb, stored_size);
+    total++; passed += test_padding(rgb);
+    total++; passed += test_qoi_black();
+
+    remove(kTmpPath);
+
+    printf("\n=== Results: %d/%d passed ===\n", passed, total);
+    return (passed == total) ? 0 : 1;
+}
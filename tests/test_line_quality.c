@@ -0,0 +1,170 @@
+/*
+ * Line quality / confidence plane test
+ *
+ * Tests:
+ *   1. Clean Robot 36: every line is measured, with a high SNR, a matched
+ *      line sync and high pixel confidence
+ *   2. Noise burst over the second half of the frame: the affected lines
+ *      and the matching rows of the confidence plane drop, the clean half
+ *      does not
+ *   3. The plane is only kept when enabled, and argument errors are caught
+ *
+ * Build: make test_line_quality
+ * Run: ./bin/test_line_quality
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sstv_decoder.h"
+#include "sstv_encoder.h"
+#include "test_signal.h"
+
+#define SAMPLE_RATE 22050.0
+#define TEST_MODE SSTV_R36
+#define CHUNK 4096
+
+/* Encode a gradient frame; from sample noise_from on, add Gaussian noise */
+static float* encode_test_frame(size_t noise_from, double noise_rms, size_t *count) {
+    float *samples = encode_frame(TEST_MODE, SAMPLE_RATE, pixel_gradient, count);
+    if (samples && noise_from < *count) {
+        add_awgn(samples + noise_from, *count - noise_from, 777, noise_rms);
+    }
+    return samples;
+}
+
+static sstv_decoder_t* decode(const float *samples, size_t count, int plane) {
+    sstv_decoder_t *dec = sstv_decoder_create(SAMPLE_RATE);
+    if (!dec) return NULL;
+    sstv_decoder_set_confidence_enabled(dec, plane);
+    for (size_t pos = 0; pos < count; pos += CHUNK) {
+        size_t n = count - pos < CHUNK ? count - pos : CHUNK;
+        if (sstv_decoder_feed(dec, samples + pos, n) == SSTV_RX_IMAGE_READY) break;
+    }
+    return dec;
+}
+
+/* Mean over lines [a, b) */
+static void line_means(const sstv_line_quality_t *q, int a, int b,
+                       double *snr, double *sync, double *conf) {
+    *snr = *sync = *conf = 0.0;
+    for (int i = a; i < b; i++) {
+        *snr += q[i].snr_db;
+        *sync += q[i].sync_peak;
+        *conf += q[i].confidence;
+    }
+    *snr /= (b - a);
+    *sync /= (b - a);
+    *conf /= (b - a);
+}
+
+static double plane_mean(const sstv_image_t *p, int y0, int y1) {
+    double sum = 0.0;
+    for (int y = y0; y < y1; y++) {
+        for (uint32_t x = 0; x < p->width; x++) sum += p->pixels[(size_t)y * p->stride + x];
+    }
+    return sum / ((double)(y1 - y0) * p->width);
+}
+
+/* Test 1: clean frame */
+int test_clean(void) {
+    printf("TEST 1: Clean frame measures high quality on every line\n");
+    size_t count = 0;
+    float *samples = encode_test_frame((size_t)-1, 0.0, &count);
+    sstv_decoder_t *dec = samples ? decode(samples, count, 0) : NULL;
+    const sstv_mode_info_t *info = sstv_get_mode_info(TEST_MODE);
+    sstv_line_quality_t q[512];
+    int n = dec ? sstv_decoder_get_line_quality(dec, q, 512) : -1;
+
+    int ok = n == (int)info->height;
+    if (ok) {
+        double snr, sync, conf;
+        line_means(q, 0, n, &snr, &sync, &conf);
+        int synced = 0;
+        for (int i = 0; i < n; i++) synced += q[i].sync_peak > 0.5f;
+        printf("  %d lines: snr %.1f dB, sync %.2f (%d matched), confidence %.0f\n",
+               n, snr, sync, synced, conf);
+        ok = snr > 25.0 && synced >= n * 9 / 10 && conf > 230.0;
+    }
+    sstv_decoder_free(dec);
+    free(samples);
+    printf(ok ? "  PASS\n" : "  FAIL: clean frame rated low\n");
+    return ok;
+}
+
+/* Test 2: noise over the second half */
+int test_noise_burst(void) {
+    printf("TEST 2: Noise burst shows up in the affected lines only\n");
+    const sstv_mode_info_t *info = sstv_get_mode_info(TEST_MODE);
+    size_t clean_count = 0;
+    float *clean = encode_test_frame((size_t)-1, 0.0, &clean_count);
+    free(clean);
+    /* Image data ends about a second before the end of the buffer */
+    size_t image_end = clean_count - (size_t)SAMPLE_RATE;
+    size_t half = image_end - (size_t)(info->duration_sec * SAMPLE_RATE / 2.0);
+
+    size_t count = 0;
+    float *samples = encode_test_frame(half, TEST_AMPLITUDE * 0.5, &count);
+    sstv_decoder_t *dec = samples ? decode(samples, count, 1) : NULL;
+    sstv_line_quality_t q[512];
+    int n = dec ? sstv_decoder_get_line_quality(dec, q, 512) : -1;
+    sstv_image_t plane;
+
+    int ok = n == (int)info->height && sstv_decoder_get_confidence(dec, &plane) == 0 &&
+             plane.format == SSTV_GRAY8 && plane.width == info->width &&
+             plane.height == info->height;
+    if (ok) {
+        double s0, y0, c0, s1, y1, c1;
+        line_means(q, 8, n / 2 - 8, &s0, &y0, &c0);
+        line_means(q, n / 2 + 8, n - 8, &s1, &y1, &c1);
+        double p0 = plane_mean(&plane, 8, n / 2 - 8);
+        double p1 = plane_mean(&plane, n / 2 + 8, n - 8);
+        printf("  clean half: snr %.1f dB, sync %.2f, confidence %.0f, plane %.0f\n",
+               s0, y0, c0, p0);
+        printf("  noisy half: snr %.1f dB, sync %.2f, confidence %.0f, plane %.0f\n",
+               s1, y1, c1, p1);
+        ok = s0 > 25.0 && s1 < s0 - 10.0 && s1 > 3.0 && s1 < 20.0 &&
+             c1 < c0 - 10.0 && p1 < p0 - 10.0 && y1 <= y0;
+    }
+    sstv_decoder_free(dec);
+    free(samples);
+    printf(ok ? "  PASS\n" : "  FAIL: burst not reflected in line quality\n");
+    return ok;
+}
+
+/* Test 3: plane on demand, argument checks */
+int test_api(void) {
+    printf("TEST 3: Plane only when enabled, bad arguments rejected\n");
+    size_t count = 0;
+    float *samples = encode_test_frame((size_t)-1, 0.0, &count);
+    sstv_decoder_t *dec = samples ? decode(samples, count, 0) : NULL;
+    sstv_image_t plane;
+    int ok = dec && sstv_decoder_get_confidence(dec, &plane) == -1 &&
+             sstv_decoder_get_line_quality(dec, NULL, 0) > 0 &&
+             sstv_decoder_get_line_quality(NULL, NULL, 0) == -1 &&
+             sstv_decoder_set_confidence_enabled(NULL, 1) == -1;
+    if (ok) {
+        sstv_decoder_reset(dec);
+        ok = sstv_decoder_get_line_quality(dec, NULL, 0) == 0;
+    }
+    sstv_decoder_free(dec);
+    free(samples);
+    printf(ok ? "  PASS\n" : "  FAIL: API contract broken\n");
+    return ok;
+}
+
+int main(void) {
+    printf("=== Line Quality Tests ===\n\n");
+
+    int passed = 0;
+    int total = 0;
+
+    total++; passed += test_clean();
+    total++; passed += test_noise_burst();
+    total++; passed += test_api();
+
+    printf("\n=== Results: %d/%d passed ===\n", passed, total);
+    return (passed == total) ? 0 : 1;
+}
@@ -0,0 +1,180 @@
+/*
+ * Line sync correlator test
+ *
+ * Tests:
+ *   1. Clean Robot 36: the tracker locks and matches nearly every line
+ *      sync with no measured clock error
+ *   2. Sender clock 1000 ppm fast: the measured line period follows it and
+ *      the slant-corrected image is closer to the reference than an
+ *      open-loop re-decode at the nominal rate
+ *   3. Wideband noise at 1.5x the tone amplitude: lock holds and the period
+ *      estimate stays within 200 ppm
+ *   4. Status of a decoder that has seen no frame is all zeros
+ *
+ * Build: make test_line_sync
+ * Run: ./bin/test_line_sync
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sstv_decoder.h"
+#include "sstv_encoder.h"
+#include "test_signal.h"
+
+#define SAMPLE_RATE 22050.0
+#define TEST_MODE SSTV_R36
+
+static void pixel_stripes(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint8_t *p) {
+    (void)width;
+    (void)height;
+    p[0] = p[1] = p[2] = (uint8_t)((((x + y) / 16) & 1) ? 230 : 20);
+}
+
+/* Encode a diagonal-stripe frame as if the sender's clock ran at
+ * (1 + ppm) x SAMPLE_RATE, then add Gaussian noise of the given RMS */
+static float* encode_test_frame(double ppm, double noise_rms, size_t *count) {
+    float *samples = encode_frame_padded(TEST_MODE, SAMPLE_RATE * (1.0 + ppm * 1e-6), pixel_stripes,
+                                         0, (size_t)SAMPLE_RATE, count);
+    if (samples) add_awgn(samples, *count, 12345, noise_rms);
+    return samples;
+}
+
+/* Decode one frame, optionally keeping the frequency track */
+static int decode(const float *samples, size_t count, int track, sstv_decoder_t **out) {
+    sstv_decoder_t *dec = sstv_decoder_create(SAMPLE_RATE);
+    if (!dec) return 0;
+    if (track) sstv_decoder_set_track_enabled(dec, 1);
+    int ready = 0;
+    for (size_t pos = 0; pos < count && !ready; pos += 4096) {
+        size_t n = count - pos < 4096 ? count - pos : 4096;
+        ready = sstv_decoder_feed(dec, samples + pos, n) == SSTV_RX_IMAGE_READY;
+    }
+    *out = dec;
+    return ready;
+}
+
+static double image_diff(sstv_decoder_t *a, const uint8_t *ref) {
+    sstv_image_t img;
+    if (sstv_decoder_get_image(a, &img) != 0) return 999.0;
+    size_t n = (size_t)img.stride * img.height;
+    double sum = 0.0;
+    for (size_t i = 0; i < n; i++) sum += fabs((double)img.pixels[i] - (double)ref[i]);
+    return sum / (double)n;
+}
+
+int main(void) {
+    printf("=== Line Sync Correlator Tests ===\n\n");
+    const sstv_mode_info_t *info = sstv_get_mode_info(TEST_MODE);
+    int passed = 0;
+    int total = 0;
+    uint8_t *ref = NULL;
+
+    /* Test 1: clean signal */
+    printf("TEST 1: Clean signal locks on every line\n");
+    total++;
+    {
+        size_t count = 0;
+        float *samples = encode_test_frame(0.0, 0.0, &count);
+        sstv_decoder_t *dec = NULL;
+        int ready = samples && decode(samples, count, 0, &dec);
+        sstv_line_sync_t ls;
+        sstv_image_t img;
+        int ok = ready && sstv_decoder_get_line_sync(dec, &ls) == 0 &&
+                 sstv_decoder_get_image(dec, &img) == 0;
+        if (ok) {
+            ref = (uint8_t*)malloc((size_t)img.stride * img.height);
+            memcpy(ref, img.pixels, (size_t)img.stride * img.height);
+            printf("  found=%d missed=%d ppm=%.1f peak=%.2f\n",
+                   ls.lines_found, ls.lines_missed, ls.clock_ppm, ls.last_peak);
+            ok = ls.locked && ls.lines_found >= (int)info->height * 95 / 100 &&
+                 ls.lines_missed == 0 && fabs(ls.clock_ppm) < 50.0;
+        }
+        sstv_decoder_free(dec);
+        free(samples);
+        if (ok) {
+            printf("  PASS\n");
+            passed++;
+        } else {
+            printf("  FAIL: tracker did not follow the line sync\n");
+        }
+    }
+
+    /* Test 2: sender clock offset */
+    printf("TEST 2: 1000 ppm sender clock offset is measured and corrected\n");
+    total++;
+    {
+        size_t count = 0;
+        float *samples = encode_test_frame(1000.0, 0.0, &count);
+        sstv_decoder_t *dec = NULL;
+        int ready = ref && samples && decode(samples, count, 1, &dec);
+        sstv_line_sync_t ls;
+        int ok = ready && sstv_decoder_get_line_sync(dec, &ls) == 0;
+        if (ok) {
+            double corrected = image_diff(dec, ref);
+            int lines = sstv_decoder_redecode(dec, TEST_MODE, 0.0, 0);
+            double open_loop = lines > 0 ? image_diff(dec, ref) : 0.0;
+            printf("  ppm=%.1f |diff| corrected=%.2f open-loop=%.2f\n",
+                   ls.clock_ppm, corrected, open_loop);
+            ok = ls.locked && fabs(ls.clock_ppm - 1000.0) < 100.0 && corrected < open_loop;
+        }
+        sstv_decoder_free(dec);
+        free(samples);
+        if (ok) {
+            printf("  PASS\n");
+            passed++;
+        } else {
+            printf("  FAIL: clock offset not tracked\n");
+        }
+    }
+
+    /* Test 3: noise */
+    printf("TEST 3: Lock holds in wideband noise\n");
+    total++;
+    {
+        size_t count = 0;
+        float *samples = encode_test_frame(0.0, 1.5 * TEST_AMPLITUDE, &count);
+        sstv_decoder_t *dec = NULL;
+        int ready = samples && decode(samples, count, 0, &dec);
+        sstv_line_sync_t ls;
+        int ok = ready && sstv_decoder_get_line_sync(dec, &ls) == 0;
+        if (ok) {
+            printf("  found=%d missed=%d ppm=%.1f\n", ls.lines_found, ls.lines_missed, ls.clock_ppm);
+            ok = ls.locked && ls.lines_found >= (int)info->height * 80 / 100 &&
+                 fabs(ls.clock_ppm) < 200.0;
+        }
+        sstv_decoder_free(dec);
+        free(samples);
+        if (ok) {
+            printf("  PASS\n");
+            passed++;
+        } else {
+            printf("  FAIL: lock lost in noise\n");
+        }
+    }
+
+    /* Test 4: idle decoder */
+    printf("TEST 4: No frame, no status\n");
+    total++;
+    {
+        sstv_decoder_t *dec = sstv_decoder_create(SAMPLE_RATE);
+        sstv_line_sync_t ls;
+        memset(&ls, 0xff, sizeof(ls));
+        int ok = sstv_decoder_get_line_sync(dec, &ls) == 0 && !ls.locked &&
+                 ls.lines_found == 0 && ls.period_samples == 0.0 &&
+                 sstv_decoder_get_line_sync(dec, NULL) == -1;
+        sstv_decoder_free(dec);
+        if (ok) {
+            printf("  PASS\n");
+            passed++;
+        } else {
+            printf("  FAIL: unexpected status\n");
+        }
+    }
+
+    free(ref);
+    printf("\n=== Results: %d/%d passed ===\n", passed, total);
+    return (passed == total) ? 0 : 1;
+}
@@ -0,0 +1,305 @@
+/*
+ * Mode registry test
+ *
+ * Tests:
+ *   1. Every built-in mode is found again by name (any case) and by its
+ *      8- or 16-bit VIS code, and its descriptor agrees with the mode info
+ *   2. Line period lookup returns all modes sharing a period, nearest
+ *      first, and rejects tolerances the index cannot answer in O(1)
+ *   3. A custom mode (Robot 36 line format at half speed, own VIS code)
+ *      encodes, is recognised by the decoder from its VIS, and decodes
+ *      with the same error as Robot 36 itself
+ *   4. Registration errors: taken names and VIS codes, bad bases and
+ *      heights, a full registry, and unregistering
+ *   5. Register/unregister churn with a concurrent reader: lookups never
+ *      see a half-built index and early descriptors stay readable
+ *
+ * Build: make test_mode_registry
+ * Run: ./bin/test_mode_registry
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "sstv_encoder.h"
+#include "sstv_decoder.h"
+#include "test_signal.h"
+
+#define SAMPLE_RATE 11025.0
+
+static int test_builtin_lookups(void) {
+    printf("TEST 1: Built-in modes round-trip through name and VIS lookups\n");
+    int bad = 0;
+    for (int m = 0; m < SSTV_MODE_COUNT; m++) {
+        const sstv_mode_info_t *info = sstv_get_mode_info((sstv_mode_t)m);
+        const sstv_mode_desc_t *d = sstv_get_mode_desc((sstv_mode_t)m);
+        char upper[64];
+        size_t k;
+        for (k = 0; info->name[k] && k < sizeof(upper) - 1; k++) {
+            upper[k] = (char)toupper((unsigned char)info->name[k]);
+        }
+        upper[k] = '\0';
+
+        int ok = d && d->mode == (sstv_mode_t)m && d->base == (sstv_mode_t)m &&
+                 strcmp(d->name, info->name) == 0 && d->width == info->width &&
+                 d->height == info->height && d->is_color == info->is_color &&
+                 d->height % d->lines == 0 &&
+                 fabs(d->line_ms * d->lines / 1000.0 - info->duration_sec) < 0.01 &&
+                 sstv_find_mode_by_name(info->name) == m &&
+                 sstv_find_mode_by_name(upper) == m;
+        if (ok && d->vis_bits != 0) {
+            ok = sstv_find_mode_by_vis(d->vis_code, d->vis_bits == 16) == m;
+        }
+        if (!ok) {
+            printf("  mode %d (%s) failed\n", m, info->name);
+            bad++;
+        }
+    }
+    /* Same byte, told apart by the 0x23 prefix */
+    int shared = sstv_find_mode_by_vis(0x86, 0) == SSTV_BW12 &&
+                 sstv_find_mode_by_vis(0x86, 1) == SSTV_ML240;
+    int misses = sstv_find_mode_by_name("Robot 37") == -1 && sstv_find_mode_by_name("") == -1 &&
+                 sstv_find_mode_by_name(NULL) == -1 && sstv_find_mode_by_vis(0x23, 0) == -1 &&
+                 sstv_find_mode_by_vis(0x45, 0) == -1 && sstv_get_mode_desc(SSTV_MODE_COUNT) == NULL;
+    int ok = bad == 0 && shared && misses;
+    printf("  %d modes, %d mismatches, 0x86 split %s\n", SSTV_MODE_COUNT, bad, shared ? "yes" : "no");
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+static int test_line_period(void) {
+    printf("TEST 2: Line period lookup\n");
+    sstv_mode_t found[8];
+    int n570 = sstv_find_modes_by_line_ms(570.2, 0.5, found, 8);
+    int pair = n570 == 2 &&
+               ((found[0] == SSTV_MP73 && found[1] == SSTV_MN73) ||
+                (found[0] == SSTV_MN73 && found[1] == SSTV_MP73));
+
+    /* Scottie 1 (428.22) and MC110-N (428.5): nearest first */
+    int n428 = sstv_find_modes_by_line_ms(428.45, 0.5, found, 8);
+    int nearest = n428 == 2 && found[0] == SSTV_MC110 && found[1] == SSTV_SCOTTIE1;
+    int tight = sstv_find_modes_by_line_ms(428.22, 0.1, found, 8) == 1 && found[0] == SSTV_SCOTTIE1;
+
+    /* Bucket edges: B/W 8 (66.897) seen from the neighbouring bucket */
+    int edge = sstv_find_modes_by_line_ms(67.2, 0.5, NULL, 0) == 1;
+    int none = sstv_find_modes_by_line_ms(3000.0, 1.0, found, 8) == 0;
+    int errs = sstv_find_modes_by_line_ms(150.0, 9.0, found, 8) == -1 &&
+               sstv_find_modes_by_line_ms(0.0, 1.0, found, 8) == -1 &&
+               sstv_find_modes_by_line_ms(150.0, -1.0, found, 8) == -1;
+    int ok = pair && nearest && tight && edge && none && errs;
+    printf("  570 ms: %d modes, 428.45 ms: %d modes (nearest %s)\n", n570, n428,
+           nearest ? "MC110-N" : "wrong");
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+static void pixel_checker(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint8_t *p) {
+    p[0] = (uint8_t)(x * 255 / width);
+    p[1] = (uint8_t)(y * 255 / height);
+    p[2] = (uint8_t)(((x / 40) ^ (y / 30)) & 1 ? 200 : 60);
+}
+
+/* Decode and return a copy of the image (NULL if none) */
+static uint8_t* decode(const float *x, size_t n, sstv_mode_t *mode_out) {
+    sstv_decoder_t *dec = sstv_decoder_create(SAMPLE_RATE);
+    sstv_decoder_feed(dec, x, n);
+    sstv_decoder_state_t st;
+    sstv_image_t img;
+    uint8_t *copy = NULL;
+    *mode_out = SSTV_MODE_COUNT;
+    if (sstv_decoder_get_state(dec, &st) == 0 && sstv_decoder_get_image(dec, &img) == 0 &&
+        img.pixels) {
+        *mode_out = st.current_mode;
+        size_t bytes = (size_t)img.width * img.height * 3;
+        copy = (uint8_t*)malloc(bytes);
+        if (copy) memcpy(copy, img.pixels, bytes);
+    }
+    sstv_decoder_free(dec);
+    return copy;
+}
+
+static double mean_abs_diff(const uint8_t *a, const uint8_t *b, size_t bytes) {
+    double sum = 0.0;
+    for (size_t i = 0; i < bytes; i++) sum += fabs((double)a[i] - b[i]);
+    return sum / (double)bytes;
+}
+
+static int test_custom_round_trip(void) {
+    printf("TEST 3: Custom mode encodes and decodes through its VIS code\n");
+    sstv_custom_mode_t def;
+    memset(&def, 0, sizeof(def));
+    def.name = "Robot 36 Slow";
+    def.base = SSTV_R36;
+    def.line_ms = 300.0;
+    def.vis_code = 0x90;              /* 0x10 with even parity; unused */
+    int id = sstv_register_mode(&def);
+    const sstv_mode_desc_t *d = id >= 0 ? sstv_get_mode_desc((sstv_mode_t)id) : NULL;
+    const sstv_mode_info_t *info = id >= 0 ? sstv_get_mode_info((sstv_mode_t)id) : NULL;
+    int ok = id >= SSTV_MODE_CUSTOM_FIRST && d && info && d->base == SSTV_R36 &&
+             d->width == 320 && d->height == 240 && d->lines == 240 && d->line_ms == 300.0 &&
+             d->vis_bits == 8 && fabs(info->duration_sec - 72.0) < 1e-9 &&
+             sstv_find_mode_by_name("robot 36 slow") == id &&
+             sstv_find_mode_by_vis(0x90, 0) == id;
+    sstv_mode_t slow_found[4];
+    ok = ok && sstv_find_modes_by_line_ms(300.0, 0.01, slow_found, 4) == 2;   /* + Robot 72 */
+
+    uint8_t *rgb = make_image(SSTV_R36, pixel_checker);
+    size_t n_ref = 0, n_slow = 0;
+    float *ref = encode_frame_padded(SSTV_R36, SAMPLE_RATE, pixel_checker, 0, 0, &n_ref);
+    float *slow = ok ? encode_frame_padded((sstv_mode_t)id, SAMPLE_RATE, pixel_checker, 0, 0, &n_slow)
+                     : NULL;
+    sstv_mode_t m_ref = SSTV_MODE_COUNT, m_slow = SSTV_MODE_COUNT;
+    uint8_t *img_ref = ref ? decode(ref, n_ref, &m_ref) : NULL;
+    uint8_t *img_slow = slow ? decode(slow, n_slow, &m_slow) : NULL;
+    const size_t bytes = 320 * 240 * 3;
+    double e_ref = img_ref ? mean_abs_diff(img_ref, rgb, bytes) : -1.0;
+    double e_slow = img_slow ? mean_abs_diff(img_slow, rgb, bytes) : -1.0;
+
+    /* Image part twice as long; preamble and VIS unchanged */
+    long extra = (long)n_slow - (long)n_ref;
+    long want = (long)(36.0 * SAMPLE_RATE);
+    ok = ok && slow && labs(extra - want) < 64 && m_ref == SSTV_R36 && m_slow == (sstv_mode_t)id &&
+         e_slow >= 0.0 && e_ref >= 0.0 && e_slow <= e_ref + 2.0;
+    printf("  mode %d, %zu vs %zu samples, decoded as %d, error %.2f (Robot 36 %.2f)\n",
+           id, n_slow, n_ref, (int)m_slow, e_slow, e_ref);
+    ok = ok && sstv_unregister_mode((sstv_mode_t)id) == 0;
+    free(img_ref);
+    free(img_slow);
+    free(ref);
+    free(slow);
+    free(rgb);
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+static int test_registration_errors(void) {
+    printf("TEST 4: Registration errors, full registry, unregister\n");
+    sstv_custom_mode_t def;
+    memset(&def, 0, sizeof(def));
+    def.base = SSTV_PD120;
+
+    def.name = "martin 1";                                       /* taken (any case) */
+    int ok = sstv_register_mode(&def) == -1;
+    def.name = "PD120 Tall";
+    def.vis_code = 0x5f;                                         /* PD120's code */
+    ok = ok && sstv_register_mode(&def) == -1;
+    def.vis_code = 0x45;                                         /* MR73, but 8-bit is free */
+    def.height = 497;                                            /* PD pairs lines */
+    ok = ok && sstv_register_mode(&def) == -1;
+    def.height = 600;
+    def.base = SSTV_MODE_COUNT;
+    ok = ok && sstv_register_mode(&def) == -1;
+    def.base = SSTV_PD120;
+    def.vis_code = 0x23;                                         /* 16-bit prefix */
+    ok = ok && sstv_register_mode(&def) == -1 && sstv_register_mode(NULL) == -1;
+
+    def.vis_code = 0x45;
+    int tall = sstv_register_mode(&def);
+    const sstv_mode_desc_t *d = sstv_get_mode_desc((sstv_mode_t)tall);
+    ok = ok && tall >= SSTV_MODE_CUSTOM_FIRST && d && d->lines == 300 &&
+         sstv_find_mode_by_vis(0x45, 0) == tall && sstv_find_mode_by_vis(0x45, 1) == SSTV_MR73;
+
+    /* Fill the registry */
+    int ids[SSTV_MAX_CUSTOM_MODES];
+    int n = 0;
+    char names[SSTV_MAX_CUSTOM_MODES][16];
+    memset(&def, 0, sizeof(def));
+    def.base = SSTV_MARTIN1;
+    for (int i = 0; i < SSTV_MAX_CUSTOM_MODES; i++) {
+        snprintf(names[i], sizeof(names[i]), "Exp %d", i);
+        def.name = names[i];
+        def.line_ms = 400.0 + i;
+        int id = sstv_register_mode(&def);
+        if (id < 0) break;
+        ids[n++] = id;
+    }
+    int full = n == SSTV_MAX_CUSTOM_MODES - 1;                   /* "PD120 Tall" holds a slot */
+    int found_all = 1;
+    for (int i = 0; i < n; i++) {
+        if (sstv_find_mode_by_name(names[i]) != ids[i]) found_all = 0;
+    }
+
+    /* Unregister: the old descriptor stays readable, lookups forget it */
+    ok = ok && full && found_all && sstv_unregister_mode((sstv_mode_t)tall) == 0 &&
+         sstv_unregister_mode((sstv_mode_t)tall) == -1 &&
+         sstv_unregister_mode(SSTV_R36) == -1 &&
+         sstv_get_mode_desc((sstv_mode_t)tall) == NULL &&
+         sstv_find_mode_by_name("PD120 Tall") == -1 && sstv_find_mode_by_vis(0x45, 0) == -1 &&
+         sstv_encoder_create((sstv_mode_t)tall, SAMPLE_RATE) == NULL &&
+         d->lines == 300;
+    for (int i = 0; i < n; i++) sstv_unregister_mode((sstv_mode_t)ids[i]);
+    ok = ok && sstv_find_mode_by_name("Exp 0") == -1 && sstv_find_mode_by_name("Martin 1") == SSTV_MARTIN1;
+    printf("  %d custom modes registered before full\n", n + 1);
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+typedef struct {
+    volatile int stop;
+    long lookups;
+    long bad;
+} churn_reader_t;
+
+static void *churn_reader(void *arg) {
+    churn_reader_t *r = (churn_reader_t*)arg;
+    while (!r->stop) {
+        int id = sstv_find_mode_by_name("Churn");
+        const sstv_mode_desc_t *d = id >= 0 ? sstv_get_mode_desc((sstv_mode_t)id) : NULL;
+        if (id >= 0 && d && strcmp(d->name, "Churn") != 0) r->bad++;
+        if (sstv_find_mode_by_name("Martin 1") != SSTV_MARTIN1 ||
+            sstv_find_mode_by_vis(0x5f, 0) != SSTV_PD120) r->bad++;
+        r->lookups++;
+    }
+    return NULL;
+}
+
+static int test_churn(void) {
+    printf("TEST 5: Register/unregister churn under concurrent lookups\n");
+    sstv_custom_mode_t def;
+    memset(&def, 0, sizeof(def));
+    def.name = "Churn";
+    def.base = SSTV_SCOTTIE1;
+    def.vis_code = 0x90;
+
+    churn_reader_t r;
+    memset(&r, 0, sizeof(r));
+    pthread_t th;
+    int ok = pthread_create(&th, NULL, churn_reader, &r) == 0;
+    const sstv_mode_desc_t *first = NULL;
+    int cycles = 0;
+    for (int i = 0; ok && i < 20000; i++) {
+        int id = sstv_register_mode(&def);
+        if (id < 0) break;
+        if (!first) first = sstv_get_mode_desc((sstv_mode_t)id);
+        if (sstv_find_mode_by_vis(0x90, 0) != id || sstv_unregister_mode((sstv_mode_t)id) != 0) break;
+        cycles++;
+    }
+    r.stop = 1;
+    if (ok) pthread_join(th, NULL);
+
+    ok = ok && cycles == 20000 && r.bad == 0 && first && strcmp(first->name, "Churn") == 0 &&
+         first->base == SSTV_SCOTTIE1 && sstv_find_mode_by_name("Churn") == -1;
+    printf("  %d cycles, %ld concurrent lookups, %ld inconsistent\n", cycles, r.lookups, r.bad);
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+int main(void) {
+    printf("=== Mode Registry Tests ===\n\n");
+
+    int passed = 0;
+    int total = 0;
+
+    total++; passed += test_builtin_lookups();
+    total++; passed += test_line_period();
+    total++; passed += test_custom_round_trip();
+    total++; passed += test_registration_errors();
+    total++; passed += test_churn();
+
+    printf("\n=== Results: %d/%d passed ===\n", passed, total);
+    return (passed == total) ? 0 : 1;
+}
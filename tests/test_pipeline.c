@@ -0,0 +1,440 @@
+/*
+ * Stage pipeline test
+ *
+ * Tests:
+ *   1. Encoder -> decoder -> callback: inline and threaded runs give the
+ *      same rows as feeding the decoder by hand
+ *   2. Fan-out shares blocks: a buffer source's blocks reach two sinks as
+ *      views of caller memory, and an in-place stage copies only then
+ *   3. Resampler: unity gain, exact length, pass-through at equal rates,
+ *      and a 22050 Hz stream decodes on an 11025 Hz decoder
+ *   4. Files: encoder -> WAV sink, then WAV source -> channel -> DNR ->
+ *      decoder -> image sink, threaded
+ *   5. Graph errors: type mismatch, second input, cycles, unlinked stages,
+ *      wrong decoder rate, and a callback stopping a threaded run
+ *
+ * Build: make test_pipeline
+ * Run: ./bin/test_pipeline
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sstv_pipeline.h"
+#include "test_signal.h"
+
+static void pixel_checker(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint8_t *p) {
+    p[0] = (uint8_t)(x * 255 / width);
+    p[1] = (uint8_t)(y * 255 / height);
+    p[2] = (uint8_t)((x / 40 + y / 40) % 2 ? 200 : 40);
+}
+
+/* Encoder plus the image it reads from; both must outlive generation */
+typedef struct {
+    sstv_encoder_t *enc;
+    sstv_image_t image;
+    uint8_t *rgb;
+} tx_t;
+
+static int tx_open(tx_t *tx, sstv_mode_t mode, double rate) {
+    const sstv_mode_info_t *info = sstv_get_mode_info(mode);
+    memset(tx, 0, sizeof(*tx));
+    if (!info) return -1;
+    tx->rgb = make_image(mode, pixel_checker);
+    if (!tx->rgb) return -1;
+    tx->image = sstv_image_from_rgb(tx->rgb, info->width, info->height);
+    tx->enc = sstv_encoder_create(mode, rate);
+    if (!tx->enc || sstv_encoder_set_image(tx->enc, &tx->image) != 0) return -1;
+    sstv_encoder_set_vis_enabled(tx->enc, 1);
+    return 0;
+}
+
+static void tx_close(tx_t *tx) {
+    sstv_encoder_free(tx->enc);
+    free(tx->rgb);
+}
+
+/* Decoded frame collected row by row */
+typedef struct {
+    uint8_t *pixels;
+    uint32_t width, height;
+    int rows;
+    int frames_done;
+} frame_t;
+
+static void frame_store(frame_t *f, int line, const uint8_t *rgb, int width, int height) {
+    if (!f->pixels) {
+        f->width = (uint32_t)width;
+        f->height = (uint32_t)height;
+        f->pixels = (uint8_t*)calloc((size_t)width * height, 3);
+    }
+    if (f->pixels && line >= 0 && line < (int)f->height) {
+        memcpy(f->pixels + (size_t)line * f->width * 3, rgb, f->width * 3);
+        f->rows++;
+    }
+}
+
+static void on_line(void *user, int line, const uint8_t *rgb, int width, int height) {
+    frame_store((frame_t*)user, line, rgb, width, height);
+}
+
+static int on_row(void *user, const sstv_block_t *b) {
+    frame_t *f = (frame_t*)user;
+    if (b->type != SSTV_BLOCK_IMAGE_ROW || b->frame != 0) return 0;
+    frame_store(f, (int)b->line, b->row, (int)b->width, (int)b->height);
+    if (b->last_row) f->frames_done++;
+    return 0;
+}
+
+/* Direct decode, the way every utility used to do it */
+static void decode_direct(const float *x, size_t n, double rate, frame_t *f) {
+    sstv_decoder_t *dec = sstv_decoder_create(rate);
+    sstv_decoder_set_line_callback(dec, on_line, f);
+    for (size_t pos = 0; pos < n; pos += 1024) {
+        size_t len = n - pos < 1024 ? n - pos : 1024;
+        if (sstv_decoder_feed(dec, x + pos, len) == SSTV_RX_IMAGE_READY) break;
+    }
+    sstv_decoder_free(dec);
+}
+
+static double frame_diff(const frame_t *a, const frame_t *b) {
+    if (!a->pixels || !b->pixels || a->width != b->width || a->height != b->height) return 1e9;
+    size_t n = (size_t)a->width * a->height * 3;
+    double sum = 0.0;
+    for (size_t i = 0; i < n; i++) sum += fabs((double)a->pixels[i] - b->pixels[i]);
+    return sum / (double)n;
+}
+
+static int run_encode_decode(sstv_pipeline_mode_t mode, frame_t *f) {
+    tx_t tx;
+    tx_open(&tx, SSTV_R36, 11025.0);
+    sstv_decoder_t *dec = sstv_decoder_create(11025.0);
+    sstv_pipeline_t *p = sstv_pipeline_create();
+    sstv_stage_t *src = sstv_pipeline_add_encoder_source(p, tx.enc, 11025.0, TEST_AMPLITUDE);
+    sstv_stage_t *dst = sstv_pipeline_add_decoder(p, dec, 11025.0);
+    sstv_stage_t *sink = sstv_pipeline_add_callback_sink(p, SSTV_BLOCK_IMAGE_ROW, on_row, f);
+    int rc = -1;
+    if (src && dst && sink && sstv_pipeline_link(p, src, dst) == 0 &&
+        sstv_pipeline_link(p, dst, sink) == 0) {
+        rc = sstv_pipeline_run(p, mode);
+        if (rc != 0) printf("  run failed: %s\n", sstv_pipeline_error(p));
+    }
+    sstv_pipeline_free(p);
+    sstv_decoder_free(dec);
+    tx_close(&tx);
+    return rc;
+}
+
+static int test_encode_decode(void) {
+    printf("TEST 1: Encoder -> decoder -> callback, inline and threaded\n");
+    size_t n = 0;
+    float *x = encode_frame_padded(SSTV_R36, 11025.0, pixel_checker, 0, 0, &n);
+    frame_t ref = {0}, in = {0}, th = {0};
+    decode_direct(x, n, 11025.0, &ref);
+    int rc_in = run_encode_decode(SSTV_PIPELINE_INLINE, &in);
+    int rc_th = run_encode_decode(SSTV_PIPELINE_THREADED, &th);
+
+    int ok = ref.rows == 240 && rc_in == 0 && rc_th == 0 &&
+             in.rows == 240 && th.rows == 240 && in.frames_done == 1 && th.frames_done == 1 &&
+             frame_diff(&ref, &in) == 0.0 && frame_diff(&ref, &th) == 0.0;
+    printf("  rows: direct %d, inline %d, threaded %d; diff inline %.3f threaded %.3f\n",
+           ref.rows, in.rows, th.rows, frame_diff(&ref, &in), frame_diff(&ref, &th));
+    free(ref.pixels);
+    free(in.pixels);
+    free(th.pixels);
+    free(x);
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+/* Records where each block's samples live */
+typedef struct {
+    const float *base;
+    int blocks;
+    int views;                   /* Blocks pointing at base + position */
+    double sum;
+} tap_t;
+
+static int on_audio(void *user, const sstv_block_t *b) {
+    tap_t *t = (tap_t*)user;
+    t->blocks++;
+    if (t->base && b->samples == t->base + b->position) t->views++;
+    for (size_t i = 0; i < b->count; i++) t->sum += b->samples[i];
+    return 0;
+}
+
+static int test_fanout(void) {
+    printf("TEST 2: Fan-out shares blocks, in-place stages copy only when shared\n");
+    size_t n = 10000;
+    float *x = (float*)malloc(n * sizeof(float));
+    double ref = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        x[i] = (float)(1000.0 * sin(0.01 * (double)i));
+        ref += x[i];
+    }
+
+    sstv_pipeline_t *p = sstv_pipeline_create();
+    sstv_pipeline_set_block_size(p, 1000);
+    tap_t a = {x, 0, 0, 0.0}, b = {x, 0, 0, 0.0}, c = {NULL, 0, 0, 0.0};
+    sstv_channel_params_t ch;
+    memset(&ch, 0, sizeof(ch));
+    ch.gain = 2.0f;
+    sstv_stage_t *src = sstv_pipeline_add_buffer_source(p, x, n, 8000.0);
+    sstv_stage_t *sa = sstv_pipeline_add_callback_sink(p, SSTV_BLOCK_AUDIO, on_audio, &a);
+    sstv_stage_t *sb = sstv_pipeline_add_callback_sink(p, SSTV_BLOCK_AUDIO, on_audio, &b);
+    sstv_stage_t *gain = sstv_pipeline_add_channel(p, &ch);
+    sstv_stage_t *sc = sstv_pipeline_add_callback_sink(p, SSTV_BLOCK_AUDIO, on_audio, &c);
+    int rc = sstv_pipeline_link(p, src, sa) | sstv_pipeline_link(p, src, sb) |
+             sstv_pipeline_link(p, src, gain) | sstv_pipeline_link(p, gain, sc);
+    rc |= sstv_pipeline_run(p, SSTV_PIPELINE_INLINE);
+
+    sstv_stage_stats_t s_src, s_gain;
+    sstv_pipeline_get_stage_stats(src, &s_src);
+    sstv_pipeline_get_stage_stats(gain, &s_gain);
+    int ok = rc == 0 && a.blocks == 10 && a.views == 10 && b.views == 10 &&
+             fabs(a.sum - ref) < 1e-3 && fabs(c.sum - 2.0 * ref) < 1e-2 &&
+             s_src.blocks_out == 10 && s_gain.copies == 10 && s_gain.samples_out == n;
+    printf("  views %d/%d and %d/%d, channel copies %llu, gain sum ratio %.4f\n",
+           a.views, a.blocks, b.views, b.blocks, (unsigned long long)s_gain.copies,
+           ref != 0.0 ? c.sum / ref : 0.0);
+    sstv_pipeline_free(p);
+    free(x);
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+/* Collects a whole audio stream */
+typedef struct {
+    float *x;
+    size_t n, cap;
+    double rate;
+} capture_t;
+
+static int on_capture(void *user, const sstv_block_t *b) {
+    capture_t *c = (capture_t*)user;
+    if (c->n + b->count > c->cap) {
+        c->cap = (c->n + b->count) * 2;
+        c->x = (float*)realloc(c->x, c->cap * sizeof(float));
+    }
+    memcpy(c->x + c->n, b->samples, b->count * sizeof(float));
+    c->n += b->count;
+    c->rate = b->sample_rate;
+    return 0;
+}
+
+static int test_resampler(void) {
+    printf("TEST 3: Resampler gain, length, pass-through and decode\n");
+    /* 1 kHz sine, 48000 -> 11025 Hz */
+    size_t n = 48000;
+    float *x = (float*)malloc(n * sizeof(float));
+    for (size_t i = 0; i < n; i++) x[i] = (float)(10000.0 * sin(2.0 * M_PI * 1000.0 * i / 48000.0));
+    sstv_pipeline_t *p = sstv_pipeline_create();
+    capture_t cap = {NULL, 0, 0, 0.0};
+    tap_t same = {x, 0, 0, 0.0};
+    sstv_stage_t *src = sstv_pipeline_add_buffer_source(p, x, n, 48000.0);
+    sstv_stage_t *rs = sstv_pipeline_add_resampler(p, 11025.0);
+    sstv_stage_t *rs_same = sstv_pipeline_add_resampler(p, 48000.0);
+    int rc = sstv_pipeline_link(p, src, rs) | sstv_pipeline_link(p, src, rs_same);
+    rc |= sstv_pipeline_link(p, rs, sstv_pipeline_add_callback_sink(p, SSTV_BLOCK_AUDIO, on_capture, &cap));
+    rc |= sstv_pipeline_link(p, rs_same, sstv_pipeline_add_callback_sink(p, SSTV_BLOCK_AUDIO, on_audio, &same));
+    rc |= sstv_pipeline_run(p, SSTV_PIPELINE_THREADED);
+    sstv_pipeline_free(p);
+
+    /* Steady-state rms, away from the edges */
+    double rms = 0.0;
+    size_t lo = 1000, hi = cap.n > 1000 ? cap.n - 1000 : 0;
+    for (size_t i = lo; i < hi; i++) rms += (double)cap.x[i] * cap.x[i];
+    rms = hi > lo ? sqrt(rms / (double)(hi - lo)) : 0.0;
+    double want = 10000.0 / sqrt(2.0);
+    int ok_sine = rc == 0 && cap.n == 11025 && cap.rate == 11025.0 &&
+                  fabs(rms / want - 1.0) < 0.01 && same.views == same.blocks && same.blocks > 0;
+    printf("  48000 -> 11025: %zu samples, rms ratio %.4f; pass-through views %d/%d\n",
+           cap.n, rms / want, same.views, same.blocks);
+    free(cap.x);
+    free(x);
+
+    /* R36 sent at 22050 Hz, decoded at 11025 Hz. The reference is a
+     * native 11025 Hz encode; encoder timing quantisation alone makes
+     * native 11025 and 22050 Hz decodes differ by ~15 levels */
+    size_t m = 0;
+    float *y = encode_frame_padded(SSTV_R36, 11025.0, pixel_checker, 0, 0, &m);
+    frame_t ref = {0}, got = {0};
+    decode_direct(y, m, 11025.0, &ref);
+    free(y);
+    y = encode_frame_padded(SSTV_R36, 22050.0, pixel_checker, 0, 0, &m);
+    sstv_decoder_t *dec = sstv_decoder_create(11025.0);
+    p = sstv_pipeline_create();
+    src = sstv_pipeline_add_buffer_source(p, y, m, 22050.0);
+    rs = sstv_pipeline_add_resampler(p, 11025.0);
+    sstv_stage_t *d = sstv_pipeline_add_decoder(p, dec, 11025.0);
+    rc = sstv_pipeline_link(p, src, rs) | sstv_pipeline_link(p, rs, d);
+    rc |= sstv_pipeline_link(p, d, sstv_pipeline_add_callback_sink(p, SSTV_BLOCK_IMAGE_ROW, on_row, &got));
+    rc |= sstv_pipeline_run(p, SSTV_PIPELINE_INLINE);
+    sstv_pipeline_free(p);
+    sstv_decoder_free(dec);
+    free(y);
+    double diff = frame_diff(&ref, &got);
+    int ok_decode = rc == 0 && got.rows == 240 && diff < 10.0;
+    printf("  22050 -> 11025 decode: %d rows, mean diff %.2f vs native 11025\n", got.rows, diff);
+    free(ref.pixels);
+    free(got.pixels);
+
+    int ok = ok_sine && ok_decode;
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+static int test_files(void) {
+    printf("TEST 4: WAV sink, WAV source -> channel -> DNR -> decoder -> image sink\n");
+    const char *wav = "test_pipeline_out.wav";
+    const char *prefix = "test_pipeline_img";
+
+    tx_t tx;
+    tx_open(&tx, SSTV_BW8, 11025.0);
+    size_t total = sstv_encoder_get_total_samples(tx.enc);
+    sstv_pipeline_t *p = sstv_pipeline_create();
+    sstv_stage_t *src = sstv_pipeline_add_encoder_source(p, tx.enc, 11025.0, TEST_AMPLITUDE);
+    sstv_stage_t *ws = sstv_pipeline_add_wav_sink(p, wav);
+    int rc = sstv_pipeline_link(p, src, ws) | sstv_pipeline_run(p, SSTV_PIPELINE_THREADED);
+    sstv_stage_stats_t s_ws, s_enc;
+    sstv_pipeline_get_stage_stats(ws, &s_ws);
+    sstv_pipeline_get_stage_stats(src, &s_enc);
+    sstv_pipeline_free(p);
+    tx_close(&tx);
+    int ok_wav = rc == 0 && s_ws.samples_in >= total && s_ws.samples_in == s_enc.samples_out;
+    total = (size_t)s_ws.samples_in;
+    printf("  WAV sink: %llu samples\n", (unsigned long long)s_ws.samples_in);
+
+    sstv_channel_params_t ch;
+    memset(&ch, 0, sizeof(ch));
+    ch.gain = 0.8f;
+    ch.noise_rms = 300.0f;
+    ch.fade_hz = 0.2f;
+    ch.fade_depth_db = 6.0f;
+    ch.hum_level = 100.0f;
+    ch.seed = 7;
+    sstv_decoder_t *dec = sstv_decoder_create(11025.0);
+    frame_t got = {0};
+    p = sstv_pipeline_create();
+    src = sstv_pipeline_add_wav_source(p, wav);
+    sstv_stage_t *chan = sstv_pipeline_add_channel(p, &ch);
+    sstv_stage_t *dnr = sstv_pipeline_add_dnr(p, 0, 0);
+    sstv_stage_t *d = sstv_pipeline_add_decoder(p, dec, 11025.0);
+    sstv_stage_t *img = sstv_pipeline_add_image_sink(p, prefix, SSTV_IMAGE_PPM);
+    sstv_stage_t *cb = sstv_pipeline_add_callback_sink(p, SSTV_BLOCK_IMAGE_ROW, on_row, &got);
+    rc = -1;
+    if (src && chan && dnr && d && img && cb) {
+        rc = sstv_pipeline_link(p, src, chan) | sstv_pipeline_link(p, chan, dnr) |
+             sstv_pipeline_link(p, dnr, d) | sstv_pipeline_link(p, d, img) |
+             sstv_pipeline_link(p, d, cb);
+        rc |= sstv_pipeline_run(p, SSTV_PIPELINE_THREADED);
+        if (rc != 0) printf("  run failed: %s\n", sstv_pipeline_error(p));
+    }
+    sstv_stage_stats_t s_src, s_dnr;
+    sstv_pipeline_get_stage_stats(src, &s_src);
+    sstv_pipeline_get_stage_stats(dnr, &s_dnr);
+    sstv_pipeline_free(p);
+    sstv_decoder_free(dec);
+
+    char path[256];
+    snprintf(path, sizeof(path), "%s_0.ppm", prefix);
+    const sstv_mode_info_t *info = sstv_get_mode_info(SSTV_BW8);
+    char want[32], header[32] = {0};
+    snprintf(want, sizeof(want), "P6\n%u %u\n", info->width, info->height);
+    FILE *fp = fopen(path, "rb");
+    if (fp) {
+        if (fread(header, 1, strlen(want), fp) != strlen(want)) header[0] = 0;
+        fclose(fp);
+    }
+    int ok_chain = rc == 0 && s_src.samples_out == total && s_dnr.samples_out == total &&
+                   got.rows >= (int)info->height * 9 / 10 && strcmp(header, want) == 0;
+    printf("  chain: source %llu, dnr %llu samples, %d rows, image %s\n",
+           (unsigned long long)s_src.samples_out, (unsigned long long)s_dnr.samples_out,
+           got.rows, strcmp(header, want) == 0 ? "ok" : "missing");
+    free(got.pixels);
+    remove(wav);
+    remove(path);
+
+    int ok = ok_wav && ok_chain;
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+static int stop_at_third(void *user, const sstv_block_t *b) {
+    (void)b;
+    return ++*(int*)user >= 3;
+}
+
+static int test_errors(void) {
+    printf("TEST 5: Graph errors are reported\n");
+    float x[4096] = {0};
+    int ok = 1;
+
+    sstv_decoder_t *dec = sstv_decoder_create(11025.0);
+    sstv_pipeline_t *p = sstv_pipeline_create();
+    sstv_stage_t *src = sstv_pipeline_add_buffer_source(p, x, 4096, 22050.0);
+    sstv_stage_t *r1 = sstv_pipeline_add_resampler(p, 11025.0);
+    sstv_stage_t *r2 = sstv_pipeline_add_resampler(p, 11025.0);
+    sstv_stage_t *d = sstv_pipeline_add_decoder(p, dec, 11025.0);
+    sstv_stage_t *ws = sstv_pipeline_add_wav_sink(p, "test_pipeline_err.wav");
+    ok &= sstv_pipeline_link(p, d, ws) == -1;          /* rows into an audio sink */
+    ok &= sstv_pipeline_link(p, r1, r2) == 0;
+    ok &= sstv_pipeline_link(p, r2, r1) == -1;         /* cycle */
+    ok &= sstv_pipeline_link(p, src, r2) == -1;        /* second input */
+    ok &= sstv_pipeline_link(p, ws, r1) == -1;         /* out of a sink */
+    ok &= sstv_pipeline_link(p, src, d) == 0;
+    ok &= sstv_pipeline_run(p, SSTV_PIPELINE_INLINE) == -1;   /* r1 and ws unlinked */
+    printf("  unlinked: %s\n", sstv_pipeline_error(p));
+    ok &= strstr(sstv_pipeline_error(p), "no input") != NULL;
+    ok &= sstv_pipeline_run(p, SSTV_PIPELINE_INLINE) == -1;   /* runs once */
+    sstv_pipeline_free(p);
+    remove("test_pipeline_err.wav");
+
+    p = sstv_pipeline_create();
+    src = sstv_pipeline_add_buffer_source(p, x, 4096, 22050.0);
+    d = sstv_pipeline_add_decoder(p, dec, 11025.0);
+    ok &= sstv_pipeline_link(p, src, d) == 0;
+    ok &= sstv_pipeline_run(p, SSTV_PIPELINE_THREADED) == -1;
+    printf("  wrong rate: %s\n", sstv_pipeline_error(p));
+    ok &= strstr(sstv_pipeline_error(p), "decoder") != NULL;
+    sstv_pipeline_free(p);
+
+    /* A sink stopping early must not leave producers blocked on full queues */
+    int seen = 0;
+    p = sstv_pipeline_create();
+    sstv_pipeline_set_block_size(p, 64);
+    sstv_pipeline_set_queue_depth(p, 1);
+    src = sstv_pipeline_add_buffer_source(p, x, 4096, 22050.0);
+    r1 = sstv_pipeline_add_resampler(p, 22050.0);
+    ok &= sstv_pipeline_link(p, src, r1) == 0;
+    ok &= sstv_pipeline_link(p, r1, sstv_pipeline_add_callback_sink(p, SSTV_BLOCK_AUDIO, stop_at_third, &seen)) == 0;
+    ok &= sstv_pipeline_run(p, SSTV_PIPELINE_THREADED) == -1 && seen == 3;
+    printf("  stopped: %s\n", sstv_pipeline_error(p));
+    sstv_pipeline_free(p);
+
+    p = sstv_pipeline_create();
+    ok &= sstv_pipeline_add_wav_source(p, "test_pipeline_missing.wav") == NULL;
+    ok &= sstv_pipeline_add_dnr(p, 1000, 0) == NULL;     /* not a power of two */
+    sstv_pipeline_free(p);
+    sstv_decoder_free(dec);
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+int main(void) {
+    printf("=== Pipeline Tests ===\n\n");
+
+    int passed = 0;
+    int total = 0;
+
+    total++; passed += test_encode_decode();
+    total++; passed += test_fanout();
+    total++; passed += test_resampler();
+    total++; passed += test_files();
+    total++; passed += test_errors();
+
+    printf("\n=== Results: %d/%d passed ===\n", passed, total);
+    return (passed == total) ? 0 : 1;
+}
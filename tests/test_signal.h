@@ -0,0 +1,128 @@
+/*
+ * Test signal helpers - shared by the decoder tests
+ *
+ * Encode a synthetic frame, with its VIS header, to the int16-scale float
+ * samples the decoder expects, and add reproducible Gaussian noise.
+ * Header-only so each test stays a single translation unit.
+ */
+#ifndef SSTV_TEST_SIGNAL_H
+#define SSTV_TEST_SIGNAL_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sstv_encoder.h"
+
+/* Encoder output (+-1.0) to decoder input scale */
+#define TEST_AMPLITUDE 16000.0f
+
+/* Fills pixel (x, y) of a width x height test image: p[0..2] = R, G, B */
+typedef void (*test_pixel_fn)(uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                              uint8_t *p);
+
+/* Red ramps across, green down, blue mid grey */
+static inline void pixel_gradient(uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                                  uint8_t *p) {
+    p[0] = (uint8_t)(x * 255 / width);
+    p[1] = (uint8_t)(y * 255 / height);
+    p[2] = 128;
+}
+
+/**
+ * Build an RGB24 image of the mode's size
+ *
+ * @param mode Mode whose geometry to use
+ * @param rgb_fn Pixel pattern
+ * @return malloc'd width * height * 3 bytes, or NULL
+ */
+static inline uint8_t* make_image(sstv_mode_t mode, test_pixel_fn rgb_fn) {
+    const sstv_mode_info_t *info = sstv_get_mode_info(mode);
+    if (!info) return NULL;
+    uint8_t *rgb = (uint8_t*)malloc((size_t)info->width * info->height * 3);
+    if (!rgb) return NULL;
+    for (uint32_t y = 0; y < info->height; y++) {
+        for (uint32_t x = 0; x < info->width; x++) {
+            rgb_fn(x, y, info->width, info->height, rgb + ((size_t)y * info->width + x) * 3);
+        }
+    }
+    return rgb;
+}
+
+/**
+ * Encode one frame with VIS between stretches of silence
+ *
+ * @param mode Mode to send
+ * @param rate Encoder sample rate (differs from the decoder's to model
+ *             sender clock error)
+ * @param rgb_fn Pixel pattern
+ * @param lead Samples of silence before the transmission
+ * @param tail Samples of silence after its last sample
+ * @param count Output: total samples
+ * @return malloc'd int16-scale samples, or NULL
+ */
+static inline float* encode_frame_padded(sstv_mode_t mode, double rate, test_pixel_fn rgb_fn,
+                                         size_t lead, size_t tail, size_t *count) {
+    const sstv_mode_info_t *info = sstv_get_mode_info(mode);
+    uint8_t *rgb = make_image(mode, rgb_fn);
+    if (!rgb) return NULL;
+
+    sstv_image_t image = sstv_image_from_rgb(rgb, info->width, info->height);
+    sstv_encoder_t *enc = sstv_encoder_create(mode, rate);
+    if (!enc || sstv_encoder_set_image(enc, &image) != 0) {
+        sstv_encoder_free(enc);
+        free(rgb);
+        return NULL;
+    }
+    sstv_encoder_set_vis_enabled(enc, 1);
+
+    /* get_total_samples() can fall a few samples short; leave slack */
+    size_t cap = lead + sstv_encoder_get_total_samples(enc) + 4096;
+    float *s = (float*)calloc(cap + tail, sizeof(float));
+    size_t n = lead;
+    while (s && !sstv_encoder_is_complete(enc) && n < cap) {
+        size_t got = sstv_encoder_generate(enc, s + n, cap - n);
+        if (got == 0) break;
+        n += got;
+    }
+    sstv_encoder_free(enc);
+    free(rgb);
+    if (!s) return NULL;
+
+    for (size_t i = lead; i < n; i++) s[i] *= TEST_AMPLITUDE;
+    *count = n + tail;
+    return s;
+}
+
+/**
+ * Encode one frame with VIS, followed by a second of silence so the
+ * decoder runs past the last line
+ */
+static inline float* encode_frame(sstv_mode_t mode, double rate, test_pixel_fn rgb_fn,
+                                  size_t *count) {
+    return encode_frame_padded(mode, rate, rgb_fn, 0, (size_t)rate, count);
+}
+
+/* Box-Muller over a fixed LCG so runs are reproducible */
+static inline double gauss(uint32_t *seed) {
+    *seed = *seed * 1664525u + 1013904223u;
+    double u1 = ((*seed >> 8) + 1.0) / 16777217.0;
+    *seed = *seed * 1664525u + 1013904223u;
+    double u2 = (*seed >> 8) / 16777216.0;
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+/**
+ * Add white Gaussian noise
+ *
+ * @param s Samples, modified in place
+ * @param count Number of samples
+ * @param seed LCG seed; the same seed gives the same noise
+ * @param rms Noise RMS in sample units (<= 0 leaves s untouched)
+ */
+static inline void add_awgn(float *s, size_t count, uint32_t seed, double rms) {
+    if (!s || !(rms > 0.0)) return;
+    for (size_t i = 0; i < count; i++) s[i] += (float)(gauss(&seed) * rms);
+}
+
+#endif
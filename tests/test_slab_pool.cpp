@@ -0,0 +1,210 @@
+/*
+ * Slab pool allocator test
+ *
+ * Tests:
+ *   1. Decoders sharing a reserved pool allocate every frame and VIS
+ *      buffer from its free lists (no new slabs after the reserve)
+ *   2. A partial frame decoded into a recycled (dirty) slab reads back
+ *      identical to the malloc-backed decoder: received lines match and
+ *      the unreceived tail is black
+ *   3. Decoders on several threads share one pool; results match a
+ *      single-threaded run and every block is returned
+ *   4. The byte limit is enforced
+ *
+ * Build: make test_slab_pool
+ * Run: ./bin/test_slab_pool
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "sstv_encoder.h"
+#include "sstv_decoder.h"
+#include "test_signal.h"
+
+#define SAMPLE_RATE 22050.0
+#define TEST_MODE SSTV_R36
+#define CHUNK 4096
+
+/* Grey diagonal ramps; Seed shifts the pattern so frames differ */
+template <int Seed>
+static void pixel_diagonal(uint32_t x, uint32_t y, uint32_t, uint32_t, uint8_t *p) {
+    p[0] = p[1] = p[2] = static_cast<uint8_t>((x * 3 + y * 2 + Seed * 40) & 0xff);
+}
+
+static std::vector<float> encode_audio(test_pixel_fn rgb_fn) {
+    size_t count = 0;
+    float *s = encode_frame(TEST_MODE, SAMPLE_RATE, rgb_fn, &count);
+    std::vector<float> audio(s, s + (s ? count : 0));
+    free(s);
+    return audio;
+}
+
+struct decode_result_t {
+    int status;
+    uint64_t checksum;
+    std::vector<uint8_t> pixels;
+};
+
+/* Decode the first len samples; keep the (possibly partial) image */
+static decode_result_t decode(const sstv_allocator_t *alloc, const std::vector<float> &audio,
+                              size_t len) {
+    decode_result_t r;
+    r.status = -1;
+    r.checksum = 0;
+    sstv_decoder_t *dec = sstv_decoder_create_with_allocator(SAMPLE_RATE, alloc);
+    if (!dec) return r;
+    sstv_rx_status_t st = SSTV_RX_NEED_MORE;
+    for (size_t pos = 0; pos < len && st != SSTV_RX_IMAGE_READY; pos += CHUNK) {
+        size_t n = len - pos < CHUNK ? len - pos : CHUNK;
+        st = sstv_decoder_feed(dec, audio.data() + pos, n);
+    }
+    r.status = static_cast<int>(st);
+    r.checksum = sstv_decoder_get_checksum(dec);
+    sstv_image_t img;
+    if (sstv_decoder_get_image(dec, &img) == 0) {
+        r.pixels.assign(img.pixels, img.pixels + static_cast<size_t>(img.stride) * img.height);
+    }
+    sstv_decoder_free(dec);
+    return r;
+}
+
+static size_t frame_bytes() {
+    const sstv_mode_info_t *info = sstv_get_mode_info(TEST_MODE);
+    return static_cast<size_t>(info->width) * info->height * 3;
+}
+
+/* Test 1: reserved pool serves everything from free lists */
+static int test_reuse(const std::vector<float> &audio) {
+    std::printf("TEST 1: Reserved pool serves frames without new slabs\n");
+    sstv_slab_pool_t *pool = sstv_slab_pool_create(0);
+    sstv_allocator_t alloc;
+    size_t vis_bytes = static_cast<size_t>(0.800 * SAMPLE_RATE) * sizeof(double);
+    int ok = pool && sstv_slab_pool_allocator(pool, &alloc) == 0 &&
+             sstv_slab_pool_reserve(pool, frame_bytes(), 1) == 0 &&
+             sstv_slab_pool_reserve(pool, vis_bytes, 2) == 0;
+    sstv_slab_stats_t before, after;
+    ok = ok && sstv_slab_pool_get_stats(pool, &before) == 0;
+    for (int i = 0; ok && i < 3; i++) {
+        ok = decode(&alloc, audio, audio.size()).status == SSTV_RX_IMAGE_READY;
+    }
+    ok = ok && sstv_slab_pool_get_stats(pool, &after) == 0;
+    if (ok) {
+        std::printf("  %llu allocs, %llu reused, %zu bytes held, %d classes\n",
+                    static_cast<unsigned long long>(after.allocs),
+                    static_cast<unsigned long long>(after.reused),
+                    after.bytes_total, after.size_classes);
+        ok = after.allocs == 9 && after.reused == after.allocs &&
+             after.bytes_total == before.bytes_total && after.bytes_in_use == 0 &&
+             after.size_classes == 2;
+    }
+    sstv_slab_pool_free(pool);
+    std::printf(ok ? "  PASS\n" : "  FAIL: pool allocated new slabs\n");
+    return ok;
+}
+
+/* Test 2: partial frame in a dirty slab */
+static int test_dirty_slab(const std::vector<float> &a, const std::vector<float> &b) {
+    std::printf("TEST 2: Partial frame in a recycled slab matches malloc\n");
+    sstv_slab_pool_t *pool = sstv_slab_pool_create(0);
+    sstv_allocator_t alloc;
+    int ok = pool && sstv_slab_pool_allocator(pool, &alloc) == 0;
+
+    /* Leave frame a in the pool's only frame slab, then decode half of b */
+    ok = ok && decode(&alloc, a, a.size()).status == SSTV_RX_IMAGE_READY;
+    size_t half = b.size() / 2;
+    decode_result_t got = decode(&alloc, b, half);
+    decode_result_t ref = decode(NULL, b, half);
+    ok = ok && !ref.pixels.empty() && got.pixels == ref.pixels && got.checksum == ref.checksum;
+    if (ok) {
+        /* The tail of the reference is black: the stale frame must not show */
+        size_t black = 0;
+        for (size_t i = ref.pixels.size(); i > 0 && ref.pixels[i - 1] == 0; i--) black++;
+        std::printf("  %zu of %zu bytes not yet received, all black\n", black, ref.pixels.size());
+        ok = black > ref.pixels.size() / 4;
+    }
+    sstv_slab_pool_free(pool);
+    std::printf(ok ? "  PASS\n" : "  FAIL: recycled slab leaked into the image\n");
+    return ok;
+}
+
+/* Test 3: threads sharing the pool */
+static int test_threads(const std::vector<float> &a, const std::vector<float> &b) {
+    std::printf("TEST 3: Threads share one pool\n");
+    const int kThreads = 4;
+    sstv_slab_pool_t *pool = sstv_slab_pool_create(0);
+    sstv_allocator_t alloc;
+    int ok = pool && sstv_slab_pool_allocator(pool, &alloc) == 0;
+
+    decode_result_t ref[2] = { decode(NULL, a, a.size()), decode(NULL, b, b.size()) };
+    std::vector<decode_result_t> got(kThreads);
+    std::vector<std::thread> pool_threads;
+    for (int t = 0; ok && t < kThreads; t++) {
+        pool_threads.push_back(std::thread([&, t]() {
+            const std::vector<float> &audio = (t & 1) ? b : a;
+            got[t] = decode(&alloc, audio, audio.size());
+        }));
+    }
+    for (auto &th : pool_threads) th.join();
+    for (int t = 0; ok && t < kThreads; t++) {
+        ok = got[t].status == SSTV_RX_IMAGE_READY && got[t].pixels == ref[t & 1].pixels &&
+             got[t].checksum == ref[t & 1].checksum;
+    }
+    sstv_slab_stats_t st;
+    ok = ok && sstv_slab_pool_get_stats(pool, &st) == 0 && st.bytes_in_use == 0 &&
+         st.allocs == static_cast<uint64_t>(kThreads) * 3;
+    sstv_slab_pool_free(pool);
+    std::printf(ok ? "  PASS\n" : "  FAIL: shared pool changed the output\n");
+    return ok;
+}
+
+/* Test 4: byte limit */
+static int test_limit() {
+    std::printf("TEST 4: Byte limit enforced\n");
+    sstv_slab_pool_t *pool = sstv_slab_pool_create(frame_bytes() * 2);
+    sstv_slab_stats_t st;
+    sstv_allocator_t alloc;
+    int ok = pool && sstv_slab_pool_reserve(pool, frame_bytes(), 2) == 0 &&
+             sstv_slab_pool_reserve(pool, frame_bytes(), 3) == -1 &&
+             sstv_slab_pool_allocator(pool, &alloc) == 0;
+    if (ok) {
+        void *p[3];
+        for (int i = 0; i < 3; i++) p[i] = alloc.alloc(alloc.user, frame_bytes());
+        ok = p[0] && p[1] && !p[2] && sstv_slab_pool_get_stats(pool, &st) == 0 &&
+             st.failed == 2 && st.bytes_in_use == frame_bytes() * 2;
+        for (int i = 0; i < 3; i++) alloc.free(alloc.user, p[i], frame_bytes());
+    }
+    ok = ok && sstv_slab_pool_allocator(NULL, &alloc) == -1 &&
+         sstv_slab_pool_reserve(pool, 0, 1) == -1;
+    sstv_allocator_t bad = { NULL, NULL, NULL };
+    ok = ok && sstv_decoder_create_with_allocator(SAMPLE_RATE, &bad) == NULL;
+    sstv_slab_pool_free(pool);
+    std::printf(ok ? "  PASS\n" : "  FAIL: limit not enforced\n");
+    return ok;
+}
+
+int main() {
+    std::printf("=== Slab Pool Tests ===\n\n");
+
+    std::vector<float> a = encode_audio(pixel_diagonal<0>);
+    std::vector<float> b = encode_audio(pixel_diagonal<1>);
+    if (a.empty() || b.empty()) {
+        std::printf("FAIL: could not encode test frames\n");
+        return 1;
+    }
+
+    int passed = 0;
+    int total = 0;
+
+    total++; passed += test_reuse(a);
+    total++; passed += test_dirty_slab(a, b);
+    total++; passed += test_threads(a, b);
+    total++; passed += test_limit();
+
+    std::printf("\n=== Results: %d/%d passed ===\n", passed, total);
+    return (passed == total) ? 0 : 1;
+}
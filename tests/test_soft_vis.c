@@ -0,0 +1,156 @@
+/*
+ * Soft-decision VIS test
+ *
+ * Tests:
+ *   1. Clean 8-bit (Robot 36) and 16-bit (MR73, MP73, ML180) VIS lock with
+ *      a high soft confidence and no parity repairs
+ *   2. One VIS bit blurred into an even mix of mark and space: the weakest
+ *      bit is flipped back by the parity check, for the 8-bit word and for
+ *      the mode byte of a 16-bit word
+ *   3. 16-bit VIS under noise stronger than the signal (-3 dB) locks the right
+ *      mode in most trials and never a wrong one
+ *
+ * Build: make test_soft_vis
+ * Run: ./bin/test_soft_vis
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sstv_decoder.h"
+#include "sstv_encoder.h"
+#include "test_signal.h"
+
+#define SAMPLE_RATE 11025.0
+#define CHUNK 1024
+#define LEAD_SEC 0.5
+#define DATA_MS 1440.0               /* Preamble, leader, break, leader, start bit */
+#define BIT_MS 30.0
+
+static void pixel_grey(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint8_t *p) {
+    (void)x;
+    (void)y;
+    (void)width;
+    (void)height;
+    p[0] = p[1] = p[2] = 128;
+}
+
+/* VIS and the first two seconds of a grey frame, after LEAD_SEC of silence */
+static float* make_vis(sstv_mode_t mode, size_t *count) {
+    float *s = encode_frame_padded(mode, SAMPLE_RATE, pixel_grey, (size_t)(LEAD_SEC * SAMPLE_RATE), 0,
+                                   count);
+    size_t total = (size_t)((LEAD_SEC + 3.2) * SAMPLE_RATE);
+    if (s && *count > total) *count = total;
+    return s;
+}
+
+/* Replace VIS data bit `bit` (0 = first after the start bit) with an even
+ * mix of both tones, the space tone slightly stronger */
+static void blur_bit(float *s, int bit) {
+    size_t from = (size_t)((LEAD_SEC + (DATA_MS + bit * BIT_MS) / 1000.0) * SAMPLE_RATE);
+    size_t len = (size_t)(BIT_MS / 1000.0 * SAMPLE_RATE);
+    for (size_t i = 0; i < len; i++) {
+        double t = (double)i / SAMPLE_RATE;
+        s[from + i] = (float)(TEST_AMPLITUDE * (0.46 * sin(2.0 * M_PI * 1080.0 * t) +
+                                           0.54 * sin(2.0 * M_PI * 1320.0 * t)));
+    }
+}
+
+/* Decode; returns the locked mode (SSTV_MODE_COUNT if none) */
+static sstv_mode_t decode(const float *s, size_t count, sstv_sense_stats_t *stats) {
+    sstv_decoder_t *dec = sstv_decoder_create(SAMPLE_RATE);
+    if (!dec) return SSTV_MODE_COUNT;
+    for (size_t pos = 0; pos < count; pos += CHUNK) {
+        size_t n = count - pos < CHUNK ? count - pos : CHUNK;
+        sstv_decoder_feed(dec, s + pos, n);
+    }
+    sstv_decoder_state_t st;
+    sstv_mode_t mode = SSTV_MODE_COUNT;
+    if (sstv_decoder_get_state(dec, &st) == 0) mode = st.current_mode;
+    sstv_decoder_get_sense_stats(dec, stats);
+    sstv_decoder_free(dec);
+    return mode;
+}
+
+static int test_clean(void) {
+    printf("TEST 1: Clean 8- and 16-bit VIS lock with high confidence\n");
+    const sstv_mode_t modes[] = { SSTV_R36, SSTV_MR73, SSTV_MP73, SSTV_ML180 };
+    int ok = 1;
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        size_t count = 0;
+        float *s = make_vis(modes[m], &count);
+        sstv_sense_stats_t st;
+        memset(&st, 0, sizeof(st));
+        sstv_mode_t got = s ? decode(s, count, &st) : SSTV_MODE_COUNT;
+        printf("  %-8s locked %d, confidence %.2f, repairs %llu\n",
+               sstv_get_mode_info(modes[m])->name, got == modes[m], st.vis_confidence,
+               (unsigned long long)st.vis_repairs);
+        ok = ok && got == modes[m] && st.vis_confidence > 0.5 && st.vis_repairs == 0;
+        free(s);
+    }
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+static int test_repair(void) {
+    printf("TEST 2: A blurred bit is repaired by the parity check\n");
+    /* Robot 36 (0x88): bit 3 is a mark; MR73 (0x23, 0x45): mode byte bit 2 is a mark */
+    const sstv_mode_t modes[] = { SSTV_R36, SSTV_MR73 };
+    const int bits[] = { 3, 8 + 2 };
+    int ok = 1;
+    for (int m = 0; m < 2; m++) {
+        size_t count = 0;
+        float *s = make_vis(modes[m], &count);
+        if (s) blur_bit(s, bits[m]);
+        sstv_sense_stats_t st;
+        memset(&st, 0, sizeof(st));
+        sstv_mode_t got = s ? decode(s, count, &st) : SSTV_MODE_COUNT;
+        printf("  %-8s bit %d blurred: locked %d, confidence %.2f, repairs %llu\n",
+               sstv_get_mode_info(modes[m])->name, bits[m], got == modes[m],
+               st.vis_confidence, (unsigned long long)st.vis_repairs);
+        ok = ok && got == modes[m] && st.vis_repairs == 1 && st.vis_confidence > 0.0;
+        free(s);
+    }
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+static int test_noise(void) {
+    printf("TEST 3: 16-bit VIS in heavy noise\n");
+    const int trials = 10;
+    size_t count = 0;
+    float *clean = make_vis(SSTV_MR73, &count);
+    float *s = (float*)malloc(count * sizeof(float));
+    int locked = 0, wrong = 0;
+    for (int t = 0; clean && s && t < trials; t++) {
+        uint32_t seed = 1000u + (uint32_t)t * 7919u;
+        memcpy(s, clean, count * sizeof(float));
+        add_awgn(s, count, seed, TEST_AMPLITUDE);
+        sstv_sense_stats_t st;
+        sstv_mode_t got = decode(s, count, &st);
+        if (got == SSTV_MR73) locked++;
+        else if (got != SSTV_MODE_COUNT) wrong++;
+    }
+    printf("  MR73 locked in %d of %d trials, %d wrong modes\n", locked, trials, wrong);
+    int ok = clean && s && locked >= 9 && wrong == 0;
+    free(clean);
+    free(s);
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+int main(void) {
+    printf("=== Soft-Decision VIS Tests ===\n\n");
+
+    int passed = 0;
+    int total = 0;
+
+    total++; passed += test_clean();
+    total++; passed += test_repair();
+    total++; passed += test_noise();
+
+    printf("\n=== Results: %d/%d passed ===\n", passed, total);
+    return (passed == total) ? 0 : 1;
+}
@@ -0,0 +1,180 @@
+/*
+ * Per-state run handler test
+ *
+ * Idle and image reception run in blocks; with profiling on, every sample
+ * goes through the per-sample state machine instead. Both must leave the
+ * decoder in exactly the same state.
+ *
+ * Tests:
+ *   1. Noise with fixed levels (many start-bit triggers), then Robot 36:
+ *      checksums after every feed, counters and image are identical
+ *   2. The same with adaptive levels, the zero-crossing demodulator and
+ *      the frequency track on, fed in different chunk sizes
+ *   3. The line callback switches the demodulator and the track mid-frame
+ *      (both ways), inside large feeds
+ *
+ * Build: make test_state_runs
+ * Run: ./bin/test_state_runs
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sstv_decoder.h"
+#include "sstv_encoder.h"
+#include "test_signal.h"
+
+#define SAMPLE_RATE 11025.0
+#define TEST_MODE SSTV_R36
+
+static void pixel_xor(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint8_t *p) {
+    p[0] = (uint8_t)(x * 255 / width);
+    p[1] = (uint8_t)(y * 255 / height);
+    p[2] = (uint8_t)((x ^ y) & 0xff);
+}
+
+/* `lead_sec` of noise, then a frame, with noise of noise_rms throughout */
+static float* make_signal(double lead_sec, double noise_rms, size_t *count) {
+    float *s = encode_frame_padded(TEST_MODE, SAMPLE_RATE, pixel_xor, (size_t)(lead_sec * SAMPLE_RATE),
+                                   (size_t)SAMPLE_RATE, count);
+    if (s) add_awgn(s, *count, 777, noise_rms);
+    return s;
+}
+
+typedef struct {
+    double rate;                 /* False-alarm rate (0 = fixed levels) */
+    sstv_demod_t demod;
+    int track;
+    int flip_line;               /* Line whose callback flips demod and track (0 = none) */
+} setup_t;
+
+/* Line callback: at the given lines, swap the demodulator and the track */
+typedef struct {
+    sstv_decoder_t *dec;
+    int flip_line;
+} flipper_t;
+
+static void flip_on_line(void *user, int line, const uint8_t *rgb, int width, int height) {
+    flipper_t *f = (flipper_t*)user;
+    (void)rgb;
+    (void)width;
+    (void)height;
+    if (line == f->flip_line) {
+        sstv_decoder_set_demod(f->dec, SSTV_DEMOD_ZC);
+        sstv_decoder_set_track_enabled(f->dec, 1);
+    } else if (line == 2 * f->flip_line) {
+        sstv_decoder_set_demod(f->dec, SSTV_DEMOD_TONE);
+        sstv_decoder_set_track_enabled(f->dec, 0);
+    }
+}
+
+static sstv_decoder_t* make_decoder(const setup_t *su, int per_sample) {
+    sstv_decoder_t *dec = sstv_decoder_create(SAMPLE_RATE);
+    if (!dec) return NULL;
+    sstv_decoder_set_false_alarm_rate(dec, su->rate);
+    sstv_decoder_set_demod(dec, su->demod);
+    sstv_decoder_set_track_enabled(dec, su->track);
+    /* Profiling times samples one by one, so it takes the per-sample path */
+    sstv_decoder_set_profiling(dec, per_sample);
+    return dec;
+}
+
+/* Feed both decoders in varying chunk sizes, comparing as they go */
+static int run_pair(const setup_t *su, const float *s, size_t count, const size_t *chunks, int nchunks) {
+    sstv_decoder_t *runs = make_decoder(su, 0);
+    sstv_decoder_t *ref = make_decoder(su, 1);
+    int ok = runs && ref;
+    flipper_t fa = { runs, su->flip_line }, fb = { ref, su->flip_line };
+    if (ok && su->flip_line > 0) {
+        sstv_decoder_set_line_callback(runs, flip_on_line, &fa);
+        sstv_decoder_set_line_callback(ref, flip_on_line, &fb);
+    }
+    size_t pos = 0, feeds = 0, diverged = 0;
+    while (ok && pos < count) {
+        size_t n = chunks[feeds % (size_t)nchunks];
+        if (n > count - pos) n = count - pos;
+        sstv_rx_status_t a = sstv_decoder_feed(runs, s + pos, n);
+        sstv_rx_status_t b = sstv_decoder_feed(ref, s + pos, n);
+        if (a != b || sstv_decoder_get_checksum(runs) != sstv_decoder_get_checksum(ref)) {
+            diverged++;
+        }
+        pos += n;
+        feeds++;
+    }
+
+    sstv_sense_stats_t sa, sb;
+    sstv_image_t ia, ib;
+    memset(&ia, 0, sizeof(ia));
+    memset(&ib, 0, sizeof(ib));
+    ok = ok && diverged == 0 &&
+         sstv_decoder_get_sense_stats(runs, &sa) == 0 &&
+         sstv_decoder_get_sense_stats(ref, &sb) == 0 &&
+         sstv_decoder_get_image(runs, &ia) == 0 &&
+         sstv_decoder_get_image(ref, &ib) == 0;
+    if (ok) {
+        printf("  %zu feeds, %llu triggers, %llu false starts, %llu locks\n", feeds,
+               (unsigned long long)sa.triggers, (unsigned long long)sa.false_starts,
+               (unsigned long long)sa.vis_locks);
+        ok = sa.triggers == sb.triggers && sa.false_starts == sb.false_starts &&
+             sa.vis_locks == 1 && sb.vis_locks == 1 && sa.k == sb.k &&
+             ia.width == ib.width && ia.height == ib.height &&
+             memcmp(ia.pixels, ib.pixels, (size_t)ia.stride * ia.height) == 0;
+    } else {
+        printf("  %zu of %zu feeds diverged\n", diverged, feeds);
+    }
+    sstv_decoder_free(runs);
+    sstv_decoder_free(ref);
+    return ok;
+}
+
+static int test_fixed_levels(void) {
+    printf("TEST 1: Noise then Robot 36, fixed levels: runs match per-sample\n");
+    size_t count = 0;
+    float *s = make_signal(30.0, 9000.0, &count);
+    setup_t su = { 0.0, SSTV_DEMOD_TONE, 0, 0 };
+    size_t chunks[] = { 4096 };
+    int ok = s && run_pair(&su, s, count, chunks, 1);
+    free(s);
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+static int test_adaptive_zc(void) {
+    printf("TEST 2: Adaptive levels, zero-crossing demod and track, odd chunks\n");
+    size_t count = 0;
+    float *s = make_signal(30.0, 7000.0, &count);
+    setup_t su = { 3600.0, SSTV_DEMOD_ZC, 1, 0 };
+    size_t chunks[] = { 1, 37, 255, 256, 257, 1000, 3 };
+    int ok = s && run_pair(&su, s, count, chunks, 7);
+    free(s);
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+static int test_switch_in_callback(void) {
+    printf("TEST 3: Demodulator and track switched from the line callback\n");
+    size_t count = 0;
+    float *s = make_signal(2.0, 3000.0, &count);
+    setup_t su = { 0.0, SSTV_DEMOD_TONE, 0, 60 };
+    size_t chunks[] = { 65536, 4096 };
+    int ok = s && run_pair(&su, s, count, chunks, 2);
+    free(s);
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+int main(void) {
+    printf("=== State Run Handler Tests ===\n\n");
+
+    int passed = 0;
+    int total = 0;
+
+    total++; passed += test_fixed_levels();
+    total++; passed += test_adaptive_zc();
+    total++; passed += test_switch_in_callback();
+
+    printf("\n=== Results: %d/%d passed ===\n", passed, total);
+    return (passed == total) ? 0 : 1;
+}
@@ -0,0 +1,200 @@
+/*
+ * Pull-model TX adapter test
+ *
+ * Tests:
+ *   1. Small pulls return exactly the samples sstv_encoder_generate()
+ *      writes, bit for bit, and the adapter then reports it is done
+ *   2. A reader pacing 128-frame pulls at twice real time with a 50 ms
+ *      budget sees no underruns over four seconds of audio
+ *   3. Pulling without start counts underruns; pulls after the end are
+ *      silence, not underruns; bad arguments are rejected
+ *
+ * Build: make test_tx
+ * Run: ./bin/test_tx
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sstv_tx.h"
+
+#define SAMPLE_RATE 11025.0
+#define TEST_MODE SSTV_R36
+
+/* Encoder plus the image it reads from; both must outlive generation */
+typedef struct {
+    sstv_encoder_t *enc;
+    sstv_image_t image;
+    uint8_t *rgb;
+} src_t;
+
+static int src_open(src_t *src) {
+    const sstv_mode_info_t *info = sstv_get_mode_info(TEST_MODE);
+    memset(src, 0, sizeof(*src));
+    src->rgb = (uint8_t*)malloc(info->width * info->height * 3);
+    if (!src->rgb) return -1;
+    for (uint32_t y = 0; y < info->height; y++) {
+        for (uint32_t x = 0; x < info->width; x++) {
+            uint8_t *p = &src->rgb[(y * info->width + x) * 3];
+            p[0] = (uint8_t)(x * 255 / info->width);
+            p[1] = (uint8_t)(y * 255 / info->height);
+            p[2] = (uint8_t)((x ^ y) & 0xff);
+        }
+    }
+    src->image = sstv_image_from_rgb(src->rgb, info->width, info->height);
+    src->enc = sstv_encoder_create(TEST_MODE, SAMPLE_RATE);
+    if (!src->enc) return -1;
+    sstv_encoder_set_image(src->enc, &src->image);
+    sstv_encoder_set_vis_enabled(src->enc, 1);
+    return 0;
+}
+
+static void src_close(src_t *src) {
+    sstv_encoder_free(src->enc);
+    free(src->rgb);
+}
+
+/* Whole transmission straight from the encoder */
+static float* reference(size_t *count) {
+    src_t src;
+    if (src_open(&src) != 0) return NULL;
+    size_t cap = sstv_encoder_get_total_samples(src.enc) + 4096;
+    float *ref = (float*)malloc(cap * sizeof(float));
+    size_t n = 0;
+    while (ref && !sstv_encoder_is_complete(src.enc) && n < cap) {
+        size_t got = sstv_encoder_generate(src.enc, ref + n, cap - n < 1000 ? cap - n : 1000);
+        if (got == 0) break;
+        n += got;
+    }
+    src_close(&src);
+    *count = n;
+    return ref;
+}
+
+static int test_bit_exact(void) {
+    printf("TEST 1: 64-frame pulls match the encoder bit for bit\n");
+    size_t ref_n = 0;
+    float *ref = reference(&ref_n);
+    src_t src;
+    if (!ref || src_open(&src) != 0) {
+        printf("  FAIL\n");
+        return 0;
+    }
+    sstv_tx_t *tx = sstv_tx_create(src.enc, SAMPLE_RATE, 20.0);
+    float *got = (float*)malloc((ref_n + 4096) * sizeof(float));
+    size_t n = 0;
+    int ok = tx && got && sstv_tx_start(tx) == 0 && sstv_tx_start(tx) == -1;
+    struct timespec idle = { 0, 200000 };
+    int stalls = 0;
+    while (ok && !sstv_tx_is_done(tx) && n < ref_n + 64) {
+        float buf[64];
+        size_t k = sstv_tx_pull(tx, buf, 64);
+        memcpy(got + n, buf, k * sizeof(float));
+        n += k;
+        if (k == 0) {
+            if (++stalls > 100000) break;        /* producer stalled */
+            nanosleep(&idle, NULL);
+        }
+    }
+    sstv_tx_stats_t st;
+    sstv_tx_get_stats(tx, &st);
+    ok = ok && n == ref_n && memcmp(got, ref, ref_n * sizeof(float)) == 0 &&
+         st.frames_generated == ref_n && st.frames_pulled == ref_n && st.complete &&
+         (st.capacity & (st.capacity - 1)) == 0;
+    printf("  %zu of %zu samples, capacity %u, %llu underruns while racing the producer\n",
+           n, ref_n, st.capacity, (unsigned long long)st.underruns);
+    sstv_tx_free(tx);
+    src_close(&src);
+    free(got);
+    free(ref);
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+static int test_paced(void) {
+    printf("TEST 2: Paced pulls at 2x real time with a 50 ms budget never underrun\n");
+    src_t src;
+    if (src_open(&src) != 0) {
+        printf("  FAIL\n");
+        return 0;
+    }
+    sstv_tx_t *tx = sstv_tx_create(src.enc, SAMPLE_RATE, 50.0);
+    int ok = tx && sstv_tx_start(tx) == 0;
+    /* 128 frames at 11025 Hz is 11.6 ms; half of that per pull */
+    struct timespec period = { 0, (long)(128.0 / SAMPLE_RATE * 1e9 / 2.0) };
+    size_t pulled = 0;
+    while (ok && pulled < (size_t)(4.0 * SAMPLE_RATE)) {
+        float buf[128];
+        pulled += sstv_tx_pull(tx, buf, 128);
+        nanosleep(&period, NULL);
+    }
+    sstv_tx_stats_t st;
+    sstv_tx_get_stats(tx, &st);
+    ok = ok && st.underruns == 0 && st.underrun_frames == 0 && pulled == st.frames_pulled &&
+         st.min_fill > 0 && !st.complete;
+    printf("  %zu samples, %llu underruns, lowest fill %u of %u\n", pulled,
+           (unsigned long long)st.underruns, st.min_fill, st.capacity);
+    sstv_tx_free(tx);
+    src_close(&src);
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+static int test_edges(void) {
+    printf("TEST 3: Underruns before start, silence after the end, bad arguments\n");
+    src_t src;
+    if (src_open(&src) != 0) {
+        printf("  FAIL\n");
+        return 0;
+    }
+    float buf[256];
+    sstv_tx_stats_t st;
+    sstv_tx_t *tx = sstv_tx_create(src.enc, SAMPLE_RATE, 10.0);
+    int ok = tx != NULL;
+
+    /* Nothing produced yet: all silence, counted */
+    memset(buf, 0x7f, sizeof(buf));
+    ok = ok && sstv_tx_pull(tx, buf, 256) == 0 && buf[0] == 0.0f && buf[255] == 0.0f;
+    sstv_tx_get_stats(tx, &st);
+    ok = ok && st.underruns == 1 && st.underrun_frames == 256;
+
+    /* Drain, then pull past the end */
+    ok = ok && sstv_tx_start(tx) == 0;
+    while (ok && !sstv_tx_is_done(tx)) sstv_tx_pull(tx, buf, 256);
+    sstv_tx_get_stats(tx, &st);
+    uint64_t before = st.underruns;
+    memset(buf, 0x7f, sizeof(buf));
+    ok = ok && sstv_tx_pull(tx, buf, 256) == 0 && buf[17] == 0.0f;
+    sstv_tx_get_stats(tx, &st);
+    ok = ok && st.underruns == before && st.complete;
+    sstv_tx_free(tx);
+
+    ok = ok && sstv_tx_create(NULL, SAMPLE_RATE, 10.0) == NULL &&
+         sstv_tx_create(src.enc, 0.0, 10.0) == NULL &&
+         sstv_tx_create(src.enc, SAMPLE_RATE, 0.5) == NULL &&
+         sstv_tx_create(src.enc, SAMPLE_RATE, 5000.0) == NULL &&
+         sstv_tx_start(NULL) == -1 && sstv_tx_pull(NULL, buf, 16) == 0 &&
+         sstv_tx_get_stats(NULL, &st) == -1 && !sstv_tx_is_done(NULL);
+    sstv_tx_free(NULL);
+    src_close(&src);
+    printf(ok ? "  PASS\n" : "  FAIL\n");
+    return ok;
+}
+
+int main(void) {
+    printf("=== TX Adapter Tests ===\n\n");
+
+    int passed = 0;
+    int total = 0;
+
+    total++; passed += test_bit_exact();
+    total++; passed += test_paced();
+    total++; passed += test_edges();
+
+    printf("\n=== Results: %d/%d passed ===\n", passed, total);
+    return (passed == total) ? 0 : 1;
+}
@@ -0,0 +1,654 @@
+/*
+ * sstv_batch_decode - decode every WAV file under one or more paths
+ *
+ * Directories are walked recursively; each WAV is memory-mapped and decoded
+ * by one of N worker threads (one decoder instance per worker). Every image
+ * found in a file is written out (the decoder is reset after each image so
+ * back-to-back transmissions in a long recording are all recovered). Rows
+ * are streamed into the image file from the decoder's line callback, so an
+ * output file is finished as soon as its last line is decoded. One JSON
+ * object per image is appended to a manifest:
+ *
+ *   {"file":"a/b.wav","index":0,"offset":13230,"offset_sec":0.600,
+ *    "mode":"Scottie 1","width":320,"height":256,"lines":256,
+ *    "complete":true,"snr_db":21.4,"min_snr_db":18.9,"sync":0.62,
+ *    "confidence":203,"decode_ms":35.2,"output":"out/a_b_0.png"}
+ *
+ * "offset" is the sample position in the source file at which the VIS code
+ * was locked (start of image data), as reported by the decoder. The quality fields come from the
+ * decoder's per-line measurements (sstv_decoder_get_line_quality()):
+ * "snr_db" and "min_snr_db" are the mean and worst line SNR (video band vs
+ * an out-of-band slot), "sync" the mean line sync correlation and
+ * "confidence" the mean pixel confidence (0-255), so images can be triaged
+ * without another pass over the audio.
+ * A recording that ends mid-image is reported with "complete":false and
+ * the missing lines left black.
+ *
+ * Usage: sstv_batch_decode [-j N] [-f png|png-stored|qoi|ppm] [-o outdir]
+ *                          [-m manifest.jsonl|-] <file-or-dir>...
+ */
+
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "sstv_decoder.h"
+#include "sstv_image_writer.h"
+
+#define BLOCK_SAMPLES 1024
+
+/* ------------------------------------------------------------------ */
+/* WAV parsing (RIFF chunk walk over a mapped file)                   */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    uint16_t audio_format;     /* 1 = PCM, 3 = IEEE float */
+    uint16_t num_channels;
+    uint32_t sample_rate;
+    uint16_t bits_per_sample;
+    uint16_t block_align;
+    const uint8_t *data;
+    size_t frames;
+} wav_view_t;
+
+static uint16_t rd_le16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t rd_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static int wav_parse(const uint8_t *buf, size_t len, wav_view_t *wv) {
+    if (len < 12 || memcmp(buf, "RIFF", 4) != 0 || memcmp(buf + 8, "WAVE", 4) != 0) {
+        return -1;
+    }
+    memset(wv, 0, sizeof(*wv));
+    int have_fmt = 0;
+    size_t pos = 12;
+    while (pos + 8 <= len) {
+        const uint8_t *ck = buf + pos;
+        uint32_t ck_size = rd_le32(ck + 4);
+        size_t body = pos + 8;
+        size_t avail = len - body;
+
+        if (memcmp(ck, "fmt ", 4) == 0 && ck_size >= 16 && avail >= 16) {
+            wv->audio_format = rd_le16(ck + 8);
+            wv->num_channels = rd_le16(ck + 10);
+            wv->sample_rate = rd_le32(ck + 12);
+            wv->block_align = rd_le16(ck + 20);
+            wv->bits_per_sample = rd_le16(ck + 22);
+            /* WAVE_FORMAT_EXTENSIBLE: real format is the first 2 bytes of the GUID */
+            if (wv->audio_format == 0xFFFE && ck_size >= 26 && avail >= 26) {
+                wv->audio_format = rd_le16(ck + 32);
+            }
+            have_fmt = 1;
+        } else if (memcmp(ck, "data", 4) == 0) {
+            if (!have_fmt || wv->block_align == 0) return -1;
+            /* Truncated recordings are common in archives: clamp to file size */
+            size_t bytes = ck_size < avail ? ck_size : avail;
+            wv->data = ck + 8;
+            wv->frames = bytes / wv->block_align;
+            return 0;
+        }
+        pos = body + ck_size + (ck_size & 1);
+    }
+    return -1;
+}
+
+static int wav_supported(const wav_view_t *wv) {
+    if (wv->num_channels == 0 || wv->sample_rate == 0) return 0;
+    /* wav_convert reads every channel of a frame: a short block_align
+     * would run past the end of the mapping */
+    if (wv->block_align < (uint32_t)wv->num_channels * (wv->bits_per_sample / 8)) return 0;
+    if (wv->audio_format == 1) {
+        return wv->bits_per_sample == 8 || wv->bits_per_sample == 16 ||
+               wv->bits_per_sample == 24 || wv->bits_per_sample == 32;
+    }
+    if (wv->audio_format == 3) {
+        return wv->bits_per_sample == 32;
+    }
+    return 0;
+}
+
+/* Convert frames to mono float at int16 scale (what the decoder expects) */
+static void wav_convert(const wav_view_t *wv, size_t first, size_t count, float *out) {
+    const int ch = wv->num_channels;
+    const int bps = wv->bits_per_sample / 8;
+    const float inv_ch = 1.0f / (float)ch;
+    const uint8_t *p = wv->data + first * wv->block_align;
+
+    for (size_t i = 0; i < count; i++, p += wv->block_align) {
+        float acc = 0.0f;
+        for (int c = 0; c < ch; c++) {
+            const uint8_t *s = p + c * bps;
+            float v;
+            if (wv->audio_format == 3) {
+                union { uint32_t u; float f; } cv;
+                cv.u = rd_le32(s);
+                v = cv.f * 32767.0f;
+            } else if (bps == 1) {
+                v = (float)((int)s[0] - 128) * 256.0f;
+            } else if (bps == 2) {
+                v = (float)(int16_t)rd_le16(s);
+            } else if (bps == 3) {
+                int32_t x = (int32_t)((uint32_t)s[0] << 8 | (uint32_t)s[1] << 16 | (uint32_t)s[2] << 24);
+                v = (float)(x >> 8) * (1.0f / 256.0f);
+            } else {
+                v = (float)(int32_t)rd_le32(s) * (1.0f / 65536.0f);
+            }
+            acc += v;
+        }
+        out[i] = acc * inv_ch;
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* File list                                                          */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    char **items;
+    size_t count;
+    size_t cap;
+} path_list_t;
+
+static int path_list_add(path_list_t *l, const char *path) {
+    if (l->count == l->cap) {
+        size_t ncap = l->cap ? l->cap * 2 : 64;
+        char **n = (char**)realloc(l->items, ncap * sizeof(char*));
+        if (!n) return -1;
+        l->items = n;
+        l->cap = ncap;
+    }
+    l->items[l->count] = strdup(path);
+    if (!l->items[l->count]) return -1;
+    l->count++;
+    return 0;
+}
+
+static int has_wav_ext(const char *name) {
+    size_t n = strlen(name);
+    return n > 4 && strcasecmp(name + n - 4, ".wav") == 0;
+}
+
+static void collect_paths(path_list_t *l, const char *path, int top) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return;
+    }
+    if (S_ISREG(st.st_mode)) {
+        /* Explicitly named files are taken regardless of extension */
+        if (top || has_wav_ext(path)) path_list_add(l, path);
+        return;
+    }
+    if (!S_ISDIR(st.st_mode)) return;
+
+    DIR *d = opendir(path);
+    if (!d) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return;
+    }
+    struct dirent *de;
+    size_t plen = strlen(path);
+    while ((de = readdir(d)) != NULL) {
+        if (de->d_name[0] == '.') continue;
+        size_t len = plen + 1 + strlen(de->d_name) + 1;
+        char *child = (char*)malloc(len);
+        if (!child) break;
+        snprintf(child, len, "%s%s%s", path,
+                 (plen && path[plen - 1] == '/') ? "" : "/", de->d_name);
+        collect_paths(l, child, 0);
+        free(child);
+    }
+    closedir(d);
+}
+
+static int cmp_str(const void *a, const void *b) {
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+/* ------------------------------------------------------------------ */
+/* Worker pool                                                        */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    path_list_t files;
+    const char *outdir;
+    sstv_image_format_t fmt;
+    FILE *manifest;
+
+    pthread_mutex_t lock;      /* guards next_file, manifest, counters */
+    size_t next_file;
+    size_t images_total;
+    size_t files_failed;
+} batch_ctx_t;
+
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} strbuf_t;
+
+static void sb_putc(strbuf_t *sb, char c) {
+    if (sb->len + 2 > sb->cap) {
+        size_t ncap = sb->cap ? sb->cap * 2 : 512;
+        char *n = (char*)realloc(sb->data, ncap);
+        if (!n) return;
+        sb->data = n;
+        sb->cap = ncap;
+    }
+    sb->data[sb->len++] = c;
+    sb->data[sb->len] = '\0';
+}
+
+static void sb_printf(strbuf_t *sb, const char *fmt, ...) {
+    char tmp[256];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
+    va_end(ap);
+    for (int i = 0; i < n && i < (int)sizeof(tmp) - 1; i++) sb_putc(sb, tmp[i]);
+}
+
+static void sb_json_str(strbuf_t *sb, const char *s) {
+    sb_putc(sb, '"');
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        switch (c) {
+            case '"':  sb_putc(sb, '\\'); sb_putc(sb, '"'); break;
+            case '\\': sb_putc(sb, '\\'); sb_putc(sb, '\\'); break;
+            case '\n': sb_putc(sb, '\\'); sb_putc(sb, 'n'); break;
+            case '\r': sb_putc(sb, '\\'); sb_putc(sb, 'r'); break;
+            case '\t': sb_putc(sb, '\\'); sb_putc(sb, 't'); break;
+            default:
+                if (c < 0x20) sb_printf(sb, "\\u%04x", c);
+                else sb_putc(sb, (char)c);
+                break;
+        }
+    }
+    sb_putc(sb, '"');
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+/* Build "<outdir>/<path with separators flattened>_<index>.<ext>" */
+static void make_output_path(char *out, size_t cap, const char *outdir,
+                             const char *src, int index, sstv_image_format_t fmt) {
+    char stem[1024];
+    size_t n = 0;
+    const char *s = src;
+    while (s[0] == '.' && s[1] == '/') s += 2;
+    while (*s == '/') s++;
+    for (; *s && n + 1 < sizeof(stem); s++) {
+        stem[n++] = (*s == '/' || *s == '\\') ? '_' : *s;
+    }
+    stem[n] = '\0';
+    if (n > 4 && strcasecmp(stem + n - 4, ".wav") == 0) stem[n - 4] = '\0';
+    snprintf(out, cap, "%s/%s_%d.%s", outdir, stem, index, sstv_image_format_ext(fmt));
+}
+
+/* Per-file output state; rows arrive through the decoder line callback */
+typedef struct {
+    batch_ctx_t *ctx;
+    const char *path;
+    int index;                     /* Images finished so far in this file */
+    sstv_image_writer_t *writer;   /* Open while an image is being received */
+    int width, height;
+    int write_failed;
+    char out_path[1536];
+} image_sink_t;
+
+static void sink_on_line(void *user, int line, const uint8_t *rgb, int width, int height) {
+    image_sink_t *sink = (image_sink_t*)user;
+    (void)line;
+    if (sink->write_failed) return;
+    if (!sink->writer) {
+        make_output_path(sink->out_path, sizeof(sink->out_path), sink->ctx->outdir,
+                         sink->path, sink->index, sink->ctx->fmt);
+        sink->writer = sstv_image_writer_open(sink->out_path, sink->ctx->fmt,
+                                              (uint32_t)width, (uint32_t)height);
+        sink->width = width;
+        sink->height = height;
+        if (!sink->writer) {
+            fprintf(stderr, "%s: cannot create %s\n", sink->path, sink->out_path);
+            sink->write_failed = 1;
+            return;
+        }
+    }
+    if (sstv_image_writer_write_row(sink->writer, rgb) != 0) {
+        sink->write_failed = 1;
+    }
+}
+
+/* Frame summary of the decoder's per-line quality */
+typedef struct {
+    double snr_db, min_snr_db, sync, confidence;
+} frame_quality_t;
+
+static void frame_quality(sstv_decoder_t *dec, frame_quality_t *fq) {
+    sstv_line_quality_t lq[1024];
+    int n = sstv_decoder_get_line_quality(dec, lq, 1024);
+    if (n > 1024) n = 1024;
+    memset(fq, 0, sizeof(*fq));
+    if (n <= 0) return;
+    fq->min_snr_db = lq[0].snr_db;
+    for (int i = 0; i < n; i++) {
+        fq->snr_db += lq[i].snr_db;
+        fq->sync += lq[i].sync_peak;
+        fq->confidence += lq[i].confidence;
+        if (lq[i].snr_db < fq->min_snr_db) fq->min_snr_db = lq[i].snr_db;
+    }
+    fq->snr_db /= n;
+    fq->sync /= n;
+    fq->confidence /= n;
+}
+
+/* Close the current image (padding missing rows) and append its record */
+static void sink_finish(image_sink_t *sink, strbuf_t *sb, sstv_mode_t mode,
+                        size_t offset, uint32_t sample_rate, const frame_quality_t *fq,
+                        double elapsed_ms, int complete) {
+    int lines = sink->writer ? sstv_image_writer_rows(sink->writer) : 0;
+    if (sink->writer && sstv_image_writer_close(sink->writer) != 0) {
+        sink->write_failed = 1;
+    }
+    sink->writer = NULL;
+    if (sink->write_failed) {
+        fprintf(stderr, "%s: failed to write %s\n", sink->path, sink->out_path);
+    }
+
+    const sstv_mode_info_t *mi = sstv_get_mode_info(mode);
+    sb_printf(sb, "{\"file\":");
+    sb_json_str(sb, sink->path);
+    sb_printf(sb, ",\"index\":%d,\"offset\":%zu,\"offset_sec\":%.3f,\"mode\":",
+              sink->index, offset, (double)offset / sample_rate);
+    sb_json_str(sb, mi ? mi->name : "unknown");
+    sb_printf(sb, ",\"width\":%d,\"height\":%d,\"lines\":%d,\"complete\":%s,",
+              sink->width, sink->height, lines, complete ? "true" : "false");
+    sb_printf(sb, "\"snr_db\":%.1f,\"min_snr_db\":%.1f,\"sync\":%.2f,\"confidence\":%.0f,",
+              fq->snr_db, fq->min_snr_db, fq->sync, fq->confidence);
+    sb_printf(sb, "\"decode_ms\":%.1f,\"output\":", elapsed_ms);
+    if (!sink->write_failed && sink->out_path[0]) sb_json_str(sb, sink->out_path);
+    else sb_printf(sb, "null");
+    sb_printf(sb, "}\n");
+
+    sink->index++;
+    sink->write_failed = 0;
+    sink->out_path[0] = '\0';
+}
+
+/* Decode one file; returns number of images, -1 on open/format error */
+static int decode_file(batch_ctx_t *ctx, sstv_decoder_t **dec_cache,
+                       double *dec_rate, const char *path, strbuf_t *sb) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 44) {
+        fprintf(stderr, "%s: not a WAV file\n", path);
+        close(fd);
+        return -1;
+    }
+    size_t len = (size_t)st.st_size;
+    const uint8_t *map = (const uint8_t*)mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == (const uint8_t*)MAP_FAILED) {
+        fprintf(stderr, "%s: mmap: %s\n", path, strerror(errno));
+        return -1;
+    }
+    madvise((void*)map, len, MADV_SEQUENTIAL);
+
+    wav_view_t wv;
+    if (wav_parse(map, len, &wv) != 0 || !wav_supported(&wv)) {
+        fprintf(stderr, "%s: unsupported or invalid WAV file\n", path);
+        munmap((void*)map, len);
+        return -1;
+    }
+
+    /* Decoders are reused across files of the same rate */
+    if (!*dec_cache || *dec_rate != (double)wv.sample_rate) {
+        sstv_decoder_free(*dec_cache);
+        *dec_cache = sstv_decoder_create((double)wv.sample_rate);
+        *dec_rate = (double)wv.sample_rate;
+        if (!*dec_cache) {
+            munmap((void*)map, len);
+            return -1;
+        }
+        sstv_decoder_set_vis_enabled(*dec_cache, 1);
+    } else {
+        sstv_decoder_reset(*dec_cache);
+    }
+    sstv_decoder_t *dec = *dec_cache;
+
+    image_sink_t sink;
+    memset(&sink, 0, sizeof(sink));
+    sink.ctx = ctx;
+    sink.path = path;
+    sstv_decoder_set_line_callback(dec, sink_on_line, &sink);
+
+    float block[BLOCK_SAMPLES];
+    int locked = 0;
+    size_t lock_offset = 0;
+    size_t reset_pos = 0;                /* Decoder positions count from here */
+    sstv_mode_t lock_mode = SSTV_MODE_COUNT;
+    frame_quality_t fq;
+    double t_start = now_ms();
+
+    for (size_t pos = 0; pos < wv.frames; pos += BLOCK_SAMPLES) {
+        size_t n = wv.frames - pos;
+        if (n > BLOCK_SAMPLES) n = BLOCK_SAMPLES;
+        wav_convert(&wv, pos, n, block);
+
+        sstv_rx_status_t rs = sstv_decoder_feed(dec, block, n);
+
+        if (!locked) {
+            sstv_decoder_state_t ds;
+            if (sstv_decoder_get_state(dec, &ds) == 0 && ds.current_mode != SSTV_MODE_COUNT) {
+                locked = 1;
+                lock_offset = reset_pos + (size_t)ds.lock_sample;
+                lock_mode = ds.current_mode;
+            }
+        }
+
+        if (rs == SSTV_RX_IMAGE_READY) {
+            /* Every row has already been streamed out by the line callback */
+            frame_quality(dec, &fq);
+            sink_finish(&sink, sb, lock_mode, lock_offset, wv.sample_rate,
+                        &fq, now_ms() - t_start, 1);
+
+            /* Re-arm for the next transmission in the same recording */
+            sstv_decoder_reset(dec);
+            reset_pos = pos + n;
+            locked = 0;
+            t_start = now_ms();
+        } else if (rs == SSTV_RX_ERROR) {
+            fprintf(stderr, "%s: decoder error at sample %zu\n", path, pos);
+            break;
+        }
+    }
+
+    /* Recording ended mid-image: keep what was received */
+    if (sink.writer) {
+        frame_quality(dec, &fq);
+        sink_finish(&sink, sb, lock_mode, lock_offset, wv.sample_rate,
+                    &fq, now_ms() - t_start, 0);
+    }
+    sstv_decoder_set_line_callback(dec, NULL, NULL);
+
+    munmap((void*)map, len);
+    return sink.index;
+}
+
+static void* worker_main(void *arg) {
+    batch_ctx_t *ctx = (batch_ctx_t*)arg;
+    sstv_decoder_t *dec = NULL;
+    double dec_rate = 0.0;
+    strbuf_t sb = {NULL, 0, 0};
+
+    for (;;) {
+        pthread_mutex_lock(&ctx->lock);
+        size_t idx = ctx->next_file++;
+        pthread_mutex_unlock(&ctx->lock);
+        if (idx >= ctx->files.count) break;
+
+        const char *path = ctx->files.items[idx];
+        sb.len = 0;
+        int images = decode_file(ctx, &dec, &dec_rate, path, &sb);
+
+        /* Whole-file records are written under the lock so lines from
+         * different workers never interleave. */
+        pthread_mutex_lock(&ctx->lock);
+        if (images < 0) {
+            ctx->files_failed++;
+        } else {
+            ctx->images_total += (size_t)images;
+            if (sb.len) {
+                fwrite(sb.data, 1, sb.len, ctx->manifest);
+                fflush(ctx->manifest);
+            }
+        }
+        pthread_mutex_unlock(&ctx->lock);
+    }
+
+    sstv_decoder_free(dec);
+    free(sb.data);
+    return NULL;
+}
+
+static int parse_format(const char *name, sstv_image_format_t *out) {
+    if (strcasecmp(name, "png") == 0)             *out = SSTV_IMAGE_PNG;
+    else if (strcasecmp(name, "png-stored") == 0) *out = SSTV_IMAGE_PNG_STORED;
+    else if (strcasecmp(name, "qoi") == 0)        *out = SSTV_IMAGE_QOI;
+    else if (strcasecmp(name, "ppm") == 0)        *out = SSTV_IMAGE_PPM;
+    else return -1;
+    return 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [-j N] [-f png|png-stored|qoi|ppm] [-o outdir] [-m manifest.jsonl|-] <file-or-dir>...\n"
+            "  -j N   worker threads (default: online CPUs)\n"
+            "  -f     output image format (default: png)\n"
+            "  -o     output directory (default: .)\n"
+            "  -m     manifest path, '-' for stdout (default: <outdir>/manifest.jsonl)\n",
+            prog);
+}
+
+int main(int argc, char **argv) {
+    batch_ctx_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.outdir = ".";
+    ctx.fmt = SSTV_IMAGE_PNG;
+    const char *manifest_path = NULL;
+
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int jobs = ncpu > 0 ? (int)ncpu : 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "j:f:o:m:h")) != -1) {
+        switch (opt) {
+            case 'j':
+                jobs = atoi(optarg);
+                if (jobs < 1) jobs = 1;
+                break;
+            case 'f':
+                if (parse_format(optarg, &ctx.fmt) != 0) {
+                    fprintf(stderr, "Unknown format: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'o':
+                ctx.outdir = optarg;
+                break;
+            case 'm':
+                manifest_path = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (mkdir(ctx.outdir, 0777) != 0 && errno != EEXIST) {
+        fprintf(stderr, "%s: %s\n", ctx.outdir, strerror(errno));
+        return 1;
+    }
+
+    for (int i = optind; i < argc; i++) {
+        collect_paths(&ctx.files, argv[i], 1);
+    }
+    if (ctx.files.count == 0) {
+        fprintf(stderr, "No WAV files found.\n");
+        return 1;
+    }
+    qsort(ctx.files.items, ctx.files.count, sizeof(char*), cmp_str);
+
+    char default_manifest[1024];
+    if (!manifest_path) {
+        snprintf(default_manifest, sizeof(default_manifest), "%s/manifest.jsonl", ctx.outdir);
+        manifest_path = default_manifest;
+    }
+    if (strcmp(manifest_path, "-") == 0) {
+        ctx.manifest = stdout;
+    } else {
+        ctx.manifest = fopen(manifest_path, "w");
+        if (!ctx.manifest) {
+            fprintf(stderr, "%s: %s\n", manifest_path, strerror(errno));
+            return 1;
+        }
+    }
+
+    if ((size_t)jobs > ctx.files.count) jobs = (int)ctx.files.count;
+    pthread_mutex_init(&ctx.lock, NULL);
+
+    double t0 = now_ms();
+    pthread_t *threads = (pthread_t*)calloc((size_t)jobs, sizeof(pthread_t));
+    int started = 0;
+    for (int i = 0; threads && i < jobs; i++) {
+        if (pthread_create(&threads[i], NULL, worker_main, &ctx) != 0) break;
+        started++;
+    }
+    if (started == 0) {
+        /* No threads available: decode on the main thread */
+        worker_main(&ctx);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+    double t1 = now_ms();
+
+    pthread_mutex_destroy(&ctx.lock);
+    if (ctx.manifest != stdout) fclose(ctx.manifest);
+
+    fprintf(stderr, "Decoded %zu image(s) from %zu file(s) (%zu failed) in %.1f s using %d worker(s).\n",
+            ctx.images_total, ctx.files.count, ctx.files_failed, (t1 - t0) / 1000.0,
+            started ? started : 1);
+
+    for (size_t i = 0; i < ctx.files.count; i++) free(ctx.files.items[i]);
+    free(ctx.files.items);
+    return ctx.files_failed ? 2 : 0;
+}
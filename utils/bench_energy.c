@@ -0,0 +1,102 @@
+/*
+ * bench_energy - CPU package energy from Linux powercap (RAPL)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+
+#include "bench_energy.h"
+
+#define RAPL_ROOT "/sys/class/powercap"
+
+static int read_u64(const char *path, uint64_t *v) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    unsigned long long x = 0;
+    int ok = fscanf(f, "%llu", &x) == 1;
+    fclose(f);
+    if (!ok) return -1;
+    *v = (uint64_t)x;
+    return 0;
+}
+
+static int read_line(const char *path, char *buf, size_t size) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    int ok = fgets(buf, (int)size, f) != NULL;
+    fclose(f);
+    if (!ok) return -1;
+    buf[strcspn(buf, "\r\n")] = '\0';
+    return 0;
+}
+
+/* Top-level zones only ("intel-rapl:0", not the "intel-rapl:0:1" subzones,
+ * which are already counted in their package) */
+static int is_package_zone(const char *name) {
+    const char *p = strchr(name, ':');
+    return strncmp(name, "intel-rapl:", 11) == 0 && p && !strchr(p + 1, ':');
+}
+
+int bench_energy_open(bench_energy_t *e) {
+    memset(e, 0, sizeof(*e));
+    const char *root = getenv("SSTV_RAPL_ROOT");
+    if (!root || !*root) root = RAPL_ROOT;
+
+    DIR *dir = opendir(root);
+    if (!dir) {
+        snprintf(e->reason, sizeof(e->reason), "no powercap interface (%s)", root);
+        return -1;
+    }
+    int unreadable = 0;
+    struct dirent *de;
+    while ((de = readdir(dir)) != NULL && e->zones < BENCH_ENERGY_MAX_ZONES) {
+        if (!is_package_zone(de->d_name)) continue;
+        char path[512], name[64];
+        snprintf(path, sizeof(path), "%s/%s/name", root, de->d_name);
+        /* psys/dram domains at the top level would double count */
+        if (read_line(path, name, sizeof(name)) != 0 || strncmp(name, "package", 7) != 0) {
+            continue;
+        }
+        uint64_t v, range;
+        snprintf(path, sizeof(path), "%s/%s/max_energy_range_uj", root, de->d_name);
+        if (read_u64(path, &range) != 0) range = 0;
+        snprintf(path, sizeof(path), "%s/%s/energy_uj", root, de->d_name);
+        if (strlen(path) >= sizeof(e->path[0]) || read_u64(path, &v) != 0) {
+            unreadable++;
+            continue;
+        }
+        memcpy(e->path[e->zones], path, strlen(path) + 1);
+        e->range[e->zones] = range;
+        e->zones++;
+    }
+    closedir(dir);
+
+    if (e->zones == 0) {
+        snprintf(e->reason, sizeof(e->reason), "%s",
+                 unreadable ? "RAPL energy counters not readable (needs root)"
+                            : "no RAPL package domains");
+        return -1;
+    }
+    return 0;
+}
+
+int bench_energy_mark(const bench_energy_t *e, bench_energy_mark_t *m) {
+    memset(m, 0, sizeof(*m));
+    for (int i = 0; i < e->zones; i++) {
+        if (read_u64(e->path[i], &m->uj[i]) != 0) return -1;
+    }
+    return 0;
+}
+
+double bench_energy_joules(const bench_energy_t *e, const bench_energy_mark_t *a,
+                           const bench_energy_mark_t *b) {
+    double uj = 0.0;
+    for (int i = 0; i < e->zones; i++) {
+        uint64_t d = b->uj[i] - a->uj[i];
+        if (b->uj[i] < a->uj[i]) d = e->range[i] ? e->range[i] - a->uj[i] + b->uj[i] : 0;
+        uj += (double)d;
+    }
+    return uj * 1e-6;
+}
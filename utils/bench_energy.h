@@ -0,0 +1,61 @@
+/*
+ * bench_energy - CPU package energy from Linux powercap (RAPL)
+ *
+ * Reads the energy_uj counters of the package domains under
+ * /sys/class/powercap (intel-rapl:N, also used for AMD). The counters are
+ * system wide, so a measured region should run on an otherwise idle
+ * machine. Most kernels only let root read them; when they are missing or
+ * unreadable bench_energy_open() fails with a reason and the benchmarks
+ * leave the energy columns out.
+ *
+ * SSTV_RAPL_ROOT overrides the powercap directory.
+ */
+
+#ifndef BENCH_ENERGY_H
+#define BENCH_ENERGY_H
+
+#include <stdint.h>
+
+#define BENCH_ENERGY_MAX_ZONES 8
+
+typedef struct {
+    int zones;
+    char path[BENCH_ENERGY_MAX_ZONES][256];    /* energy_uj files */
+    uint64_t range[BENCH_ENERGY_MAX_ZONES];    /* max_energy_range_uj (wrap) */
+    char reason[128];                          /* Why energy is unavailable */
+} bench_energy_t;
+
+/* Counter snapshot */
+typedef struct {
+    uint64_t uj[BENCH_ENERGY_MAX_ZONES];
+} bench_energy_mark_t;
+
+/**
+ * Find readable package energy counters
+ *
+ * @param e Output: counter set (e->reason explains a failure)
+ * @return 0 if energy can be measured, -1 if not
+ */
+int bench_energy_open(bench_energy_t *e);
+
+/**
+ * Snapshot the counters
+ *
+ * @param e Counter set from bench_energy_open()
+ * @param m Output: snapshot
+ * @return 0 on success, -1 if a counter could not be read
+ */
+int bench_energy_mark(const bench_energy_t *e, bench_energy_mark_t *m);
+
+/**
+ * Energy used between two snapshots, summed over packages
+ *
+ * A counter that wrapped once is corrected with its range; regions long
+ * enough to wrap twice (minutes under full load) are not.
+ *
+ * @return Joules
+ */
+double bench_energy_joules(const bench_energy_t *e, const bench_energy_mark_t *a,
+                           const bench_energy_mark_t *b);
+
+#endif /* BENCH_ENERGY_H */
@@ -48,7 +48,7 @@ static int read_wav_header(FILE *fp, wav_info_t *info) {
 
 int main(int argc, char **argv) {
     if (argc < 2) {
-        fprintf(stderr, "Usage: %s <input.wav>\n", argv[0]);
+        fprintf(stderr, "Usage: %s <input.wav> [trace.trc]\n", argv[0]);
         return 1;
     }
 
@@ -83,6 +83,11 @@ int main(int argc, char **argv) {
     sstv_decoder_set_debug_level(dec, 2);
     sstv_decoder_set_vis_enabled(dec, 1);
 
+    /* Optional replay trace (see sstv_replay) */
+    if (argc > 2 && sstv_decoder_enable_trace(dec, argv[2]) != 0) {
+        fprintf(stderr, "Failed to create trace %s\n", argv[2]);
+    }
+
     const size_t frame_samples = 2048;
     int16_t *pcm = (int16_t *)malloc(frame_samples * sizeof(int16_t));
     float *samples = (float *)malloc(frame_samples * sizeof(float));
@@ -0,0 +1,409 @@
+/*
+ * sstv_bench - decoder accuracy / CPU trade-off per demodulator tier
+ *
+ * Encodes a test frame of horizontal grey bands, adds white Gaussian noise
+ * at a range of SNRs and decodes it with each demodulator tier
+ * (sstv_decoder_set_demod). For every tier and SNR it reports:
+ *
+ *   ns/smp   wall time of the whole decode per input sample (best of -n runs)
+ *   x_rt     real-time factor (audio seconds per CPU second)
+ *   err      median |decoded - expected| per row, averaged over the band
+ *            interiors (0-255); the median skips the sync pulse, which
+ *            lands mid-row because decoded rows are not sync-aligned
+ *   sync     line syncs matched / missed by the line sync tracker
+ *   J/s      CPU package energy per audio second (Linux RAPL, mean of the
+ *            timed runs; the column is left out when the counters are
+ *            unavailable, see bench_energy.h)
+ *
+ * followed by the encoder's cost for the same frame. SNR is tone power
+ * against noise power in a 3 kHz bandwidth. The error figure is only
+ * meaningful for the single-channel B/W modes, where every pixel of a
+ * line carries luminance; colour modes still report CPU.
+ *
+ * With -a, every mode is instead summarised on one line: encode, and
+ * clean decode with each demodulator tier, as ns/smp and J/s.
+ *
+ * Usage: sstv_bench [-m mode | -a] [-r sample_rate] [-n runs]
+ *   mode defaults to "B/W 12", sample rate to 22050, runs to 3
+ */
+
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+#include "sstv_encoder.h"
+#include "sstv_decoder.h"
+#include "bench_energy.h"
+
+#define AMPLITUDE 16000.0
+#define BANDS 8
+#define CHUNK 1024
+
+static const double kSnrDb[] = { 1000.0, 30.0, 20.0, 12.0, 6.0 };
+static const int kNumSnr = (int)(sizeof(kSnrDb) / sizeof(kSnrDb[0]));
+
+static const struct {
+    sstv_demod_t demod;
+    const char *name;
+} kTiers[] = {
+    { SSTV_DEMOD_TONE, "tone" },
+    { SSTV_DEMOD_ZC, "zc" },
+};
+static const int kNumTiers = (int)(sizeof(kTiers) / sizeof(kTiers[0]));
+
+static bench_energy_t g_energy;
+static int g_have_energy;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int band_level(int band) {
+    return band * 255 / (BANDS - 1);
+}
+
+/* Pixel value an ideal demodulator returns for a band: the encoder sends
+ * studio-range luma (16 + 0.8588 * v) at 1500 + y * 800 / 256 Hz, and the
+ * decoder maps 1500-2300 Hz linearly onto 0-255 */
+static double band_expected(int band) {
+    int y = (int)(16.0 + 0.858770 * band_level(band));
+    return (double)(y * 800 / 256) * 255.0 / 800.0;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/* Horizontal grey bands filling the mode's frame */
+static uint8_t* make_bands(const sstv_mode_info_t *info) {
+    uint8_t *rgb = (uint8_t*)malloc((size_t)info->width * info->height * 3);
+    if (!rgb) return NULL;
+    for (uint32_t y = 0; y < info->height; y++) {
+        uint8_t v = (uint8_t)band_level((int)(y * BANDS / info->height));
+        memset(rgb + (size_t)y * info->width * 3, v, (size_t)info->width * 3);
+    }
+    return rgb;
+}
+
+/* Encode the banded frame at unit amplitude plus a second of silence */
+static float* encode_frame(sstv_mode_t mode, double fs, size_t *count) {
+    const sstv_mode_info_t *info = sstv_get_mode_info(mode);
+    uint8_t *rgb = make_bands(info);
+    if (!rgb) return NULL;
+
+    sstv_image_t image = sstv_image_from_rgb(rgb, info->width, info->height);
+    sstv_encoder_t *enc = sstv_encoder_create(mode, fs);
+    if (!enc || sstv_encoder_set_image(enc, &image) != 0) {
+        sstv_encoder_free(enc);
+        free(rgb);
+        return NULL;
+    }
+    sstv_encoder_set_vis_enabled(enc, 1);
+
+    size_t total = sstv_encoder_get_total_samples(enc) + (size_t)fs;
+    float *samples = (float*)calloc(total, sizeof(float));
+    size_t n = 0;
+    while (samples && !sstv_encoder_is_complete(enc) && n < total) {
+        size_t got = sstv_encoder_generate(enc, samples + n, total - n);
+        if (got == 0) break;
+        n += got;
+    }
+    sstv_encoder_free(enc);
+    free(rgb);
+    *count = total;
+    return samples;
+}
+
+/* Scale to AMPLITUDE and add noise for the given SNR (fixed seed) */
+static void make_noisy(const float *clean, float *out, size_t n, double fs, double snr_db) {
+    double tone_rms = AMPLITUDE / sqrt(2.0);
+    double noise_rms = tone_rms / pow(10.0, snr_db / 20.0) * sqrt(fs / 2.0 / 3000.0);
+    uint32_t seed = 0x5eed1234u;
+    for (size_t i = 0; i < n; i++) {
+        double g = 0.0;
+        if (snr_db < 999.0) {
+            seed = seed * 1664525u + 1013904223u;
+            double u1 = ((seed >> 8) + 1.0) / 16777217.0;
+            seed = seed * 1664525u + 1013904223u;
+            double u2 = (seed >> 8) / 16777216.0;
+            g = sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+        }
+        out[i] = (float)(clean[i] * AMPLITUDE + g * noise_rms);
+    }
+}
+
+typedef struct {
+    int ready;
+    double ns_per_sample;
+    double joules;               /* Summed over the timed runs */
+    int energy_runs;
+    double err;
+    sstv_line_sync_t sync;
+} bench_result_t;
+
+/* Energy per audio second over the timed runs, or -1 if not measured */
+static double joules_per_second(const bench_result_t *res, size_t n, double fs) {
+    if (res->energy_runs == 0) return -1.0;
+    return res->joules / res->energy_runs / ((double)n / fs);
+}
+
+static void format_jps(char *buf, size_t size, double jps) {
+    if (jps < 0.0) {
+        snprintf(buf, size, "-");
+    } else {
+        snprintf(buf, size, "%.3f", jps);
+    }
+}
+
+/* Time generating the whole banded frame, best of `runs` */
+static void run_encode(sstv_mode_t mode, double fs, int runs, bench_result_t *res, size_t *count) {
+    const sstv_mode_info_t *info = sstv_get_mode_info(mode);
+    uint8_t *rgb = make_bands(info);
+    float *buf = (float*)malloc(CHUNK * sizeof(float));
+    *count = 0;
+    if (!rgb || !buf) {
+        free(rgb);
+        free(buf);
+        return;
+    }
+    sstv_image_t image = sstv_image_from_rgb(rgb, info->width, info->height);
+    for (int r = 0; r < runs; r++) {
+        sstv_encoder_t *enc = sstv_encoder_create(mode, fs);
+        if (!enc || sstv_encoder_set_image(enc, &image) != 0) {
+            sstv_encoder_free(enc);
+            break;
+        }
+        sstv_encoder_set_vis_enabled(enc, 1);
+
+        bench_energy_mark_t e0, e1;
+        int metered = g_have_energy && bench_energy_mark(&g_energy, &e0) == 0;
+        size_t n = 0, got;
+        double t0 = now_ns();
+        while ((got = sstv_encoder_generate(enc, buf, CHUNK)) > 0) n += got;
+        double t1 = now_ns();
+        if (metered && bench_energy_mark(&g_energy, &e1) == 0) {
+            res->joules += bench_energy_joules(&g_energy, &e0, &e1);
+            res->energy_runs++;
+        }
+        sstv_encoder_free(enc);
+
+        double ns = n ? (t1 - t0) / (double)n : 0.0;
+        if (res->ns_per_sample == 0.0 || ns < res->ns_per_sample) res->ns_per_sample = ns;
+        *count = n;
+    }
+    free(buf);
+    free(rgb);
+}
+
+/* Per-row median error, averaged over the interior rows of each band */
+static double band_error(const sstv_image_t *img) {
+    double *e = (double*)malloc(img->width * sizeof(double));
+    double sum = 0.0;
+    long cnt = 0;
+    int rows = (int)img->height / BANDS;
+    for (int b = 0; e && b < BANDS; b++) {
+        double want = band_expected(b);
+        for (int y = b * rows + rows / 4; y < (b + 1) * rows - rows / 4; y++) {
+            const uint8_t *row = img->pixels + (size_t)y * img->stride;
+            for (uint32_t x = 0; x < img->width; x++) {
+                e[x] = fabs((double)row[x * 3] - want);
+            }
+            qsort(e, img->width, sizeof(double), cmp_double);
+            sum += e[img->width / 2];
+            cnt++;
+        }
+    }
+    free(e);
+    return cnt ? sum / (double)cnt : 0.0;
+}
+
+static void run_decode(const float *x, size_t n, double fs, sstv_demod_t demod,
+                       int timed, bench_result_t *res) {
+    sstv_decoder_t *dec = sstv_decoder_create(fs);
+    if (!dec) return;
+    sstv_decoder_set_demod(dec, demod);
+
+    sstv_rx_status_t st = SSTV_RX_NEED_MORE;
+    bench_energy_mark_t e0, e1;
+    int metered = timed && g_have_energy && bench_energy_mark(&g_energy, &e0) == 0;
+    double t0 = now_ns();
+    for (size_t pos = 0; pos < n; pos += CHUNK) {
+        size_t len = n - pos < CHUNK ? n - pos : CHUNK;
+        st = sstv_decoder_feed(dec, x + pos, len);
+        if (st == SSTV_RX_IMAGE_READY) break;
+    }
+    double t1 = now_ns();
+    if (metered && bench_energy_mark(&g_energy, &e1) == 0) {
+        res->joules += bench_energy_joules(&g_energy, &e0, &e1);
+        res->energy_runs++;
+    }
+
+    res->ready = (st == SSTV_RX_IMAGE_READY);
+    if (timed) {
+        double ns = (t1 - t0) / (double)n;
+        if (res->ns_per_sample == 0.0 || ns < res->ns_per_sample) res->ns_per_sample = ns;
+    } else {
+        sstv_image_t img;
+        res->err = (res->ready && sstv_decoder_get_image(dec, &img) == 0) ? band_error(&img) : -1.0;
+        sstv_decoder_get_line_sync(dec, &res->sync);
+    }
+    sstv_decoder_free(dec);
+}
+
+/* Full table for one mode: each tier across the SNR range, then encode */
+static int bench_mode(sstv_mode_t mode, double fs, int runs) {
+    size_t n = 0;
+    float *clean = encode_frame(mode, fs, &n);
+    float *noisy = clean ? (float*)malloc(n * sizeof(float)) : NULL;
+    if (!noisy) {
+        fprintf(stderr, "Failed to encode test frame\n");
+        free(clean);
+        return 2;
+    }
+
+    const sstv_mode_info_t *info = sstv_get_mode_info(mode);
+    printf("Mode %s @ %.0f Hz, %.1f s of audio, best of %d runs\n\n",
+           info->name, fs, (double)n / fs, runs);
+    printf("%-6s %7s %8s %8s %7s %9s", "demod", "snr_db", "ns/smp", "x_rt", "err", "sync");
+    printf(g_have_energy ? " %8s\n" : "\n", "J/s");
+
+    for (int t = 0; t < kNumTiers; t++) {
+        for (int s = 0; s < kNumSnr; s++) {
+            make_noisy(clean, noisy, n, fs, kSnrDb[s]);
+            bench_result_t res;
+            memset(&res, 0, sizeof(res));
+            for (int r = 0; r < runs; r++) {
+                run_decode(noisy, n, fs, kTiers[t].demod, 1, &res);
+            }
+            run_decode(noisy, n, fs, kTiers[t].demod, 0, &res);
+
+            char snr[16], err[16], sync[24], jps[16];
+            if (kSnrDb[s] >= 999.0) {
+                snprintf(snr, sizeof(snr), "clean");
+            } else {
+                snprintf(snr, sizeof(snr), "%.0f", kSnrDb[s]);
+            }
+            if (res.ready) {
+                snprintf(err, sizeof(err), "%.1f", res.err);
+            } else {
+                snprintf(err, sizeof(err), "-");
+            }
+            snprintf(sync, sizeof(sync), "%d/%d", res.sync.lines_found, res.sync.lines_missed);
+            printf("%-6s %7s %8.1f %8.1f %7s %9s", kTiers[t].name, snr,
+                   res.ns_per_sample,
+                   res.ns_per_sample > 0.0 ? 1e9 / (res.ns_per_sample * fs) : 0.0,
+                   err, sync);
+            format_jps(jps, sizeof(jps), joules_per_second(&res, n, fs));
+            printf(g_have_energy ? " %8s\n" : "\n", jps);
+        }
+    }
+
+    bench_result_t enc;
+    memset(&enc, 0, sizeof(enc));
+    size_t enc_n = 0;
+    run_encode(mode, fs, runs, &enc, &enc_n);
+    char jps[16];
+    format_jps(jps, sizeof(jps), joules_per_second(&enc, enc_n, fs));
+    printf("\nencode %8.1f ns/smp %8.1f x_rt", enc.ns_per_sample,
+           enc.ns_per_sample > 0.0 ? 1e9 / (enc.ns_per_sample * fs) : 0.0);
+    printf(g_have_energy ? " %8s J/s\n" : "\n", jps);
+
+    free(noisy);
+    free(clean);
+    return 0;
+}
+
+/* One line per mode: encode, then clean decode per tier */
+static int bench_all(double fs, int runs) {
+    printf("All modes @ %.0f Hz, clean signal, best of %d runs (ns/smp%s)\n\n",
+           fs, runs, g_have_energy ? ", J/s" : "");
+    printf("%-14s %8s", "mode", "encode");
+    if (g_have_energy) printf(" %8s", "J/s");
+    for (int t = 0; t < kNumTiers; t++) {
+        printf(" %8s", kTiers[t].name);
+        if (g_have_energy) printf(" %8s", "J/s");
+    }
+    printf("\n");
+
+    for (int m = 0; m < SSTV_MODE_COUNT; m++) {
+        const sstv_mode_info_t *info = sstv_get_mode_info((sstv_mode_t)m);
+        size_t n = 0, enc_n = 0;
+        float *clean = encode_frame((sstv_mode_t)m, fs, &n);
+        float *x = clean ? (float*)malloc(n * sizeof(float)) : NULL;
+        if (!x) {
+            free(clean);
+            continue;
+        }
+        make_noisy(clean, x, n, fs, kSnrDb[0]);
+
+        bench_result_t enc;
+        memset(&enc, 0, sizeof(enc));
+        run_encode((sstv_mode_t)m, fs, runs, &enc, &enc_n);
+        char jps[16];
+        printf("%-14s %8.1f", info->name, enc.ns_per_sample);
+        format_jps(jps, sizeof(jps), joules_per_second(&enc, enc_n, fs));
+        if (g_have_energy) printf(" %8s", jps);
+
+        for (int t = 0; t < kNumTiers; t++) {
+            bench_result_t res;
+            memset(&res, 0, sizeof(res));
+            for (int r = 0; r < runs; r++) {
+                run_decode(x, n, fs, kTiers[t].demod, 1, &res);
+            }
+            printf(" %8.1f", res.ns_per_sample);
+            format_jps(jps, sizeof(jps), joules_per_second(&res, n, fs));
+            if (g_have_energy) printf(" %8s", jps);
+        }
+        printf("\n");
+        fflush(stdout);
+        free(x);
+        free(clean);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const char *mode_name = "B/W 12";
+    double fs = 22050.0;
+    int runs = 3;
+    int all = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            mode_name = argv[++i];
+        } else if (strcmp(argv[i], "-a") == 0) {
+            all = 1;
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            fs = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [-m mode | -a] [-r sample_rate] [-n runs]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (runs < 1) runs = 1;
+    int mode = sstv_find_mode_by_name(mode_name);
+    if ((!all && mode < 0) || fs < 8000.0) {
+        fprintf(stderr, "Unknown mode '%s' or bad sample rate\n", mode_name);
+        return 2;
+    }
+
+    g_have_energy = bench_energy_open(&g_energy) == 0;
+    if (g_have_energy) {
+        printf("Energy: %d RAPL package domain(s)\n", g_energy.zones);
+    } else {
+        printf("Energy: not measured (%s)\n", g_energy.reason);
+    }
+
+    return all ? bench_all(fs, runs) : bench_mode((sstv_mode_t)mode, fs, runs);
+}
@@ -0,0 +1,481 @@
+/*
+ * sstv_idle_bench - decoder cost when nothing is being received
+ *
+ * Streams synthetic non-SSTV audio through sstv_decoder_feed() at full
+ * speed, one decoder per signal class, and reports per audio-hour:
+ *
+ *   cpu_s    CPU seconds spent inside sstv_decoder_feed()
+ *   x_rt     real-time factor (audio seconds per CPU second)
+ *   trig     start bits that began VIS acquisition
+ *   false    acquisitions abandoned without a VIS lock
+ *   locks    false VIS detections (a code decoded to a mode)
+ *   frames   image frames allocated (decoder_allocate_image_buffer, seen
+ *            through a counting allocator)
+ *
+ * plus the decoder heap peak (VIS scratch and frames, via the allocator),
+ * the process peak RSS and, where Linux RAPL counters can be read, the CPU
+ * package energy spent in feed as J per audio-hour (see bench_energy.h).
+ * Signal classes:
+ *
+ *   awgn     white Gaussian noise
+ *   band     noise shaped to a 300-2700 Hz voice channel
+ *   speech   pitched pulse train through drifting vowel formants, in
+ *            syllables and pauses
+ *   cw       keyed Morse at 20 wpm, tone picked per over from 400-1500 Hz
+ *   rtty     45.45 baud, 170 Hz shift FSK on 2125 Hz or 1275 Hz tone pairs
+ *
+ * Every class except awgn sits on a low noise floor. With --check the
+ * results are held to the regression limits below and the exit status
+ * is 1 if any is exceeded.
+ *
+ * Usage: sstv_idle_bench [-t hours] [-r sample_rate] [-c max_cpu_s] [--check]
+ *   hours of audio per class default to 1, sample rate to 11025;
+ *   -c overrides the CPU limit (0 disables it, e.g. under sanitizers)
+ */
+
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include "sstv_decoder.h"
+#include "bench_energy.h"
+
+#define CHUNK 4096
+#define NOISE_RMS 3000.0             /* awgn / band classes */
+#define FLOOR_RMS 300.0              /* Background under the other classes */
+#define SIGNAL_AMP 12000.0           /* Peak of tones and speech */
+
+/* Regression limits for --check */
+#define MAX_CPU_S_PER_HOUR 120.0     /* At least 30x real time per channel */
+#define MAX_LOCKS_PER_HOUR 1.0
+#define MAX_RSS_MB 64.0
+
+/* === SIGNAL GENERATORS === */
+
+typedef struct {
+    double b0, b1, b2, a1, a2;
+    double x1, x2, y1, y2;
+} biquad_t;
+
+/* RBJ cookbook low-pass / high-pass (Q = 0.707) and band-pass (0 dB peak) */
+static void biquad_design(biquad_t *f, int type, double fc, double q, double fs) {
+    double w = 2.0 * M_PI * fc / fs;
+    double cw = cos(w), alpha = sin(w) / (2.0 * q);
+    double a0 = 1.0 + alpha;
+    memset(f, 0, sizeof(*f));
+    if (type == 0) {                 /* Low-pass */
+        f->b0 = f->b2 = (1.0 - cw) / 2.0 / a0;
+        f->b1 = (1.0 - cw) / a0;
+    } else if (type == 1) {          /* High-pass */
+        f->b0 = f->b2 = (1.0 + cw) / 2.0 / a0;
+        f->b1 = -(1.0 + cw) / a0;
+    } else {                         /* Band-pass */
+        f->b0 = alpha / a0;
+        f->b2 = -alpha / a0;
+    }
+    f->a1 = -2.0 * cw / a0;
+    f->a2 = (1.0 - alpha) / a0;
+}
+
+static double biquad_do(biquad_t *f, double x) {
+    double y = f->b0 * x + f->b1 * f->x1 + f->b2 * f->x2 - f->a1 * f->y1 - f->a2 * f->y2;
+    f->x2 = f->x1;
+    f->x1 = x;
+    f->y2 = f->y1;
+    f->y1 = y;
+    return y;
+}
+
+typedef struct {
+    uint32_t seed;
+    double fs;
+    long left;                       /* Samples left in the current segment */
+    int on;                          /* Segment is a tone / syllable (not a gap) */
+    long seg_len;
+    double phase;
+    double freq;
+    /* band */
+    biquad_t hp, lp;
+    /* speech */
+    biquad_t formant[3];
+    double pitch, pitch_phase;
+    /* cw */
+    int sym;                         /* Elements left in the current character */
+    uint32_t pattern;                /* Remaining dits (0) / dahs (1), LSB first */
+    /* rtty */
+    double mark, space;
+    int bits_left;
+    uint32_t shift;
+    long over_left;
+} gen_t;
+
+static uint32_t rnd(gen_t *g) {
+    g->seed = g->seed * 1664525u + 1013904223u;
+    return g->seed >> 8;
+}
+
+static double urand(gen_t *g) {
+    return (rnd(g) + 0.5) / 16777216.0;
+}
+
+/* Box-Muller over the LCG so every run is reproducible */
+static double gauss(gen_t *g) {
+    return sqrt(-2.0 * log(urand(g))) * cos(2.0 * M_PI * urand(g));
+}
+
+static void gen_awgn(gen_t *g, float *out, size_t n) {
+    for (size_t i = 0; i < n; i++) out[i] = (float)(gauss(g) * NOISE_RMS);
+}
+
+static void gen_band(gen_t *g, float *out, size_t n) {
+    /* The channel keeps 2400 Hz of the fs/2 noise bandwidth; scale back
+     * up so the total level matches awgn */
+    double gain = sqrt(g->fs / 2.0 / 2400.0);
+    for (size_t i = 0; i < n; i++) {
+        double x = biquad_do(&g->lp, biquad_do(&g->hp, gauss(g)));
+        out[i] = (float)(x * NOISE_RMS * gain);
+    }
+}
+
+/* Vowel formants (F1, F2, F3) in Hz */
+static const double kVowels[][3] = {
+    { 730, 1090, 2440 }, { 270, 2290, 3010 }, { 530, 1840, 2480 },
+    { 300, 870, 2240 }, { 570, 840, 2410 }, { 660, 1720, 2410 },
+    { 440, 1020, 2240 }, { 390, 1990, 2550 },
+};
+
+static void speech_next(gen_t *g) {
+    g->on = !g->on;
+    if (g->on) {
+        const double *v = kVowels[rnd(g) % (sizeof(kVowels) / sizeof(kVowels[0]))];
+        for (int k = 0; k < 3; k++) {
+            double f = v[k] * (0.9 + 0.2 * urand(g));
+            if (f > g->fs * 0.45) f = g->fs * 0.45;
+            biquad_design(&g->formant[k], 2, f, f / 80.0, g->fs);
+        }
+        g->pitch = 100.0 + 120.0 * urand(g);
+        g->seg_len = (long)((0.12 + 0.20 * urand(g)) * g->fs);
+    } else {
+        g->seg_len = (long)((0.02 + 0.40 * urand(g) * urand(g)) * g->fs);
+    }
+    g->left = g->seg_len;
+}
+
+static void gen_speech(gen_t *g, float *out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (g->left <= 0) speech_next(g);
+        double x = 0.0;
+        if (g->on) {
+            /* Glottal pulses with slow pitch drift and a little jitter */
+            g->pitch *= 1.0 + (urand(g) - 0.5) * 2e-4;
+            g->pitch_phase += g->pitch / g->fs;
+            double src = 0.0;
+            if (g->pitch_phase >= 1.0) {
+                g->pitch_phase -= 1.0;
+                src = 1.0;
+            }
+            src += gauss(g) * 0.02;              /* Breath */
+            for (int k = 0; k < 3; k++) x += biquad_do(&g->formant[k], src) / (k + 1);
+            double pos = 1.0 - (double)g->left / g->seg_len;
+            x *= 0.5 - 0.5 * cos(2.0 * M_PI * pos);  /* Syllable envelope */
+            x *= SIGNAL_AMP * 4.0;
+        }
+        out[i] = (float)(x + gauss(g) * FLOOR_RMS);
+        g->left--;
+    }
+}
+
+/* Morse for A-Z and 0-9 */
+static const char *kMorse[] = {
+    ".-", "-...", "-.-.", "-..", ".", "..-.", "--.", "....", "..", ".---", "-.-",
+    ".-..", "--", "-.", "---", ".--.", "--.-", ".-.", "...", "-", "..-", "...-",
+    ".--", "-..-", "-.--", "--..", "-----", ".----", "..---", "...--", "....-",
+    ".....", "-....", "--...", "---..", "----.",
+};
+
+static void cw_next(gen_t *g) {
+    long dit = (long)(0.060 * g->fs);         /* 20 wpm */
+    if (g->over_left <= 0) {
+        /* New over: new operator, new tone */
+        g->freq = 400.0 + 1100.0 * urand(g);
+        g->over_left = (long)((20.0 + 40.0 * urand(g)) * g->fs);
+    }
+    if (g->on) {
+        /* Gap after an element: 1 dit, 3 between characters, 7 between words */
+        g->on = 0;
+        long gap = dit;
+        if (g->sym == 0) gap = (rnd(g) % 5 == 0) ? 7 * dit : 3 * dit;
+        g->seg_len = g->left = gap;
+        return;
+    }
+    if (g->sym == 0) {
+        const char *c = kMorse[rnd(g) % (sizeof(kMorse) / sizeof(kMorse[0]))];
+        g->sym = (int)strlen(c);
+        g->pattern = 0;
+        for (int k = 0; k < g->sym; k++) {
+            if (c[k] == '-') g->pattern |= 1u << k;
+        }
+    }
+    g->on = 1;
+    g->seg_len = g->left = (g->pattern & 1) ? 3 * dit : dit;
+    g->pattern >>= 1;
+    g->sym--;
+}
+
+static void gen_cw(gen_t *g, float *out, size_t n) {
+    long edge = (long)(0.005 * g->fs);
+    for (size_t i = 0; i < n; i++) {
+        if (g->left <= 0) cw_next(g);
+        double x = 0.0;
+        g->phase += 2.0 * M_PI * g->freq / g->fs;
+        if (g->phase > 2.0 * M_PI) g->phase -= 2.0 * M_PI;
+        if (g->on) {
+            long done = g->seg_len - g->left;
+            double env = 1.0;
+            if (done < edge) env = 0.5 - 0.5 * cos(M_PI * done / edge);
+            if (g->left < edge) env = 0.5 - 0.5 * cos(M_PI * g->left / edge);
+            x = sin(g->phase) * env * SIGNAL_AMP;
+        }
+        out[i] = (float)(x + gauss(g) * FLOOR_RMS);
+        g->left--;
+        g->over_left--;
+    }
+}
+
+static void rtty_next(gen_t *g) {
+    if (g->over_left <= 0) {
+        /* High (2125/2295) or low (1275/1445) tone pair per over */
+        g->mark = (rnd(g) & 1) ? 2125.0 : 1275.0;
+        g->space = g->mark + 170.0;
+        g->over_left = (long)((20.0 + 40.0 * urand(g)) * g->fs);
+    }
+    if (g->bits_left == 0) {
+        /* Start (space), 5 data bits, then 1.5 stop bits (mark) sent as a
+         * full and a half-length symbol */
+        g->shift = (rnd(g) & 0x1f) << 1 | 0x3u << 6;
+        g->bits_left = 8;
+    }
+    long bit = (long)(g->fs / 45.45);
+    g->on = g->shift & 1;                     /* 1 = mark */
+    g->freq = g->on ? g->mark : g->space;
+    g->seg_len = g->left = g->bits_left == 1 ? bit / 2 : bit;
+    g->shift >>= 1;
+    g->bits_left--;
+}
+
+static void gen_rtty(gen_t *g, float *out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (g->left <= 0) rtty_next(g);
+        g->phase += 2.0 * M_PI * g->freq / g->fs;   /* Phase continuous */
+        if (g->phase > 2.0 * M_PI) g->phase -= 2.0 * M_PI;
+        out[i] = (float)(sin(g->phase) * SIGNAL_AMP + gauss(g) * FLOOR_RMS);
+        g->left--;
+        g->over_left--;
+    }
+}
+
+static const struct {
+    const char *name;
+    void (*fill)(gen_t *g, float *out, size_t n);
+} kClasses[] = {
+    { "awgn", gen_awgn },
+    { "band", gen_band },
+    { "speech", gen_speech },
+    { "cw", gen_cw },
+    { "rtty", gen_rtty },
+};
+static const int kNumClasses = (int)(sizeof(kClasses) / sizeof(kClasses[0]));
+
+static bench_energy_t g_energy;
+static int g_have_energy;
+
+/* === COUNTING ALLOCATOR === */
+
+typedef struct {
+    uint64_t allocs;
+    size_t live, peak;
+} alloc_count_t;
+
+static void* count_alloc(void *user, size_t size) {
+    alloc_count_t *c = (alloc_count_t*)user;
+    void *p = malloc(size);
+    if (p) {
+        c->allocs++;
+        c->live += size;
+        if (c->live > c->peak) c->peak = c->live;
+    }
+    return p;
+}
+
+static void count_free(void *user, void *ptr, size_t size) {
+    alloc_count_t *c = (alloc_count_t*)user;
+    if (!ptr) return;
+    c->live -= size;
+    free(ptr);
+}
+
+/* === MEASUREMENT === */
+
+typedef struct {
+    double hours;
+    double cpu_s;
+    double joules;               /* -1 if not measured */
+    double trig, false_starts, locks, frames;   /* Totals */
+    size_t heap_peak;
+    double rss_mb;
+} idle_result_t;
+
+static double cpu_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static double rss_mb(void) {
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0.0;
+    return (double)ru.ru_maxrss / 1024.0;     /* Linux reports KiB */
+}
+
+static int run_class(int cls, double hours, double fs, idle_result_t *res) {
+    alloc_count_t count;
+    memset(&count, 0, sizeof(count));
+    sstv_allocator_t alloc = { count_alloc, count_free, &count };
+    sstv_decoder_t *dec = sstv_decoder_create_with_allocator(fs, &alloc);
+    float *buf = (float*)malloc(CHUNK * sizeof(float));
+    if (!dec || !buf) {
+        sstv_decoder_free(dec);
+        free(buf);
+        return -1;
+    }
+    uint64_t base_allocs = count.allocs;      /* VIS scratch from create */
+
+    gen_t g;
+    memset(&g, 0, sizeof(g));
+    g.seed = 0x1d1e0000u + (uint32_t)cls;
+    g.fs = fs;
+    biquad_design(&g.hp, 1, 300.0, 0.707, fs);
+    biquad_design(&g.lp, 0, 2700.0, 0.707, fs);
+
+    uint64_t total = (uint64_t)(hours * 3600.0 * fs);
+    double cpu = 0.0, joules = 0.0;
+    int metered = g_have_energy;
+    for (uint64_t pos = 0; pos < total; pos += CHUNK) {
+        size_t n = total - pos < CHUNK ? (size_t)(total - pos) : CHUNK;
+        kClasses[cls].fill(&g, buf, n);
+        bench_energy_mark_t e0, e1;
+        if (metered && bench_energy_mark(&g_energy, &e0) != 0) metered = 0;
+        double t0 = cpu_now();
+        sstv_decoder_feed(dec, buf, n);
+        cpu += cpu_now() - t0;
+        if (metered && bench_energy_mark(&g_energy, &e1) == 0) {
+            joules += bench_energy_joules(&g_energy, &e0, &e1);
+        } else {
+            metered = 0;
+        }
+    }
+
+    sstv_sense_stats_t st;
+    sstv_decoder_get_sense_stats(dec, &st);
+    memset(res, 0, sizeof(*res));
+    res->hours = (double)total / fs / 3600.0;
+    res->cpu_s = cpu;
+    res->joules = metered ? joules : -1.0;
+    res->trig = (double)st.triggers;
+    res->false_starts = (double)st.false_starts;
+    res->locks = (double)st.vis_locks;
+    res->frames = (double)(count.allocs - base_allocs);
+    res->heap_peak = count.peak;
+    sstv_decoder_free(dec);
+    free(buf);
+    res->rss_mb = rss_mb();
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    double hours = 1.0;
+    double fs = 11025.0;
+    double max_cpu = MAX_CPU_S_PER_HOUR;
+    int check = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            hours = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            fs = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            max_cpu = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--check") == 0) {
+            check = 1;
+        } else {
+            fprintf(stderr, "Usage: %s [-t hours] [-r sample_rate] [-c max_cpu_s] [--check]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (hours <= 0.0 || fs < 8000.0) {
+        fprintf(stderr, "Bad duration or sample rate\n");
+        return 2;
+    }
+
+    g_have_energy = bench_energy_open(&g_energy) == 0;
+    printf("Idle decoder cost @ %.0f Hz, %.2f h of audio per class (per audio-hour)\n", fs, hours);
+    if (g_have_energy) {
+        printf("Energy: %d RAPL package domain(s)\n\n", g_energy.zones);
+    } else {
+        printf("Energy: not measured (%s)\n\n", g_energy.reason);
+    }
+    printf("%-7s %8s %8s %7s %7s %7s %7s %8s %7s",
+           "class", "cpu_s", "x_rt", "trig", "false", "locks", "frames", "heap_kb", "rss_mb");
+    printf(g_have_energy ? " %8s\n" : "\n", "J");
+
+    int failed = 0;
+    for (int c = 0; c < kNumClasses; c++) {
+        idle_result_t r;
+        if (run_class(c, hours, fs, &r) != 0) {
+            fprintf(stderr, "Cannot create decoder\n");
+            return 2;
+        }
+        double cpu_h = r.cpu_s / r.hours;
+        printf("%-7s %8.1f %8.0f %7.1f %7.1f %7.1f %7.1f %8.0f %7.1f", kClasses[c].name,
+               cpu_h, cpu_h > 0.0 ? 3600.0 / cpu_h : 0.0,
+               r.trig / r.hours, r.false_starts / r.hours, r.locks / r.hours,
+               r.frames / r.hours, (double)r.heap_peak / 1024.0, r.rss_mb);
+        if (!g_have_energy) {
+            printf("\n");
+        } else if (r.joules < 0.0) {
+            printf(" %8s\n", "-");
+        } else {
+            printf(" %8.1f\n", r.joules / r.hours);
+        }
+
+        if (!check) continue;
+        /* Counts are compared as totals so a short run cannot hide one lock */
+        if (max_cpu > 0.0 && cpu_h > max_cpu) {
+            printf("  FAIL: %.1f CPU s per audio-hour (limit %.1f)\n", cpu_h, max_cpu);
+            failed = 1;
+        }
+        if (r.locks > MAX_LOCKS_PER_HOUR * (r.hours > 1.0 ? r.hours : 1.0)) {
+            printf("  FAIL: %.0f false VIS locks (limit %.1f per hour)\n", r.locks,
+                   MAX_LOCKS_PER_HOUR);
+            failed = 1;
+        }
+        if (r.frames > r.locks) {
+            printf("  FAIL: %.0f frames allocated for %.0f VIS locks\n", r.frames, r.locks);
+            failed = 1;
+        }
+        if (r.rss_mb > MAX_RSS_MB) {
+            printf("  FAIL: peak RSS %.1f MB (limit %.1f)\n", r.rss_mb, MAX_RSS_MB);
+            failed = 1;
+        }
+    }
+    if (check) printf(failed ? "\nFAIL\n" : "\nPASS\n");
+    return failed;
+}
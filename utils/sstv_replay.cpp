@@ -0,0 +1,158 @@
+/*
+ * sstv_replay - re-run a recorded decoder trace
+ *
+ * Feeds the samples of a trace written by sstv_decoder_enable_trace()
+ * through a fresh decoder with the same configuration, API calls and
+ * chunk boundaries, and checks every returned status and state checksum
+ * against the recording. Reports the first divergence (feed index and
+ * sample position), recorded vs replayed processing time, and the
+ * per-stage time split of the replay.
+ *
+ * Usage: sstv_replay <trace.trc> [-q]
+ * Exit status: 0 identical, 1 diverged, 2 unreadable trace
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <chrono>
+
+#include "sstv_decoder.h"
+#include "trace.h"
+
+static void apply_call(sstv_decoder_t *dec, const trace_call_t *call) {
+    switch (call->op) {
+        case TRACE_CALL_RESET:
+            sstv_decoder_reset(dec);
+            break;
+        case TRACE_CALL_MODE_HINT:
+            sstv_decoder_set_mode_hint(dec, (sstv_mode_t)call->arg);
+            break;
+        case TRACE_CALL_VIS_ENABLED:
+            sstv_decoder_set_vis_enabled(dec, call->arg);
+            break;
+        case TRACE_CALL_AGC_MODE:
+            sstv_decoder_set_agc_mode(dec, (sstv_agc_mode_t)call->arg);
+            break;
+        case TRACE_CALL_VIS_TONES:
+            sstv_decoder_set_vis_tones(dec, call->a, call->b);
+            break;
+        case TRACE_CALL_DEMOD:
+            sstv_decoder_set_demod(dec, (sstv_demod_t)call->arg);
+            break;
+        case TRACE_CALL_SENSE:
+            sstv_decoder_set_false_alarm_rate(dec, call->a);
+            break;
+        case TRACE_CALL_AGC_TIMING:
+            sstv_decoder_set_agc_timing(dec, call->arg / 1000.0, call->a, call->b);
+            break;
+        default:
+            fprintf(stderr, "warning: unknown call op %u skipped\n", call->op);
+            break;
+    }
+}
+
+static double ms(uint64_t ns) {
+    return (double)ns / 1e6;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <trace.trc> [-q]\n", argv[0]);
+        return 2;
+    }
+    const char *path = argv[1];
+    int quiet = (argc > 2 && strcmp(argv[2], "-q") == 0);
+
+    trace_reader_t rd;
+    trace_config_t cfg;
+    if (trace_reader_open(&rd, path, &cfg) != 0) {
+        fprintf(stderr, "Cannot read trace %s\n", path);
+        return 2;
+    }
+
+    sstv_decoder_t *dec = sstv_decoder_create(cfg.sample_rate);
+    if (!dec) {
+        fprintf(stderr, "Failed to create decoder.\n");
+        trace_reader_close(&rd);
+        return 2;
+    }
+    sstv_decoder_set_vis_enabled(dec, cfg.vis_enabled);
+    sstv_decoder_set_mode_hint(dec, (sstv_mode_t)cfg.mode_hint);
+    sstv_decoder_set_agc_mode(dec, (sstv_agc_mode_t)cfg.agc_mode);
+    sstv_decoder_set_vis_tones(dec, cfg.vis_mark_hz, cfg.vis_space_hz);
+    sstv_decoder_set_profiling(dec, 1);
+
+    uint64_t feeds = 0, calls = 0, checks = 0, samples = 0;
+    uint64_t rec_ns = 0, rep_ns = 0;
+    int diverged = 0;
+    int rc;
+    trace_record_t rec;
+
+    while ((rc = trace_read(&rd, &rec)) == 1) {
+        if (rec.type == TRACE_REC_CALL) {
+            apply_call(dec, &rec.call);
+            calls++;
+        } else if (rec.type == TRACE_REC_FEED) {
+            auto t0 = std::chrono::steady_clock::now();
+            sstv_rx_status_t st = sstv_decoder_feed(dec, rec.samples, rec.feed.count);
+            auto t1 = std::chrono::steady_clock::now();
+            rep_ns += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+            rec_ns += rec.feed.proc_ns;
+            if (!diverged && (int32_t)st != rec.feed.status) {
+                printf("DIVERGED at feed %llu (samples %llu..%llu): status %d, recorded %d\n",
+                       (unsigned long long)rec.feed.index,
+                       (unsigned long long)rec.feed.first_sample,
+                       (unsigned long long)(rec.feed.first_sample + rec.feed.count),
+                       (int)st, (int)rec.feed.status);
+                diverged = 1;
+            }
+            samples = rec.feed.first_sample + rec.feed.count;
+            feeds++;
+        } else if (rec.type == TRACE_REC_CHECK) {
+            uint64_t sum = sstv_decoder_get_checksum(dec);
+            if (!diverged && sum != rec.check.checksum) {
+                printf("DIVERGED at sample %llu (after feed %llu): checksum %016llx, recorded %016llx\n",
+                       (unsigned long long)rec.check.sample_pos,
+                       (unsigned long long)(feeds ? feeds - 1 : 0),
+                       (unsigned long long)sum,
+                       (unsigned long long)rec.check.checksum);
+                diverged = 1;
+            }
+            checks++;
+        }
+    }
+    if (rc < 0) {
+        fprintf(stderr, "warning: trace truncated or corrupt after feed %llu\n",
+                (unsigned long long)feeds);
+    }
+
+    double audio_s = (double)samples / cfg.sample_rate;
+    printf("Trace: %s\n", path);
+    printf("  %.0f Hz, %llu samples (%.1f s), %llu feeds, %llu calls, %llu checksums\n",
+           cfg.sample_rate, (unsigned long long)samples, audio_s,
+           (unsigned long long)feeds, (unsigned long long)calls, (unsigned long long)checks);
+    printf("  recorded: %.1f ms (%.1fx realtime)\n", ms(rec_ns),
+           rec_ns ? audio_s * 1e9 / (double)rec_ns : 0.0);
+    printf("  replayed: %.1f ms (%.1fx realtime)\n", ms(rep_ns),
+           rep_ns ? audio_s * 1e9 / (double)rep_ns : 0.0);
+
+    if (!quiet) {
+        sstv_decoder_profile_t prof;
+        sstv_decoder_get_profile(dec, &prof);
+        uint64_t sum = prof.frontend_ns + prof.tone_ns + prof.sync_ns + prof.image_ns;
+        if (sum) {
+            printf("  stages (est. from %llu timed samples):\n", (unsigned long long)prof.sampled);
+            printf("    front end  %8.1f ms %5.1f%%\n", ms(prof.frontend_ns), 100.0 * prof.frontend_ns / sum);
+            printf("    tones      %8.1f ms %5.1f%%\n", ms(prof.tone_ns), 100.0 * prof.tone_ns / sum);
+            printf("    sync/VIS   %8.1f ms %5.1f%%\n", ms(prof.sync_ns), 100.0 * prof.sync_ns / sum);
+            printf("    image      %8.1f ms %5.1f%%\n", ms(prof.image_ns), 100.0 * prof.image_ns / sum);
+        }
+    }
+    printf("%s\n", diverged ? "Result: DIVERGED" : "Result: identical");
+
+    sstv_decoder_free(dec);
+    trace_reader_close(&rd);
+    return diverged ? 1 : 0;
+}